@@ -0,0 +1,51 @@
+# -*- mode: python ; coding: utf-8 -*-
+# One-dir build: dist/PRIMAcquisition/PRIMAcquisition.exe next to its
+# libraries.  Unlike the one-file PRIMAcquisition.spec nothing is unpacked to a
+# temp dir on each launch, and UPX is off so DLLs load without decompression.
+#
+#   pyinstaller PRIMAcquisition-onedir.spec
+
+
+a = Analysis(
+    ['prim_app\\prim_app.py'],
+    pathex=[],
+    binaries=[],
+    datas=[('.primenv/Lib/site-packages/imagingcontrol4/*', 'imagingcontrol4'), ('prim_app/ui/icons/*', 'prim_app/ui/icons'), ('prim_app/ui/style.qss', 'prim_app/ui')],
+    hiddenimports=['imagingcontrol4'],
+    hookspath=[],
+    hooksconfig={},
+    runtime_hooks=[],
+    excludes=[],
+    noarchive=False,
+    optimize=0,
+)
+pyz = PYZ(a.pure)
+
+exe = EXE(
+    pyz,
+    a.scripts,
+    [],
+    exclude_binaries=True,
+    name='PRIMAcquisition',
+    debug=False,
+    bootloader_ignore_signals=False,
+    strip=False,
+    upx=False,
+    console=True,
+    disable_windowed_traceback=False,
+    argv_emulation=False,
+    target_arch=None,
+    codesign_identity=None,
+    entitlements_file=None,
+    icon=['prim_app\\ui\\icons\\PRIM.ico'],
+)
+
+coll = COLLECT(
+    exe,
+    a.binaries,
+    a.datas,
+    strip=False,
+    upx=False,
+    upx_exclude=[],
+    name='PRIMAcquisition',
+)
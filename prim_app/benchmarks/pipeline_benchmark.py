@@ -0,0 +1,303 @@
+# prim_app/benchmarks/pipeline_benchmark.py
+"""
+End-to-end throughput benchmark on simulated sources.
+
+Drives the real RecordingManager (sync engine, write-behind queue, frame
+writer backend) and, unless ``--no-gui``, the live-view path (preview
+conversion, UiRefreshScheduler, QtCameraWidget, PressurePlotWidget) from a
+SimulatedCameraThread triggered by a SimulatedSerialThread, once per writer
+backend, and prints sustained fps, drops, end-to-end latency and MB/s
+(``--cameras N`` records N triggered cameras side by side, with a line of
+stats per camera)::
+
+    cd prim_app
+    python benchmarks/pipeline_benchmark.py --resolution 2448x2048 --bits 12 \\
+        --fps 60 --duration 20 --formats tif tif-zstd h5 --json results.json
+
+Recordings go to a temporary folder that is removed afterwards (``--keep``
+keeps it).
+"""
+
+import argparse
+import json
+import os
+import shutil
+import sys
+import tempfile
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from PyQt5.QtCore import QEventLoop, QMetaObject, QThread, QTimer, Qt
+
+from recording_manager import RecordingManager
+from threads.simulated_sources import SimulatedCameraThread, SimulatedSerialThread
+from utils.config import (
+    SIM_CAMERA_BIT_DEPTH,
+    SIM_CAMERA_RESOLUTION,
+    SIM_SAMPLE_RATE_HZ,
+    SUPPORTED_FORMATS,
+)
+from utils.telemetry import telemetry
+
+# Latency histograms reported per run (see utils/telemetry.py for the names)
+LATENCY_METRICS = (
+    "queue.frame_to_recorder",
+    "queue.frame_to_disk",
+    "queue.frame_to_ui",
+    "ui.paint",
+    "ui.plot_redraw",
+)
+
+
+class LiveView:
+    """The GUI side of MainWindow: refresh scheduler, camera view and plot."""
+
+    def __init__(self):
+        from ui.canvas.pressure_plot_widget import PressurePlotWidget
+        from ui.canvas.qtcamera_widget import QtCameraWidget
+        from ui.refresh_scheduler import UiRefreshScheduler
+
+        self.scheduler = UiRefreshScheduler()
+        self.camera_widget = QtCameraWidget()
+        self.camera_widget.resize(640, 512)
+        self.camera_widget.show()
+        self.plot = PressurePlotWidget()
+        self.plot.resize(640, 400)
+        self.plot.show()
+        self.scheduler.frame_ready.connect(self.camera_widget._on_frame_ready)
+        self.scheduler.samples_ready.connect(
+            lambda idx, t, p: self.plot.update_plot_block(t, p, True, True)
+        )
+
+    def attach(self, camera, serial):
+        """Preview ``camera`` (the first one) and plot ``serial``."""
+        camera.frame_ready.connect(self.scheduler.push_frame)
+        serial.samples_ready.connect(self.scheduler.push_block)
+        self.scheduler.start()
+
+    def detach(self):
+        self.scheduler.stop()
+        self.camera_widget.clear_image()
+        self.plot.clear_plot()
+
+
+def run_case(fmt, args, root, view):
+    """One recording with writer backend ``fmt``; returns a result dict."""
+    telemetry.reset()
+    outdir = os.path.join(root, fmt)
+    os.makedirs(outdir, exist_ok=True)
+
+    cameras = []
+    for camera_id in range(max(1, args.cameras)):
+        camera = SimulatedCameraThread(
+            resolution=args.resolution,
+            bit_depth=args.bits,
+            fps=args.fps,
+            triggered=True,
+            camera_id=camera_id,
+        )
+        camera.set_preview_enabled(view is not None and camera_id == 0)
+        cameras.append(camera)
+    serial = SimulatedSerialThread(rate_hz=args.fps, camera=cameras)
+
+    recorder_thread = QThread()
+    recorder = RecordingManager(
+        output_dir=outdir,
+        recording_format=fmt,
+        pretrigger_s=0,
+        cameras={c.camera_id: None for c in cameras},
+    )
+    recorder.moveToThread(recorder_thread)
+    # Latest stats per camera_id
+    stats = {"writer": {}, "sync": {}, "camera": {}}
+    timing = {}
+    loop = QEventLoop()
+
+    def keep(kind):
+        return lambda s: stats[kind].__setitem__(s.get("camera_id", 0), s)
+
+    recorder.writer_stats.connect(keep("writer"))
+    recorder.sync_stats.connect(keep("sync"))
+    recorder_thread.started.connect(recorder.start_recording)
+    recorder.finished.connect(recorder_thread.quit)
+    recorder.finished.connect(loop.quit)
+    serial.samples_ready.connect(recorder.append_pressure_block)
+    for camera in cameras:
+        camera.stats_updated.connect(keep("camera"))
+        camera.frame_ready.connect(recorder.append_frame)
+    if view is not None:
+        view.attach(cameras[0], serial)
+
+    def on_ready():
+        serial.send_command("G")
+        timing["start"] = time.monotonic()
+        QTimer.singleShot(int(args.duration * 1000), stop)
+
+    def stop():
+        serial.send_command("S")
+        serial.samples_ready.disconnect(recorder.append_pressure_block)
+        for camera in cameras:
+            camera.frame_ready.disconnect(recorder.append_frame)
+            stats["camera"][camera.camera_id] = camera.get_stats()
+        timing["stop"] = time.monotonic()
+        QMetaObject.invokeMethod(recorder, "stop_recording", Qt.QueuedConnection)
+
+    recorder.ready_for_acquisition.connect(on_ready)
+
+    serial.start()
+    for camera in cameras:
+        camera.start()
+    recorder_thread.start()
+    loop.exec_()
+    timing["finished"] = time.monotonic()
+
+    recorder_thread.wait(5000)
+    for camera in cameras:
+        camera.stop()
+        camera.wait(5000)
+    serial.stop()
+    if view is not None:
+        view.detach()
+
+    elapsed = timing["stop"] - timing["start"]
+    per_camera = [
+        camera_result(
+            stats["camera"].get(c.camera_id, {}),
+            stats["writer"].get(c.camera_id, {}),
+            stats["sync"].get(c.camera_id, {}),
+            elapsed,
+        )
+        for c in cameras
+    ]
+    on_disk = sum(
+        os.path.getsize(os.path.join(d, f)) for d, _, files in os.walk(outdir) for f in files
+    )
+    snap = telemetry.snapshot()
+    latency = {
+        name: snap["histograms"][name]
+        for name in LATENCY_METRICS
+        if name in snap["histograms"]
+    }
+    result = {
+        "format": fmt,
+        "duration_s": elapsed,
+        "drain_s": timing["finished"] - timing["stop"],
+        "mb_on_disk": on_disk / 1e6,
+        "latency": latency,
+    }
+    # Totals over all cameras; max_queue_depth is the worst stream
+    for key in per_camera[0]:
+        values = [r[key] for r in per_camera]
+        result[key] = max(values) if key == "max_queue_depth" else sum(values)
+    if len(per_camera) > 1:
+        result["cameras"] = per_camera
+    return result
+
+
+def camera_result(c, w, s, elapsed):
+    """Throughput of one camera's stream from its camera, writer and sync stats."""
+    return {
+        "frames_generated": c.get("queued", 0),
+        "frames_written": w.get("written", 0),
+        "fps": w.get("written", 0) / elapsed if elapsed > 0 else 0.0,
+        "camera_dropped": c.get("dropped", 0),
+        "writer_dropped": w.get("dropped", 0),
+        "writer_spilled": w.get("spilled", 0),
+        "max_queue_depth": w.get("max_queue_depth", 0),
+        "unmatched_frames": s.get("unmatched_frames", 0),
+        "unmatched_samples": s.get("unmatched_samples", 0),
+        "mb_per_s": w.get("mb_written", 0.0) / elapsed if elapsed > 0 else 0.0,
+    }
+
+
+def print_result(r):
+    print(
+        f"{r['format']:>9}: {r['fps']:7.1f} fps, {r['mb_per_s']:7.1f} MB/s "
+        f"({r['mb_on_disk']:.0f} MB on disk) | written {r['frames_written']}"
+        f"/{r['frames_generated']}, dropped camera {r['camera_dropped']} "
+        f"writer {r['writer_dropped']}, spilled {r['writer_spilled']}, "
+        f"max queue {r['max_queue_depth']}, unmatched {r['unmatched_frames']} | "
+        f"drain {r['drain_s']:.2f} s"
+    )
+    for cid, c in enumerate(r.get("cameras", [])):
+        print(
+            f"{'':>11}camera {cid}: {c['fps']:7.1f} fps, {c['mb_per_s']:7.1f} MB/s | "
+            f"dropped camera {c['camera_dropped']} writer {c['writer_dropped']}, "
+            f"max queue {c['max_queue_depth']}, unmatched {c['unmatched_frames']}"
+        )
+    for name, h in r["latency"].items():
+        print(
+            f"{'':>11}{name:<24} p50 {h['p50'] * 1e3:7.2f} ms  "
+            f"p99 {h['p99'] * 1e3:7.2f} ms  max {h['max'] * 1e3:7.2f} ms"
+        )
+
+
+def parse_args(argv):
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument(
+        "--resolution",
+        type=lambda s: tuple(int(v) for v in s.lower().split("x")),
+        default=SIM_CAMERA_RESOLUTION,
+        help="Frame size as WxH.",
+    )
+    parser.add_argument("--bits", type=int, default=SIM_CAMERA_BIT_DEPTH)
+    parser.add_argument("--fps", type=float, default=SIM_SAMPLE_RATE_HZ)
+    parser.add_argument("--duration", type=float, default=10.0, help="Seconds per run.")
+    parser.add_argument(
+        "--cameras", type=int, default=1, help="Simulated cameras on the CamTrig line."
+    )
+    parser.add_argument(
+        "--formats", nargs="+", choices=SUPPORTED_FORMATS, default=SUPPORTED_FORMATS
+    )
+    parser.add_argument(
+        "--no-gui", action="store_true", help="Recorder only (no preview or plot)."
+    )
+    parser.add_argument("--json", help="Also write the results to this file.")
+    parser.add_argument("--keep", action="store_true", help="Keep the recordings.")
+    return parser.parse_args(argv)
+
+
+def main(argv=None):
+    args = parse_args(sys.argv[1:] if argv is None else argv)
+
+    if args.no_gui:
+        from PyQt5.QtCore import QCoreApplication
+
+        app = QCoreApplication(sys.argv[:1])
+        view = None
+    else:
+        os.environ.setdefault("QT_QPA_PLATFORM", "offscreen")
+        from PyQt5.QtWidgets import QApplication
+
+        app = QApplication(sys.argv[:1])
+        view = LiveView()
+
+    root = tempfile.mkdtemp(prefix="prim_bench_")
+    w, h = args.resolution
+    print(
+        f"Pipeline benchmark: {w}×{h} @ {args.bits} bit, {args.fps:g} fps, "
+        f"{args.duration:g} s per format, {args.cameras} camera(s), "
+        f"live view {'off' if view is None else 'on'}"
+    )
+    results = []
+    try:
+        for fmt in args.formats:
+            result = run_case(fmt, args, root, view)
+            print_result(result)
+            results.append(result)
+    finally:
+        if args.keep:
+            print(f"Recordings kept in {root}")
+        else:
+            shutil.rmtree(root, ignore_errors=True)
+
+    if args.json:
+        with open(args.json, "w", encoding="utf-8") as f:
+            json.dump({"args": vars(args), "results": results}, f, indent=2)
+    app.quit()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
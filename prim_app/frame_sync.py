@@ -0,0 +1,313 @@
+# prim_app/frame_sync.py
+
+import collections
+import itertools
+import logging
+import time
+
+from utils.config import (
+    SYNC_LOCK_TOLERANCE_S,
+    SYNC_MATCH_TIMEOUT_S,
+    SYNC_ZERO_COPY_FRAMES,
+    SYNC_MAX_SKEW_S,
+)
+
+log = logging.getLogger(__name__)
+
+
+class _PendingFrame:
+    __slots__ = ("frame", "key", "sample")
+
+    def __init__(self, frame, key):
+        self.frame = frame
+        self.key = key
+        self.sample = None
+
+
+class FrameSyncEngine:
+    """
+    Pairs camera frames with Arduino samples instead of relying on Qt signal
+    arrival order.
+
+    With ``counter_pairing`` (camera in hardware-trigger mode) every CamTrig
+    pulse produces one Arduino sample (``frameIdx``) and one camera exposure
+    (IC4 ``device_frame_number``).  The two counters differ by a constant
+    offset, which is locked once: the first sample is paired with the frame
+    whose host arrival time is closest (within SYNC_LOCK_TOLERANCE_S).  From
+    then on a frame matches the sample with ``frameIdx == frame_number -
+    offset`` regardless of which path delivers first or how far either queue
+    backs up; camera drops leave gaps in the frame numbers and therefore stay
+    aligned.  Frames that arrive before the lock (idle frames before the
+    first pulse) are passed on unmatched and counted in ``pre_trigger_frames``.
+    Each matched pair is additionally checked against the device clocks: the
+    camera timestamp interval since the previous pair must agree with the
+    Arduino ``deviceTime`` interval within SYNC_MAX_SKEW_S.
+
+    Without it the camera free-runs and its counter has no fixed relation to
+    ``frameIdx``, so each frame gets the sample nearest to it in host time
+    (within SYNC_LOCK_TOLERANCE_S), decided once a sample at or after the
+    frame's arrival is in or SYNC_MATCH_TIMEOUT_S has passed.  A sample may
+    go to several frames when the camera runs faster than the device.
+
+    Frames are handed to ``on_pair(frame, sample)`` in arrival order, where
+    ``sample`` is a PRESSURE_RECORD_DTYPE row or None for an unmatched frame.
+    The callback takes over the frame reference.  Not thread-safe: all calls
+    come from the recorder's thread.
+    """
+
+    def __init__(
+        self,
+        on_pair,
+        match_timeout_s=SYNC_MATCH_TIMEOUT_S,
+        lock_tolerance_s=SYNC_LOCK_TOLERANCE_S,
+        zero_copy_frames=SYNC_ZERO_COPY_FRAMES,
+        max_skew_s=SYNC_MAX_SKEW_S,
+        counter_pairing=True,
+    ):
+        self._on_pair = on_pair
+        self.counter_pairing = bool(counter_pairing)
+        self.match_timeout_s = match_timeout_s
+        self.lock_tolerance_s = lock_tolerance_s
+        self.zero_copy_frames = max(0, int(zero_copy_frames))
+        self.max_skew_s = max_skew_s
+
+        self.offset = None  # camera frame number - Arduino frameIdx
+        self._frames = collections.deque()  # _PendingFrame in arrival order
+        self._frames_by_key = {}
+        self._samples = collections.OrderedDict()  # frameIdx -> row (unlocked/unseen)
+        self._recent = collections.deque()  # [row, used] by host time (no counters)
+        self._arrival_counter = 0  # stand-in when a frame has no frame number
+        self._last_pair_clock = None  # (camera_ts_ns, deviceTime) of last match
+
+        self.matched = 0
+        self.unmatched_frames = 0
+        self.unmatched_samples = 0
+        self.pre_trigger_frames = 0
+        self.skew_violations = 0
+
+    # ─── Input ──────────────────────────────────────────────────────────
+    def add_samples(self, block):
+        """Add a PRESSURE_RECORD_DTYPE block (or 1-row array) of samples."""
+        if not self.counter_pairing:
+            self._recent.extend([row, False] for row in block)
+            self.poll()
+            return
+        for row in block:
+            idx = int(row["frameIdx"])
+            pending = self._frames_by_key.get(idx) if self.offset is not None else None
+            if pending is not None and pending.sample is None:
+                self._match(pending, row)
+            else:
+                self._samples[idx] = row
+        if self.offset is None:
+            self._try_lock()
+        self.poll()
+
+    def add_frame(self, frame):
+        """Queue a CameraFrame (ownership of one reference passes to the engine)."""
+        if not self.counter_pairing:
+            self._frames.append(_PendingFrame(frame, None))
+            self._limit_pinned_buffers()
+            self.poll()
+            return
+        number = frame.frame_number
+        if number is None or number < 0:
+            number = self._arrival_counter
+        self._arrival_counter += 1
+
+        key = number - self.offset if self.offset is not None else None
+        pending = _PendingFrame(frame, key)
+        self._frames.append(pending)
+        if key is not None:
+            self._frames_by_key[key] = pending
+            row = self._samples.pop(key, None)
+            if row is not None:
+                self._match(pending, row)
+        else:
+            pending.key = number  # raw number until the offset is known
+            self._try_lock()
+
+        self._limit_pinned_buffers()
+        self.poll()
+
+    # ─── Offset lock ────────────────────────────────────────────────────
+    def _try_lock(self):
+        if not self._samples or not self._frames:
+            return
+        first_idx, first = next(iter(self._samples.items()))
+        t_sample = float(first["hostTime"])
+
+        # Frames from well before the first sample are pre-trigger idle frames
+        while self._frames and (
+            self._frames[0].frame.host_timestamp < t_sample - self.lock_tolerance_s
+        ):
+            self._emit_pre_trigger()
+        if not self._frames:
+            return
+
+        best = min(self._frames, key=lambda pf: abs(pf.frame.host_timestamp - t_sample))
+        if abs(best.frame.host_timestamp - t_sample) > self.lock_tolerance_s:
+            return  # wait for a closer frame (or for the sample to expire)
+
+        # Frames that arrived before the chosen one were not triggered by
+        # the acquisition
+        while self._frames[0] is not best:
+            self._emit_pre_trigger()
+
+        self.offset = best.key - first_idx
+        log.info(
+            f"FrameSyncEngine: locked offset {self.offset} "
+            f"(camera frame {best.key} ↔ Arduino frameIdx {first_idx})"
+        )
+        for pf in self._frames:
+            pf.key -= self.offset
+            self._frames_by_key[pf.key] = pf
+            row = self._samples.pop(pf.key, None)
+            if row is not None:
+                self._match(pf, row)
+
+    def _emit_pre_trigger(self):
+        """Pass the oldest frame on unmatched; it arrived before the lock."""
+        stale = self._frames.popleft()
+        self.pre_trigger_frames += 1
+        self._on_pair(stale.frame, None)
+
+    # ─── Matching / output ──────────────────────────────────────────────
+    def _match(self, pending, row):
+        pending.sample = row
+        self.matched += 1
+
+        cam_ts = pending.frame.device_timestamp_ns
+        dev_t = float(row["deviceTime"])
+        if cam_ts and self._last_pair_clock is not None:
+            last_cam, last_dev = self._last_pair_clock
+            skew = (dev_t - last_dev) - (cam_ts - last_cam) * 1e-9
+            if abs(skew) > self.max_skew_s:
+                self.skew_violations += 1
+                if self.skew_violations <= 10:
+                    log.warning(
+                        f"FrameSyncEngine: interval skew {skew * 1e3:.2f} ms at "
+                        f"frameIdx {int(row['frameIdx'])} (camera free-running?)"
+                    )
+        if cam_ts:
+            self._last_pair_clock = (cam_ts, dev_t)
+
+    def _emit_head(self, now, force):
+        while self._frames:
+            head = self._frames[0]
+            waited = now - head.frame.host_timestamp
+            if head.sample is None and not force and waited < self.match_timeout_s:
+                break
+            self._frames.popleft()
+            if self._frames_by_key.get(head.key) is head:
+                del self._frames_by_key[head.key]
+            if head.sample is None:
+                self.unmatched_frames += 1
+            self._on_pair(head.frame, head.sample)
+
+    def _pair_by_time(self, now, force):
+        """Free-running camera: nearest sample in host time for each frame."""
+        while self._frames:
+            head = self._frames[0]
+            t = head.frame.host_timestamp
+            newest = float(self._recent[-1][0]["hostTime"]) if self._recent else None
+            if (
+                not force
+                and now - t < self.match_timeout_s
+                and (newest is None or newest < t)
+            ):
+                break  # a closer sample may still be on its way
+            # Samples before the last one at or before ``t`` cannot be the
+            # nearest for this frame or any later one
+            while len(self._recent) > 1 and float(self._recent[1][0]["hostTime"]) <= t:
+                self._drop_recent()
+            best = None
+            for entry in itertools.islice(self._recent, 2):
+                dt = abs(float(entry[0]["hostTime"]) - t)
+                if dt <= self.lock_tolerance_s and (best is None or dt < best[0]):
+                    best = (dt, entry)
+            self._frames.popleft()
+            if best is None:
+                self.unmatched_frames += 1
+                self._on_pair(head.frame, None)
+            else:
+                best[1][1] = True
+                self.matched += 1
+                self._on_pair(head.frame, best[1][0])
+        horizon = now - self.match_timeout_s - self.lock_tolerance_s
+        while self._recent and (
+            force or float(self._recent[0][0]["hostTime"]) < horizon
+        ):
+            self._drop_recent()
+
+    def _drop_recent(self):
+        _, used = self._recent.popleft()
+        if not used:
+            self.unmatched_samples += 1
+
+    def _expire_samples(self, now, force):
+        while self._samples:
+            idx, row = next(iter(self._samples.items()))
+            if not force and now - float(row["hostTime"]) < self.match_timeout_s:
+                break
+            del self._samples[idx]
+            self.unmatched_samples += 1
+
+    def _limit_pinned_buffers(self):
+        """Copy the oldest waiting frames so the camera ring is not starved."""
+        pinned = [pf for pf in self._frames if pf.frame.holds_buffer]
+        for pf in pinned[: max(0, len(pinned) - self.zero_copy_frames)]:
+            original = pf.frame
+            copy = original.copy()
+            if copy is None:
+                # Memory budget exhausted: keep the IC4 buffer rather than
+                # lose the frame; the camera ring is the limit from here on
+                break
+            pf.frame = copy
+            original.release()
+
+    def poll(self, now=None):
+        """Emit resolved/expired frames and expire stale samples."""
+        now = time.time() if now is None else now
+        if not self.counter_pairing:
+            self._pair_by_time(now, force=False)
+            return
+        if self.offset is None:
+            # Before the lock nothing can be paired; frames that waited out
+            # the timeout belong to the idle period before the trigger
+            while self._frames and (
+                now - self._frames[0].frame.host_timestamp >= self.match_timeout_s
+            ):
+                self._emit_pre_trigger()
+        else:
+            self._emit_head(now, force=False)
+        if self.offset is not None or not self._frames:
+            self._expire_samples(now, force=False)
+        elif self._samples:
+            first = next(iter(self._samples.values()))
+            if now - float(first["hostTime"]) >= self.match_timeout_s:
+                # No frame ever came close to this sample; try the next one
+                self._samples.popitem(last=False)
+                self.unmatched_samples += 1
+                self._try_lock()
+
+    def flush(self):
+        """Emit everything still pending (at the end of a recording)."""
+        if not self.counter_pairing:
+            self._pair_by_time(time.time(), force=True)
+            return
+        self._emit_head(time.time(), force=True)
+        self._expire_samples(time.time(), force=True)
+
+    def stats(self):
+        return {
+            "offset": self.offset,
+            "counter_pairing": self.counter_pairing,
+            "matched": self.matched,
+            "unmatched_frames": self.unmatched_frames,
+            "unmatched_samples": self.unmatched_samples,
+            "pre_trigger_frames": self.pre_trigger_frames,
+            "skew_violations": self.skew_violations,
+            "pending_frames": len(self._frames),
+            "pending_samples": len(self._samples) + len(self._recent),
+        }
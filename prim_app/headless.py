@@ -0,0 +1,377 @@
+# prim_app/headless.py
+
+import json
+import logging
+import signal
+import sys
+import time
+
+from PyQt5.QtCore import QObject, QThread, QTimer, QMetaObject, Qt, pyqtSlot
+
+from recording_manager import RecordingManager
+from threads.serial_thread import SerialThread
+from threads.simulated_sources import SimulatedCameraThread, SimulatedSerialThread
+from utils.config import (
+    DEFAULT_FPS,
+    DEFAULT_SERIAL_BAUD_RATE,
+    DEFAULT_RECORDING_FORMAT,
+    PRETRIGGER_SECONDS,
+    SERIAL_PROTOCOL,
+    HEADLESS_STATUS_INTERVAL_S,
+)
+from utils.path_helpers import get_next_fill_folder
+
+log = logging.getLogger(__name__)
+
+# Settings understood in a --config JSON file (command line flags win)
+DEFAULTS = {
+    # Serial number, model name or index; first device if None.  A list (or
+    # "A,B" on the command line) records one stream per camera, all on the
+    # same CamTrig line; with simulate only its length matters.
+    "camera": None,
+    "resolution": None,  # "WxH"; the device's current size if None
+    "pixel_format": None,  # e.g. "Mono16"; the device's current format if None
+    "fps": DEFAULT_FPS,
+    "roi": None,  # "X,Y,W,H" hardware capture ROI in sensor px; full sensor if None
+    "binning": 1,
+    "serial_port": None,
+    "baud": DEFAULT_SERIAL_BAUD_RATE,
+    "protocol": SERIAL_PROTOCOL,
+    "output_dir": None,  # next PRIM_ROOT/YYYY-MM-DD/FillN if None
+    "format": DEFAULT_RECORDING_FORMAT,
+    "duration": None,  # seconds; run until Ctrl+C if None
+    "pretrigger": PRETRIGGER_SECONDS,
+    "simulate": False,  # synthetic camera + PRIM device instead of hardware
+}
+
+
+def load_headless_config(path, overrides):
+    """Merge DEFAULTS, the JSON file at ``path`` (optional) and non-None ``overrides``."""
+    settings = dict(DEFAULTS)
+    if path:
+        with open(path, "r", encoding="utf-8") as f:
+            data = json.load(f)
+        unknown = set(data) - set(DEFAULTS)
+        if unknown:
+            log.warning(f"Headless config: ignoring unknown keys {sorted(unknown)}")
+        settings.update({k: v for k, v in data.items() if k in DEFAULTS})
+    settings.update({k: v for k, v in overrides.items() if v is not None})
+    return settings
+
+
+class HeadlessSession(QObject):
+    """
+    Camera + PRIM device + recorder without any widgets: no preview
+    conversion, plotting or console output.  Starts the recording as soon as
+    the camera stream is up and stops after ``duration`` seconds or on
+    Ctrl+C, printing a one-line status every HEADLESS_STATUS_INTERVAL_S.
+    With several cameras the recording starts once every stream is up.
+    """
+
+    def __init__(self, settings, app, parent=None):
+        super().__init__(parent)
+        self.settings = settings
+        self.app = app
+        self.exit_code = 0
+
+        self.camera_threads = []  # index = camera_id
+        self.serial_thread = None
+        self.recorder_thread = None
+        self.recorder = None
+        self._stopping = False
+        self._started_at = None
+
+        self._grabbers_ready = set()
+        # Latest stats per camera_id
+        self._camera_stats = {}
+        self._writer_stats = {}
+        self._sync_stats = {}
+        self._last_sample = None
+        self._last_processed = {}  # camera_id -> (processed, monotonic time)
+
+        self._status_timer = QTimer(self)
+        self._status_timer.setInterval(int(HEADLESS_STATUS_INTERVAL_S * 1000))
+        self._status_timer.timeout.connect(self._print_status)
+
+    # ─── Setup ──────────────────────────────────────────────────────────
+    def _wanted_cameras(self):
+        wanted = self.settings["camera"]
+        if wanted is None:
+            return [None]
+        if isinstance(wanted, str):
+            wanted = [w.strip() for w in wanted.split(",") if w.strip()]
+        elif not isinstance(wanted, (list, tuple)):
+            wanted = [wanted]
+        return list(wanted) or [None]
+
+    def _find_device(self, wanted):
+        import imagingcontrol4 as ic4
+
+        devices = ic4.DeviceEnum.devices()
+        if not devices:
+            raise RuntimeError("No IC4 camera found.")
+        if wanted is None:
+            return devices[0]
+        if str(wanted).isdigit() and int(wanted) < len(devices):
+            return devices[int(wanted)]
+        for dev in devices:
+            if str(wanted) in (dev.serial, dev.model_name):
+                return dev
+        raise RuntimeError(
+            f"Camera {wanted!r} not found; available: "
+            + ", ".join(f"{d.model_name} (S/N {d.serial})" for d in devices)
+        )
+
+    def _resolution_tuple(self):
+        res, pf = self.settings["resolution"], self.settings["pixel_format"]
+        if not res or not pf:
+            return None
+        w, h = (int(v) for v in str(res).lower().split("x"))
+        return (w, h, pf)
+
+    def _capture_roi(self):
+        roi, binning = self.settings["roi"], int(self.settings["binning"] or 1)
+        if not roi and binning <= 1:
+            return None
+        x, y, w, h = (int(v) for v in str(roi).split(",")) if roi else (0, 0, None, None)
+        return {
+            "x": x,
+            "y": y,
+            "width": w,
+            "height": h,
+            "binning": binning,
+            "max_frame_rate": False,  # --fps stays authoritative
+        }
+
+    def start(self):
+        simulate = bool(self.settings["simulate"])
+        if not simulate and not self.settings["serial_port"]:
+            raise RuntimeError("Headless mode needs a serial port (--serial-port).")
+
+        if not simulate:
+            # IC4 only on the hardware path: --simulate runs without the driver
+            from threads.sdk_camera_thread import SDKCameraThread
+
+        resolution = self._resolution_tuple()
+        for camera_id, wanted in enumerate(self._wanted_cameras()):
+            if simulate:
+                log.info(f"Headless: simulated camera {camera_id}")
+                camera = SimulatedCameraThread(triggered=True, camera_id=camera_id)
+            else:
+                dev_info = self._find_device(wanted)
+                log.info(
+                    f"Headless: camera {camera_id} = {dev_info.model_name} "
+                    f"(S/N {dev_info.serial})"
+                )
+                camera = SDKCameraThread(camera_id=camera_id)
+                camera.set_device_info(dev_info)
+            if resolution:
+                camera.set_resolution(resolution)
+            camera.set_frame_rate(self.settings["fps"])
+            camera.set_capture_roi(self._capture_roi())
+            camera.set_preview_enabled(False)
+            camera.grabber_ready.connect(
+                lambda cid=camera_id: self._on_grabber_ready(cid)
+            )
+            camera.error.connect(self._on_camera_error)
+            camera.stats_updated.connect(self._on_camera_stats)
+            self.camera_threads.append(camera)
+
+        if simulate:
+            log.info("Headless: simulated PRIM device")
+            self.serial_thread = SimulatedSerialThread(
+                rate_hz=float(self.settings["fps"]), camera=self.camera_threads
+            )
+        else:
+            self.serial_thread = SerialThread(
+                port=self.settings["serial_port"],
+                baud=int(self.settings["baud"]),
+                protocol=self.settings["protocol"],
+            )
+        self.serial_thread.error_occurred.connect(
+            lambda msg: log.error(f"Headless: serial error: {msg}")
+        )
+        self.serial_thread.status_changed.connect(
+            lambda msg: log.info(f"Headless: PRIM device: {msg}")
+        )
+        self.serial_thread.samples_ready.connect(self._on_samples)
+
+        self.serial_thread.start()
+        for camera in self.camera_threads:
+            camera.start()
+
+    def _on_grabber_ready(self, camera_id):
+        """
+        Every camera is open: start the recorder (it triggers the Arduino
+        when ready).
+        """
+        self._grabbers_ready.add(camera_id)
+        if len(self._grabbers_ready) < len(self.camera_threads):
+            return
+        if self.recorder is not None or self._stopping:
+            return
+        outdir = self.settings["output_dir"] or get_next_fill_folder()
+
+        self.recorder_thread = QThread()
+        self.recorder = RecordingManager(
+            output_dir=outdir,
+            recording_format=self.settings["format"],
+            pretrigger_s=float(self.settings["pretrigger"]),
+            cameras={c.camera_id: c.capture_geometry for c in self.camera_threads},
+            trigger_modes={c.camera_id: c.trigger_mode for c in self.camera_threads},
+        )
+        self.recorder.moveToThread(self.recorder_thread)
+        self.recorder_thread.started.connect(self.recorder.start_recording)
+        self.recorder.finished.connect(self.recorder_thread.quit)
+        self.recorder.finished.connect(self._on_recorder_finished)
+        self.recorder.ready_for_acquisition.connect(self._on_recorder_ready)
+        self.recorder.writer_stats.connect(self._on_writer_stats)
+        self.recorder.sync_stats.connect(self._on_sync_stats)
+        self.recorder.writer_failed.connect(self._on_writer_failed)
+
+        self.serial_thread.samples_ready.connect(self.recorder.append_pressure_block)
+        if getattr(self.serial_thread, "dsp", None) is not None:
+            self.serial_thread.processed_ready.connect(
+                self.recorder.append_processed_block
+            )
+        for camera in self.camera_threads:
+            camera.frame_ready.connect(self.recorder.append_frame)
+
+        self.recorder_thread.start()
+        self._started_at = time.monotonic()
+        self._status_timer.start()
+        log.info(f"Headless: recording into {outdir}")
+
+        duration = self.settings["duration"]
+        if duration:
+            QTimer.singleShot(int(float(duration) * 1000), self.stop)
+
+    @pyqtSlot()
+    def _on_recorder_ready(self):
+        self.serial_thread.send_command("G")
+
+    # ─── Status ─────────────────────────────────────────────────────────
+    @pyqtSlot(object)
+    def _on_samples(self, block):
+        if len(block):
+            self._last_sample = block[-1]
+
+    @pyqtSlot(dict)
+    def _on_camera_stats(self, stats):
+        self._camera_stats[stats.get("camera_id", 0)] = stats
+
+    @pyqtSlot(dict)
+    def _on_writer_stats(self, stats):
+        self._writer_stats[stats.get("camera_id", 0)] = stats
+
+    @pyqtSlot(dict)
+    def _on_sync_stats(self, stats):
+        self._sync_stats[stats.get("camera_id", 0)] = stats
+
+    def _print_status(self):
+        """One line per camera: camera fps/drops, writer and sync of its stream."""
+        now = time.monotonic()
+        pressure = (
+            f"{float(self._last_sample['pressure']):.2f}"
+            if self._last_sample is not None
+            else "–"
+        )
+        for camera in self.camera_threads:
+            cid = camera.camera_id
+            c = self._camera_stats.get(cid, {})
+            processed = c.get("processed", 0)
+            last_count, last_time = self._last_processed.get(cid, (0, self._started_at))
+            fps = (processed - last_count) / max(now - last_time, 1e-6)
+            self._last_processed[cid] = (processed, now)
+
+            w, s = self._writer_stats.get(cid, {}), self._sync_stats.get(cid, {})
+            label = "camera" if len(self.camera_threads) == 1 else f"camera {cid}"
+            print(
+                f"[{now - self._started_at:8.1f} s] {label} {fps:5.1f} fps "
+                f"(dropped {c.get('dropped', 0)}) | "
+                f"writer {w.get('written', 0)} written, queue {w.get('queue_depth', 0)}/"
+                f"{w.get('queue_size', 0)}, {w.get('mb_per_s', 0.0):.1f} MB/s, "
+                f"dropped {w.get('dropped', 0)} | "
+                f"sync {s.get('matched', 0)} matched, {s.get('unmatched_frames', 0)} "
+                f"unmatched | P={pressure}",
+                flush=True,
+            )
+
+    # ─── Shutdown ───────────────────────────────────────────────────────
+    @pyqtSlot(int, str, bool)
+    def _on_writer_failed(self, camera_id, msg, any_left):
+        log.error(f"Headless: writer of camera {camera_id} failed: {msg}")
+        self.exit_code = 1
+        if not any_left:
+            self.stop()
+
+    @pyqtSlot(str, str)
+    def _on_camera_error(self, msg, code):
+        log.error(f"Headless: camera error {code}: {msg}")
+        self.exit_code = 1
+        self.stop()
+
+    @pyqtSlot()
+    def stop(self):
+        if self._stopping:
+            return
+        self._stopping = True
+        self._status_timer.stop()
+        log.info("Headless: stopping…")
+
+        if self.recorder is None:
+            self._shutdown_threads()
+            return
+
+        if self.serial_thread is not None:
+            self.serial_thread.send_command("S")
+            try:
+                self.serial_thread.samples_ready.disconnect(
+                    self.recorder.append_pressure_block
+                )
+            except Exception:
+                pass
+        for camera in self.camera_threads:
+            try:
+                camera.frame_ready.disconnect(self.recorder.append_frame)
+            except Exception:
+                pass
+        QMetaObject.invokeMethod(self.recorder, "stop_recording", Qt.QueuedConnection)
+
+    @pyqtSlot()
+    def _on_recorder_finished(self):
+        if self._started_at is not None:
+            self._print_status()
+        self._shutdown_threads()
+
+    def _shutdown_threads(self):
+        if self.recorder_thread is not None:
+            self.recorder_thread.wait(5000)
+        for camera in self.camera_threads:
+            camera.stop()
+            camera.wait(5000)
+        if self.serial_thread is not None:
+            self.serial_thread.stop()
+        self.app.exit(self.exit_code)
+
+
+def run_headless(app, settings):
+    """Run a HeadlessSession on ``app`` (a QCoreApplication); returns the exit code."""
+    session = HeadlessSession(settings, app)
+
+    # Ctrl+C: Python only runs signal handlers between bytecodes, so a idle
+    # timer keeps the interpreter ticking inside the Qt event loop
+    signal.signal(signal.SIGINT, lambda *_: QTimer.singleShot(0, session.stop))
+    tick = QTimer()
+    tick.timeout.connect(lambda: None)
+    tick.start(200)
+
+    try:
+        session.start()
+    except Exception as e:
+        log.error(f"Headless: {e}")
+        print(f"Headless start failed: {e}", file=sys.stderr)
+        session.stop()
+        return 1
+
+    return app.exec_()
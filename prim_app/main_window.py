@@ -6,8 +6,8 @@ import re
 import logging
 import csv
 import json
+import time
 from datetime import datetime
-import imagingcontrol4 as ic4
 
 from PyQt5.QtWidgets import (
     QApplication,
@@ -18,13 +18,14 @@ from PyQt5.QtWidgets import (
     QSplitter,
     QFormLayout,
     QDockWidget,
-    QTextEdit,
     QToolBar,
     QStatusBar,
     QAction,
     QFileDialog,
     QDialog,
     QDialogButtonBox,
+    QInputDialog,
+    QProgressDialog,
     QLineEdit,
     QComboBox,
     QLabel,
@@ -36,6 +37,7 @@ from PyQt5.QtWidgets import (
     QDoubleSpinBox,
     QCheckBox,
     QHBoxLayout,
+    QActionGroup,
 )
 from PyQt5.QtCore import (
     Qt,
@@ -54,6 +56,11 @@ from utils.app_settings import (
     save_app_setting,
     load_app_setting,
     SETTING_LAST_CAMERA_INDEX,
+    SETTING_LAST_PROFILE_NAME,
+    SETTING_RECORDING_FORMAT,
+    SETTING_PLOT_BACKEND,
+    SETTING_TRIGGER_MODE,
+    SETTING_TRIGGER_RATE_HZ,
 )
 from utils.config import (
     DEFAULT_FPS,
@@ -66,24 +73,73 @@ from utils.config import (
     ABOUT_TEXT,
     PLOT_DEFAULT_Y_MIN,
     PLOT_DEFAULT_Y_MAX,
+    SUPPORTED_FORMATS,
+    DEFAULT_RECORDING_FORMAT,
+    PLOT_BACKEND,
+    PLOT_BACKENDS,
+    PRETRIGGER_SECONDS,
+    MAX_CAMERAS,
+    DSP_PLOT_CHANNEL,
+    DSP_SOFTWARE_ZERO,
+    MEMORY_GAUGE_WARN_FRACTION,
+    CAMERA_TRIGGER_MODE,
+    RECORDER_STOP_TIMEOUT_S,
+    RECORDER_STOP_S_PER_FRAME,
 )
 from utils.path_helpers import get_next_fill_folder
 from ui.canvas.qtcamera_widget import QtCameraWidget
+from ui.camera_dock import CameraDock
+from ui.review_dock import ReviewDock
+from ui.export_dialog import ExportDialog
 from ui.control_panels.camera_control_panel import CameraControlPanel
 from ui.control_panels.top_control_panel import TopControlPanel
 from ui.control_panels.plot_control_panel import PlotControlPanel
-from ui.canvas.pressure_plot_widget import PressurePlotWidget
+from ui.control_panels.telemetry_panel import TelemetryPanel
+from ui.canvas.plot_backends import create_pressure_plot_widget
+from ui.refresh_scheduler import UiRefreshScheduler
+from ui.console_log import ConsoleLogWidget
 
 from threads.serial_thread import SerialThread
-from threads.sdk_camera_thread import SDKCameraThread
+from threads.device_enumerator import DeviceEnumerator
+from threads.camera_properties import list_profiles, load_profile
+from threads.diameter_tracker import DiameterTracker, mean_per_frame
+from threads.frame_pool import frame_pool
+from threads.export_thread import ExportThread
+from threads.rate_calibrator import RateCalibrator
 from recording_manager import RecordingManager
-from utils.utils import list_serial_ports
+from writers.recording_index import find_recordings
 
 log = logging.getLogger(__name__)
 
+# (worker, thread) of recorders still writing when the window closed: detached
+# from the window so its destruction does not destroy a running QThread, and
+# referenced here until they finish (see wait_for_detached_recorders)
+_detached_recorders = []
+
+
+def wait_for_detached_recorders():
+    """
+    Let recorders detached by MainWindow.closeEvent finish writing before the
+    process exits.  Called after the event loop has ended, so events are
+    pumped here for the worker's queued ``finished`` → ``quit``.
+    """
+    if _detached_recorders:
+        log.info("Waiting for the recorder to finish writing before exiting…")
+    while _detached_recorders:
+        worker, thread = _detached_recorders[0]
+        try:
+            running = thread.isRunning()
+        except RuntimeError:
+            running = False  # already deleted
+        if not running:
+            _detached_recorders.pop(0)
+            continue
+        QApplication.processEvents()
+        thread.wait(100)
+
 
 class MainWindow(QMainWindow):
-    def __init__(self):
+    def __init__(self, plot_backend=None):
         super().__init__()
 
         # ─── State Variables ─────────────────────────────────────────────────────
@@ -91,6 +147,16 @@ class MainWindow(QMainWindow):
         self._serial_active = False
         self._recorder_thread = None
         self._recorder_worker = None
+        self._recorder_armed = False  # armed and waiting for “Start Recording”
+        self._recording_format = load_app_setting(
+            SETTING_RECORDING_FORMAT, DEFAULT_RECORDING_FORMAT
+        )
+        if self._recording_format not in SUPPORTED_FORMATS:
+            self._recording_format = DEFAULT_RECORDING_FORMAT
+        # Command line flag > saved setting > config default
+        self._plot_backend = plot_backend or load_app_setting(
+            SETTING_PLOT_BACKEND, PLOT_BACKEND
+        )
 
         # Camera‐related
         self.device_combo = None
@@ -100,6 +166,18 @@ class MainWindow(QMainWindow):
         self.camera_control_panel = None
         self.camera_tabs = None
         self.camera_thread = None  # SDKCameraThread instance
+        self._capture_roi = None  # Applied at the next camera start
+        self._device_enumerator = None  # Background camera/serial port scan
+        self._camera_devices = []  # ic4.DeviceInfo list from the last scan
+        # Additional cameras (camera_id >= 1) recorded next to camera_thread
+        self._camera_docks = {}  # camera_id -> CameraDock
+        self._recorded_cameras = []  # camera threads connected to the recorder
+        self._review_dock = None  # ReviewDock of a finished recording
+        self._export_thread = None  # ExportThread of a running export
+        self._export_progress = None
+        self._calibrator = None  # RateCalibrator of a running calibration
+        self._calibrator_thread = None
+        self._calibration_progress = None
 
         # Plot controls
         self.plot_control_panel = None
@@ -114,6 +192,7 @@ class MainWindow(QMainWindow):
         self.lbl_cam_connection = None
         self.lbl_cam_frame = None
         self.lbl_cam_resolution = None
+        self.lbl_cam_buffers = None
 
         # ─── CREATE THE RECORDER THREAD + WORKER ─────────────────────────────────
         # 1) Instantiate the thread object:
@@ -138,7 +217,27 @@ class MainWindow(QMainWindow):
         self._build_main_toolbar()
         self._build_status_bar()
 
-        # Populate device list so user can select camera
+        # ─── Live-view refresh scheduler ─────────────────────────────────────
+        # Camera frames and serial samples reach the widgets through this
+        # rate limiter; the recorder is connected to the threads directly.
+        self.ui_refresh = UiRefreshScheduler(parent=self)
+        self.ui_refresh.samples_ready.connect(self._handle_new_serial_block)
+        self.ui_refresh.processed_ready.connect(self._handle_processed_block)
+        self.ui_refresh.frame_ready.connect(self.camera_widget._on_frame_ready)
+        self.ui_refresh.start()
+
+        # ─── Live diameter tracking ──────────────────────────────────────────
+        # Off the GUI thread; fed straight from the camera while tracking is on
+        self._diameter_thread = QThread(self)
+        self.diameter_tracker = DiameterTracker()
+        self.diameter_tracker.moveToThread(self._diameter_thread)
+        self.diameter_tracker.diameters_ready.connect(self._handle_diameter_block)
+        self.camera_widget.lines_changed.connect(self.diameter_tracker.set_rois)
+        self.camera_widget.rect_drawn.connect(self._on_capture_rect_drawn)
+        self._diameter_thread.start()
+
+        # Cameras and serial ports are found in the background (this also
+        # loads and initializes IC4) so the window is usable straight away
         self._populate_device_list()
         self._set_initial_control_states()
 
@@ -185,15 +284,25 @@ class MainWindow(QMainWindow):
         self.dock_console.setAllowedAreas(
             Qt.BottomDockWidgetArea | Qt.TopDockWidgetArea
         )
-        console_widget = QWidget()
-        layout = QVBoxLayout(console_widget)
-        self.console_out_textedit = QTextEdit(readOnly=True)
-        self.console_out_textedit.setFontFamily("monospace")
-        layout.addWidget(self.console_out_textedit)
-        self.dock_console.setWidget(console_widget)
+        # Ring-buffered list view; Python logging is routed here as well
+        self.console_log = ConsoleLogWidget()
+        self.console_log.install()
+        self.dock_console.setWidget(self.console_log)
         self.addDockWidget(Qt.BottomDockWidgetArea, self.dock_console)
         self.dock_console.setVisible(False)
 
+        # Pipeline latency/throughput counters, tabbed with the console
+        self.dock_stats = QDockWidget("Pipeline Stats", self)
+        self.dock_stats.setObjectName("PipelineStatsDock")
+        self.dock_stats.setAllowedAreas(
+            Qt.BottomDockWidgetArea | Qt.TopDockWidgetArea
+        )
+        self.telemetry_panel = TelemetryPanel()
+        self.dock_stats.setWidget(self.telemetry_panel)
+        self.addDockWidget(Qt.BottomDockWidgetArea, self.dock_stats)
+        self.tabifyDockWidget(self.dock_console, self.dock_stats)
+        self.dock_stats.setVisible(False)
+
     def _build_central_widget_layout(self):
         """
         Top row: [Camera Info/Controls tabs] [TopControlPanel] [PlotControlPanel]
@@ -231,6 +340,12 @@ class MainWindow(QMainWindow):
         self.lbl_cam_resolution = QLabel("N/A")
         info_layout.addRow("Resolution:", self.lbl_cam_resolution)
 
+        self.lbl_cam_buffers = QLabel("N/A")
+        self.lbl_cam_buffers.setToolTip(
+            "Frames dropped / queued in the buffer ring / ring size"
+        )
+        info_layout.addRow("Dropped / Queue:", self.lbl_cam_buffers)
+
         self.device_combo = QComboBox()
         self.device_combo.addItem("Select Device...", None)
         self.device_combo.currentIndexChanged.connect(self._on_device_selected)
@@ -240,6 +355,13 @@ class MainWindow(QMainWindow):
         self.resolution_combo.addItem("Select Resolution…", None)
         info_layout.addRow("Resolution:", self.resolution_combo)
 
+        # Camera profile applied in one batch before streaming starts
+        self.profile_combo = QComboBox()
+        self.profile_combo.setToolTip("Saved exposure/gain/frame rate settings")
+        self._populate_profile_combo(load_app_setting(SETTING_LAST_PROFILE_NAME))
+        self.profile_combo.currentIndexChanged.connect(self._on_profile_selected)
+        info_layout.addRow("Profile:", self.profile_combo)
+
         self.btn_start_camera = QPushButton("Start Camera")
         self.btn_start_camera.clicked.connect(self._on_start_stop_camera)
         info_layout.addRow("", self.btn_start_camera)
@@ -255,6 +377,16 @@ class MainWindow(QMainWindow):
         # Instantiate CameraControlPanel here (disabled by default)
         self.camera_control_panel = CameraControlPanel(parent=self)
         self.camera_control_panel.setEnabled(False)
+        self.camera_control_panel.preview_settings_changed.connect(
+            self._on_preview_settings_changed
+        )
+        self.camera_control_panel.capture_roi_requested.connect(
+            self._on_capture_roi_requested
+        )
+        self.camera_control_panel.roi_draw_requested.connect(
+            self._on_roi_draw_requested
+        )
+        self.camera_control_panel.profile_saved.connect(self._populate_profile_combo)
         controls_layout.addWidget(self.camera_control_panel)
 
         self.camera_tabs.addTab(controls_tab, "Controls")
@@ -281,7 +413,10 @@ class MainWindow(QMainWindow):
         self.bottom_split.addWidget(self.camera_widget)
 
         # Right: live plot
-        self.pressure_plot_widget = PressurePlotWidget(self)
+        self.pressure_plot_widget, self._plot_backend = create_pressure_plot_widget(
+            self._plot_backend, self
+        )
+        log.info(f"Live plot backend: {self._plot_backend}")
         self.pressure_plot_widget.setSizePolicy(
             QSizePolicy.Expanding, QSizePolicy.Expanding
         )
@@ -329,11 +464,21 @@ class MainWindow(QMainWindow):
 
     # ─── Camera Device & Resolution Enumeration ─────────────────────────────
     def _populate_device_list(self):
-        try:
-            device_list = ic4.DeviceEnum.devices()
-        except Exception as e:
-            log.error(f"Failed to enumerate IC4 devices: {e}")
-            device_list = []
+        """Start a background scan for cameras and serial ports."""
+        if self._device_enumerator is not None and self._device_enumerator.isRunning():
+            return
+        self.device_combo.clear()
+        self.device_combo.addItem("Searching for cameras…", None)
+        self.device_combo.setEnabled(False)
+        self._device_enumerator = DeviceEnumerator(self)
+        self._device_enumerator.devices_ready.connect(self._on_devices_ready)
+        self._device_enumerator.start()
+
+    @pyqtSlot(list, list)
+    def _on_devices_ready(self, device_list, ports):
+        self._populate_serial_ports(ports)
+        self._camera_devices = list(device_list)
+        self.add_camera_action.setEnabled(bool(device_list))
 
         if not device_list:
             log.info("DEBUG: DeviceEnum.devices() returned ZERO devices.")
@@ -343,11 +488,28 @@ class MainWindow(QMainWindow):
                     f"DEBUG: Device {idx} = {dev.model_name!r} (S/N {dev.serial!r})"
                 )
 
+        self.device_combo.blockSignals(True)
         self.device_combo.clear()
         self.device_combo.addItem("Select Device...", None)
         for dev in device_list:
             display_str = f"{dev.model_name}  (S/N: {dev.serial})"
             self.device_combo.addItem(display_str, dev)
+        self.device_combo.blockSignals(False)
+        self.device_combo.setEnabled(True)
+
+    def _populate_serial_ports(self, ports):
+        if self._serial_thread is not None and self._serial_thread.isRunning():
+            return  # Keep the connected port selected
+        self.serial_port_combobox.clear()
+        if ports:
+            for p_dev, p_desc in ports:
+                self.serial_port_combobox.addItem(
+                    f"{os.path.basename(p_dev)} ({p_desc})", QVariant(p_dev)
+                )
+            self.serial_port_combobox.setEnabled(True)
+        else:
+            self.serial_port_combobox.addItem("No Serial Ports Found", QVariant())
+            self.serial_port_combobox.setEnabled(False)
 
     @pyqtSlot(int)
     def _on_device_selected(self, index):
@@ -361,6 +523,15 @@ class MainWindow(QMainWindow):
 
         if not dev_info:
             return
+        for display_str, resdata in self._camera_formats(dev_info):
+            self.resolution_combo.addItem(display_str, resdata)
+
+    @staticmethod
+    def _camera_formats(dev_info):
+        """``[(label, (w, h, pixel_format)), …]`` the device offers."""
+        import imagingcontrol4 as ic4
+
+        formats = []
 
         grab = ic4.Grabber()
         try:
@@ -386,8 +557,7 @@ class MainWindow(QMainWindow):
                         if w_prop and h_prop:
                             w = w_prop.value
                             h = h_prop.value
-                            display_str = f"{w}×{h} ({pf_name})"
-                            self.resolution_combo.addItem(display_str, (w, h, pf_name))
+                            formats.append((f"{w}×{h} ({pf_name})", (w, h, pf_name)))
                     except Exception:
                         # skip any PF that fails
                         pass
@@ -399,6 +569,7 @@ class MainWindow(QMainWindow):
                 grab.device_close()
             except Exception:
                 pass
+        return formats
 
     @pyqtSlot()
     def _on_start_stop_camera(self):
@@ -419,20 +590,36 @@ class MainWindow(QMainWindow):
 
             w, h, pf_name = resdata
 
-            # Instantiate the SDK camera thread
+            # Instantiate the SDK camera thread (IC4 is imported on first use)
+            from threads.sdk_camera_thread import SDKCameraThread
+
             self.camera_thread = SDKCameraThread(parent=self)
             self.camera_thread.set_device_info(dev_info)
             self.camera_thread.set_resolution((w, h, pf_name))
+            self.camera_thread.set_capture_roi(self._capture_roi)
+            self.camera_thread.set_trigger_mode(
+                bool(load_app_setting(SETTING_TRIGGER_MODE, CAMERA_TRIGGER_MODE))
+            )
+            profile = self._selected_profile()
+            if profile:
+                self.camera_thread.set_profile(profile)
 
             # 1) When the grabber is open & streaming, enable the sliders, etc.
             self.camera_thread.grabber_ready.connect(self._on_grabber_ready)
 
-            # 2) Each time a new frame is ready, update the QtCameraWidget
-            self.camera_thread.frame_ready.connect(self.camera_widget._on_frame_ready)
+            # 2) New frames go to the QtCameraWidget at most once per UI tick
+            self.camera_thread.frame_ready.connect(self.ui_refresh.push_frame)
+            if self.track_diameter_action.isChecked():
+                self.camera_thread.frame_ready.connect(
+                    self.diameter_tracker.process_frame
+                )
 
             # 3) On any camera error, pop up a dialog and tear everything down
             self.camera_thread.error.connect(self._on_camera_error)
 
+            # 4) Periodic buffer-ring statistics for the Info tab
+            self.camera_thread.stats_updated.connect(self._on_camera_stats)
+
             # Show “Connecting…” in the Info tab
             self.lbl_cam_connection.setText("Connecting…")
             self.lbl_cam_frame.setText("0")
@@ -445,8 +632,10 @@ class MainWindow(QMainWindow):
 
         else:
             # ─── Stop camera ──────────────────────────────────────────────────
+            self._stop_calibration()
             self.camera_thread.stop()
             self.camera_thread = None
+            self.camera_control_panel.release_grabber()
 
             # Reset UI
             self.btn_start_camera.setText("Start Camera")
@@ -454,7 +643,10 @@ class MainWindow(QMainWindow):
             self.lbl_cam_connection.setText("Disconnected")
             self.lbl_cam_frame.setText("0")
             self.lbl_cam_resolution.setText("N/A")
+            self.lbl_cam_buffers.setText("N/A")
+            self.ui_refresh.discard_frame()
             self.camera_widget.clear_image()
+            self._refresh_recording_button_states()
 
     @pyqtSlot()
     def _on_grabber_ready(self):
@@ -471,18 +663,187 @@ class MainWindow(QMainWindow):
             return
 
         self.camera_control_panel.grabber = grabber
+        self.camera_control_panel.property_cache = self.camera_thread.property_cache
         self.camera_control_panel._on_grabber_ready()
+        self.camera_control_panel.set_preview_settings(
+            self.camera_thread.preview_settings()
+        )
+        self.camera_control_panel.set_capture_geometry(
+            self.camera_thread.capture_geometry
+        )
         self.camera_control_panel.setEnabled(True)
+        self._refresh_recording_button_states()
 
+        geom = self.camera_thread.capture_geometry
+        if geom:
+            b = max(1, geom.get("binning", 1))
+            self.lbl_cam_resolution.setText(
+                f"{geom['width'] // b}×{geom['height'] // b}"
+            )
         self.lbl_cam_connection.setText("Connected")
 
+    @pyqtSlot(dict)
+    def _on_preview_settings_changed(self, settings):
+        """Forward preview range changes from CameraControlPanel to the camera."""
+        if self.camera_thread is not None:
+            self.camera_thread.set_preview_settings(settings)
+
+    # ─── Camera profiles ────────────────────────────────────────────────
+    def _populate_profile_combo(self, select=None):
+        self.profile_combo.blockSignals(True)
+        self.profile_combo.clear()
+        self.profile_combo.addItem("(none)", None)
+        for name in list_profiles():
+            self.profile_combo.addItem(name, name)
+        idx = self.profile_combo.findData(select) if select else 0
+        self.profile_combo.setCurrentIndex(max(idx, 0))
+        self.profile_combo.blockSignals(False)
+
+    def _selected_profile(self):
+        name = self.profile_combo.currentData()
+        if not name:
+            return None
+        try:
+            return load_profile(name)
+        except (OSError, ValueError) as e:
+            log.error(f"Could not load camera profile {name!r}: {e}")
+            return None
+
+    @pyqtSlot(int)
+    def _on_profile_selected(self, index):
+        save_app_setting(SETTING_LAST_PROFILE_NAME, self.profile_combo.currentData())
+        # Applied at the next start; a running camera gets it right away
+        if self.camera_thread is not None and self.camera_thread.isRunning():
+            profile = self._selected_profile()
+            if profile:
+                self.camera_control_panel.apply_profile(profile)
+
+    # ─── Capture ROI / binning ──────────────────────────────────────────
+    @pyqtSlot(bool)
+    def _on_roi_draw_requested(self, on):
+        if on:
+            self.draw_lines_action.setChecked(False)
+        self.camera_widget.set_draw_mode("rect" if on else None)
+
+    @pyqtSlot(tuple)
+    def _on_capture_rect_drawn(self, rect):
+        """Convert a rectangle drawn on the preview to sensor pixels."""
+        geom = (self.camera_thread.capture_geometry if self.camera_thread else None) or {}
+        b = max(1, geom.get("binning", 1))
+        x, y, w, h = rect
+        self.camera_control_panel.set_pending_roi(
+            (
+                geom.get("x", 0) + int(x) * b,
+                geom.get("y", 0) + int(y) * b,
+                int(w) * b,
+                int(h) * b,
+            )
+        )
+
+    @pyqtSlot(dict)
+    def _on_capture_roi_requested(self, roi):
+        """Restart the camera with a new hardware ROI/binning."""
+        if self._recorder_thread and self._recorder_thread.isRunning():
+            log.warning("Blocked capture ROI change during recording")
+            return
+        self._capture_roi = roi
+        log.info(f"Capture ROI requested: {roi}")
+        # Preview coordinates change with the geometry
+        self.camera_widget.set_capture_rect(None)
+        self.camera_widget.clear_line_rois()
+        if self.camera_thread is None or not self.camera_thread.isRunning():
+            return
+        thread = self.camera_thread
+        self._on_start_stop_camera()  # stop
+        thread.wait(5000)
+        self._on_start_stop_camera()  # start with the new geometry
+
+    # ─── Additional cameras ─────────────────────────────────────────────
+    @pyqtSlot()
+    def _on_add_camera(self):
+        """Pick a device and resolution and open it in a CameraDock."""
+        if self._recorder_thread and self._recorder_thread.isRunning():
+            QMessageBox.information(
+                self, "Add Camera", "Cameras cannot be added during a recording."
+            )
+            return
+        if 1 + len(self._camera_docks) >= MAX_CAMERAS:
+            QMessageBox.information(
+                self, "Add Camera", f"At most {MAX_CAMERAS} cameras are supported."
+            )
+            return
+
+        in_use = {dock.dev_info.serial for dock in self._camera_docks.values()}
+        if self.camera_thread is not None and self.device_combo.currentData():
+            in_use.add(self.device_combo.currentData().serial)
+        devices = [d for d in self._camera_devices if d.serial not in in_use]
+        if not devices:
+            QMessageBox.information(self, "Add Camera", "No unused camera found.")
+            return
+
+        dlg = QDialog(self)
+        dlg.setWindowTitle("Add Camera")
+        form = QFormLayout(dlg)
+        dev_combo = QComboBox()
+        for dev in devices:
+            dev_combo.addItem(f"{dev.model_name}  (S/N: {dev.serial})", dev)
+        res_combo = QComboBox()
+        prof_combo = QComboBox()
+        prof_combo.addItem("(none)", None)
+        for name in list_profiles():
+            prof_combo.addItem(name, name)
+
+        def fill_formats():
+            res_combo.clear()
+            for label, resdata in self._camera_formats(dev_combo.currentData()):
+                res_combo.addItem(label, resdata)
+
+        dev_combo.currentIndexChanged.connect(fill_formats)
+        fill_formats()
+        form.addRow("Device:", dev_combo)
+        form.addRow("Resolution:", res_combo)
+        form.addRow("Profile:", prof_combo)
+        buttons = QDialogButtonBox(QDialogButtonBox.Ok | QDialogButtonBox.Cancel)
+        buttons.accepted.connect(dlg.accept)
+        buttons.rejected.connect(dlg.reject)
+        form.addRow(buttons)
+        if dlg.exec_() != QDialog.Accepted or res_combo.currentData() is None:
+            return
+
+        profile = None
+        if prof_combo.currentData():
+            try:
+                profile = load_profile(prof_combo.currentData())
+            except (OSError, ValueError) as e:
+                log.error(f"Could not load camera profile {prof_combo.currentData()!r}: {e}")
+
+        camera_id = next(i for i in range(1, MAX_CAMERAS) if i not in self._camera_docks)
+        dock = CameraDock(
+            camera_id, dev_combo.currentData(), res_combo.currentData(), profile, self
+        )
+        dock.closed.connect(self._on_camera_dock_closed)
+        self._camera_docks[camera_id] = dock
+        self.addDockWidget(Qt.RightDockWidgetArea, dock)
+        dock.start()
+        log.info(f"Camera {camera_id} added: {dock.dev_info.model_name}")
+
+    @pyqtSlot(int)
+    def _on_camera_dock_closed(self, camera_id):
+        # A recording keeps its other streams; this one just stops growing
+        self._camera_docks.pop(camera_id, None)
+        log.info(f"Camera {camera_id} removed.")
+
     @pyqtSlot(QImage, object)
-    def _update_camera_info(self, image: QImage, raw):
+    def _update_camera_info(self, image: QImage, frame):
         """
         (Optional) Keep updating frame count & resolution in the “Info” tab
         every time a new frame arrives.  If you want to hook this up, simply:
             self.camera_thread.frame_ready.connect(self._update_camera_info)
         """
+        # Only the QImage geometry is needed; hand the pixels back right away
+        if frame is not None:
+            frame.release()
+
         try:
             current_count = int(self.lbl_cam_frame.text())
         except ValueError:
@@ -497,6 +858,17 @@ class MainWindow(QMainWindow):
         if self.lbl_cam_connection.text() != "Connected":
             self.lbl_cam_connection.setText("Connected")
 
+    @pyqtSlot(dict)
+    def _on_camera_stats(self, stats: dict):
+        """
+        Show the SDKCameraThread pipeline counters in the “Info” tab.
+        """
+        self.lbl_cam_frame.setText(str(stats.get("processed", 0)))
+        self.lbl_cam_buffers.setText(
+            f"{stats.get('dropped', 0)} / "
+            f"{stats.get('queue_depth', 0)} of {stats.get('buffer_count', 0)}"
+        )
+
     @pyqtSlot(str, str)
     def _on_camera_error(self, msg: str, code: str):
         """
@@ -504,6 +876,7 @@ class MainWindow(QMainWindow):
         """
         log.error(f"Camera error occurred ({code}): {msg}")
         QMessageBox.critical(self, "Camera Error", msg)
+        self._stop_calibration()
 
         # If the thread is still running, stop it
         if self.camera_thread and self.camera_thread.isRunning():
@@ -513,9 +886,11 @@ class MainWindow(QMainWindow):
                 pass
 
         self.camera_control_panel.setEnabled(False)
+        self.camera_control_panel.release_grabber()
         self.lbl_cam_connection.setText("Error")
         self.lbl_cam_frame.setText("0")
         self.lbl_cam_resolution.setText("N/A")
+        self.lbl_cam_buffers.setText("N/A")
         self.camera_widget.clear_image()
         self.btn_start_camera.setText("Start Camera")
 
@@ -530,6 +905,22 @@ class MainWindow(QMainWindow):
         exp_img_act.triggered.connect(self.pressure_plot_widget.export_as_image)
         fm.addAction(exp_img_act)
         fm.addSeparator()
+        review_act = QAction("Re&view Recording…", self, triggered=self._open_review)
+        review_act.setToolTip("Scrub a recorded Fill against its pressure trace.")
+        fm.addAction(review_act)
+        export_act = QAction("E&xport Recording…", self, triggered=self._open_export)
+        export_act.setToolTip(
+            "Write a recorded stack as a preview video or a binned TIFF."
+        )
+        fm.addAction(export_act)
+        recover_act = QAction(
+            "&Recover Recording…", self, triggered=self._recover_recordings
+        )
+        recover_act.setToolTip(
+            "Repair recordings left unfinished by a crash or power loss."
+        )
+        fm.addAction(recover_act)
+        fm.addSeparator()
         exit_act = QAction(
             "&Exit", self, shortcut=QKeySequence.Quit, triggered=self.close
         )
@@ -545,6 +936,18 @@ class MainWindow(QMainWindow):
             enabled=False,
         )
         am.addAction(self.start_recording_action)
+        self.arm_recording_action = QAction(
+            "&Arm Recording (Pre-trigger)",
+            self,
+            shortcut=Qt.CTRL | Qt.SHIFT | Qt.Key_R,
+            triggered=self._on_arm_recording,
+            enabled=False,
+        )
+        self.arm_recording_action.setToolTip(
+            f"Open the output files now and keep the last {PRETRIGGER_SECONDS:g} s "
+            "of frames and pressure; “Start Recording” then starts acquisition"
+        )
+        am.addAction(self.arm_recording_action)
         self.stop_recording_action = QAction(
             self.icon_record_stop,
             "Stop R&ecording",
@@ -555,9 +958,90 @@ class MainWindow(QMainWindow):
         )
         am.addAction(self.stop_recording_action)
 
+        am.addSeparator()
+        self.track_diameter_action = QAction(
+            "Track Vessel &Diameter", self, checkable=True
+        )
+        self.track_diameter_action.setToolTip(
+            "Measure the diameter along the line ROIs on every camera frame, "
+            "plot it with the pressure and save it with the recording"
+        )
+        self.track_diameter_action.toggled.connect(self._on_track_diameter_toggled)
+        am.addAction(self.track_diameter_action)
+        self.draw_lines_action = QAction(
+            "Draw Diameter &Lines", self, checkable=True
+        )
+        self.draw_lines_action.setToolTip(
+            "Drag across the vessel on the camera view; right-click removes the last line"
+        )
+        self.draw_lines_action.toggled.connect(
+            lambda on: self.camera_widget.set_draw_mode("line" if on else None)
+        )
+        am.addAction(self.draw_lines_action)
+        clear_lines_act = QAction(
+            "&Clear Diameter Lines", self, triggered=self.camera_widget.clear_line_rois
+        )
+        am.addAction(clear_lines_act)
+
+        am.addSeparator()
+        self.add_camera_action = QAction(
+            "Add &Camera…", self, triggered=self._on_add_camera, enabled=False
+        )
+        self.add_camera_action.setToolTip(
+            "Open another camera on the same CamTrig line; it is recorded into "
+            "its own video file, paired against the same pressure samples"
+        )
+        am.addAction(self.add_camera_action)
+        self.calibrate_rate_action = QAction(
+            "Calibrate &Trigger Rate…",
+            self,
+            triggered=self._on_calibrate_trigger_rate,
+            enabled=False,
+        )
+        self.calibrate_rate_action.setToolTip(
+            "Record scratch stacks at increasing CamTrig rates and set the PRIM "
+            "device to the highest rate the camera and disk sustain without drops"
+        )
+        am.addAction(self.calibrate_rate_action)
+
+        am.addSeparator()
+        fmt_menu = am.addMenu("Recording &Format")
+        fmt_labels = {
+            "tif": "Uncompressed BigTIFF",
+            "tif-zstd": "Compressed TIFF (zstd, lossless)",
+            "h5": "Chunked HDF5 (deflate, lossless)",
+        }
+        self.recording_format_group = QActionGroup(self)
+        self.recording_format_group.setExclusive(True)
+        for fmt in SUPPORTED_FORMATS:
+            act = QAction(fmt_labels.get(fmt, fmt), self, checkable=True)
+            act.setData(fmt)
+            act.setChecked(fmt == self._recording_format)
+            self.recording_format_group.addAction(act)
+            fmt_menu.addAction(act)
+        self.recording_format_group.triggered.connect(self._on_recording_format_changed)
+
         vm = mb.addMenu("&View")
         if hasattr(self, "dock_console") and self.dock_console:
             vm.addAction(self.dock_console.toggleViewAction())
+        if hasattr(self, "dock_stats") and self.dock_stats:
+            vm.addAction(self.dock_stats.toggleViewAction())
+
+        vm.addSeparator()
+        backend_menu = vm.addMenu("Plot &Renderer (applies on restart)")
+        backend_labels = {
+            "matplotlib": "Matplotlib (software)",
+            "pyqtgraph": "pyqtgraph (OpenGL)",
+        }
+        self.plot_backend_group = QActionGroup(self)
+        self.plot_backend_group.setExclusive(True)
+        for name in PLOT_BACKENDS:
+            act = QAction(backend_labels.get(name, name), self, checkable=True)
+            act.setData(name)
+            act.setChecked(name == self._plot_backend)
+            self.plot_backend_group.addAction(act)
+            backend_menu.addAction(act)
+        self.plot_backend_group.triggered.connect(self._on_plot_backend_changed)
 
         pm = mb.addMenu("&Plot")
         clear_plot_act = QAction(
@@ -603,15 +1087,9 @@ class MainWindow(QMainWindow):
         self.serial_port_combobox = QComboBox()
         self.serial_port_combobox.setToolTip("Select Serial Port")
         self.serial_port_combobox.setMinimumWidth(200)
-        ports = list_serial_ports()
-        if ports:
-            for p_dev, p_desc in ports:
-                self.serial_port_combobox.addItem(
-                    f"{os.path.basename(p_dev)} ({p_desc})", QVariant(p_dev)
-                )
-        else:
-            self.serial_port_combobox.addItem("No Serial Ports Found", QVariant())
-            self.serial_port_combobox.setEnabled(False)
+        # Filled in by _on_devices_ready once the background scan is done
+        self.serial_port_combobox.addItem("Searching for ports…", QVariant())
+        self.serial_port_combobox.setEnabled(False)
         tb.addWidget(self.serial_port_combobox)
         tb.addSeparator()
 
@@ -622,6 +1100,19 @@ class MainWindow(QMainWindow):
 
     def _build_status_bar(self):
         sb = self.statusBar()
+        self.writer_stats_label = QLabel("")
+        self.writer_stats_label.setToolTip(
+            "TIFF writer: queued frames / queue size, write bandwidth, dropped frames"
+        )
+        sb.addPermanentWidget(self.writer_stats_label)
+        self.sync_stats_label = QLabel("")
+        self.sync_stats_label.setToolTip(
+            "Frame/pressure sync: frames paired with their CamTrig sample, "
+            "unmatched frames and samples"
+        )
+        sb.addPermanentWidget(self.sync_stats_label)
+        self.memory_label = QLabel("")
+        sb.addPermanentWidget(self.memory_label)
         self.app_session_time_label = QLabel("Session: 00:00:00")
         sb.addPermanentWidget(self.app_session_time_label)
         self._app_session_seconds = 0
@@ -641,6 +1132,85 @@ class MainWindow(QMainWindow):
         self.app_session_time_label.setText(
             f"Session: {hours:02d}:{minutes:02d}:{seconds:02d}"
         )
+        self._update_memory_gauge()
+
+    def _update_memory_gauge(self):
+        """Frame-pool use against the memory budget (every session-timer tick)."""
+        stats = frame_pool.stats()
+        used = stats["in_use_mb"] + stats["overflow_mb"]
+        text = f"Mem: {used:.0f}/{stats['budget_mb']:.0f} MB"
+        if stats["rss_mb"] is not None:
+            text += f" (RSS {stats['rss_mb']:.0f})"
+        self.memory_label.setText(text)
+        full = used >= MEMORY_GAUGE_WARN_FRACTION * stats["budget_mb"]
+        self.memory_label.setStyleSheet(
+            "color:#C0392B;" if full or stats["dropped"] or stats["overflows"] else ""
+        )
+        self.memory_label.setToolTip(
+            f"Frame buffer pool ({stats['policy']} on overflow): "
+            f"{stats['in_use_mb']:.0f} MB borrowed, {stats['idle_mb']:.0f} MB idle, "
+            f"peak {stats['peak_mb']:.0f} MB of {stats['budget_mb']:.0f} MB\n"
+            f"{stats['allocations']} allocated, {stats['reuses']} reused, "
+            f"{stats['dropped']} refused, {stats['overflows']} beyond the budget"
+        )
+
+    @pyqtSlot(dict)
+    def _on_writer_stats(self, stats: dict):
+        """
+        Show the recorder's write-behind queue depth and bandwidth (camera 0
+        in the status bar, additional cameras in their dock).
+        """
+        dock = self._camera_docks.get(stats.get("camera_id", 0))
+        if dock is not None:
+            dock.set_writer_stats(stats)
+            return
+        text = (
+            f"Writer: {stats.get('queue_depth', 0)}/{stats.get('queue_size', 0)} queued, "
+            f"{stats.get('mb_per_s', 0.0):.1f} MB/s"
+        )
+        if stats.get("dropped"):
+            text += f", {stats['dropped']} dropped"
+        if stats.get("spilled"):
+            text += f", {stats['spilled']} spilled"
+        self.writer_stats_label.setText(text)
+
+    @pyqtSlot(int, str, bool)
+    def _on_writer_failed(self, camera_id: int, msg: str, any_left: bool):
+        """
+        A camera's frame writer stopped: say so, and stop the recording once
+        no camera is being written any more.
+        """
+        log.error(f"Recording of camera {camera_id} failed: {msg}")
+        self.writer_stats_label.setText(f"Writer: camera {camera_id} failed")
+        if any_left:
+            QMessageBox.critical(
+                self,
+                "Recording Error",
+                f"Camera {camera_id} is no longer being recorded:\n{msg}",
+            )
+            return
+        QMessageBox.critical(
+            self,
+            "Recording Error",
+            f"Frames can no longer be written; the recording is stopped:\n{msg}",
+        )
+        self._on_stop_recording()
+
+    @pyqtSlot(dict)
+    def _on_sync_stats(self, stats: dict):
+        """Show how many frames were paired with their Arduino sample."""
+        dock = self._camera_docks.get(stats.get("camera_id", 0))
+        if dock is not None:
+            dock.set_sync_stats(stats)
+            return
+        text = f"Sync: {stats.get('matched', 0)} paired"
+        unmatched_f = stats.get("unmatched_frames", 0)
+        unmatched_s = stats.get("unmatched_samples", 0)
+        if unmatched_f or unmatched_s:
+            text += f", unmatched {unmatched_f} frames / {unmatched_s} samples"
+        if stats.get("offset") is None:
+            text = "Sync: waiting for lock"
+        self.sync_stats_label.setText(text)
 
     @pyqtSlot()
     def _clear_pressure_plot(self):
@@ -660,9 +1230,17 @@ class MainWindow(QMainWindow):
             ):
                 self.pressure_plot_widget.clear_plot()
 
-            if self._serial_thread and self._serial_thread.isRunning():
+            dsp = self._serial_dsp()
+            if dsp is not None and DSP_SOFTWARE_ZERO:
+                # Tare in the serial worker's DSP stage; the device is untouched
+                dsp.request_zero()
+                msg = "Pressure zeroed in software and plot cleared."
+            elif self._serial_thread and self._serial_thread.isRunning():
                 # Send the zero command when the PRIM device is connected
                 self._serial_thread.send_command("Z")
+                if dsp is not None:
+                    # The level jumps; restart the filters and statistics
+                    dsp.request_reset()
                 msg = "Zero command sent to PRIM and plot cleared."
             else:
                 msg = "PRIM device not connected; plot cleared."
@@ -682,6 +1260,8 @@ class MainWindow(QMainWindow):
     def _set_initial_control_states(self):
         if hasattr(self, "start_recording_action"):
             self.start_recording_action.setEnabled(False)
+        if hasattr(self, "arm_recording_action"):
+            self.arm_recording_action.setEnabled(False)
         if hasattr(self, "stop_recording_action"):
             self.stop_recording_action.setEnabled(False)
         if hasattr(self, "camera_control_panel"):
@@ -697,18 +1277,343 @@ class MainWindow(QMainWindow):
         if path:
             try:
                 data = self.pressure_plot_widget.get_plot_data()  # assume method exists
+                truncated = data.get("truncated", 0)
+                if truncated:
+                    answer = QMessageBox.question(
+                        self,
+                        "Export Plot Data",
+                        f"Only the last {len(data['time'])} samples are held at "
+                        f"full resolution; the {truncated} earlier samples of "
+                        "this session will be missing from the CSV.\n\n"
+                        "Recordings keep every sample in their pressure log.  "
+                        "Export the truncated data anyway?",
+                        QMessageBox.Yes | QMessageBox.No,
+                        QMessageBox.No,
+                    )
+                    if answer != QMessageBox.Yes:
+                        return
                 with open(path, "w", newline="") as f:
                     writer = csv.writer(f)
+                    if truncated:
+                        writer.writerow(
+                            [f"# Truncated: {truncated} earlier samples not included"]
+                        )
                     writer.writerow(["Time (s)", "Pressure (mmHg)"])
                     for t, p in zip(data["time"], data["pressure"]):
                         writer.writerow([t, p])
-                self.statusBar().showMessage(f"Plot data exported to {path}", 3000)
+                note = f" (last {len(data['time'])} samples only)" if truncated else ""
+                self.statusBar().showMessage(
+                    f"Plot data exported to {path}{note}", 3000
+                )
             except Exception as e:
                 log.error(f"Error exporting CSV: {e}")
                 QMessageBox.critical(
                     self, "Export Error", f"Failed to export CSV:\n{e}"
                 )
 
+    def _pick_recording(self, title):
+        """Ask for a Fill folder and one of its stacks; None if cancelled."""
+        folder = QFileDialog.getExistingDirectory(
+            self, f"{title} in Fill Folder", PRIM_RESULTS_DIR
+        )
+        if not folder:
+            return None
+        recordings = find_recordings(folder)
+        if not recordings:
+            QMessageBox.information(self, title, "No recordings in this folder.")
+            return None
+        path = recordings[-1]
+        if len(recordings) > 1:
+            names = [os.path.basename(p) for p in recordings]
+            name, ok = QInputDialog.getItem(
+                self, title, "Recording:", names, len(names) - 1, False
+            )
+            if not ok:
+                return None
+            path = recordings[names.index(name)]
+        return path
+
+    def _open_review(self):
+        path = self._pick_recording("Review Recording")
+        if path is None:
+            return
+
+        if self._review_dock is not None:
+            self._review_dock.close()
+        dock = ReviewDock(path, self)
+        dock.closed.connect(self._on_review_closed)
+        self._review_dock = dock
+        self.addDockWidget(Qt.BottomDockWidgetArea, dock)
+        dock.start()
+        log.info(f"Reviewing {path}")
+
+    @pyqtSlot()
+    def _on_review_closed(self):
+        if self.sender() is self._review_dock:
+            self._review_dock = None
+
+    def _open_export(self):
+        if self._export_thread is not None:
+            QMessageBox.information(
+                self, "Export Recording", "An export is already running."
+            )
+            return
+        path = self._pick_recording("Export Recording")
+        if path is None:
+            return
+        dialog = ExportDialog(path, self)
+        if dialog.exec_() != QDialog.Accepted:
+            return
+
+        thread = ExportThread(path, dialog.options(), self)
+        progress = QProgressDialog(
+            f"Exporting {os.path.basename(path)}…", "Cancel", 0, 0, self
+        )
+        progress.setWindowTitle("Export Recording")
+        progress.setWindowModality(Qt.NonModal)
+        progress.setMinimumDuration(0)
+        progress.setAutoClose(False)
+        progress.setAutoReset(False)
+        progress.canceled.connect(thread.cancel)
+        thread.progress.connect(self._on_export_progress)
+        thread.export_finished.connect(self._on_export_finished)
+        thread.export_cancelled.connect(self._on_export_cancelled)
+        thread.error_occurred.connect(self._on_export_error)
+        thread.finished.connect(self._on_export_thread_done)
+        self._export_thread = thread
+        self._export_progress = progress
+        progress.show()
+        thread.start()
+
+    @pyqtSlot(int, int)
+    def _on_export_progress(self, done, total):
+        if self._export_progress is not None:
+            self._export_progress.setMaximum(total)
+            self._export_progress.setValue(done)
+
+    @pyqtSlot(dict)
+    def _on_export_finished(self, result):
+        message = f"Exported {result['pages']} pages to {result['path']}"
+        if result.get("codec"):
+            message += f" ({result['codec']}, {result['fps']:.1f} fps)"
+        self.statusBar().showMessage(message, 10000)
+
+    @pyqtSlot()
+    def _on_export_cancelled(self):
+        self.statusBar().showMessage("Export cancelled.", 5000)
+
+    @pyqtSlot(str)
+    def _on_export_error(self, msg):
+        QMessageBox.critical(self, "Export Error", f"Export failed:\n{msg}")
+
+    @pyqtSlot()
+    def _on_export_thread_done(self):
+        if self._export_progress is not None:
+            self._export_progress.close()
+            self._export_progress.deleteLater()
+            self._export_progress = None
+        if self._export_thread is not None:
+            self._export_thread.deleteLater()
+            self._export_thread = None
+
+    def _on_calibrate_trigger_rate(self):
+        if self._calibrator is not None or not self._camera_running():
+            return
+        answer = QMessageBox.question(
+            self,
+            "Calibrate Trigger Rate",
+            "The PRIM device will be started at increasing rates while scratch "
+            f"stacks are written in the {self._recording_format} format; the "
+            "camera is switched to hardware trigger.  Keep the current ROI and "
+            "pixel format, as the calibrated rate only holds for them.\n\n"
+            "Start the calibration?",
+        )
+        if answer != QMessageBox.Yes:
+            return
+
+        self._calibrator_thread = QThread(self)
+        self._calibrator = RateCalibrator(
+            self.camera_thread,
+            self._serial_thread,
+            self._recording_format,
+            os.path.join(PRIM_RESULTS_DIR, ".calibration"),
+        )
+        self._calibrator.moveToThread(self._calibrator_thread)
+        self._calibrator_thread.started.connect(self._calibrator.start)
+        # Direct: _stop_calibration() may be blocked in wait() on the GUI thread
+        self._calibrator.finished.connect(
+            self._calibrator_thread.quit, Qt.DirectConnection
+        )
+        self._calibrator.finished.connect(self._calibrator.deleteLater)
+        self._calibrator_thread.finished.connect(self._calibrator_thread.deleteLater)
+        self._calibrator.step_started.connect(self._on_calibration_step)
+        self._calibrator.progress.connect(self._on_calibration_progress)
+        self._calibrator.throughput_warning.connect(self._on_calibration_warning)
+        self._calibrator.calibration_finished.connect(self._on_calibration_finished)
+        self._calibrator.error_occurred.connect(self._on_calibration_error)
+        self.camera_thread.frame_ready.connect(self._calibrator.append_frame)
+        self._serial_thread.samples_ready.connect(
+            self._calibrator.append_pressure_block
+        )
+
+        progress = QProgressDialog(
+            "Calibrating the trigger rate…", "Cancel", 0, 0, self
+        )
+        progress.setWindowTitle("Calibrate Trigger Rate")
+        progress.setWindowModality(Qt.NonModal)
+        progress.setMinimumDuration(0)
+        progress.setAutoClose(False)
+        progress.setAutoReset(False)
+        progress.canceled.connect(self._cancel_calibration)
+        self._calibration_progress = progress
+        progress.show()
+
+        self._calibrator_thread.start()
+        self._refresh_recording_button_states()
+
+    def _camera_running(self):
+        return self.camera_thread is not None and self.camera_thread.isRunning()
+
+    def _cancel_calibration(self):
+        if self._calibrator is not None:
+            QMetaObject.invokeMethod(self._calibrator, "cancel", Qt.QueuedConnection)
+
+    @pyqtSlot(float)
+    def _on_calibration_step(self, rate_hz):
+        if self._calibration_progress is not None:
+            self._calibration_progress.setLabelText(
+                f"Calibrating the trigger rate: {rate_hz:.1f} Hz…"
+            )
+
+    @pyqtSlot(int, int)
+    def _on_calibration_progress(self, done, total):
+        if self._calibration_progress is not None:
+            self._calibration_progress.setMaximum(total)
+            self._calibration_progress.setValue(done)
+
+    @pyqtSlot(str)
+    def _on_calibration_warning(self, message):
+        self.statusBar().showMessage(f"Calibration: {message}", 6000)
+
+    @pyqtSlot(str)
+    def _on_calibration_error(self, msg):
+        QMessageBox.warning(self, "Calibrate Trigger Rate", msg)
+
+    @pyqtSlot(dict)
+    def _on_calibration_finished(self, result):
+        self._end_calibration()
+        rate = result.get("rate_hz")
+        if rate:
+            save_app_setting(SETTING_TRIGGER_MODE, True)
+            save_app_setting(SETTING_TRIGGER_RATE_HZ, rate)
+            message = (
+                f"Trigger rate set to {rate:.1f} Hz "
+                f"({result['best_hz']:.1f} Hz sustained without drops)."
+            )
+            self.statusBar().showMessage(message, 10000)
+            QMessageBox.information(self, "Calibrate Trigger Rate", message)
+            return
+        # The steps changed the device's rate; put the previous one back
+        self._send_trigger_rate(
+            self._serial_thread, load_app_setting(SETTING_TRIGGER_RATE_HZ, DEFAULT_FPS)
+        )
+        if result.get("cancelled"):
+            self.statusBar().showMessage("Trigger-rate calibration cancelled.", 5000)
+        elif result.get("steps"):
+            first = result["steps"][0]
+            QMessageBox.warning(
+                self,
+                "Calibrate Trigger Rate",
+                f"Even {first['rate_hz']:.1f} Hz dropped frames "
+                f"({first['frames']}/{first['triggers']} frames, "
+                f"{first['written_hz']:.1f} written/s).  The trigger settings were "
+                "left unchanged; try a smaller ROI or a faster recording format.",
+            )
+
+    def _send_trigger_rate(self, serial_thread, rate_hz):
+        if serial_thread is None or not rate_hz:
+            return
+        try:
+            actual = serial_thread.set_sample_rate(float(rate_hz))
+        except RuntimeError:
+            return  # SerialThread already deleted
+        log.info(f"PRIM device trigger rate set to {actual:.1f} Hz.")
+
+    def _end_calibration(self):
+        """
+        Disconnect the calibrator and queue its shutdown behind the frames
+        already on their way to it, so each of them is released.
+        """
+        calibrator, self._calibrator = self._calibrator, None
+        if calibrator is None:
+            return
+        for source, signal, slot in (
+            (self.camera_thread, "frame_ready", calibrator.append_frame),
+            (self._serial_thread, "samples_ready", calibrator.append_pressure_block),
+        ):
+            if source is None:
+                continue
+            try:
+                getattr(source, signal).disconnect(slot)
+            except (TypeError, RuntimeError):
+                pass
+        QMetaObject.invokeMethod(calibrator, "shutdown", Qt.QueuedConnection)
+        self._calibrator_thread = None
+        if self._calibration_progress is not None:
+            self._calibration_progress.close()
+            self._calibration_progress.deleteLater()
+            self._calibration_progress = None
+        self._refresh_recording_button_states()
+
+    def _stop_calibration(self, timeout_ms=5000):
+        """Cancel a running calibration and wait for its thread (camera/serial stop)."""
+        thread = self._calibrator_thread
+        if self._calibrator is None:
+            return
+        self._cancel_calibration()
+        self._end_calibration()
+        if thread is not None and not thread.wait(timeout_ms):
+            log.warning("RateCalibrator thread did not stop gracefully.")
+
+    def _recover_recordings(self):
+        folder = QFileDialog.getExistingDirectory(
+            self, "Recover Recordings in Fill Folder", PRIM_RESULTS_DIR
+        )
+        if not folder:
+            return
+        from writers.recovery import find_unfinished, recover_recording
+
+        bases = find_unfinished(folder)
+        if not bases:
+            QMessageBox.information(
+                self, "Recover Recording", "No unfinished recordings in this folder."
+            )
+            return
+        lines = []
+        QApplication.setOverrideCursor(Qt.WaitCursor)
+        try:
+            for base in bases:
+                lines.append(os.path.basename(base))
+                for path, message in recover_recording(base):
+                    lines.append(f"  {os.path.basename(path)}: {message}")
+        finally:
+            QApplication.restoreOverrideCursor()
+        log.info("Recovery report:\n" + "\n".join(lines))
+        QMessageBox.information(self, "Recover Recording", "\n".join(lines))
+
+    @pyqtSlot(QAction)
+    def _on_recording_format_changed(self, action):
+        fmt = action.data()
+        self._recording_format = fmt
+        save_app_setting(SETTING_RECORDING_FORMAT, fmt)
+        self.statusBar().showMessage(f"Recording format: {action.text()}", 3000)
+
+    def _on_plot_backend_changed(self, action):
+        save_app_setting(SETTING_PLOT_BACKEND, action.data())
+        self.statusBar().showMessage(
+            f"Plot renderer set to {action.text()}; restart to apply.", 5000
+        )
+
     def _show_about_dialog(self):
         QMessageBox.information(self, f"About {APP_NAME}", ABOUT_TEXT)
 
@@ -747,7 +1652,14 @@ class MainWindow(QMainWindow):
 
                 # Create and start the new thread
                 self._serial_thread = SerialThread(port=port, parent=self)
-                self._serial_thread.data_ready.connect(self._handle_new_serial_data)
+                self._serial_thread.samples_ready.connect(self.ui_refresh.push_block)
+                self._serial_thread.samples_ready.connect(
+                    self.diameter_tracker.update_clock
+                )
+                self._serial_thread.processed_ready.connect(
+                    self.ui_refresh.push_processed
+                )
+                self._serial_thread.step_detected.connect(self._on_pressure_step)
                 self._serial_thread.error_occurred.connect(self._handle_serial_error)
                 self._serial_thread.status_changed.connect(
                     self._handle_serial_status_change
@@ -777,6 +1689,7 @@ class MainWindow(QMainWindow):
         # (2) Otherwise, a thread is already running → go into “DISCONNECT” branch
         else:
             log.info("Stopping SerialThread on user request...")
+            self._stop_calibration()
             try:
                 self._serial_thread.stop()
             except Exception as e:
@@ -804,6 +1717,12 @@ class MainWindow(QMainWindow):
             "connected" in status.lower() or "opened serial port" in status.lower()
         )
         self.top_ctrl.update_connection_status(status, connected_flag)
+        if status.startswith(("Connected", "Reconnected")):
+            # Opening the port resets the Arduino; resend the calibrated rate
+            # (none saved means the firmware default)
+            self._send_trigger_rate(
+                self._serial_thread, load_app_setting(SETTING_TRIGGER_RATE_HZ)
+            )
 
         self._refresh_recording_button_states()
 
@@ -821,6 +1740,7 @@ class MainWindow(QMainWindow):
         sender = self.sender()
 
         if self._serial_thread is sender:
+            self._stop_calibration()
             # Clean up the thread object
             self._serial_thread.deleteLater()
             self._serial_thread = None
@@ -839,28 +1759,98 @@ class MainWindow(QMainWindow):
         # Re‐evaluate “Start/Stop Recording” button states
         self._refresh_recording_button_states()
 
-    @pyqtSlot(int, float, float)
-    def _handle_new_serial_data(self, idx: int, t: float, p: float):
+    @pyqtSlot(object, object, object)
+    def _handle_new_serial_block(self, idx, t, p):
+        """
+        Called once per UI refresh tick with every sample SerialThread emitted
+        since the previous tick (numpy arrays, oldest first).
+        Pushes the batch into TopControlPanel and the live plot.
+        """
+        if not len(t):
+            return
+
+        # With the DSP stage the readouts and plot follow its blocks instead
+        if self._serial_dsp() is None:
+            # 1) Update TopControlPanel with the newest sample only
+            self.top_ctrl.update_prim_data(int(idx[-1]), float(t[-1]), float(p[-1]))
+
+            # 2) Read the auto-scale checkboxes from PlotControlPanel
+            ax = self.plot_control_panel.auto_x_cb.isChecked()
+            ay = self.plot_control_panel.auto_y_cb.isChecked()
+
+            # 3) Send the whole batch to the plot (one redraw per tick)
+            self.pressure_plot_widget.update_plot_block(t, p, ax, ay)
+
+        # 4) Queue the batch for the console (dropped there if "Serial" is off)
+        self.console_log.append_samples(idx, t, p)
+
+    def _serial_dsp(self):
+        """PressureDSP of the running serial thread, or None."""
+        thread = self._serial_thread
+        if thread is None or not thread.isRunning():
+            return None
+        return getattr(thread, "dsp", None)
+
+    @pyqtSlot(object)
+    def _handle_processed_block(self, block):
         """
-        Called whenever SerialThread emits data_ready(idx, t, p).
-        Pushes new data into TopControlPanel and the live plot.
+        PressureDSP output since the previous tick: readouts, the (zeroed)
+        pressure trace and the DSP_PLOT_CHANNEL trace over it, one redraw.
         """
-        # 1) Update TopControlPanel (frame count, device time, pressure)
-        self.top_ctrl.update_prim_data(idx, t, p)
+        if not len(block):
+            return
+        last = block[-1]
+        self.top_ctrl.update_prim_data(
+            int(last["frameIdx"]), float(last["deviceTime"]), float(last["pressure"])
+        )
+        self.top_ctrl.update_dsp_data(last)
 
-        # 2) Read the auto-scale checkboxes from PlotControlPanel
         ax = self.plot_control_panel.auto_x_cb.isChecked()
         ay = self.plot_control_panel.auto_y_cb.isChecked()
+        if DSP_PLOT_CHANNEL:
+            self.pressure_plot_widget.update_filtered_block(
+                block["deviceTime"], block[DSP_PLOT_CHANNEL]
+            )
+        self.pressure_plot_widget.update_plot_block(
+            block["deviceTime"], block["pressure"], ax, ay
+        )
 
-        # 3) Send the new sample to the PressurePlotWidget
-        self.pressure_plot_widget.update_plot(t, p, ax, ay)
-
-        # 4) Also log it to the console dock if visible
-        if self.dock_console.isVisible():
-            self.console_out_textedit.append(
-                f"PRIM Data: Idx={idx}, Time={t:.3f}s, P={p:.2f}"
+    @pyqtSlot(float, int)
+    def _on_pressure_step(self, t_dev, direction):
+        self.top_ctrl.show_step(t_dev, direction)
+        kind = "rise" if direction > 0 else "drop"
+        log.info(f"Pressure step ({kind}) detected at device time {t_dev:.2f} s")
+
+    @pyqtSlot(bool)
+    def _on_track_diameter_toggled(self, checked):
+        """Connect/disconnect the camera stream to the diameter tracker."""
+        if self.camera_thread is not None:
+            if checked:
+                self.camera_thread.frame_ready.connect(
+                    self.diameter_tracker.process_frame
+                )
+            else:
+                try:
+                    self.camera_thread.frame_ready.disconnect(
+                        self.diameter_tracker.process_frame
+                    )
+                except Exception:
+                    pass
+        if checked and not self.camera_widget.line_rois():
+            self.statusBar().showMessage(
+                "Diameter tracking on: draw lines across the vessel "
+                "(Acquisition → Draw Diameter Lines).",
+                6000,
             )
 
+    @pyqtSlot(object)
+    def _handle_diameter_block(self, rows):
+        """DiameterTracker results: plot the mean over the ROIs of each frame."""
+        ts, ds = mean_per_frame(rows)
+        self.pressure_plot_widget.update_diameter_block(
+            ts, ds, self.diameter_tracker.units
+        )
+
     # ──────────────────────────────────────────────────────────────
     # Recording Management
     # ──────────────────────────────────────────────────────────────
@@ -868,17 +1858,56 @@ class MainWindow(QMainWindow):
     @pyqtSlot()
     def _on_start_recording(self):
         """
-        Called when the user clicks ‘Start Recording’. Creates the next
-        PRIM_ROOT/YYYY-MM-DD/FillN folder and starts a RecordingManager
-        writing there.
+        Called when the user clicks ‘Start Recording’. Triggers an armed
+        recorder, or creates the next PRIM_ROOT/YYYY-MM-DD/FillN folder and
+        starts a RecordingManager writing there.
+        """
+        if self._recorder_armed and self._recorder_worker:
+            self._recorder_armed = False
+            QMetaObject.invokeMethod(
+                self._recorder_worker, "trigger", Qt.QueuedConnection
+            )
+            self._refresh_recording_button_states()
+            log.info("Armed recording triggered.")
+            return
+        self._create_recorder(wait_for_trigger=False)
+
+    @pyqtSlot()
+    def _on_arm_recording(self):
+        """
+        Called when the user clicks ‘Arm Recording’. Like ‘Start Recording’,
+        but the Arduino is only started by a later ‘Start Recording’; until
+        then the recorder keeps the pre-trigger ring.
         """
+        self._recorder_armed = True
+        self._create_recorder(wait_for_trigger=True)
+
+    def _create_recorder(self, wait_for_trigger):
         outdir = get_next_fill_folder()
 
         fill_folder_name = os.path.basename(outdir)
 
+        # Camera 0 plus every running additional camera, one stream each
+        self._recorded_cameras = [self.camera_thread] if self.camera_thread else []
+        self._recorded_cameras += [
+            dock.camera_thread
+            for _, dock in sorted(self._camera_docks.items())
+            if dock.is_running()
+        ]
+
         # Create the recording thread + worker exactly as before:
         self._recorder_thread = QThread(self)
-        self._recorder_worker = RecordingManager(output_dir=outdir)
+        self._recorder_worker = RecordingManager(
+            output_dir=outdir,
+            recording_format=self._recording_format,
+            wait_for_trigger=wait_for_trigger,
+            cameras={
+                cam.camera_id: cam.capture_geometry for cam in self._recorded_cameras
+            },
+            trigger_modes={
+                cam.camera_id: cam.trigger_mode for cam in self._recorded_cameras
+            },
+        )
         self._recorder_worker.moveToThread(self._recorder_thread)
 
         # 7) Wire up thread start → worker.start_recording()
@@ -893,10 +1922,25 @@ class MainWindow(QMainWindow):
         self._recorder_worker.ready_for_acquisition.connect(
             self._on_recorder_ready
         )
+        self._recorder_worker.armed.connect(self._on_recorder_armed)
+        # Live write-behind queue statistics for the status bar
+        self._recorder_worker.writer_stats.connect(self._on_writer_stats)
+        self._recorder_worker.sync_stats.connect(self._on_sync_stats)
+        self._recorder_worker.writer_failed.connect(self._on_writer_failed)
 
         # 8) Hook camera + serial into the worker:
-        self._serial_thread.data_ready.connect(self._recorder_worker.append_pressure)
-        self.camera_thread.frame_ready.connect(self._recorder_worker.append_frame)
+        self._serial_thread.samples_ready.connect(
+            self._recorder_worker.append_pressure_block
+        )
+        if getattr(self._serial_thread, "dsp", None) is not None:
+            self._serial_thread.processed_ready.connect(
+                self._recorder_worker.append_processed_block
+            )
+        for cam in self._recorded_cameras:
+            cam.frame_ready.connect(self._recorder_worker.append_frame)
+        self.diameter_tracker.diameters_ready.connect(
+            self._recorder_worker.append_diameter_block
+        )
 
         # 9) Kick off the recording thread:
         self._recorder_thread.start()
@@ -910,7 +1954,19 @@ class MainWindow(QMainWindow):
 
         # 10) Update UI buttons (disable “Start” / enable “Stop”):
         self._refresh_recording_button_states()
-        log.info(f"Recording started in {fill_folder_name}.")
+        if wait_for_trigger:
+            log.info(f"Recording armed in {fill_folder_name}.")
+        else:
+            log.info(f"Recording started in {fill_folder_name}.")
+
+    @pyqtSlot()
+    def _on_recorder_armed(self):
+        if self._recorder_armed:
+            self.statusBar().showMessage(
+                "Recording armed: files open, pre-trigger ring filling. "
+                "Press “Start Recording” to begin.",
+                6000,
+            )
 
     @pyqtSlot()
     def _on_recorder_ready(self):
@@ -940,15 +1996,30 @@ class MainWindow(QMainWindow):
 
         # 1) Disconnect signals so no new data is queued
         try:
-            self._serial_thread.data_ready.disconnect(
-                self._recorder_worker.append_pressure
+            self._serial_thread.samples_ready.disconnect(
+                self._recorder_worker.append_pressure_block
+            )
+        except Exception:
+            pass
+        try:
+            self._serial_thread.processed_ready.disconnect(
+                self._recorder_worker.append_processed_block
             )
         except Exception:
             pass
 
+        for cam in self._recorded_cameras:
+            try:
+                cam.frame_ready.disconnect(self._recorder_worker.append_frame)
+            except Exception:
+                pass
+        self._recorded_cameras = []
+        for dock in self._camera_docks.values():
+            dock.clear_recording_stats()
+
         try:
-            self.camera_thread.frame_ready.disconnect(
-                self._recorder_worker.append_frame
+            self.diameter_tracker.diameters_ready.disconnect(
+                self._recorder_worker.append_diameter_block
             )
         except Exception:
             pass
@@ -959,6 +2030,7 @@ class MainWindow(QMainWindow):
             # We can delete both and clear our Python handles:
             self._recorder_thread = None
             self._recorder_worker = None
+            self._recorder_armed = False
             # If you need to update button states right away:
             self._refresh_recording_button_states()
 
@@ -995,34 +2067,112 @@ class MainWindow(QMainWindow):
         recorder_running = (
             self._recorder_thread is not None and self._recorder_thread.isRunning()
         )
-        can_start = serial_ready and not recorder_running
+        calibrating = self._calibrator is not None
+        can_arm = serial_ready and not recorder_running and not calibrating
+        # “Start” also triggers an armed recorder
+        can_start = (
+            serial_ready
+            and not calibrating
+            and (not recorder_running or self._recorder_armed)
+        )
         can_stop = recorder_running
+        can_calibrate = (
+            serial_ready
+            and self._camera_running()
+            and not recorder_running
+            and not calibrating
+        )
 
         self.start_recording_action.setEnabled(can_start)
+        self.arm_recording_action.setEnabled(can_arm)
         self.stop_recording_action.setEnabled(can_stop)
+        self.calibrate_rate_action.setEnabled(can_calibrate)
+
+    def _wait_for_recorder(self, queued):
+        """
+        Wait for the stopping recorder thread while its writers drain
+        ``queued`` frames, with a progress dialog.  Returns False if the user
+        gave up waiting.
+        """
+        thread = self._recorder_thread
+        if thread.wait(500):
+            return True
+        progress = QProgressDialog(
+            "Writing queued frames to disk…", "", 0, max(queued, 1), self
+        )
+        progress.setCancelButton(None)  # the writers must finish
+        progress.setWindowTitle("Finishing Recording")
+        progress.setWindowModality(Qt.ApplicationModal)
+        progress.setMinimumDuration(0)
+        progress.show()
+        timeout = RECORDER_STOP_TIMEOUT_S + queued * RECORDER_STOP_S_PER_FRAME
+        deadline = time.monotonic() + timeout
+        try:
+            while not thread.wait(100):
+                try:
+                    remaining = self._recorder_worker.queued_frames()
+                except RuntimeError:
+                    remaining = 0  # worker deleted while the thread exits
+                progress.setMaximum(max(queued, remaining, 1))
+                progress.setValue(max(0, queued - remaining))
+                QApplication.processEvents()
+                if time.monotonic() < deadline:
+                    continue
+                answer = QMessageBox.question(
+                    self,
+                    "Finishing Recording",
+                    f"{remaining} frames are still being written.  Keep waiting?\n\n"
+                    "Otherwise the window closes now and the remaining frames are "
+                    "written in the background before the program exits.",
+                    QMessageBox.Yes | QMessageBox.No,
+                    QMessageBox.Yes,
+                )
+                if answer != QMessageBox.Yes:
+                    return False
+                deadline = time.monotonic() + timeout
+            return True
+        finally:
+            progress.close()
+            progress.deleteLater()
 
     # ─── Window Close Cleanup ──────────────────────────────────────────────────
     def closeEvent(self, event):
         log.info("MainWindow closeEvent triggered.")
 
+        if self._device_enumerator is not None:
+            self._device_enumerator.wait(5000)
+        self.camera_control_panel.release_grabber()
+
         # 1) If RecordingManager is still running, request stop_recording() and wait.
         if self._recorder_worker and self._recorder_thread:
             if self._recorder_thread.isRunning():
                 log.info("Stopping RecordingManager...")
+                queued = self._recorder_worker.queued_frames()
                 # Ask the worker to stop via queued call
                 QMetaObject.invokeMethod(
                     self._recorder_worker, "stop_recording", Qt.QueuedConnection
                 )
-                # Wait up to 3 seconds for it to finish
-                if not self._recorder_thread.wait(3000):
+                if not self._wait_for_recorder(queued):
+                    # Never terminate a thread with open writers: a truncated
+                    # stack is worse than one its journal can recover
                     log.warning(
-                        "RecordingManager thread did not stop gracefully; forcing terminate."
+                        "RecordingManager still writing at close; finishing in "
+                        "the background before exit."
                     )
-                    try:
-                        self._recorder_thread.terminate()
-                    except Exception:
-                        pass
-                    self._recorder_thread.wait(500)
+                    # Still running: detach it from the window, which must not
+                    # destroy a running QThread, and keep it referenced
+                    thread = self._recorder_thread
+                    entry = (self._recorder_worker, thread)
+                    thread.setParent(None)
+                    _detached_recorders.append(entry)
+
+                    def _forget():
+                        if entry in _detached_recorders:
+                            _detached_recorders.remove(entry)
+
+                    thread.finished.connect(_forget)
+                    self._recorder_worker = None
+                    self._recorder_thread = None
 
         # Now that the thread is done, delete both worker and thread objects if they exist
         if self._recorder_worker:
@@ -1064,7 +2214,21 @@ class MainWindow(QMainWindow):
                     pass
                 self._serial_thread = None
 
-        # 3) Stop the camera thread (if it exists)
+        if self._review_dock is not None:
+            self._review_dock.stop()
+            self._review_dock = None
+
+        self._stop_calibration()
+
+        if self._export_thread is not None:
+            self._export_thread.cancel()
+            if not self._export_thread.wait(5000):
+                log.warning("ExportThread did not stop gracefully.")
+
+        # 3) Stop the camera threads (additional cameras first)
+        for dock in list(self._camera_docks.values()):
+            dock.stop()
+        self._camera_docks.clear()
         cam_thread = self.camera_thread
         if cam_thread:
             try:
@@ -1090,13 +2254,23 @@ class MainWindow(QMainWindow):
                     pass
                 self.camera_thread = None
 
-        # 4) Clear UI elements that might hold references
+        # 4) Stop live-view updates and drop any frame still waiting to be shown
+        self.ui_refresh.stop()
+        QMetaObject.invokeMethod(
+            self.diameter_tracker, "shutdown", Qt.BlockingQueuedConnection
+        )
+        self._diameter_thread.quit()
+        self._diameter_thread.wait(1000)
+        # Log records after this point must not reach the deleted console
+        self.console_log.uninstall()
+
+        # 5) Clear UI elements that might hold references
         try:
             self.device_combo.clear()
         except Exception:
             pass
 
-        # 5) Process any remaining events, then call the base implementation
+        # 6) Process any remaining events, then call the base implementation
         QApplication.processEvents()
         log.info("All threads cleaned up. Proceeding with close.")
         super().closeEvent(event)
@@ -0,0 +1,107 @@
+# prim_app/pretrigger_ring.py
+
+import collections
+
+import numpy as np
+
+from utils.config import PRETRIGGER_SECONDS, PRETRIGGER_MAX_MB
+from writers.columnar_log import PRESSURE_RECORD_DTYPE
+
+
+class PreTriggerRing:
+    """
+    Time-bounded in-memory history of frames and samples while a recording is
+    armed but acquisition has not started yet.
+
+    Everything older than ``seconds`` (by host arrival time) is dropped, and
+    frame pixels are additionally capped at ``max_bytes``.  Frames are stored
+    as private copies borrowed from the frame pool, so the IC4 ring is never
+    starved.  ``drain`` hands the contents to the recorder when acquisition
+    starts.  Not thread-safe: all calls come from the recorder's thread.
+    """
+
+    def __init__(self, seconds=PRETRIGGER_SECONDS, max_bytes=PRETRIGGER_MAX_MB * 1024 * 1024):
+        self.seconds = max(0.0, float(seconds))
+        self.max_bytes = int(max_bytes)
+        self._frames = collections.deque()  # CameraFrame copies, oldest first
+        self._blocks = collections.deque()  # PRESSURE_RECORD_DTYPE blocks
+        self._bytes = 0
+        self.dropped_frames = 0
+
+    @property
+    def enabled(self):
+        return self.seconds > 0
+
+    def add_frame(self, frame):
+        """Keep a copy of ``frame`` (ownership of one reference passes to the ring)."""
+        if not self.enabled:
+            frame.release()
+            return
+        if frame.holds_buffer:
+            kept = frame.copy()
+            frame.release()
+            if kept is None:
+                # Memory budget exhausted (see threads/frame_pool.py)
+                self.dropped_frames += 1
+                return
+        else:
+            kept = frame
+        self._frames.append(kept)
+        self._bytes += kept.nbytes
+        self._trim(kept.host_timestamp)
+
+    def add_samples(self, block):
+        """Keep a (read-only) PRESSURE_RECORD_DTYPE block."""
+        if not self.enabled or not len(block):
+            return
+        self._blocks.append(block)
+        self._trim(float(block["hostTime"][-1]))
+
+    def _trim(self, now):
+        cutoff = now - self.seconds
+        while self._frames and (
+            self._frames[0].host_timestamp < cutoff or self._bytes > self.max_bytes
+        ):
+            old = self._frames.popleft()
+            self._bytes -= old.nbytes
+            old.release()
+            self.dropped_frames += 1
+        while self._blocks and float(self._blocks[0]["hostTime"][-1]) < cutoff:
+            self._blocks.popleft()
+
+    def drain(self):
+        """
+        Return ``(frames, samples)`` and empty the ring: the frames (the caller
+        takes over their references) and one PRESSURE_RECORD_DTYPE array of
+        the samples inside the window, both oldest first.
+        """
+        frames = list(self._frames)
+        self._frames.clear()
+        self._bytes = 0
+
+        if self._blocks:
+            samples = np.concatenate(list(self._blocks))
+            self._blocks.clear()
+            # The oldest block may straddle the cutoff
+            newest = max(
+                float(samples["hostTime"][-1]),
+                frames[-1].host_timestamp if frames else 0.0,
+            )
+            samples = samples[samples["hostTime"] >= newest - self.seconds]
+        else:
+            samples = np.empty(0, dtype=PRESSURE_RECORD_DTYPE)
+        return frames, samples
+
+    def clear(self):
+        while self._frames:
+            self._frames.popleft().release()
+        self._blocks.clear()
+        self._bytes = 0
+
+    def stats(self):
+        return {
+            "frames": len(self._frames),
+            "samples": sum(len(b) for b in self._blocks),
+            "megabytes": self._bytes / (1024 * 1024),
+            "dropped_frames": self.dropped_frames,
+        }
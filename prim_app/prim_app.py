@@ -5,15 +5,24 @@ import os
 import re
 import traceback
 import logging
-import imagingcontrol4 as ic4
+import argparse
+import threading
 
 from PyQt5.QtWidgets import QApplication, QMessageBox, QStyleFactory
 from PyQt5.QtCore import Qt, QCoreApplication
 from PyQt5.QtGui import QIcon, QSurfaceFormat, QPalette, QColor
-from utils.config import APP_NAME, APP_VERSION as CONFIG_APP_VERSION
-
-import matplotlib
+from utils.config import (
+    APP_NAME,
+    APP_VERSION as CONFIG_APP_VERSION,
+    PLOT_BACKENDS,
+    LOG_LEVEL,
+    SUPPORTED_FORMATS,
+    SERIAL_PROTOCOLS,
+    STARTUP_PRELOAD_MODULES,
+)
 
+# imagingcontrol4 and the file-format libraries are imported where they are
+# first needed (or preloaded in the background once the window is up)
 logging.getLogger("matplotlib").setLevel(logging.INFO)
 logging.getLogger("matplotlib.font_manager").setLevel(logging.WARNING)
 logging.getLogger("fontTools").setLevel(logging.WARNING)
@@ -22,7 +31,7 @@ logging.getLogger("fontTools").setLevel(logging.WARNING)
 # Configure Python-level logging
 # ------------------------------
 logging.basicConfig(
-    level=logging.DEBUG,
+    level=getattr(logging, LOG_LEVEL, logging.INFO),
     format="%(asctime)s - %(levelname)s [%(name)s:%(lineno)d] - %(message)s",
 )
 log = logging.getLogger(__name__)
@@ -99,7 +108,107 @@ def load_processed_qss(path):
         return ""
 
 
+def preload_modules(names):
+    """Import ``names`` on a daemon thread so first use does not stall the GUI."""
+
+    def _run():
+        for name in names:
+            try:
+                __import__(name)
+            except Exception as e:
+                log.debug(f"Preload of {name} skipped: {e}")
+
+    threading.Thread(target=_run, name="module-preload", daemon=True).start()
+
+
+def parse_cli_args(argv):
+    """Application flags; anything unknown is left for QApplication."""
+    parser = argparse.ArgumentParser(prog=APP_NAME, add_help=True)
+    parser.add_argument(
+        "--plot-backend",
+        choices=PLOT_BACKENDS,
+        default=None,
+        help="Live plot renderer (overrides the saved setting).",
+    )
+
+    headless = parser.add_argument_group(
+        "headless acquisition",
+        "Record without the GUI (camera + PRIM device + writer only). Settings "
+        "come from --config (JSON with the same names) and these flags.",
+    )
+    headless.add_argument("--headless", action="store_true", help="Run without the GUI.")
+    headless.add_argument("--config", help="JSON file with headless settings.")
+    headless.add_argument(
+        "--camera", help="Camera serial number, model or index (A,B for several)."
+    )
+    headless.add_argument("--resolution", help="Frame size as WxH (with --pixel-format).")
+    headless.add_argument("--pixel-format", dest="pixel_format", help="e.g. Mono16.")
+    headless.add_argument("--fps", type=float, help="AcquisitionFrameRate.")
+    headless.add_argument("--roi", help="Hardware capture ROI as X,Y,W,H (sensor px).")
+    headless.add_argument("--binning", type=int, help="Sensor binning factor.")
+    headless.add_argument("--serial-port", dest="serial_port", help="PRIM device port.")
+    headless.add_argument("--baud", type=int, help="Serial baud rate.")
+    headless.add_argument("--protocol", choices=SERIAL_PROTOCOLS, help="Serial framing.")
+    headless.add_argument("--output-dir", dest="output_dir", help="Recording folder.")
+    headless.add_argument("--format", choices=SUPPORTED_FORMATS, help="Video format.")
+    headless.add_argument(
+        "--duration", type=float, help="Stop after this many seconds (default: Ctrl+C)."
+    )
+    headless.add_argument(
+        "--pretrigger", type=float, help="Seconds of pre-trigger history to keep."
+    )
+    headless.add_argument(
+        "--simulate",
+        action="store_true",
+        default=None,
+        help="Use a synthetic camera and PRIM device (no hardware needed).",
+    )
+    args, qt_args = parser.parse_known_args(argv[1:])
+    return args, [argv[0]] + qt_args
+
+
+def headless_entry(cli_args, qt_argv):
+    """``--headless``: QCoreApplication event loop, no widgets or OpenGL."""
+    from headless import load_headless_config, run_headless, DEFAULTS
+
+    overrides = {k: getattr(cli_args, k, None) for k in DEFAULTS}
+    try:
+        settings = load_headless_config(cli_args.config, overrides)
+    except Exception as e:
+        log.error(f"Could not read headless config {cli_args.config}: {e}")
+        sys.exit(2)
+
+    # --simulate needs no camera driver; IC4 is only loaded for hardware runs
+    ic4 = None
+    if not settings["simulate"]:
+        try:
+            import imagingcontrol4 as ic4
+
+            ic4.Library.init(
+                api_log_level=ic4.LogLevel.INFO, log_targets=ic4.LogTarget.STDERR
+            )
+        except Exception as e:
+            log.error(f"Could not initialize IC4: {e}")
+            sys.exit(1)
+
+    app = QCoreApplication(qt_argv)
+    exit_code = run_headless(app, settings)
+    log.info(f"Headless run ended with exit code {exit_code}.")
+
+    if ic4 is not None:
+        try:
+            ic4.Library.exit()
+        except Exception:
+            pass
+
+    sys.exit(exit_code)
+
+
 def main_app_entry():
+    cli_args, qt_argv = parse_cli_args(sys.argv)
+    if cli_args.headless:
+        headless_entry(cli_args, qt_argv)
+
     # ─── Set Default OpenGL 3.3 Core Profile ─────────────────────────────
     fmt = QSurfaceFormat()
     fmt.setRenderableType(QSurfaceFormat.OpenGL)
@@ -117,19 +226,11 @@ def main_app_entry():
     if hasattr(Qt, "AA_UseHighDpiPixmaps"):
         QCoreApplication.setAttribute(Qt.AA_UseHighDpiPixmaps, True)
 
-    # ─── Initialize IC4 globally so MainWindow can enumerate devices ─────────
-    try:
-        ic4.Library.init(
-            api_log_level=ic4.LogLevel.INFO, log_targets=ic4.LogTarget.STDERR
-        )
-        log.info("Global IC4 Library.init() succeeded.")
-    except Exception as e:
-        log.error(f"Could not initialize IC4 in main thread: {e}")
-        # You might still allow the UI to start (with an empty device list),
-        # or choose to exit right here with sys.exit(1).
+    # IC4 is loaded and initialized by MainWindow's background device scan
+    # (threads/device_enumerator.py), not here, so the window shows at once.
 
     # Create the QApplication
-    app = QApplication(sys.argv)
+    app = QApplication(qt_argv)
     apply_dark_theme(app)
 
     # Log what OpenGL/QSurfaceFormat we actually got
@@ -205,20 +306,25 @@ def main_app_entry():
         app.setStyle(QStyleFactory.create("Fusion"))
 
     # ─── Import & Launch MainWindow ───────────────────────────────────────
-    from main_window import MainWindow
+    from main_window import MainWindow, wait_for_detached_recorders
 
-    main_win = MainWindow()
+    main_win = MainWindow(plot_backend=cli_args.plot_backend)
     display_version = CONFIG_APP_VERSION or "Unknown"
     main_win.setWindowTitle(f"{APP_NAME} v{display_version}")
     main_win.show()
+    preload_modules(STARTUP_PRELOAD_MODULES)
 
     exit_code = app.exec_()
     log.info(f"Application event loop ended with exit code {exit_code}.")
-
-    try:
-        ic4.Library.exit()
-    except Exception:
-        pass
+    # A recorder the user stopped waiting for at close still has open writers
+    wait_for_detached_recorders()
+
+    ic4 = sys.modules.get("imagingcontrol4")
+    if ic4 is not None:
+        try:
+            ic4.Library.exit()
+        except Exception:
+            pass
 
     sys.exit(exit_code)
 
@@ -1,13 +1,23 @@
-import tifffile
-import json
+import sys
 
-# Replace "recording_video.tif" with the actual file name (or full path)
+import numpy as np
+
+from writers.recording_index import open_index
+
+# Replace "recording_video.tif" with the actual file name (or full path), or
+# pass it on the command line
 tif_path = "C:/Users/Tykocki Lab - PRIM/Documents/PRIMAcquisition Results/2025-06-06/Fill1/recording_2025-06-06_12-35-41_video.tif"
+if len(sys.argv) > 1:
+    tif_path = sys.argv[1]
 
-with tifffile.TiffFile(tif_path) as tif:
-    for page in tif.pages:
-        desc = page.tags["ImageDescription"].value
-        data = json.loads(desc)
-        print(
-            f"frameIdx={data['frameIdx']},  deviceTime={data['deviceTime']},  pressure={data['pressure']}"
-        )
+# The sidecar index (<video>_index.npy) is memory-mapped; recordings without
+# one are scanned page by page once and get an index for next time.
+index = open_index(tif_path)
+for row in index:
+    # Unmatched frames (no CamTrig sample) have frameIdx -1 and no pressure
+    device_time = None if np.isnan(row["deviceTime"]) else float(row["deviceTime"])
+    pressure = None if np.isnan(row["pressure"]) else float(row["pressure"])
+    print(
+        f"page={row['pageIdx']},  frameIdx={row['frameIdx']},  "
+        f"deviceTime={device_time},  pressure={pressure}"
+    )
@@ -1,67 +1,238 @@
 # prim_app/recording_manager.py
 
+import functools
 import os
 import time
-import csv
-import json
 import numpy as np
-import tifffile
 from PyQt5.QtCore import QObject, pyqtSlot, pyqtSignal
 from PyQt5.QtGui import QImage
 
+from frame_sync import FrameSyncEngine
+from pretrigger_ring import PreTriggerRing
+from threads.frame_pool import frame_pool
+from threads.frame_writer_thread import FrameWriterThread
+from utils.config import (
+    CAMERA_TRIGGER_MODE,
+    DEFAULT_RECORDING_FORMAT,
+    PRESSURE_LOG_EXPORT_CSV,
+    PRETRIGGER_MAX_MB,
+    PRETRIGGER_SECONDS,
+    RECORDING_CHECKPOINT_S,
+    SYNC_LOCK_TOLERANCE_S,
+    TELEMETRY_EXPORT,
+)
+from utils.telemetry import telemetry, TelemetryLog
+from writers.frame_writers import create_frame_writer
+from writers.columnar_log import (
+    ColumnarLogWriter,
+    DIAMETER_CSV_COLUMNS,
+    DIAMETER_RECORD_DTYPE,
+    DSP_CSV_COLUMNS,
+    DSP_RECORD_DTYPE,
+    PRESSURE_RECORD_DTYPE,
+    SYNC_RECORD_DTYPE,
+    export_csv,
+)
+
+
+def _geometry_metadata(capture_geometry):
+    """Page metadata keys for a SDKCameraThread.capture_geometry dict."""
+    geom = capture_geometry or {}
+    return {
+        key: int(geom[src])
+        for key, src in (
+            ("roiX", "x"),
+            ("roiY", "y"),
+            ("roiWidth", "width"),
+            ("roiHeight", "height"),
+            ("binning", "binning"),
+        )
+        if geom.get(src) is not None
+    }
+
+
+class CameraStream:
+    """
+    Everything one camera writes during a recording: its frame backend and
+    write-behind FrameWriterThread, FrameSyncEngine and sync index,
+    pre-trigger ring and page counter.  Camera 0 keeps the single-camera
+    file names; camera ``k`` adds ``_cam<k>`` to its video and sync index.
+    """
+
+    def __init__(self, camera_id, capture_geometry=None, triggered=CAMERA_TRIGGER_MODE):
+        self.camera_id = int(camera_id)
+        # Hardware-triggered cameras are paired by frame counter, free-running
+        # ones by host time (see FrameSyncEngine)
+        self.triggered = bool(triggered)
+        self.suffix = "" if self.camera_id == 0 else f"_cam{self.camera_id}"
+        # Hardware ROI/binning of the camera, stored on every page so the
+        # stack can be placed on the full sensor
+        self.geometry_metadata = _geometry_metadata(capture_geometry)
+
+        self.backend = None
+        self.tiff_path = None
+        self.sync_path = None
+        self.frame_writer = None  # FrameWriterThread (write-behind stage)
+        self.sync_log = None  # ColumnarLogWriter (frame ↔ sample pairings)
+        self.sync = None  # FrameSyncEngine
+        self.pretrigger = None  # PreTriggerRing while armed
+        self.frame_counter = 0
+
 
 class RecordingManager(QObject):
-    """Manage synchronized writing of pressure data and camera frames."""
+    """
+    Manage synchronized writing of pressure data and camera frames.
 
-    # Emitted when :func:`start_recording` has finished its setup and the worker
-    # is ready to receive the first Arduino tick.  The main window can listen for
-    # this signal to safely start the hardware acquisition.
+    :meth:`start_recording` *arms* the recorder: every output file is opened
+    and the writer thread started before acquisition, and frames and samples
+    go into a PRETRIGGER_SECONDS ring.  :meth:`trigger` (called straight away
+    unless ``wait_for_trigger`` is set) starts the acquisition; the first
+    Arduino tick after it writes the ring to the recording and switches to
+    live writing.
+
+    Several cameras on the same CamTrig line can feed :meth:`append_frame`;
+    frames are routed by ``CameraFrame.camera_id`` to a :class:`CameraStream`
+    each (``cameras``), and every stream is paired against the one pressure
+    log.  ``writer_stats`` and ``sync_stats`` carry a ``camera_id`` key.
+    ``trigger_modes`` ({camera_id: bool}) says which cameras run in hardware
+    trigger mode; the others default to CAMERA_TRIGGER_MODE.
+    """
+
+    # Emitted once the worker is armed (files open, pre-trigger ring filling)
+    armed = pyqtSignal()
+    # Emitted by :func:`trigger` when the worker is ready to receive the first
+    # Arduino tick.  The main window can listen for this signal to safely
+    # start the hardware acquisition.
     ready_for_acquisition = pyqtSignal()
     finished = pyqtSignal()
 
-    def __init__(self, output_dir, parent=None):
+    # Forwarded from each FrameWriterThread: queue depth, MB/s, drops, …
+    writer_stats = pyqtSignal(dict)
+    # FrameSyncEngine counters of each stream (matched / unmatched, …)
+    sync_stats = pyqtSignal(dict)
+    # (camera_id, message, any_writer_left): a stream's frame writer failed
+    # and that camera is no longer recorded
+    writer_failed = pyqtSignal(int, str, bool)
+
+    def __init__(
+        self,
+        output_dir,
+        recording_format=DEFAULT_RECORDING_FORMAT,
+        wait_for_trigger=False,
+        pretrigger_s=PRETRIGGER_SECONDS,
+        capture_geometry=None,
+        cameras=None,
+        trigger_modes=None,
+        parent=None,
+    ):
         super().__init__(parent)
         self.output_dir = output_dir
+        self.recording_format = recording_format  # key into writers.WRITER_BACKENDS
+        self.wait_for_trigger = wait_for_trigger
+        self.pretrigger_s = pretrigger_s
+        # {camera_id: capture_geometry} of every camera feeding append_frame;
+        # one camera (id 0) unless told otherwise
+        if not cameras:
+            cameras = {0: capture_geometry}
+        trigger_modes = {int(cid): on for cid, on in (trigger_modes or {}).items()}
+        self.streams = {
+            int(cid): CameraStream(
+                cid, geom, trigger_modes.get(int(cid), CAMERA_TRIGGER_MODE)
+            )
+            for cid, geom in sorted(cameras.items())
+        }
+        self._unknown_cameras = set()
 
         # Paths (populated in ``start_recording``)
+        self._log_path = None
         self._csv_path = None
-        self._tiff_path = None
+        self._telemetry_path = None
+        self._diameter_path = None
+        self._dsp_path = None
 
         # File handles & writers
-        self.csv_file = None
-        self.csv_writer = None
-        self.tif_writer = None
+        self.pressure_log = None  # ColumnarLogWriter (binary pressure log)
+        self.telemetry_log = None  # TelemetryLog (one snapshot per second)
+        self.diameter_log = None  # ColumnarLogWriter, opened by the first diameters
+        self.dsp_log = None  # ColumnarLogWriter, opened by the first processed block
 
-        # Recording flags
+        # Recording flags: armed → triggered → first sample (live)
         self.is_recording = False
+        self._triggered = False
         self._got_first_sample = False
 
-        # Frame counter and timer
-        self._frame_counter = 0
-        self._last_device_time = 0
+        # Last stats emission / log checkpoint
+        self._last_sync_stats = 0.0
+        self._last_checkpoint = 0.0
 
     @pyqtSlot()
     def start_recording(self):
-        """Prepare file paths and wait for the first pressure sample."""
+        """Arm: open every output file and start filling the pre-trigger ring."""
         timestamp = time.strftime("%Y-%m-%d_%H-%M-%S")
         base_name = f"recording_{timestamp}"
 
         os.makedirs(self.output_dir, exist_ok=True)
+        self._log_path = os.path.join(self.output_dir, f"{base_name}_pressure.bin")
         self._csv_path = os.path.join(self.output_dir, f"{base_name}_pressure.csv")
-        self._tiff_path = os.path.join(self.output_dir, f"{base_name}_video.tif")
+        self._telemetry_path = os.path.join(
+            self.output_dir, f"{base_name}_telemetry.jsonl"
+        )
+        self._diameter_path = os.path.join(self.output_dir, f"{base_name}_diameter.bin")
+        self._dsp_path = os.path.join(self.output_dir, f"{base_name}_dsp.bin")
 
-        self.is_recording = True
+        self._triggered = False
         self._got_first_sample = False
-        self._frame_counter = 0
-        self._last_device_time = 0
+        self._unknown_cameras.clear()
+        # The pre-trigger memory cap is shared by all cameras
+        ring_bytes = PRETRIGGER_MAX_MB * 1024 * 1024 // len(self.streams)
+        for stream in self.streams.values():
+            stream.sync_path = os.path.join(
+                self.output_dir, f"{base_name}{stream.suffix}_sync.bin"
+            )
+            stream.backend = create_frame_writer(
+                self.recording_format,
+                os.path.join(self.output_dir, f"{base_name}{stream.suffix}_video"),
+            )
+            stream.tiff_path = stream.backend.path
+            stream.frame_counter = 0
+            stream.sync = FrameSyncEngine(
+                functools.partial(self._write_frame, stream),
+                counter_pairing=stream.triggered,
+            )
+            stream.pretrigger = PreTriggerRing(self.pretrigger_s, ring_bytes)
+
+        # Opening files (and the writer threads' backends) here keeps that
+        # latency off the first frames of the fill
+        if not self._open_outputs():
+            # Stays idle; stop_recording still finishes the worker
+            for stream in self.streams.values():
+                stream.pretrigger = None
+            return
+        if TELEMETRY_EXPORT:
+            try:
+                self.telemetry_log = TelemetryLog(self._telemetry_path)
+            except Exception as e:
+                print(f"[RecordingManager] Failed to open telemetry log: {e}")
+                self.telemetry_log = None
+        self.is_recording = True
 
         print(
-            f"[RecordingManager] Ready to record →\n  CSV will be: {self._csv_path}\n  TIFF will be: {self._tiff_path}"
+            f"[RecordingManager] Armed →\n  Log: {self._log_path}\n{self._video_paths()}"
+            f"  Pre-trigger ring: {self.pretrigger_s:.1f} s"
         )
-        print("[RecordingManager] Waiting for the first Arduino tick to open files...")
-        # Notify the GUI that the worker thread finished setup and the files
-        # paths have been prepared.  The application can now start the Arduino
-        # so the first sample will create the CSV/TIFF files.
+        self.armed.emit()
+        if not self.wait_for_trigger:
+            self.trigger()
+
+    @pyqtSlot()
+    def trigger(self):
+        """Start the acquisition of an armed recording."""
+        if not self.is_recording or self._triggered:
+            return
+        self._triggered = True
+        print("[RecordingManager] Triggered; waiting for the first Arduino tick...")
+        # Notify the GUI that the application can now start the Arduino; the
+        # first sample flushes the pre-trigger ring into the files.
         self.ready_for_acquisition.emit()
 
     @pyqtSlot(int, float, float)
@@ -69,105 +240,476 @@ class RecordingManager(QObject):
         """Handle a pressure sample from the serial thread."""
         if not self.is_recording:
             return
+        row = np.array(
+            [(frameIdx, t_device, pressure, time.time())], dtype=PRESSURE_RECORD_DTYPE
+        )
+        self.append_pressure_block(row)
+
+    @pyqtSlot(object)
+    def append_pressure_block(self, block):
+        """
+        Handle a block of samples from SerialThread.samples_ready (a
+        PRESSURE_RECORD_DTYPE structured array); written with one call.
+        """
+        if not self.is_recording or not len(block):
+            return
+        telemetry.record(
+            "queue.samples_to_recorder", time.time() - float(block["hostTime"][-1])
+        )
 
         if not self._got_first_sample:
-            self._got_first_sample = True
+            if not self._triggered:
+                for stream in self.streams.values():
+                    stream.pretrigger.add_samples(block)
+                return
+            self._start_acquisition()
+
+        if self.pressure_log:
             try:
-                self.csv_file = open(self._csv_path, "w", newline="")
-                self.csv_writer = csv.writer(self.csv_file)
-                self.csv_writer.writerow(["frameIdx", "deviceTime", "pressure"])
+                self.pressure_log.append_block(block)
             except Exception as e:
-                print(f"[RecordingManager] Failed to open CSV: {e}")
-                self.is_recording = False
+                print(
+                    f"[RecordingManager] Error writing log block "
+                    f"(frameIdx {block['frameIdx'][0]}–{block['frameIdx'][-1]}): {e}"
+                )
+            for stream in self.streams.values():
+                stream.sync.add_samples(block)
+            self._maybe_emit_sync_stats()
+            self._maybe_checkpoint()
+
+    @pyqtSlot(object)
+    def append_diameter_block(self, rows):
+        """
+        Handle a block of live diameters from DiameterTracker.diameters_ready
+        (DIAMETER_RECORD_DTYPE).  Only measurements made after the first
+        sample are kept; the log is opened when the first block arrives, so
+        recordings without ROIs get no diameter file.
+        """
+        if not self.is_recording or not self._got_first_sample or not len(rows):
+            return
+        if self.diameter_log is None:
+            if self._diameter_path is None:  # failed to open earlier
                 return
             try:
-                self.tif_writer = tifffile.TiffWriter(self._tiff_path, bigtiff=True)
+                self.diameter_log = ColumnarLogWriter(
+                    self._diameter_path,
+                    DIAMETER_RECORD_DTYPE,
+                    attrs={"rois": int(rows["roi"].max()) + 1},
+                )
             except Exception as e:
-                print(f"[RecordingManager] Failed to open TIFF: {e}")
-                if self.csv_file:
-                    self.csv_file.close()
-                    self.csv_file = None
-                    self.csv_writer = None
-                self.is_recording = False
+                print(f"[RecordingManager] Failed to open diameter log: {e}")
+                self._diameter_path = None
                 return
-            print(
-                f"[RecordingManager] Recording truly started →\n  CSV: {self._csv_path}\n  TIFF: {self._tiff_path}"
-            )
+        try:
+            self.diameter_log.append_block(rows)
+        except Exception as e:
+            print(f"[RecordingManager] Error writing diameter block: {e}")
 
-        if self.csv_writer:
+    @pyqtSlot(object)
+    def append_processed_block(self, block):
+        """
+        Handle a SerialThread.processed_ready block (DSP_RECORD_DTYPE).  Like
+        the diameters, only blocks after the first sample are kept; the raw
+        pressure log stays the reference, this one holds the derived channels.
+        """
+        if not self.is_recording or not self._got_first_sample or not len(block):
+            return
+        if self.dsp_log is None:
+            if self._dsp_path is None:  # failed to open earlier
+                return
             try:
-                self.csv_writer.writerow([frameIdx, t_device, pressure])
-                self._last_device_time = t_device
+                self.dsp_log = ColumnarLogWriter(self._dsp_path, DSP_RECORD_DTYPE)
+            except Exception as e:
+                print(f"[RecordingManager] Failed to open DSP log: {e}")
+                self._dsp_path = None
+                return
+        try:
+            self.dsp_log.append_block(block)
+        except Exception as e:
+            print(f"[RecordingManager] Error writing DSP block: {e}")
+
+    def _open_outputs(self):
+        """Open the pressure log, then every camera's sync index and frame writer."""
+        try:
+            self.pressure_log = ColumnarLogWriter(self._log_path)
+        except Exception as e:
+            print(f"[RecordingManager] Failed to open pressure log: {e}")
+            return False
+        for stream in self.streams.values():
+            try:
+                stream.sync_log = ColumnarLogWriter(stream.sync_path, SYNC_RECORD_DTYPE)
+            except Exception as e:
+                # Pairings are still written into every page's metadata
+                print(
+                    f"[RecordingManager] Failed to open sync index of camera "
+                    f"{stream.camera_id}: {e}"
+                )
+                stream.sync_log = None
+            try:
+                stream.frame_writer = FrameWriterThread(stream.backend)
+                stream.frame_writer.stats_updated.connect(
+                    functools.partial(self._forward_writer_stats, stream.camera_id)
+                )
+                stream.frame_writer.error_occurred.connect(
+                    functools.partial(self._on_writer_error, stream.camera_id)
+                )
+                stream.frame_writer.start()
             except Exception as e:
                 print(
-                    f"[RecordingManager] Error writing CSV row ({frameIdx}, {t_device}, {pressure}): {e}"
+                    f"[RecordingManager] Failed to start TIFF writer of camera "
+                    f"{stream.camera_id}: {e}"
                 )
+                stream.frame_writer = None
+                self._close_outputs()
+                return False
+        return True
+
+    def _close_outputs(self):
+        """Undo a partial :meth:`_open_outputs`."""
+        if self.pressure_log:
+            self.pressure_log.close()
+            self.pressure_log = None
+        for stream in self.streams.values():
+            if stream.frame_writer is not None:
+                stream.frame_writer.finish()
+                stream.frame_writer.wait()
+                stream.frame_writer = None
+            if stream.sync_log:
+                stream.sync_log.close()
+                stream.sync_log = None
+
+    def _start_acquisition(self):
+        """First sample after the trigger: write the pre-trigger rings, go live."""
+        self._got_first_sample = True
+        drained = {cid: s.pretrigger.drain() for cid, s in self.streams.items()}
+        # Every ring saw the same samples; write them to the log once
+        samples = next(iter(drained.values()))[1]
+        if len(samples) and self.pressure_log:
+            try:
+                self.pressure_log.append_block(samples)
+            except Exception as e:
+                print(f"[RecordingManager] Error writing pre-trigger samples: {e}")
+
+        # Pre-trigger frames were not paired by hardware counters; each page
+        # gets the sample nearest in host time as its baseline reading.
+        host_times = samples["hostTime"]
+        n_frames = 0
+        for cid, (frames, _) in drained.items():
+            stream = self.streams[cid]
+            n_frames += len(frames)
+            for frame in frames:
+                sample = None
+                if len(samples):
+                    i = int(np.searchsorted(host_times, frame.host_timestamp))
+                    near = [j for j in (i - 1, i) if 0 <= j < len(samples)]
+                    j = min(near, key=lambda k: abs(host_times[k] - frame.host_timestamp))
+                    if abs(host_times[j] - frame.host_timestamp) <= SYNC_LOCK_TOLERANCE_S:
+                        sample = samples[j]
+                self._write_frame(stream, frame, sample, pre_trigger=True)
+
+        print(
+            f"[RecordingManager] Recording truly started ({n_frames} pre-trigger "
+            f"frames, {len(samples)} pre-trigger samples) →\n"
+            f"  Log: {self._log_path}\n{self._video_paths()}"
+        )
+
+    def _video_paths(self):
+        """One ``TIFF:`` line per camera for the log messages."""
+        if len(self.streams) == 1:
+            return f"  TIFF: {next(iter(self.streams.values())).tiff_path}\n"
+        return "".join(
+            f"  TIFF (camera {cid}): {stream.tiff_path}\n"
+            for cid, stream in self.streams.items()
+        )
 
     @pyqtSlot(QImage, object)
-    def append_frame(self, qimage, raw):
-        """Handle a camera frame from the camera thread."""
-        if not self.is_recording or not self._got_first_sample:
-            return
+    def append_frame(self, qimage, frame):
+        """Handle a camera frame from the camera thread.
+
+        ``frame`` is a :class:`~threads.camera_frame.CameraFrame`; it goes to
+        the FrameSyncEngine of its camera's stream, which pairs it with its
+        Arduino sample by hardware frame counters and then calls
+        :meth:`_write_frame`.  The preview ``qimage`` is ignored.
+        """
+        try:
+            if not self.is_recording:
+                return
+            telemetry.record("queue.frame_to_recorder", time.time() - frame.host_timestamp)
 
-        if self.tif_writer:
+            stream = self.streams.get(frame.camera_id)
+            if stream is None:
+                if frame.camera_id not in self._unknown_cameras:
+                    self._unknown_cameras.add(frame.camera_id)
+                    print(
+                        f"[RecordingManager] Ignoring frames of camera "
+                        f"{frame.camera_id} (not part of this recording)."
+                    )
+                return
+
+            if not self._got_first_sample:
+                # Armed (or triggered, before the first tick): keep a copy
+                stream.pretrigger.add_frame(frame)
+                frame = None
+                return
+
+            if stream.frame_writer:
+                # The sync engine takes over our frame reference
+                stream.sync.add_frame(frame)
+                frame = None
+                self._maybe_emit_sync_stats()
+        finally:
+            if frame is not None:
+                frame.release()
+
+    def _write_frame(self, stream, frame, sample, pre_trigger=False):
+        """
+        FrameSyncEngine callback (bound to ``stream``): write one page with
+        its paired sample (``None`` if unmatched) and record the pairing in
+        the stream's sync index.  ``pre_trigger`` pages come from the ring,
+        paired by host time only.
+        """
+        matched = sample is not None
+        metadata = {
+            "frameIdx": int(sample["frameIdx"]) if matched else -1,
+            "deviceTime": float(sample["deviceTime"]) if matched else None,
+            "pressure": float(sample["pressure"]) if matched else None,
+            "pageIdx": stream.frame_counter,
+            "cameraFrame": int(frame.frame_number),
+            "cameraTimestampNs": int(frame.device_timestamp_ns),
+        }
+        if len(self.streams) > 1:
+            metadata["cameraId"] = stream.camera_id
+        metadata.update(stream.geometry_metadata)
+        if pre_trigger:
+            metadata["preTrigger"] = True
+        row = (
+            stream.frame_counter,
+            int(frame.frame_number),
+            int(frame.device_timestamp_ns),
+            metadata["frameIdx"],
+            metadata["deviceTime"] if matched else np.nan,
+            metadata["pressure"] if matched else np.nan,
+            frame.host_timestamp,
+        )
+
+        # The writer takes over the frame reference and releases it once the
+        # page is on disk (or dropped by its policy).
+        writer = stream.frame_writer
+        if writer is not None and writer.submit(frame, metadata):
+            stream.frame_counter += 1
+        else:
+            row = (-1,) + row[1:]
+            if writer is None:
+                frame.release()
+
+        if stream.sync_log is not None:
+            try:
+                stream.sync_log.append(*row)
+            except Exception as e:
+                print(f"[RecordingManager] Error writing sync index row: {e}")
+
+    def _maybe_emit_sync_stats(self):
+        now = time.monotonic()
+        if now - self._last_sync_stats >= 1.0:
+            self._last_sync_stats = now
+            self._write_telemetry(self._emit_sync_stats())
+
+    def _maybe_checkpoint(self):
+        """
+        Every RECORDING_CHECKPOINT_S, fsync the columnar logs so a crash or
+        power loss loses at most that much of them (the stacks are
+        checkpointed by their FrameWriterThread).
+        """
+        now = time.monotonic()
+        if now - self._last_checkpoint < RECORDING_CHECKPOINT_S:
+            return
+        self._last_checkpoint = now
+        logs = [self.pressure_log, self.diameter_log, self.dsp_log, self.telemetry_log]
+        logs += [stream.sync_log for stream in self.streams.values()]
+        for out in logs:
+            if out is None:
+                continue
             try:
-                arr = self._qimage_to_numpy(qimage)
-                metadata = {"frameIdx": self._frame_counter, "deviceTime": self._last_device_time}  # Embed device time for FPS tracking
-                self.tif_writer.write(arr, description=json.dumps(metadata))
-                self._frame_counter += 1
+                out.sync()
             except Exception as e:
-                failed_idx = max(0, self._frame_counter)
-                print(f"[RecordingManager] Error writing TIFF page for frame {failed_idx}: {e}")
+                print(f"[RecordingManager] Error syncing {out.path}: {e}")
+
+    def _emit_sync_stats(self):
+        """Emit ``sync_stats`` for every stream; returns ``{camera_id: stats}``."""
+        all_stats = {}
+        for cid, stream in self.streams.items():
+            if stream.sync is None:
+                continue
+            stats = dict(stream.sync.stats(), camera_id=cid)
+            all_stats[cid] = stats
+            self.sync_stats.emit(stats)
+        return all_stats
+
+    def _forward_writer_stats(self, camera_id, stats):
+        self.writer_stats.emit(dict(stats, camera_id=camera_id))
+
+    def _write_telemetry(self, sync_stats, writer_stats=None):
+        """
+        Append the pipeline counters plus each camera's sync and writer stats
+        (``{camera_id: stats}``) to the telemetry log.  Camera 0 stays under
+        the ``sync``/``writer`` keys; others go under ``cameras``.
+        """
+        if self.telemetry_log is None:
+            return
+        memory = frame_pool.stats()  # also refreshes the memory.* gauges
+        snapshot = telemetry.snapshot()
+        snapshot["memory"] = memory
+        writer_stats = dict(writer_stats or {})
+        for cid, stream in self.streams.items():
+            if cid not in writer_stats and stream.frame_writer is not None:
+                writer_stats[cid] = stream.frame_writer.get_stats()
+        cameras = {}
+        for cid in self.streams:
+            entry = {}
+            if cid in sync_stats:
+                entry["sync"] = sync_stats[cid]
+            if cid in writer_stats:
+                entry["writer"] = writer_stats[cid]
+            cameras[cid] = entry
+        primary = cameras.pop(next(iter(self.streams)), {})
+        snapshot.update(primary)
+        if cameras:
+            snapshot["cameras"] = {str(cid): entry for cid, entry in cameras.items()}
+        try:
+            self.telemetry_log.write(snapshot)
+        except Exception as e:
+            print(f"[RecordingManager] Error writing telemetry: {e}")
+            self.telemetry_log = None
+
+    def queued_frames(self):
+        """
+        Frames still waiting in the writer queues.  Safe to call from another
+        thread (e.g. the GUI while stop_recording drains them).
+        """
+        total = 0
+        for stream in list(self.streams.values()):
+            writer = stream.frame_writer
+            if writer is not None:
+                total += writer.get_stats()["queue_depth"]
+        return total
 
     @pyqtSlot()
     def stop_recording(self):
         """Close files and reset state."""
         if not self.is_recording:
+            self.finished.emit()
             return
 
         self.is_recording = False
 
+        for stream in self.streams.values():
+            if stream.pretrigger is not None:
+                # Never triggered (disarmed): the ring is not part of the recording
+                if not self._got_first_sample:
+                    print(
+                        f"[RecordingManager] Disarmed before acquisition; discarding "
+                        f"{stream.pretrigger.stats()['frames']} pre-trigger frames "
+                        f"of camera {stream.camera_id}."
+                    )
+                stream.pretrigger.clear()
+                stream.pretrigger = None
+
+            # Hand every frame still waiting for its sample to the writer
+            if stream.sync is not None:
+                stream.sync.flush()
+
+        sync_final = self._emit_sync_stats()
+        for cid, stats in sync_final.items():
+            print(
+                f"[RecordingManager] Sync (camera {cid}): {stats['matched']} matched, "
+                f"{stats['unmatched_frames']} unmatched frames, "
+                f"{stats['unmatched_samples']} unmatched samples, "
+                f"{stats['pre_trigger_frames']} frames before the offset lock "
+                f"(written unmatched), {stats['skew_violations']} skew violations."
+            )
+
+        writer_final = {}
+        for cid, stream in self.streams.items():
+            try:
+                if stream.frame_writer:
+                    # Let the writer drain its queue before the file is closed
+                    stream.frame_writer.finish()
+                    stream.frame_writer.wait()
+                    writer_final[cid] = stream.frame_writer.get_stats()
+                    self.writer_stats.emit(dict(writer_final[cid], camera_id=cid))
+                    stream.frame_writer = None
+            except Exception as e:
+                print(f"[RecordingManager] Error closing TIFF of camera {cid}: {e}")
+
         try:
-            if self.tif_writer:
-                self.tif_writer.close()
-                self.tif_writer = None
+            if self.pressure_log:
+                self.pressure_log.close()
+                self.pressure_log = None
+                if PRESSURE_LOG_EXPORT_CSV:
+                    # Keep producing the CSV layout existing analysis expects
+                    export_csv(self._log_path, self._csv_path)
         except Exception as e:
-            print(f"[RecordingManager] Error closing TIFF: {e}")
+            print(f"[RecordingManager] Error closing pressure log: {e}")
+
+        for cid, stream in self.streams.items():
+            try:
+                if stream.sync_log:
+                    stream.sync_log.close()
+                    stream.sync_log = None
+            except Exception as e:
+                print(f"[RecordingManager] Error closing sync index of camera {cid}: {e}")
 
         try:
-            if self.csv_file:
-                self.csv_file.close()
-                self.csv_file = None
-                self.csv_writer = None
+            if self.diameter_log:
+                self.diameter_log.close()
+                self.diameter_log = None
+                if PRESSURE_LOG_EXPORT_CSV:
+                    export_csv(self._diameter_path, columns=DIAMETER_CSV_COLUMNS)
         except Exception as e:
-            print(f"[RecordingManager] Error closing CSV: {e}")
+            print(f"[RecordingManager] Error closing diameter log: {e}")
 
+        try:
+            if self.dsp_log:
+                self.dsp_log.close()
+                self.dsp_log = None
+                if PRESSURE_LOG_EXPORT_CSV:
+                    export_csv(self._dsp_path, columns=DSP_CSV_COLUMNS)
+        except Exception as e:
+            print(f"[RecordingManager] Error closing DSP log: {e}")
+
+        try:
+            if self.telemetry_log:
+                # Final snapshot, with the writer's totals after draining
+                self._write_telemetry(sync_final, writer_final)
+            if self.telemetry_log:
+                self.telemetry_log.close()
+                self.telemetry_log = None
+        except Exception as e:
+            print(f"[RecordingManager] Error closing telemetry log: {e}")
+
+        self._triggered = False
         self._got_first_sample = False
-        self._frame_counter = 0
+        for stream in self.streams.values():
+            stream.frame_counter = 0
+            stream.sync = None
+        # Spill/pre-trigger buffers are not needed until the next recording
+        frame_pool.trim()
 
         print("[RecordingManager] Recording stopped and files closed.")
         self.finished.emit()
 
-    def _qimage_to_numpy(self, qimage):
-        """Convert a ``QImage`` to a ``numpy.ndarray``.
-
-        If the image is already 8‑bit grayscale, the raw bytes are read
-        directly into a ``(H, W)`` ``uint8`` array.  Otherwise the image is
-        converted to ARGB32 and the returned array has shape ``(H, W, 3)`` in
-        RGB order.
-        """
-
-        fmt = qimage.format()
-        if fmt in (QImage.Format_Grayscale8, QImage.Format_Indexed8):
-            w, h = qimage.width(), qimage.height()
-            ptr = qimage.bits()
-            ptr.setsize(qimage.byteCount())
-            arr = np.frombuffer(ptr, np.uint8).reshape((h, w))
-            return arr
-
-        qimg = qimage.convertToFormat(QImage.Format_ARGB32)
-        w, h = qimg.width(), qimg.height()
-        ptr = qimg.bits()
-        ptr.setsize(qimg.byteCount())
-        arr = np.frombuffer(ptr, np.uint8).reshape((h, w, 4))
-        return arr[:, :, [2, 1, 0]]
\ No newline at end of file
+    def _on_writer_error(self, camera_id, msg):
+        """
+        A frame writer gave up (it refuses further frames): stop feeding that
+        stream and tell the UI, so the recording does not look healthy while
+        the camera's pages go nowhere.
+        """
+        print(f"[RecordingManager] TIFF writer error (camera {camera_id}): {msg}")
+        stream = self.streams.get(camera_id)
+        if stream is not None and stream.frame_writer is not None:
+            writer = stream.frame_writer
+            stream.frame_writer = None
+            # The writer's run() returns right after reporting the failure
+            writer.wait()
+        any_left = any(s.frame_writer is not None for s in self.streams.values())
+        self.writer_failed.emit(camera_id, msg, any_left)
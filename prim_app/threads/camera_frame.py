@@ -0,0 +1,171 @@
+# prim_app/threads/camera_frame.py
+
+import threading
+import time
+
+from threads.frame_pool import frame_pool
+
+
+class CameraFrame:
+    """
+    A single camera frame as it travels from SDKCameraThread to its consumers.
+
+    Carries the raw ``numpy`` view of the IC4 image buffer (no copy) plus the
+    metadata that came with it.  The IC4 buffer is kept out of the sink's free
+    queue until every consumer has called :meth:`release`, so ``array`` (and a
+    QImage built on top of it) stays valid for as long as anyone holds the frame.
+
+    Reference counting protocol:
+      * The producer owns one reference when the frame is created.
+      * Before emitting, the producer calls ``retain(n)`` for the ``n`` slots
+        connected to its signal, emits, then releases its own reference.
+      * Every slot that receives a frame must call ``release()`` exactly once
+        when it no longer needs the pixels (immediately, or later if it keeps
+        the frame around, e.g. the preview widget).
+    If a consumer forgets, the buffer is still returned when the Python object
+    is garbage-collected; the explicit count only returns it sooner.
+    """
+
+    __slots__ = (
+        "array",
+        "preview",
+        "frame_number",
+        "device_timestamp_ns",
+        "pixel_format",
+        "host_timestamp",
+        "camera_id",
+        "_buffer",
+        "_lease",
+        "_refs",
+        "_lock",
+        "__weakref__",
+    )
+
+    def __init__(
+        self,
+        array,
+        buffer=None,
+        frame_number=-1,
+        device_timestamp_ns=0,
+        pixel_format="",
+        host_timestamp=None,
+        camera_id=0,
+    ):
+        self.array = array  # native bit depth, shape (H, W)
+        self.preview = None  # optional 8-bit display copy (owned by this frame)
+        self.frame_number = frame_number
+        self.device_timestamp_ns = device_timestamp_ns
+        self.pixel_format = pixel_format
+        self.host_timestamp = (
+            host_timestamp if host_timestamp is not None else time.time()
+        )
+        self.camera_id = camera_id
+
+        self._buffer = buffer
+        self._lease = None  # PooledBuffer behind ``array`` for pooled copies
+        self._refs = 1
+        self._lock = threading.Lock()
+
+    @classmethod
+    def from_ic4_buffer(cls, buf, camera_id=0):
+        """Wrap an ``ic4.ImageBuffer`` without copying its pixels."""
+        frame_number = -1
+        device_ts = 0
+        try:
+            md = buf.meta_data
+            frame_number = md.device_frame_number
+            device_ts = md.device_timestamp_ns
+        except Exception:
+            pass
+
+        pf_name = ""
+        try:
+            pf_name = buf.image_type.pixel_format.name
+        except Exception:
+            pass
+
+        return cls(
+            buf.numpy_wrap(),
+            buffer=buf,
+            frame_number=frame_number,
+            device_timestamp_ns=device_ts,
+            pixel_format=pf_name,
+            camera_id=camera_id,
+        )
+
+    @property
+    def holds_buffer(self):
+        """True while this frame still pins an IC4 buffer."""
+        return self._buffer is not None
+
+    def copy(self, policy=None):
+        """
+        Return an independent frame with a private copy of the pixels and the
+        same metadata (no IC4 buffer, no preview).  The caller still owns its
+        reference to ``self`` and must release it as usual.
+
+        The pixels are borrowed from the shared :data:`frame_pool` and go
+        back to it when the copy is released.  Returns None when the memory
+        budget is exhausted and the pool's (or the given) overflow ``policy``
+        refuses the buffer.
+        """
+        lease = frame_pool.copy_of(self.array, policy)
+        if lease is None:
+            return None
+        frame = CameraFrame(
+            lease.array,
+            frame_number=self.frame_number,
+            device_timestamp_ns=self.device_timestamp_ns,
+            pixel_format=self.pixel_format,
+            host_timestamp=self.host_timestamp,
+            camera_id=self.camera_id,
+        )
+        frame._lease = lease
+        return frame
+
+    @property
+    def width(self):
+        return self.array.shape[1]
+
+    @property
+    def height(self):
+        return self.array.shape[0]
+
+    @property
+    def nbytes(self):
+        return self.array.nbytes
+
+    @property
+    def released(self):
+        return self._refs <= 0
+
+    def retain(self, count=1):
+        """Add ``count`` references (one per consumer that will receive the frame)."""
+        with self._lock:
+            self._refs += count
+        return self
+
+    def release(self):
+        """
+        Drop one reference.  When the last one goes, the IC4 buffer is handed
+        back to the sink (a pooled copy's pixels to the frame pool) and
+        ``array``/``preview`` must no longer be used.
+        """
+        with self._lock:
+            if self._refs <= 0:
+                return
+            self._refs -= 1
+            if self._refs > 0:
+                return
+            buf, self._buffer = self._buffer, None
+            lease, self._lease = self._lease, None
+
+        self.array = None
+        self.preview = None
+        if lease is not None:
+            lease.release()
+        if buf is not None:
+            try:
+                buf.release()
+            except Exception:
+                pass
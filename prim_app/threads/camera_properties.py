@@ -0,0 +1,260 @@
+# prim_app/threads/camera_properties.py
+
+import json
+import logging
+import os
+import threading
+import time
+
+from PyQt5.QtCore import QThread, pyqtSignal
+
+from utils.config import CAMERA_PROFILES_DIR, CAMERA_PROPERTY_COALESCE_MS
+
+log = logging.getLogger(__name__)
+
+# GenICam node type of every property the app reads or writes
+PROPERTY_TYPES = {
+    "ExposureTime": "float",
+    "Gain": "float",
+    "AcquisitionFrameRate": "float",
+    "BlackLevel": "float",
+    "Gamma": "float",
+    "ExposureAuto": "enumeration",
+    "GainAuto": "enumeration",
+    "PixelFormat": "enumeration",
+    "TriggerMode": "enumeration",
+    "TriggerSelector": "enumeration",
+    "TriggerSource": "enumeration",
+    "TriggerActivation": "enumeration",
+    "Width": "integer",
+    "Height": "integer",
+    "OffsetX": "integer",
+    "OffsetY": "integer",
+    "BinningHorizontal": "integer",
+    "BinningVertical": "integer",
+}
+
+# Saved in a camera profile, in the order they are applied: auto modes before
+# the values they would override, exposure before the frame rate it limits.
+PROFILE_PROPERTIES = [
+    "ExposureAuto",
+    "GainAuto",
+    "ExposureTime",
+    "Gain",
+    "BlackLevel",
+    "Gamma",
+    "AcquisitionFrameRate",
+]
+
+# After a write to the key, the ranges of these properties may have moved
+DEPENDENT_RANGES = {
+    "ExposureTime": ("AcquisitionFrameRate",),
+    "AcquisitionFrameRate": ("ExposureTime",),
+    "BinningHorizontal": ("Width", "OffsetX", "AcquisitionFrameRate"),
+    "BinningVertical": ("Height", "OffsetY", "AcquisitionFrameRate"),
+    "Width": ("OffsetX", "AcquisitionFrameRate"),
+    "Height": ("OffsetY", "AcquisitionFrameRate"),
+    "PixelFormat": ("AcquisitionFrameRate",),
+}
+
+
+class PropertyCache:
+    """
+    Cached access to an IC4 ``device_property_map``.  Node handles are looked
+    up once per name; numeric ranges (minimum, maximum, increment) are cached
+    until a write to a property they depend on (DEPENDENT_RANGES).  Safe to
+    share between the GUI thread and a PropertyWriter.
+    """
+
+    def __init__(self, property_map):
+        self._map = property_map
+        self._nodes = {}
+        self._ranges = {}
+        self._lock = threading.Lock()
+
+    def node(self, name):
+        """The property node for ``name``, or None if the camera lacks it."""
+        with self._lock:
+            if name in self._nodes:
+                return self._nodes[name]
+        kind = PROPERTY_TYPES.get(name, "float")
+        try:
+            node = getattr(self._map, f"find_{kind}")(name)
+        except Exception as e:
+            log.debug(f"PropertyCache: {name} not available: {e}")
+            node = None
+        with self._lock:
+            self._nodes[name] = node
+        return node
+
+    def range(self, name):
+        """``(minimum, maximum, increment)`` of a numeric property, or None."""
+        with self._lock:
+            if name in self._ranges:
+                return self._ranges[name]
+        node = self.node(name)
+        rng = None
+        if node is not None and PROPERTY_TYPES.get(name, "float") != "enumeration":
+            try:
+                try:
+                    inc = node.increment
+                except Exception:
+                    inc = None
+                rng = (node.minimum, node.maximum, inc)
+            except Exception as e:
+                log.debug(f"PropertyCache: no range for {name}: {e}")
+        with self._lock:
+            self._ranges[name] = rng
+        return rng
+
+    def invalidate_ranges(self, names=None):
+        with self._lock:
+            if names is None:
+                self._ranges.clear()
+            for name in names or ():
+                self._ranges.pop(name, None)
+
+    def get(self, name, default=None):
+        node = self.node(name)
+        if node is None:
+            return default
+        try:
+            return node.value
+        except Exception:
+            return default
+
+    def set(self, name, value):
+        """
+        Write ``value`` (clamped to the cached range) and return the value the
+        camera reports back.  Raises if the node is missing or rejects it.
+        """
+        node = self.node(name)
+        if node is None:
+            raise KeyError(f"Property {name} not found")
+        kind = PROPERTY_TYPES.get(name, "float")
+        if kind != "enumeration":
+            rng = self.range(name)
+            cast = int if kind == "integer" else float
+            value = cast(value)
+            if rng is not None:
+                value = min(max(value, rng[0]), rng[1])
+        node.value = value
+        self.invalidate_ranges(DEPENDENT_RANGES.get(name, ()))
+        try:
+            return node.value
+        except Exception:
+            return value
+
+    def apply_batch(self, values, order=PROFILE_PROPERTIES):
+        """
+        Write several properties in one pass (``order`` first, then the rest)
+        and return ``{name: error}`` for the ones that failed.
+        """
+        names = [n for n in order if n in values] + [n for n in values if n not in order]
+        failed = {}
+        for name in names:
+            try:
+                self.set(name, values[name])
+            except Exception as e:
+                failed[name] = str(e)
+        if failed:
+            log.warning(f"PropertyCache: could not apply {failed}")
+        return failed
+
+    def snapshot(self, names=PROFILE_PROPERTIES):
+        """Current values of ``names`` the camera has (for saving a profile)."""
+        values = {}
+        for name in names:
+            value = self.get(name)
+            if value is not None:
+                values[name] = value
+        return values
+
+
+class PropertyWriter(QThread):
+    """
+    Applies property changes from the GUI on a worker thread.  :meth:`submit`
+    only records the newest value per property, so dragging a slider queues
+    at most one pending write per name; the thread writes whatever is
+    pending at most every CAMERA_PROPERTY_COALESCE_MS and reports the value
+    the camera accepted via ``property_applied``.
+    """
+
+    property_applied = pyqtSignal(str, object)
+    property_failed = pyqtSignal(str, str)
+
+    def __init__(self, cache, interval_ms=CAMERA_PROPERTY_COALESCE_MS, parent=None):
+        super().__init__(parent)
+        self.cache = cache
+        self._interval = max(0.0, interval_ms / 1000.0)
+        self._pending = {}
+        self._cond = threading.Condition()
+        self._stop_requested = False
+
+    def submit(self, name, value):
+        with self._cond:
+            self._pending[name] = value
+            self._cond.notify()
+
+    def submit_batch(self, values):
+        with self._cond:
+            self._pending.update(values)
+            self._cond.notify()
+
+    def run(self):
+        while True:
+            with self._cond:
+                while not self._pending and not self._stop_requested:
+                    self._cond.wait()
+                if self._stop_requested:
+                    return
+                pending, self._pending = self._pending, {}
+
+            for name in [n for n in PROFILE_PROPERTIES if n in pending] + [
+                n for n in pending if n not in PROFILE_PROPERTIES
+            ]:
+                try:
+                    applied = self.cache.set(name, pending[name])
+                    self.property_applied.emit(name, applied)
+                except Exception as e:
+                    log.error(f"PropertyWriter: failed to set {name} = {pending[name]}: {e}")
+                    self.property_failed.emit(name, str(e))
+
+            # Let further changes pile up (and collapse) before the next pass
+            time.sleep(self._interval)
+
+    def stop(self):
+        with self._cond:
+            self._stop_requested = True
+            self._pending = {}
+            self._cond.notify()
+        self.wait(2000)
+
+
+# ─── Camera profiles (JSON files in CAMERA_PROFILES_DIR) ───────────────────
+def profile_path(name):
+    return os.path.join(CAMERA_PROFILES_DIR, f"{name}.json")
+
+
+def list_profiles():
+    try:
+        files = os.listdir(CAMERA_PROFILES_DIR)
+    except OSError:
+        return []
+    return sorted(os.path.splitext(f)[0] for f in files if f.endswith(".json"))
+
+
+def load_profile(name):
+    """``{property: value}`` of the saved profile ``name``."""
+    with open(profile_path(name), "r", encoding="utf-8") as f:
+        data = json.load(f)
+    return dict(data.get("properties", {}))
+
+
+def save_profile(name, properties, device=None):
+    data = {"name": name, "device": device, "properties": properties}
+    path = profile_path(name)
+    with open(path, "w", encoding="utf-8") as f:
+        json.dump(data, f, indent=2)
+    log.info(f"Saved camera profile {name!r} to {path}")
+    return path
@@ -0,0 +1,57 @@
+# prim_app/threads/device_enumerator.py
+
+import logging
+
+from PyQt5.QtCore import QThread, pyqtSignal
+
+log = logging.getLogger(__name__)
+
+
+class DeviceEnumerator(QThread):
+    """
+    Finds cameras and serial ports off the GUI thread.  The first run also
+    imports imagingcontrol4 and calls ``ic4.Library.init()`` (both take
+    seconds on a cold start), so the main window can be shown before any
+    hardware is touched.  Emits ``devices_ready(cameras, serial_ports)``:
+    a list of ``ic4.DeviceInfo`` and a list of ``(device, description)``.
+    """
+
+    devices_ready = pyqtSignal(list, list)
+
+    def run(self):
+        self.devices_ready.emit(self._cameras(), self._serial_ports())
+
+    @staticmethod
+    def _cameras():
+        try:
+            import imagingcontrol4 as ic4
+        except Exception as e:
+            log.error(f"imagingcontrol4 unavailable: {e}")
+            return []
+        try:
+            ic4.Library.init(
+                api_log_level=ic4.LogLevel.INFO, log_targets=ic4.LogTarget.STDERR
+            )
+            log.info("Global IC4 Library.init() succeeded.")
+        except RuntimeError as e:
+            if "already called" not in str(e):
+                log.error(f"Could not initialize IC4: {e}")
+                return []
+        except Exception as e:
+            log.error(f"Could not initialize IC4: {e}")
+            return []
+        try:
+            return list(ic4.DeviceEnum.devices())
+        except Exception as e:
+            log.error(f"Failed to enumerate IC4 devices: {e}")
+            return []
+
+    @staticmethod
+    def _serial_ports():
+        try:
+            from utils.utils import list_serial_ports
+
+            return list_serial_ports()
+        except Exception as e:
+            log.error(f"Failed to list serial ports: {e}")
+            return []
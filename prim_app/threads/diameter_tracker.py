@@ -0,0 +1,312 @@
+# prim_app/threads/diameter_tracker.py
+
+import collections
+import logging
+import math
+import time
+from concurrent.futures import ThreadPoolExecutor
+
+import numpy as np
+from PyQt5.QtCore import QObject, QMetaObject, Qt, pyqtSignal, pyqtSlot
+from PyQt5.QtGui import QImage
+
+from utils.config import (
+    DIAMETER_LINE_WIDTH,
+    DIAMETER_SMOOTH_PX,
+    DIAMETER_WORKERS,
+    DIAMETER_MAX_PENDING,
+    DIAMETER_UM_PER_PX,
+)
+from utils.telemetry import telemetry
+from writers.columnar_log import DIAMETER_RECORD_DTYPE
+
+log = logging.getLogger(__name__)
+
+
+class LineRoi:
+    """
+    Sampling pattern of one line ROI for frames of a given shape: the pixel
+    coordinates of ``width`` parallel lines (one pixel apart, centred on the
+    drawn line) with one sample per pixel of length.  :meth:`sample` gathers
+    them with a single fancy-index and averages across the band.
+    """
+
+    def __init__(self, p0, p1, shape, width=DIAMETER_LINE_WIDTH):
+        (x0, y0), (x1, y1) = p0, p1
+        length = math.hypot(x1 - x0, y1 - y0)
+        n = max(2, int(math.ceil(length)) + 1)
+        self.length = length
+        self.spacing = length / (n - 1)  # pixels between profile samples
+
+        t = np.linspace(0.0, 1.0, n)
+        xs = x0 + t * (x1 - x0)
+        ys = y0 + t * (y1 - y0)
+        if length > 0:
+            nx, ny = -(y1 - y0) / length, (x1 - x0) / length
+        else:
+            nx, ny = 0.0, 0.0
+        offsets = np.arange(max(1, int(width)), dtype=float)
+        offsets -= offsets.mean()
+
+        h, w = shape[:2]
+        cols = np.rint(xs[None, :] + offsets[:, None] * nx)
+        rows = np.rint(ys[None, :] + offsets[:, None] * ny)
+        self.cols = np.clip(cols, 0, w - 1).astype(np.intp)
+        self.rows = np.clip(rows, 0, h - 1).astype(np.intp)
+
+    def sample(self, arr):
+        """Band-averaged intensity profile of ``arr`` (2-D) along the line."""
+        return arr[self.rows, self.cols].mean(axis=0, dtype=np.float32)
+
+
+def _parabolic(g, k):
+    """Sub-sample offset of the peaks ``g[r, k[r]]`` from a 3-point parabola fit."""
+    m = g.shape[1]
+    rows = np.arange(len(k))
+    kc = np.clip(k, 1, m - 2)
+    a, b, c = g[rows, kc - 1], g[rows, kc], g[rows, kc + 1]
+    denom = a - 2.0 * b + c
+    with np.errstate(divide="ignore", invalid="ignore"):
+        offset = np.where(denom < 0, 0.5 * (a - c) / denom, 0.0)
+    offset[(k < 1) | (k > m - 2)] = 0.0
+    return np.clip(offset, -0.5, 0.5)
+
+
+def measure_edges(profiles, smooth=DIAMETER_SMOOTH_PX):
+    """
+    Edge-to-edge distance for a stack of intensity profiles, shape (n, L).
+
+    Each profile is box-smoothed over ``smooth`` samples (running sums), the
+    strongest absolute gradient is taken in each half as the two vessel
+    walls and refined to sub-sample precision.  Returns ``(distance,
+    strength)``: distance in samples (NaN where no edge was found) and the
+    weaker wall's gradient relative to the profile's range (0–1).
+    Everything is done on whole arrays, one pass per step for all n rows.
+    """
+    p = np.asarray(profiles, dtype=np.float32)
+    n = p.shape[0]
+    k = int(smooth)
+    if k > 1 and p.shape[1] > k:
+        c = np.zeros((n, p.shape[1] + 1), dtype=np.float64)
+        np.cumsum(p, axis=1, out=c[:, 1:])
+        p = ((c[:, k:] - c[:, :-k]) / k).astype(np.float32)
+
+    g = np.abs(np.diff(p, axis=1))
+    m = g.shape[1]
+    if n == 0 or m < 4:
+        return np.full(n, np.nan), np.zeros(n, dtype=np.float32)
+
+    half = m // 2
+    rows = np.arange(n)
+    i = np.argmax(g[:, :half], axis=1)
+    j = half + np.argmax(g[:, half:], axis=1)
+    # Smoothing shifts both edges by the same amount, so it cancels here
+    distance = (j + _parabolic(g, j)) - (i + _parabolic(g, i))
+
+    span = p.max(axis=1) - p.min(axis=1)
+    strength = np.minimum(g[rows, i], g[rows, j]) / np.maximum(span, 1e-6)
+    distance = distance.astype(np.float64)
+    distance[strength <= 0] = np.nan
+    return distance, np.clip(strength, 0.0, 1.0).astype(np.float32)
+
+
+def mean_per_frame(rows):
+    """
+    Collapse a frame-major DIAMETER_RECORD_DTYPE block to one value per
+    frame: ``(deviceTime, mean diameter over the ROIs with edges)``.
+    """
+    if not len(rows):
+        return np.zeros(0), np.zeros(0)
+    n_rois = int(rows["roi"].max()) + 1
+    d = rows["diameter"].reshape(-1, n_rois)
+    valid = np.isfinite(d)
+    count = valid.sum(axis=1)
+    total = np.where(valid, d, 0.0).sum(axis=1)
+    mean = np.where(count > 0, total / np.maximum(count, 1), np.nan)
+    return rows["deviceTime"][::n_rois].copy(), mean
+
+
+class DiameterTracker(QObject):
+    """
+    Live vessel diameter along the line ROIs drawn on the camera view.
+
+    Lives in its own QThread and is connected straight to
+    SDKCameraThread.frame_ready (so the UI's frame coalescing does not thin
+    it out).  :meth:`process_frame` only gathers the ROI profiles and
+    releases the frame; the edge search runs on a pool of DIAMETER_WORKERS
+    threads (numpy releases the GIL in the kernels).  Frames arriving while
+    every worker is busy are batched, so one job measures all of them at
+    once.  Results are emitted in frame order on :attr:`diameters_ready` as
+    DIAMETER_RECORD_DTYPE blocks, one row per ROI per frame.
+
+    Frame device times are estimated from the newest Arduino sample
+    (:meth:`update_clock`); they are NaN until the PRIM device is streaming.
+    """
+
+    diameters_ready = pyqtSignal(object)
+
+    def __init__(
+        self,
+        workers=DIAMETER_WORKERS,
+        max_pending=DIAMETER_MAX_PENDING,
+        um_per_px=DIAMETER_UM_PER_PX,
+        parent=None,
+    ):
+        super().__init__(parent)
+        self.workers = max(1, int(workers))
+        self.um_per_px = um_per_px
+        self._pool = None
+
+        self._lines = []  # [((x0, y0), (x1, y1))] in image pixels
+        self._rois = []  # LineRoi per line for _roi_shape
+        self._roi_shape = None
+        self._generation = 0  # bumped by set_rois; stale results are dropped
+
+        # (frame_number, host_time, device_time, [profile per ROI])
+        self._batch = collections.deque(maxlen=max(1, int(max_pending)))
+        self._inflight = collections.deque()  # futures, in submission order
+        self._clock = None  # (hostTime, deviceTime) of the newest sample
+        self._last_device_time = -math.inf
+
+        self.frames_measured = 0
+        self.frames_dropped = 0
+
+    @property
+    def units(self):
+        return "µm" if self.um_per_px else "px"
+
+    # ─── Configuration ──────────────────────────────────────────────────
+    @pyqtSlot(object)
+    def set_rois(self, lines):
+        """Replace the line ROIs (image pixel end points); drops queued work."""
+        self._lines = [tuple(map(tuple, line)) for line in (lines or [])]
+        self._rois = []
+        self._roi_shape = None
+        self._generation += 1
+        self._batch.clear()
+
+    @pyqtSlot(object)
+    def update_clock(self, block):
+        """SerialThread.samples_ready: remember the newest (hostTime, deviceTime)."""
+        if len(block):
+            last = block[-1]
+            self._clock = (float(last["hostTime"]), float(last["deviceTime"]))
+
+    @pyqtSlot()
+    def reset(self):
+        """Forget the clock (e.g. after the plot was cleared or a new fill)."""
+        self._clock = None
+        self._last_device_time = -math.inf
+
+    def _device_time(self, host_time):
+        if self._clock is None:
+            return np.nan
+        t = self._clock[1] + (host_time - self._clock[0])
+        # Clock updates can step back slightly; keep the trace monotonic
+        t = max(t, self._last_device_time)
+        self._last_device_time = t
+        return t
+
+    # ─── Frame input ────────────────────────────────────────────────────
+    @pyqtSlot(QImage, object)
+    def process_frame(self, qimage, frame):
+        """Sample the ROI profiles of ``frame`` and queue them for the pool."""
+        try:
+            if not self._lines or frame is None or frame.array is None:
+                return
+            telemetry.record("queue.frame_to_diameter", time.time() - frame.host_timestamp)
+            arr = frame.array
+            if arr.ndim == 3:
+                arr = arr[:, :, 0]
+            if self._roi_shape != arr.shape:
+                self._roi_shape = arr.shape
+                self._rois = [LineRoi(p0, p1, arr.shape) for p0, p1 in self._lines]
+            profiles = [roi.sample(arr) for roi in self._rois]
+            item = (
+                int(frame.frame_number),
+                frame.host_timestamp,
+                self._device_time(frame.host_timestamp),
+                profiles,
+            )
+        finally:
+            if frame is not None:
+                frame.release()
+
+        if len(self._batch) == self._batch.maxlen:
+            # Workers cannot keep up: the oldest waiting frame goes
+            self.frames_dropped += 1
+            telemetry.count("diameter.dropped")
+        self._batch.append(item)
+        self._maybe_submit()
+
+    @pyqtSlot()
+    def _maybe_submit(self):
+        if not self._batch or len(self._inflight) >= self.workers:
+            return
+        if self._pool is None:
+            self._pool = ThreadPoolExecutor(
+                max_workers=self.workers, thread_name_prefix="diameter"
+            )
+        items = list(self._batch)
+        self._batch.clear()
+        spacings = [roi.spacing for roi in self._rois]
+        future = self._pool.submit(self._measure, self._generation, items, spacings)
+        future.add_done_callback(
+            lambda _f: QMetaObject.invokeMethod(self, "_collect", Qt.QueuedConnection)
+        )
+        self._inflight.append(future)
+
+    def _measure(self, generation, items, spacings):
+        """Pool worker: edges for every (frame, ROI) of ``items``."""
+        t0 = time.perf_counter()
+        n, n_rois = len(items), len(spacings)
+        scale = self.um_per_px or 1.0
+        diameter = np.empty((n, n_rois))
+        strength = np.empty((n, n_rois), dtype=np.float32)
+        for r, spacing in enumerate(spacings):
+            stack = np.stack([item[3][r] for item in items])
+            d, s = measure_edges(stack)
+            diameter[:, r] = d * spacing * scale
+            strength[:, r] = s
+
+        rows = np.empty(n * n_rois, dtype=DIAMETER_RECORD_DTYPE)
+        rows["cameraFrame"] = np.repeat([item[0] for item in items], n_rois)
+        rows["hostTime"] = np.repeat([item[1] for item in items], n_rois)
+        rows["deviceTime"] = np.repeat([item[2] for item in items], n_rois)
+        rows["roi"] = np.tile(np.arange(n_rois, dtype=np.int32), n)
+        rows["diameter"] = diameter.ravel()
+        rows["strength"] = strength.ravel()
+        telemetry.record("diameter.batch", time.perf_counter() - t0)
+        return generation, rows
+
+    @pyqtSlot()
+    def _collect(self):
+        """Emit finished jobs in submission order, then feed idle workers."""
+        while self._inflight and self._inflight[0].done():
+            future = self._inflight.popleft()
+            try:
+                generation, rows = future.result()
+            except Exception:
+                log.exception("Diameter measurement failed")
+                continue
+            if generation == self._generation and len(rows):
+                self.frames_measured += len(rows) // max(1, len(self._lines))
+                self.diameters_ready.emit(rows)
+        self._maybe_submit()
+
+    def stats(self):
+        return {
+            "measured": self.frames_measured,
+            "dropped": self.frames_dropped,
+            "pending": len(self._batch),
+            "in_flight": len(self._inflight),
+        }
+
+    @pyqtSlot()
+    def shutdown(self):
+        """Stop the worker pool (waits for running jobs)."""
+        self._batch.clear()
+        if self._pool is not None:
+            self._pool.shutdown(wait=True)
+            self._pool = None
+        self._inflight.clear()
@@ -0,0 +1,56 @@
+# prim_app/threads/export_thread.py
+
+import logging
+import threading
+
+from PyQt5.QtCore import QThread, pyqtSignal
+
+log = logging.getLogger(__name__)
+
+
+class ExportThread(QThread):
+    """
+    Runs :func:`writers.stack_export.export_stack` off the GUI thread.
+    ``progress`` follows every page; :meth:`cancel` stops the export before
+    the next page and removes the partial file.  Exactly one of
+    ``export_finished``, ``export_cancelled`` or ``error_occurred`` is
+    emitted at the end.
+    """
+
+    progress = pyqtSignal(int, int)  # pages done, pages total
+    export_finished = pyqtSignal(dict)  # summary from export_stack
+    export_cancelled = pyqtSignal()
+    error_occurred = pyqtSignal(str)
+
+    def __init__(self, video_path, options, parent=None):
+        super().__init__(parent)
+        self.video_path = video_path
+        self.options = dict(options)  # keyword arguments of export_stack
+        self._cancel = threading.Event()
+
+    def cancel(self):
+        self._cancel.set()
+
+    def run(self):
+        from writers.stack_export import ExportCancelled, export_stack
+
+        try:
+            result = export_stack(
+                self.video_path,
+                progress=self.progress.emit,
+                cancelled=self._cancel.is_set,
+                **self.options,
+            )
+        except ExportCancelled:
+            log.info(f"Export of {self.video_path} cancelled.")
+            self.export_cancelled.emit()
+            return
+        except Exception as e:
+            log.error(f"ExportThread: Error exporting {self.video_path}: {e}")
+            self.error_occurred.emit(str(e))
+            return
+        log.info(
+            f"Exported {result['pages']} pages of {self.video_path} to "
+            f"{result['path']} in {result['seconds']:.1f} s"
+        )
+        self.export_finished.emit(result)
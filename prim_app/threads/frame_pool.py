@@ -0,0 +1,225 @@
+# prim_app/threads/frame_pool.py
+
+import collections
+import logging
+import os
+import threading
+import time
+
+import numpy as np
+
+from utils.config import (
+    MEMORY_BUDGET_MB,
+    MEMORY_OVERFLOW_POLICY,
+    MEMORY_BLOCK_TIMEOUT_S,
+)
+from utils.telemetry import telemetry
+
+log = logging.getLogger(__name__)
+
+OVERFLOW_POLICIES = ("block", "drop", "allocate")
+
+
+class PooledBuffer:
+    """
+    One array borrowed from a :class:`FrameBufferPool`.  :meth:`release`
+    hands it back (once; later calls do nothing), so a lease can stand in for
+    an IC4 buffer in :class:`~threads.camera_frame.CameraFrame`.
+    """
+
+    __slots__ = ("array", "_pool", "_tracked")
+
+    def __init__(self, array, pool, tracked):
+        self.array = array
+        self._pool = pool
+        self._tracked = tracked
+
+    def release(self):
+        arr, self.array = self.array, None
+        if arr is not None:
+            self._pool._give_back(arr, self._tracked)
+
+    # A lease that is garbage-collected unreleased still returns its bytes
+    __del__ = release
+
+
+class FrameBufferPool:
+    """
+    Process-wide pool of frame-sized arrays bounded by a memory budget.
+
+    Every stage that keeps pixels beyond the camera's own buffer ring
+    (pre-trigger history, frames waiting for their CamTrig sample, the
+    writer's spill queue, preview output rings) borrows its arrays here
+    instead of allocating them.  Returned arrays are kept per
+    ``(shape, dtype)`` and handed out again, so a steady recording does not
+    allocate at all; idle arrays of another shape are freed when room is
+    needed.
+
+    ``budget`` counts borrowed plus idle bytes.  What :meth:`acquire` does
+    when a new array would exceed it is set by ``policy`` (see
+    ``MEMORY_OVERFLOW_POLICY`` in utils.config):
+
+      ``block``     wait up to ``block_timeout_s`` for a buffer to come back,
+                    then behave like ``drop``
+      ``drop``      return None; the caller leaves the frame out
+      ``allocate``  hand out an untracked array beyond the budget (counted as
+                    an overflow); only for small fixed rings that ask for it
+                    per call (the preview converter), or when configured
+                    explicitly, since the budget then stops being a limit
+    """
+
+    def __init__(
+        self,
+        budget_bytes=MEMORY_BUDGET_MB * 1024 * 1024,
+        policy=MEMORY_OVERFLOW_POLICY,
+        block_timeout_s=MEMORY_BLOCK_TIMEOUT_S,
+    ):
+        if policy not in OVERFLOW_POLICIES:
+            log.warning(
+                f"FrameBufferPool: Unknown overflow policy {policy!r}, using 'drop'."
+            )
+            policy = "drop"
+        self.budget = max(0, int(budget_bytes))
+        self.policy = policy
+        self.block_timeout_s = max(0.0, float(block_timeout_s))
+
+        self._cond = threading.Condition()
+        self._idle = collections.defaultdict(list)  # (shape, dtype) -> arrays
+        self._idle_bytes = 0
+        self._in_use_bytes = 0
+        self._peak_bytes = 0
+        self.allocations = 0
+        self.reuses = 0
+        self.dropped = 0
+        self.overflows = 0
+        self._overflow_bytes = 0
+
+    # ─── Borrowing ──────────────────────────────────────────────────────
+    def acquire(self, shape, dtype, policy=None):
+        """
+        Borrow an uninitialised array of ``shape``/``dtype``.  Returns a
+        :class:`PooledBuffer` (its ``array`` is the buffer), or None when the
+        budget is exhausted under the ``drop``/``block`` policy.  ``policy``
+        overrides the pool's policy for this call.
+        """
+        shape = tuple(int(n) for n in shape)
+        dtype = np.dtype(dtype)
+        key = (shape, dtype.str)
+        nbytes = int(np.prod(shape)) * dtype.itemsize
+        policy = policy or self.policy
+        deadline = None
+
+        with self._cond:
+            while True:
+                free = self._idle.get(key)
+                if free:
+                    arr = free.pop()
+                    self._idle_bytes -= nbytes
+                    self.reuses += 1
+                    return self._lend(arr, nbytes)
+                if self._make_room(nbytes):
+                    self.allocations += 1
+                    return self._lend(np.empty(shape, dtype=dtype), nbytes)
+
+                if policy == "allocate":
+                    self.overflows += 1
+                    self._overflow_bytes += nbytes
+                    telemetry.count("memory.overflow")
+                    if self.overflows == 1 or self.overflows % 1000 == 0:
+                        log.warning(
+                            f"FrameBufferPool: Budget of {self.budget / 1e6:.0f} MB "
+                            f"exceeded, {self.overflows} buffers allocated beyond it."
+                        )
+                    return PooledBuffer(np.empty(shape, dtype=dtype), self, False)
+                if policy == "block":
+                    now = time.monotonic()
+                    if deadline is None:
+                        deadline = now + self.block_timeout_s
+                    if now < deadline:
+                        self._cond.wait(deadline - now)
+                        continue
+                self.dropped += 1
+                telemetry.count(f"memory.overflow_{policy}")
+                return None
+
+    def copy_of(self, arr, policy=None):
+        """A pooled copy of ``arr`` (see :meth:`acquire`), or None."""
+        lease = self.acquire(arr.shape, arr.dtype, policy)
+        if lease is not None:
+            np.copyto(lease.array, arr)
+        return lease
+
+    def _make_room(self, nbytes):
+        """Free idle arrays until ``nbytes`` more fit in the budget (lock held)."""
+        while self._in_use_bytes + self._idle_bytes + nbytes > self.budget:
+            if not self._idle_bytes:
+                return False
+            key = next(k for k, free in self._idle.items() if free)
+            arr = self._idle[key].pop()
+            if not self._idle[key]:
+                del self._idle[key]
+            self._idle_bytes -= arr.nbytes
+        return True
+
+    def _lend(self, arr, nbytes):
+        self._in_use_bytes += nbytes
+        self._peak_bytes = max(self._peak_bytes, self._in_use_bytes)
+        return PooledBuffer(arr, self, True)
+
+    def _give_back(self, arr, tracked):
+        with self._cond:
+            if not tracked:
+                self._overflow_bytes -= arr.nbytes
+                return
+            self._in_use_bytes -= arr.nbytes
+            if self._in_use_bytes + self._idle_bytes + arr.nbytes <= self.budget:
+                self._idle[(arr.shape, arr.dtype.str)].append(arr)
+                self._idle_bytes += arr.nbytes
+            self._cond.notify_all()
+
+    def trim(self):
+        """Free every idle array (e.g. after a recording)."""
+        with self._cond:
+            self._idle = collections.defaultdict(list)
+            self._idle_bytes = 0
+
+    # ─── Gauge ──────────────────────────────────────────────────────────
+    def stats(self):
+        with self._cond:
+            stats = {
+                "budget_mb": self.budget / 1e6,
+                "in_use_mb": self._in_use_bytes / 1e6,
+                "idle_mb": self._idle_bytes / 1e6,
+                "peak_mb": self._peak_bytes / 1e6,
+                "overflow_mb": self._overflow_bytes / 1e6,
+                "allocations": self.allocations,
+                "reuses": self.reuses,
+                "dropped": self.dropped,
+                "overflows": self.overflows,
+                "policy": self.policy,
+            }
+        stats["rss_mb"] = process_rss_mb()
+        telemetry.set_gauge("memory.pool_in_use_mb", stats["in_use_mb"])
+        telemetry.set_gauge("memory.pool_idle_mb", stats["idle_mb"])
+        if stats["rss_mb"] is not None:
+            telemetry.set_gauge("memory.rss_mb", stats["rss_mb"])
+        return stats
+
+
+def process_rss_mb():
+    """Resident set size of this process in MB, or None if unavailable."""
+    try:
+        import psutil
+
+        return psutil.Process().memory_info().rss / 1e6
+    except Exception:
+        pass
+    try:
+        with open("/proc/self/statm") as f:
+            return int(f.read().split()[1]) * os.sysconf("SC_PAGE_SIZE") / 1e6
+    except Exception:
+        return None
+
+
+# Shared instance used by all threads
+frame_pool = FrameBufferPool()
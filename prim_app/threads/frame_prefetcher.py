@@ -0,0 +1,213 @@
+# prim_app/threads/frame_prefetcher.py
+
+import collections
+import logging
+import threading
+import time
+
+import numpy as np
+from PyQt5.QtCore import QThread, pyqtSignal
+
+from utils.config import REVIEW_CACHE_MB, REVIEW_PREFETCH_AHEAD, REVIEW_PREFETCH_BEHIND
+from utils.telemetry import telemetry
+
+log = logging.getLogger(__name__)
+
+
+class FrameCache:
+    """
+    Thread-safe LRU cache of decoded pages (``page -> array``) bounded by
+    ``max_bytes``; the least recently used pages are evicted first.
+    """
+
+    def __init__(self, max_bytes):
+        self.max_bytes = max(0, int(max_bytes))
+        self.nbytes = 0
+        self.hits = 0
+        self.misses = 0
+        self._pages = collections.OrderedDict()
+        self._lock = threading.Lock()
+
+    def __contains__(self, page):
+        with self._lock:
+            return page in self._pages
+
+    def __len__(self):
+        with self._lock:
+            return len(self._pages)
+
+    def get(self, page):
+        """The cached array of ``page`` (now most recently used), or None."""
+        with self._lock:
+            arr = self._pages.get(page)
+            if arr is None:
+                self.misses += 1
+                return None
+            self._pages.move_to_end(page)
+            self.hits += 1
+            return arr
+
+    def put(self, page, arr):
+        with self._lock:
+            old = self._pages.pop(page, None)
+            if old is not None:
+                self.nbytes -= old.nbytes
+            self._pages[page] = arr
+            self.nbytes += arr.nbytes
+            while self.nbytes > self.max_bytes and len(self._pages) > 1:
+                _, evicted = self._pages.popitem(last=False)
+                self.nbytes -= evicted.nbytes
+
+    def clear(self):
+        with self._lock:
+            self._pages.clear()
+            self.nbytes = 0
+
+
+class FramePrefetcher(QThread):
+    """
+    Reads the pages of a recorded stack for review mode.
+
+    The :class:`~writers.recording_index.RecordingReader` is opened and used
+    on this thread only.  :meth:`request` (GUI thread) moves the cursor: it
+    returns the page straight from the :class:`FrameCache` when it is there,
+    otherwise the page is read first and delivered through ``frame_loaded``.
+    Between requests the thread fills the cache with up to ``ahead`` pages in
+    the direction of travel and ``behind`` pages the other way; a new request
+    interrupts that, so the cursor page never waits behind prefetching.
+    """
+
+    # The recording's index (INDEX_RECORD_DTYPE rows), once the stack is open
+    opened = pyqtSignal(object)
+    # (page, array) of a requested page that was not in the cache
+    frame_loaded = pyqtSignal(int, object)
+    error_occurred = pyqtSignal(str)
+
+    def __init__(
+        self,
+        video_path,
+        cache_mb=REVIEW_CACHE_MB,
+        ahead=REVIEW_PREFETCH_AHEAD,
+        behind=REVIEW_PREFETCH_BEHIND,
+        parent=None,
+    ):
+        super().__init__(parent)
+        self.video_path = video_path
+        self.cache = FrameCache(cache_mb * 1024 * 1024)
+        self.ahead = max(0, int(ahead))
+        self.behind = max(0, int(behind))
+
+        self._cond = threading.Condition()
+        self._target = None  # page the cursor is on
+        self._delivered = True  # False until the target page went out
+        self._direction = 1
+        self._generation = 0  # bumped by every request
+        self._stop = False
+        self._pages = 0
+
+    # ─── GUI side ───────────────────────────────────────────────────────
+    def request(self, page):
+        """
+        Move the cursor to ``page``.  Returns its array if cached (and
+        nothing is emitted), else None and ``frame_loaded`` follows.
+        """
+        arr = self.cache.get(page)
+        with self._cond:
+            if self._target is not None and page != self._target:
+                self._direction = 1 if page > self._target else -1
+            self._target = page
+            self._delivered = arr is not None
+            self._generation += 1
+            self._cond.notify()
+        return arr
+
+    def stop(self):
+        with self._cond:
+            self._stop = True
+            self._cond.notify()
+
+    def stats(self):
+        c = self.cache
+        lookups = c.hits + c.misses
+        return {
+            "cached_pages": len(c),
+            "cache_mb": c.nbytes / 1e6,
+            "hit_rate": c.hits / lookups if lookups else 0.0,
+        }
+
+    # ─── Thread side ────────────────────────────────────────────────────
+    def run(self):
+        from writers.recording_index import RecordingReader
+
+        try:
+            reader = RecordingReader(self.video_path)
+        except Exception as e:
+            log.error(f"FramePrefetcher: Cannot open {self.video_path}: {e}")
+            self.error_occurred.emit(f"Cannot open {self.video_path}: {e}")
+            return
+
+        try:
+            self._pages = len(reader)
+            frame_bytes = int(np.prod(reader.shape)) * reader.dtype.itemsize
+            # Never prefetch more than the cache can hold next to the cursor
+            room = max(0, self.cache.max_bytes // max(frame_bytes, 1) - 1)
+            self.ahead = min(self.ahead, room)
+            self.behind = min(self.behind, max(0, room - self.ahead))
+            self.opened.emit(reader.index)
+            self._serve(reader)
+        finally:
+            reader.close()
+            self.cache.clear()
+
+    def _serve(self, reader):
+        while True:
+            with self._cond:
+                while not self._stop and self._target is None:
+                    self._cond.wait()
+                if self._stop:
+                    return
+                target = self._target
+                delivered = self._delivered
+                direction = self._direction
+                generation = self._generation
+
+            if not delivered:
+                arr = self._load(reader, target)
+                if arr is not None:
+                    self.frame_loaded.emit(target, arr)
+                with self._cond:
+                    if self._generation == generation:
+                        self._delivered = True
+
+            for page in self._prefetch_order(target, direction):
+                with self._cond:
+                    if self._stop or self._generation != generation:
+                        break
+                if page not in self.cache:
+                    self._load(reader, page)
+            else:
+                # Window filled: sleep until the cursor moves
+                with self._cond:
+                    while not self._stop and self._generation == generation:
+                        self._cond.wait()
+
+    def _prefetch_order(self, target, direction):
+        pages = [target + direction * k for k in range(1, self.ahead + 1)]
+        pages += [target - direction * k for k in range(1, self.behind + 1)]
+        return [p for p in pages if 0 <= p < self._pages]
+
+    def _load(self, reader, page):
+        if not 0 <= page < self._pages:
+            return None
+        try:
+            t0 = time.perf_counter()
+            arr = reader.frame(page)
+            if not arr.flags.owndata:
+                # Memory-mapped view: read the pixels now, on this thread
+                arr = arr.copy()
+            telemetry.record("review.read_frame", time.perf_counter() - t0)
+        except Exception as e:
+            log.error(f"FramePrefetcher: Error reading page {page}: {e}")
+            return None
+        self.cache.put(page, arr)
+        return arr
@@ -0,0 +1,303 @@
+# prim_app/threads/frame_writer_thread.py
+
+import collections
+import logging
+import threading
+import time
+
+from PyQt5.QtCore import QThread, pyqtSignal
+
+from utils.config import (
+    CAMERA_BUFFER_COUNT,
+    MEMORY_BUDGET_MB,
+    RECORDING_CHECKPOINT_S,
+    WRITER_QUEUE_SIZE,
+    WRITER_BATCH_SIZE,
+    WRITER_BACKPRESSURE_POLICY,
+    WRITER_STATS_INTERVAL_MS,
+)
+from utils.telemetry import telemetry
+
+log = logging.getLogger(__name__)
+
+BACKPRESSURE_POLICIES = ("block", "drop", "spill")
+
+
+class FrameWriterThread(QThread):
+    """
+    Write-behind stage for camera frames.
+
+    RecordingManager calls :meth:`submit` with a CameraFrame and its page
+    metadata; the frame is queued and this thread drains the queue in batches
+    of up to ``batch_size`` frames, handing each batch to a
+    :class:`~writers.frame_writers.FrameWriterBackend` (BigTIFF, compressed
+    TIFF, HDF5, …).  Disk stalls therefore only grow the queue instead of
+    blocking the recorder's event loop.
+
+    The queue is bounded by ``queue_size``; what happens beyond that is set by
+    ``policy`` (see ``WRITER_BACKPRESSURE_POLICY`` in utils.config).  Only the
+    first CAMERA_BUFFER_COUNT // 2 queued frames keep their IC4 buffer; deeper
+    entries are copied into buffers from the shared frame pool so a backlog
+    never starves the camera's buffer ring; when the pool's memory budget is
+    exhausted the frame is counted as dropped.  The ``spill`` policy is
+    bounded the same way: once the queued pixels reach ``spill_budget_bytes``
+    (MEMORY_BUDGET_MB) further frames are dropped instead of queued.
+
+    Every ``checkpoint_s`` the thread calls the backend's ``checkpoint``
+    between batches (fsync + journal row), so a crash loses at most that much
+    of the stack; the journal is removed once the file is closed cleanly.
+    """
+
+    # Emitted every WRITER_STATS_INTERVAL_MS with a dict (see get_stats())
+    stats_updated = pyqtSignal(dict)
+    error_occurred = pyqtSignal(str)
+
+    def __init__(
+        self,
+        backend,
+        queue_size=WRITER_QUEUE_SIZE,
+        policy=WRITER_BACKPRESSURE_POLICY,
+        batch_size=WRITER_BATCH_SIZE,
+        checkpoint_s=RECORDING_CHECKPOINT_S,
+        spill_budget_bytes=MEMORY_BUDGET_MB * 1024 * 1024,
+        parent=None,
+    ):
+        super().__init__(parent)
+        if policy not in BACKPRESSURE_POLICIES:
+            log.warning(f"Unknown backpressure policy {policy!r}; using 'block'.")
+            policy = "block"
+
+        self.backend = backend
+        self.path = backend.path
+        self.queue_size = max(1, int(queue_size))
+        self.policy = policy
+        self.batch_size = max(1, int(batch_size))
+        self.checkpoint_s = max(0.0, float(checkpoint_s or 0))
+        self.spill_budget_bytes = max(0, int(spill_budget_bytes))
+        self._zero_copy_depth = max(1, CAMERA_BUFFER_COUNT // 2)
+
+        # Pending entries: (frame, array, metadata_dict, host_timestamp)
+        self._pending = collections.deque()
+        self._pending_bytes = 0
+        self._cond = threading.Condition()
+        self._closing = False
+
+        # Counters
+        self._written = 0
+        self._dropped = 0
+        self._spilled = 0
+        self._bytes_written = 0
+        self._bytes_on_disk = 0
+        self._write_errors = 0
+        self._max_depth = 0
+        self._mb_per_s = 0.0
+        self._checkpoints = 0
+
+    # ─── Producer side (called from the recorder thread) ───────────────────
+    def submit(self, frame, metadata):
+        """
+        Queue ``frame`` for writing.  Ownership of one frame reference passes to
+        the writer, which releases it once the page is on disk.  Returns False
+        if the frame was dropped by the backpressure policy.
+        """
+        with self._cond:
+            if self._closing:
+                frame.release()
+                return False
+
+            depth = len(self._pending)
+            if depth >= self.queue_size:
+                telemetry.count(f"writer.backpressure_{self.policy}")
+                if self.policy == "drop":
+                    self._dropped += 1
+                    frame.release()
+                    return False
+                if self.policy == "block":
+                    while len(self._pending) >= self.queue_size and not self._closing:
+                        self._cond.wait(0.1)
+                    if self._closing:
+                        # finish() came while we waited; the writer may be gone
+                        frame.release()
+                        return False
+                    depth = len(self._pending)
+                elif self._pending_bytes + frame.array.nbytes > self.spill_budget_bytes:
+                    self._dropped += 1
+                    telemetry.count("writer.spill_budget_dropped")
+                    frame.release()
+                    return False
+                else:
+                    self._spilled += 1
+
+            if depth < self._zero_copy_depth or not frame.holds_buffer:
+                self._append(frame, metadata)
+                return True
+
+        # Too deep to keep holding camera buffers; take a pooled copy.  The
+        # pool may block (MEMORY_OVERFLOW_POLICY) until the writer frees
+        # memory, so this happens outside the lock the writer pops under.
+        copy = frame.copy()
+        frame.release()
+        with self._cond:
+            if copy is None:
+                self._dropped += 1
+                telemetry.count("writer.memory_dropped")
+                return False
+            if self._closing:
+                copy.release()
+                return False
+            self._append(copy, metadata)
+            return True
+
+    def _append(self, frame, metadata):
+        """Queue one entry; the caller holds ``_cond``."""
+        entry = (frame, frame.array, metadata, frame.host_timestamp)
+        self._pending.append(entry)
+        self._pending_bytes += entry[1].nbytes
+        self._max_depth = max(self._max_depth, len(self._pending))
+        self._cond.notify_all()
+
+    def finish(self):
+        """Ask the thread to write whatever is still queued, then close the file."""
+        with self._cond:
+            self._closing = True
+            self._cond.notify_all()
+
+    def get_stats(self):
+        with self._cond:
+            return {
+                "queue_depth": len(self._pending),
+                "queue_mb": self._pending_bytes / 1e6,
+                "max_queue_depth": self._max_depth,
+                "queue_size": self.queue_size,
+                "written": self._written,
+                "dropped": self._dropped,
+                "spilled": self._spilled,
+                "mb_written": self._bytes_written / 1e6,
+                "mb_on_disk": self._bytes_on_disk / 1e6,
+                "mb_per_s": self._mb_per_s,
+                "write_errors": self._write_errors,
+                "checkpoints": self._checkpoints,
+                "durable_pages": self.backend.durable_pages,
+                "policy": self.policy,
+            }
+
+    # ─── Writer side ───────────────────────────────────────────────────────
+    def run(self):
+        try:
+            self.backend.open()
+        except Exception as e:
+            log.error(f"FrameWriterThread: Failed to open {self.path}: {e}")
+            self.error_occurred.emit(f"Failed to open {self.path}: {e}")
+            with self._cond:
+                # Nothing will drain the queue; refuse further frames
+                self._closing = True
+            self._discard_pending()
+            return
+        if self.checkpoint_s > 0:
+            try:
+                self.backend.open_journal()
+            except Exception as e:
+                log.warning(f"FrameWriterThread: No crash journal for {self.path}: {e}")
+
+        stats_interval = WRITER_STATS_INTERVAL_MS / 1000.0
+        last_stats = last_checkpoint = time.monotonic()
+        bytes_at_last_stats = 0
+
+        try:
+            while True:
+                with self._cond:
+                    while not self._pending and not self._closing:
+                        self._cond.wait(stats_interval)
+                        if time.monotonic() - last_stats >= stats_interval:
+                            break
+                    batch = [
+                        self._pending.popleft()
+                        for _ in range(min(self.batch_size, len(self._pending)))
+                    ]
+                    self._pending_bytes -= sum(arr.nbytes for _, arr, _, _ in batch)
+                    done = self._closing and not self._pending and not batch
+                    telemetry.set_gauge("writer.queue_depth", len(self._pending) + len(batch))
+                    if batch:
+                        # Wake a producer blocked by the "block" policy
+                        self._cond.notify_all()
+
+                if batch:
+                    self._write_batch(batch)
+
+                now = time.monotonic()
+                if self.checkpoint_s > 0 and now - last_checkpoint >= self.checkpoint_s:
+                    self._checkpoint()
+                    last_checkpoint = now
+                if now - last_stats >= stats_interval or done:
+                    elapsed = now - last_stats
+                    delta = self._bytes_written - bytes_at_last_stats
+                    self._mb_per_s = (delta / 1e6) / elapsed if elapsed > 0 else 0.0
+                    bytes_at_last_stats = self._bytes_written
+                    self._bytes_on_disk = self.backend.file_size()
+                    last_stats = now
+                    self.stats_updated.emit(self.get_stats())
+
+                if done:
+                    break
+        finally:
+            clean = True
+            try:
+                self.backend.close()
+            except Exception as e:
+                clean = False
+                log.error(f"FrameWriterThread: Error closing {self.path}: {e}")
+            try:
+                self.backend.write_index()
+            except Exception as e:
+                clean = False
+                log.error(f"FrameWriterThread: Error writing index for {self.path}: {e}")
+            # The journal is only needed if the stack was not closed cleanly
+            self.backend.close_journal(remove=clean)
+            self._discard_pending()
+            log.info(
+                f"FrameWriterThread: wrote {self._written} frames "
+                f"({self._bytes_written / 1e6:.1f} MB), dropped {self._dropped}, "
+                f"spilled {self._spilled}."
+            )
+
+    def _checkpoint(self):
+        try:
+            t0 = time.perf_counter()
+            self.backend.checkpoint()
+            telemetry.record("writer.checkpoint", time.perf_counter() - t0)
+            self._checkpoints += 1
+        except Exception as e:
+            log.error(f"FrameWriterThread: Checkpoint of {self.path} failed: {e}")
+
+    def _write_batch(self, batch):
+        try:
+            t0 = time.perf_counter()
+            self.backend.write_batch([(arr, metadata) for _, arr, metadata, _ in batch])
+            elapsed = time.perf_counter() - t0
+            telemetry.record("writer.batch", elapsed)
+            telemetry.record("writer.frame", elapsed / len(batch))
+            # End-to-end latency: camera arrival → page handed to the backend
+            now = time.time()
+            for _, _, _, host_ts in batch:
+                telemetry.record("queue.frame_to_disk", now - host_ts)
+            self._written += len(batch)
+            self._bytes_written += sum(arr.nbytes for _, arr, _, _ in batch)
+        except Exception as e:
+            self._write_errors += len(batch)
+            log.error(
+                f"FrameWriterThread: Error writing frames "
+                f"{batch[0][2].get('frameIdx')}–{batch[-1][2].get('frameIdx')}: {e}"
+            )
+        finally:
+            for frame, _, _, _ in batch:
+                if frame is not None:
+                    frame.release()
+
+    def _discard_pending(self):
+        with self._cond:
+            while self._pending:
+                frame, _, _, _ = self._pending.popleft()
+                if frame is not None:
+                    frame.release()
+            self._pending_bytes = 0
+            self._cond.notify_all()
@@ -0,0 +1,309 @@
+# prim_app/threads/pressure_dsp.py
+"""
+Streaming processing of the PRIM pressure signal.
+
+Every filter keeps a constant amount of state and does O(1) work per sample
+(the moving median O(log n) search plus a small memmove), so the stage can
+run inline on the serial worker for each block before it is emitted.
+"""
+
+import bisect
+import collections
+import logging
+import math
+
+import numpy as np
+
+from utils.config import (
+    DSP_LOWPASS_HZ,
+    DSP_MOVING_WINDOW,
+    DSP_SLOPE_WINDOW,
+    DSP_STEP_DRIFT_MMHG,
+    DSP_STEP_THRESHOLD_MMHG,
+)
+from writers.columnar_log import DSP_RECORD_DTYPE
+
+log = logging.getLogger(__name__)
+
+
+class MovingAverage:
+    """
+    Mean of the last ``window`` values: a running sum over a ring, re-summed
+    once per window so rounding errors do not build up over long runs.
+    """
+
+    def __init__(self, window):
+        self.window = max(1, int(window))
+        self._values = collections.deque()
+        self._sum = 0.0
+        self._since_resum = 0
+
+    def update(self, x):
+        self._values.append(x)
+        self._sum += x
+        if len(self._values) > self.window:
+            self._sum -= self._values.popleft()
+        self._since_resum += 1
+        if self._since_resum >= self.window:
+            self._since_resum = 0
+            self._sum = math.fsum(self._values)
+        return self._sum / len(self._values)
+
+
+class MovingMedian:
+    """Median of the last ``window`` values (arrival ring + sorted window)."""
+
+    def __init__(self, window):
+        self.window = max(1, int(window))
+        self._values = collections.deque()
+        self._sorted = []
+
+    def update(self, x):
+        self._values.append(x)
+        bisect.insort(self._sorted, x)
+        if len(self._values) > self.window:
+            old = self._values.popleft()
+            del self._sorted[bisect.bisect_left(self._sorted, old)]
+        n = len(self._sorted)
+        mid = n // 2
+        if n % 2:
+            return self._sorted[mid]
+        return 0.5 * (self._sorted[mid - 1] + self._sorted[mid])
+
+
+class LowPass:
+    """
+    One-pole IIR low-pass with cut-off ``cutoff_hz``.  The coefficient
+    follows the actual sample spacing, so gaps in the stream do not change
+    the filter's time constant.
+    """
+
+    def __init__(self, cutoff_hz):
+        self.cutoff_hz = float(cutoff_hz)
+        self._y = None
+        self._dt = None
+        self._alpha = 1.0
+
+    def update(self, x, dt):
+        if self._y is None or self.cutoff_hz <= 0:
+            self._y = x
+            return x
+        if dt != self._dt:
+            self._dt = dt
+            w = 2.0 * math.pi * self.cutoff_hz
+            self._alpha = 1.0 - math.exp(-w * max(dt, 0.0))
+        self._y += self._alpha * (x - self._y)
+        return self._y
+
+
+class RunningStats:
+    """Mean and standard deviation since the last reset (Welford)."""
+
+    def __init__(self):
+        self.n = 0
+        self.mean = 0.0
+        self._m2 = 0.0
+
+    def update(self, x):
+        self.n += 1
+        delta = x - self.mean
+        self.mean += delta / self.n
+        self._m2 += delta * (x - self.mean)
+        return self.mean, self.std
+
+    @property
+    def std(self):
+        return math.sqrt(self._m2 / (self.n - 1)) if self.n > 1 else 0.0
+
+
+class SlidingSlope:
+    """
+    Least-squares slope (units per second) over the last ``window`` samples
+    from running sums.  Times are taken relative to the oldest sample, and
+    the sums rebuilt on that origin once per window, so they stay well
+    conditioned however long the recording runs.
+    """
+
+    def __init__(self, window):
+        self.window = max(2, int(window))
+        self._points = collections.deque()  # (absolute t, y)
+        self._t0 = None
+        self._st = self._sy = self._stt = self._sty = 0.0
+        self._since_rebase = 0
+
+    def _rebase(self):
+        self._t0 = self._points[0][0]
+        self._st = self._sy = self._stt = self._sty = 0.0
+        for t, y in self._points:
+            t -= self._t0
+            self._st += t
+            self._sy += y
+            self._stt += t * t
+            self._sty += t * y
+        self._since_rebase = 0
+
+    def update(self, t, y):
+        if self._t0 is None:
+            self._t0 = t
+        self._points.append((t, y))
+        rt = t - self._t0
+        self._st += rt
+        self._sy += y
+        self._stt += rt * rt
+        self._sty += rt * y
+        if len(self._points) > self.window:
+            ot, oy = self._points.popleft()
+            ot -= self._t0
+            self._st -= ot
+            self._sy -= oy
+            self._stt -= ot * ot
+            self._sty -= ot * oy
+        self._since_rebase += 1
+        if self._since_rebase >= self.window:
+            self._rebase()
+
+        n = len(self._points)
+        denom = n * self._stt - self._st * self._st
+        if n < 2 or denom <= 1e-12:
+            return 0.0
+        return (n * self._sty - self._st * self._sy) / denom
+
+
+class StepDetector:
+    """
+    Two-sided CUSUM against a reference level.  Deviations beyond ``drift``
+    accumulate; once either sum passes ``threshold`` a step is reported (+1
+    up, -1 down) and the reference moves to the new level.
+    """
+
+    def __init__(self, threshold, drift):
+        self.threshold = float(threshold)
+        self.drift = float(drift)
+        self._ref = None
+        self._pos = self._neg = 0.0
+
+    def update(self, x):
+        if self._ref is None:
+            self._ref = x
+            return 0
+        d = x - self._ref
+        self._pos = max(0.0, self._pos + d - self.drift)
+        self._neg = max(0.0, self._neg - d - self.drift)
+        if self._pos > self.threshold or self._neg > self.threshold:
+            step = 1 if self._pos > self._neg else -1
+            self._ref = x
+            self._pos = self._neg = 0.0
+            return step
+        return 0
+
+
+class PressureDSP:
+    """
+    Per-sample processing chain of the serial worker: software zero, IIR
+    low-pass, moving average and median, running mean/SD, rate of change of
+    the low-passed signal and step detection on it.
+
+    :meth:`process` turns a PRESSURE_RECORD_DTYPE block into a
+    DSP_RECORD_DTYPE block of the same length.  :meth:`request_zero` and
+    :meth:`request_reset` may be called from any thread; they take effect at
+    the start of the next block.
+    """
+
+    def __init__(
+        self,
+        window=DSP_MOVING_WINDOW,
+        lowpass_hz=DSP_LOWPASS_HZ,
+        slope_window=DSP_SLOPE_WINDOW,
+        step_threshold=DSP_STEP_THRESHOLD_MMHG,
+        step_drift=DSP_STEP_DRIFT_MMHG,
+    ):
+        self.window = window
+        self.lowpass_hz = lowpass_hz
+        self.slope_window = slope_window
+        self.step_threshold = step_threshold
+        self.step_drift = step_drift
+        self.offset = 0.0
+        self.steps = 0
+        self._zero_requested = False
+        self._reset_requested = False
+        self._last_average = None  # raw moving average, for the zero
+        self.reset()
+
+    def reset(self):
+        """Restart every filter and statistic (the zero offset is kept)."""
+        self._lowpass = LowPass(self.lowpass_hz)
+        self._average = MovingAverage(self.window)
+        self._raw_average = MovingAverage(self.window)
+        self._median = MovingMedian(self.window)
+        self._stats = RunningStats()
+        self._slope = SlidingSlope(self.slope_window)
+        self._steps = StepDetector(self.step_threshold, self.step_drift)
+        self._last_t = None
+
+    def request_zero(self):
+        """Tare: subtract the current moving average from now on."""
+        self._zero_requested = True
+
+    def request_reset(self):
+        """Restart the filters, e.g. after the device was zeroed."""
+        self._reset_requested = True
+
+    def _apply_requests(self):
+        if self._zero_requested:
+            self._zero_requested = False
+            if self._last_average is not None:
+                self.offset = self._last_average
+                log.info(f"PressureDSP: software zero at {self.offset:.2f} mmHg")
+            self._reset_requested = True
+        if self._reset_requested:
+            self._reset_requested = False
+            self.reset()
+
+    def process(self, block):
+        self._apply_requests()
+        out = np.empty(len(block), dtype=DSP_RECORD_DTYPE)
+        out["frameIdx"] = block["frameIdx"]
+        out["deviceTime"] = block["deviceTime"]
+        out["offset"] = self.offset
+
+        rows = []
+        for t, p in zip(block["deviceTime"].tolist(), block["pressure"].tolist()):
+            self._last_average = self._raw_average.update(p)
+            x = p - self.offset
+            dt = t - self._last_t if self._last_t is not None else 0.0
+            self._last_t = t
+            lp = self._lowpass.update(x, dt)
+            mean, std = self._stats.update(x)
+            step = self._steps.update(lp)
+            rows.append(
+                (
+                    x,
+                    lp,
+                    self._average.update(x),
+                    self._median.update(x),
+                    mean,
+                    std,
+                    self._slope.update(t, lp),
+                    step,
+                )
+            )
+            if step:
+                self.steps += 1
+
+        if rows:
+            cols = list(zip(*rows))
+            for name, values in zip(
+                (
+                    "pressure",
+                    "lowpass",
+                    "movingAverage",
+                    "movingMedian",
+                    "mean",
+                    "std",
+                    "slope",
+                    "step",
+                ),
+                cols,
+            ):
+                out[name] = values
+        return out
@@ -0,0 +1,177 @@
+# prim_app/threads/preview_converter.py
+
+import logging
+import threading
+
+import numpy as np
+
+from threads.frame_pool import frame_pool
+from utils.config import (
+    PREVIEW_MODES,
+    PREVIEW_DEFAULT_MODE,
+    PREVIEW_PERCENTILES,
+    PREVIEW_PERCENTILE_INTERVAL,
+    PREVIEW_PERCENTILE_SMOOTHING,
+    PREVIEW_PERCENTILE_STRIDE,
+)
+
+log = logging.getLogger(__name__)
+
+
+class PreviewConverter:
+    """
+    Converts native 10/12/16-bit mono frames to 8-bit preview images.
+
+    Every mode is implemented as a 65536-entry uint8 lookup table, so each
+    frame costs a single ``np.take`` pass into a pre-allocated output buffer
+    (no float temporaries, no per-frame extrema).  Modes:
+
+    ``bitdepth``    fixed shift for the sensor's significant bits (stable
+                    brightness; the default)
+    ``percentile``  window from low/high percentiles of a strided sub-sample,
+                    recomputed every PREVIEW_PERCENTILE_INTERVAL frames and
+                    smoothed so the image does not flicker
+    ``manual``      user-set window (low, high) in native counts
+
+    Output buffers form a ring of ``ring_size`` arrays (borrowed from the
+    frame pool) that are reused in turn.  The ring must be at least as large
+    as the number of frames that can be alive at once (the camera's buffer
+    count).
+
+    Settings may be changed from the GUI thread while frames are converted on
+    the camera thread; the table is rebuilt under a lock and swapped in.
+    """
+
+    def __init__(self, ring_size, bit_depth=16, mode=PREVIEW_DEFAULT_MODE):
+        self._lock = threading.Lock()
+        self._ring_size = max(1, int(ring_size))
+        self._ring = []
+        self._ring_index = 0
+        self._ring_shape = None
+
+        self.mode = mode if mode in PREVIEW_MODES else PREVIEW_DEFAULT_MODE
+        self.bit_depth = int(bit_depth)
+        self.window = (0, (1 << self.bit_depth) - 1)
+        self.percentiles = PREVIEW_PERCENTILES
+        self._frames_since_stats = PREVIEW_PERCENTILE_INTERVAL
+        self._smoothed = None
+
+        self._lut = None
+        self._rebuild_lut()
+
+    # ─── Settings ───────────────────────────────────────────────────────
+    def configure(self, mode=None, bit_depth=None, window=None, percentiles=None):
+        """Update any subset of the settings (thread-safe)."""
+        with self._lock:
+            if mode is not None:
+                if mode not in PREVIEW_MODES:
+                    log.warning(f"Unknown preview mode {mode!r}; ignoring.")
+                else:
+                    self.mode = mode
+            if bit_depth is not None:
+                self.bit_depth = min(max(int(bit_depth), 8), 16)
+            if window is not None:
+                low, high = int(window[0]), int(window[1])
+                if high > low:
+                    self.window = (low, high)
+                else:
+                    log.warning(f"Preview window needs low < high: {window}")
+            if percentiles is not None:
+                self.percentiles = (float(percentiles[0]), float(percentiles[1]))
+            # Force fresh statistics when switching to percentile mode
+            self._frames_since_stats = PREVIEW_PERCENTILE_INTERVAL
+            self._smoothed = None
+            self._rebuild_lut()
+
+    def settings(self):
+        with self._lock:
+            return {
+                "mode": self.mode,
+                "bit_depth": self.bit_depth,
+                "window": self.window,
+                "percentiles": self.percentiles,
+            }
+
+    # ─── Lookup table ───────────────────────────────────────────────────
+    @staticmethod
+    def _window_lut(low, high):
+        codes = np.arange(65536, dtype=np.float32)
+        lut = (codes - low) * (255.0 / max(high - low, 1))
+        return np.clip(lut, 0, 255).astype(np.uint8)
+
+    def _rebuild_lut(self):
+        # Caller holds the lock (or is __init__)
+        if self.mode == "bitdepth":
+            shift = max(self.bit_depth - 8, 0)
+            codes = np.arange(65536, dtype=np.uint32) >> shift
+            self._lut = np.minimum(codes, 255).astype(np.uint8)
+        elif self.mode == "manual":
+            self._lut = self._window_lut(*self.window)
+        elif self._smoothed is not None:
+            self._lut = self._window_lut(*self._smoothed)
+        else:
+            full = (1 << self.bit_depth) - 1
+            self._lut = self._window_lut(0, full)
+
+    def _update_percentile_window(self, arr):
+        self._frames_since_stats += 1
+        if self._frames_since_stats < PREVIEW_PERCENTILE_INTERVAL:
+            return
+        self._frames_since_stats = 0
+
+        stride = PREVIEW_PERCENTILE_STRIDE
+        sample = arr[::stride, ::stride]
+        low, high = np.percentile(sample, self.percentiles)
+        if high <= low:
+            high = low + 1
+        with self._lock:
+            if self.mode != "percentile":
+                return
+            if self._smoothed is None:
+                self._smoothed = (float(low), float(high))
+            else:
+                a = PREVIEW_PERCENTILE_SMOOTHING
+                s_low, s_high = self._smoothed
+                self._smoothed = (
+                    s_low + a * (low - s_low),
+                    s_high + a * (high - s_high),
+                )
+            self._rebuild_lut()
+
+    # ─── Conversion ─────────────────────────────────────────────────────
+    def _next_output(self, shape):
+        if self._ring_shape != shape:
+            # Borrowed from the frame pool so the display buffers count
+            # against the memory budget; never refused (policy "allocate")
+            for lease in self._ring:
+                lease.release()
+            self._ring = [
+                frame_pool.acquire(shape, np.uint8, policy="allocate")
+                for _ in range(self._ring_size)
+            ]
+            self._ring_shape = shape
+            self._ring_index = 0
+        out = self._ring[self._ring_index].array
+        self._ring_index = (self._ring_index + 1) % self._ring_size
+        return out
+
+    def convert(self, arr):
+        """
+        Return an 8-bit 2-D view of ``arr`` for display.  8-bit input is
+        returned unchanged; wider input is mapped through the LUT into the
+        next ring buffer.
+        """
+        if arr.ndim == 3 and arr.shape[2] == 1:
+            arr = arr[:, :, 0]
+        if arr.dtype == np.uint8:
+            return arr
+        if arr.dtype != np.uint16:
+            arr = arr.astype(np.uint16)
+
+        if self.mode == "percentile":
+            self._update_percentile_window(arr)
+
+        out = self._next_output(arr.shape)
+        # mode="clip" avoids the buffered bounds check of the default "raise"
+        np.take(self._lut, arr, out=out, mode="clip")
+        return out
@@ -0,0 +1,380 @@
+# prim_app/threads/rate_calibrator.py
+
+import glob
+import logging
+import os
+import shutil
+import time
+
+from PyQt5.QtCore import QObject, QTimer, pyqtSignal, pyqtSlot
+from PyQt5.QtGui import QImage
+
+from threads.frame_writer_thread import FrameWriterThread
+from utils.config import (
+    CALIBRATION_HEADROOM,
+    CALIBRATION_MAX_HZ,
+    CALIBRATION_MIN_THROUGHPUT,
+    CALIBRATION_RATE_FACTOR,
+    CALIBRATION_SETTLE_S,
+    CALIBRATION_START_HZ,
+    CALIBRATION_STEP_S,
+    CALIBRATION_TICK_MS,
+)
+from utils.telemetry import telemetry
+from writers.frame_writers import create_frame_writer
+
+from .serial_protocol import rate_command
+
+log = logging.getLogger(__name__)
+
+
+def calibration_rates(start_hz, max_hz, factor=CALIBRATION_RATE_FACTOR):
+    """
+    Increasing trigger rates from ``start_hz`` to ``max_hz``, ``factor``
+    apart, as the firmware can run them (whole-millisecond intervals).
+    """
+    rates = []
+    hz = max(float(start_hz), 0.1)
+    while hz <= max_hz * 1.0001:
+        actual = rate_command(hz)[1]
+        if not rates or actual > rates[-1]:
+            rates.append(actual)
+        hz *= max(factor, 1.01)
+    return rates
+
+
+class RateCalibrator(QObject):
+    """
+    Finds the highest trigger rate the whole pipeline sustains at the current
+    ROI, pixel format and recording format.
+
+    Meant to be moved to its own QThread (like RecordingManager); its slots
+    then run there.  For each rate of :func:`calibration_rates` the PRIM
+    device is set to it and started, and every frame of ``camera`` goes
+    through a :class:`FrameWriterThread` into a scratch stack in
+    ``scratch_dir``, exactly as when recording.  After CALIBRATION_SETTLE_S
+    the step is measured for CALIBRATION_STEP_S:
+
+    * triggers: samples received from the device (one per CamTrig pulse)
+    * frames: frames that reached the calibrator; fewer than triggers means
+      the camera missed pulses
+    * camera/writer drops, writer spills and frame-pool refusals
+
+    A step passes with zero drops and missed frames and the writer keeping
+    up.  Every tick the written-frame rate is compared with the trigger
+    rate; once it falls below CALIBRATION_MIN_THROUGHPUT of it,
+    ``throughput_warning`` fires and the step fails straight away.  The ramp
+    stops at the first failure, and the highest passing rate times
+    CALIBRATION_HEADROOM is sent to the device; the camera is left in
+    trigger mode.  Scratch stacks are deleted as soon as their step ends.
+
+    After ``calibration_finished`` the owner disconnects ``append_frame`` and
+    queues :meth:`shutdown`; frames queued before it are released first, then
+    ``finished`` fires (connect it to the thread's ``quit``).
+    """
+
+    step_started = pyqtSignal(float)  # trigger rate (Hz)
+    step_finished = pyqtSignal(dict)  # measurements of one step
+    progress = pyqtSignal(int, int)  # steps done, steps planned
+    throughput_warning = pyqtSignal(str)
+    calibration_finished = pyqtSignal(dict)  # {"rate_hz", "best_hz", "steps", ...}
+    error_occurred = pyqtSignal(str)
+    finished = pyqtSignal()
+
+    def __init__(
+        self,
+        camera,
+        serial_thread,
+        recording_format,
+        scratch_dir,
+        start_hz=CALIBRATION_START_HZ,
+        max_hz=CALIBRATION_MAX_HZ,
+        step_s=CALIBRATION_STEP_S,
+        settle_s=CALIBRATION_SETTLE_S,
+        parent=None,
+    ):
+        super().__init__(parent)
+        self.camera = camera
+        self.serial_thread = serial_thread
+        self.recording_format = recording_format
+        self.scratch_dir = scratch_dir
+        self.step_s = float(step_s)
+        self.settle_s = float(settle_s)
+
+        geometry = getattr(camera, "capture_geometry", None) or {}
+        camera_max = geometry.get("max_frame_rate") or max_hz
+        self.rates = calibration_rates(
+            start_hz, min(float(max_hz), float(camera_max))
+        )
+
+        self._timer = None
+        self._writer = None
+        self._step = -1
+        self._results = []
+        self._cancelled = False
+        self._done = False
+        self._was_triggered = getattr(camera, "trigger_mode", False)
+        self._reset_counters()
+
+    def _reset_counters(self):
+        self._measuring = False
+        self._step_started = 0.0
+        self._measure_started = 0.0
+        self._samples = 0
+        self._frames = 0
+        self._frames_submitted = 0
+        self._camera_dropped0 = 0
+        self._writer0 = {}
+        self._pool_dropped0 = 0
+        self._warned = False
+
+    # ─── Control (queued from the GUI thread) ───────────────────────────
+    @pyqtSlot()
+    def start(self):
+        if not self.rates:
+            self.error_occurred.emit(
+                "No trigger rates to try (check the camera's maximum frame rate)."
+            )
+            self._finish()
+            return
+        os.makedirs(self.scratch_dir, exist_ok=True)
+        if not self.camera.set_trigger_mode(True):
+            self.error_occurred.emit(
+                "The camera did not accept TriggerMode On; check the CamTrig wiring "
+                "and CAMERA_TRIGGER_SOURCE."
+            )
+            self._finish()
+            return
+        self._timer = QTimer(self)
+        self._timer.setInterval(CALIBRATION_TICK_MS)
+        self._timer.timeout.connect(self._on_tick)
+        log.info(
+            "RateCalibrator: trying "
+            + ", ".join(f"{r:.1f}" for r in self.rates)
+            + f" Hz with the {self.recording_format} writer"
+        )
+        self._next_step()
+
+    @pyqtSlot()
+    def cancel(self):
+        if self._cancelled or self._done:
+            return
+        self._cancelled = True
+        log.info("RateCalibrator: cancelled.")
+        self._finish()
+
+    @pyqtSlot()
+    def shutdown(self):
+        self._finish()
+        self.finished.emit()
+
+    # ─── Data (queued from the camera and serial threads) ───────────────
+    @pyqtSlot(QImage, object)
+    def append_frame(self, qimg, frame):
+        writer = self._writer
+        if writer is None:
+            frame.release()
+            return
+        if self._measuring:
+            self._frames += 1
+        self._frames_submitted += 1
+        metadata = {
+            "pageIdx": self._frames_submitted - 1,
+            "cameraFrame": int(frame.frame_number),
+            "cameraTimestampNs": int(frame.device_timestamp_ns),
+        }
+        # Ownership of the frame reference passes to the writer
+        writer.submit(frame, metadata)
+
+    @pyqtSlot(object)
+    def append_pressure_block(self, block):
+        if self._measuring:
+            self._samples += len(block)
+
+    # ─── Steps ──────────────────────────────────────────────────────────
+    def _next_step(self):
+        self._step += 1
+        if self._cancelled or self._step >= len(self.rates):
+            self._finish()
+            return
+        rate = self.rates[self._step]
+        base = os.path.join(self.scratch_dir, f"calibration_{self._step:02d}")
+        self._writer = FrameWriterThread(
+            create_frame_writer(self.recording_format, base)
+        )
+        self._writer.error_occurred.connect(self._on_writer_error)
+        self._writer.start()
+
+        self._reset_counters()
+        self._step_started = time.monotonic()
+        self.serial_thread.set_sample_rate(rate)
+        self.serial_thread.send_command("G")
+        self.step_started.emit(rate)
+        self.progress.emit(self._step, len(self.rates))
+        log.info(
+            f"RateCalibrator: step {self._step + 1}/{len(self.rates)} at {rate:.1f} Hz"
+        )
+        self._timer.start()
+
+    def _on_tick(self):
+        now = time.monotonic()
+        if not self._measuring:
+            if now - self._step_started < self.settle_s:
+                return
+            # Baselines once the pipeline has reached its steady state
+            self._measuring = True
+            self._measure_started = now
+            self._samples = self._frames = 0
+            self._camera_dropped0 = self._camera_dropped()
+            self._writer0 = self._writer.get_stats()
+            self._pool_dropped0 = self._pool_dropped()
+            return
+
+        step = self._measure()
+        elapsed = step["elapsed_s"]
+        trigger_hz = self.rates[self._step]
+        # Early warning: the disk side must keep pace with the triggers.  A
+        # drained queue means the camera, not the writer, is short of frames,
+        # which the missed-trigger count catches at the end of the step.
+        falling_behind = (
+            elapsed >= 1.0
+            and step["written_hz"] < CALIBRATION_MIN_THROUGHPUT * trigger_hz
+            and step["queue_depth"] > 1
+        )
+        if falling_behind:
+            self._warned = True
+            message = (
+                f"Throughput {step['written_hz']:.1f} frames/s is below the "
+                f"trigger rate {trigger_hz:.1f} Hz (queue {step['queue_depth']})."
+            )
+            log.warning(f"RateCalibrator: {message}")
+            telemetry.count("calibration.throughput_warning")
+            self.throughput_warning.emit(message)
+            self._end_step()
+            return
+        if (
+            step["camera_dropped"]
+            or step["writer_dropped"]
+            or step["pool_dropped"]
+            or elapsed >= self.step_s
+        ):
+            self._end_step()
+
+    def _measure(self):
+        elapsed = max(time.monotonic() - self._measure_started, 1e-6)
+        writer = self._writer.get_stats()
+        written = writer["written"] - self._writer0.get("written", 0)
+        return {
+            "rate_hz": self.rates[self._step],
+            "elapsed_s": elapsed,
+            "triggers": self._samples,
+            "frames": self._frames,
+            "missed": max(0, self._samples - self._frames),
+            "trigger_hz": self._samples / elapsed,
+            "written_hz": written / elapsed,
+            "camera_dropped": self._camera_dropped() - self._camera_dropped0,
+            "writer_dropped": writer["dropped"] - self._writer0.get("dropped", 0),
+            "spilled": writer["spilled"] - self._writer0.get("spilled", 0),
+            "queue_depth": writer["queue_depth"],
+            "mb_per_s": writer["mb_per_s"],
+            "pool_dropped": self._pool_dropped() - self._pool_dropped0,
+        }
+
+    def _end_step(self):
+        self._timer.stop()
+        step = self._measure()
+        self._measuring = False
+        self.serial_thread.send_command("S")
+        # Missed triggers within one block of the end are still in flight
+        tolerance = max(1, int(0.01 * step["triggers"]))
+        step["passed"] = bool(
+            not self._warned
+            and step["triggers"] > 0
+            and step["missed"] <= tolerance
+            and not step["camera_dropped"]
+            and not step["writer_dropped"]
+            and not step["spilled"]
+            and not step["pool_dropped"]
+        )
+        self._close_writer()
+        self._results.append(step)
+        self.step_finished.emit(step)
+        log.info(
+            f"RateCalibrator: {step['rate_hz']:.1f} Hz "
+            + ("passed" if step["passed"] else "failed")
+            + f" ({step['frames']}/{step['triggers']} frames, "
+            f"{step['written_hz']:.1f} written/s, camera dropped "
+            f"{step['camera_dropped']}, writer dropped {step['writer_dropped']}, "
+            f"spilled {step['spilled']})"
+        )
+        if not step["passed"]:
+            self._finish()
+            return
+        self._next_step()
+
+    def _close_writer(self):
+        writer, self._writer = self._writer, None
+        if writer is None:
+            return
+        writer.finish()
+        if not writer.wait(30000):
+            log.warning("RateCalibrator: writer did not finish in time.")
+        for path in glob.glob(writer.path.rsplit(".", 1)[0] + "*"):
+            try:
+                os.remove(path)
+            except OSError as e:
+                log.debug(f"RateCalibrator: could not remove {path}: {e}")
+
+    def _finish(self):
+        if self._done:
+            return
+        self._done = True
+        if self._timer is not None:
+            self._timer.stop()
+        if self._writer is not None:
+            self.serial_thread.send_command("S")
+            self._close_writer()
+        shutil.rmtree(self.scratch_dir, ignore_errors=True)
+
+        summary = self._summary()
+        if summary["rate_hz"] and not self._cancelled:
+            summary["rate_hz"] = self.serial_thread.set_sample_rate(summary["rate_hz"])
+            log.info(
+                f"RateCalibrator: highest sustained rate {summary['best_hz']:.1f} Hz; "
+                f"device set to {summary['rate_hz']:.1f} Hz"
+            )
+        else:
+            # Nothing passed (or cancelled): leave the camera as it was
+            summary["rate_hz"] = None
+            self.camera.set_trigger_mode(self._was_triggered)
+        self.progress.emit(len(self._results), len(self.rates))
+        self.calibration_finished.emit(summary)
+
+    def _summary(self):
+        passed = [s for s in self._results if s["passed"]]
+        best = passed[-1]["rate_hz"] if passed else None
+        return {
+            "best_hz": best,
+            "rate_hz": best * CALIBRATION_HEADROOM if best else None,
+            "steps": list(self._results),
+            "cancelled": self._cancelled,
+            "recording_format": self.recording_format,
+        }
+
+    # ─── Counters ───────────────────────────────────────────────────────
+    def _camera_dropped(self):
+        try:
+            return int(self.camera.get_stats().get("dropped", 0))
+        except Exception:
+            return 0
+
+    @staticmethod
+    def _pool_dropped():
+        from threads.frame_pool import frame_pool
+
+        return frame_pool.dropped
+
+    @pyqtSlot(str)
+    def _on_writer_error(self, msg):
+        log.error(f"RateCalibrator: writer error: {msg}")
+        self.error_occurred.emit(msg)
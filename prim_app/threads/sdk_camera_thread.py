@@ -1,51 +1,234 @@
 # File: prim_app/threads/sdk_camera_thread.py
 
 import logging
+import queue
+import threading
+import time
+import re
 import imagingcontrol4 as ic4
-import numpy as np
 
-from utils.config import DEFAULT_FPS
+from utils.telemetry import telemetry
+from utils.config import (
+    DEFAULT_FPS,
+    CAMERA_BUFFER_COUNT,
+    CAMERA_STATS_INTERVAL_MS,
+    CAMERA_DUMP_PROPERTIES,
+    CAMERA_TRIGGER_ACTIVATION,
+    CAMERA_TRIGGER_MODE,
+    CAMERA_TRIGGER_SOURCE,
+    PREVIEW_BIT_DEPTH,
+)
 
 from PyQt5.QtCore import QThread, pyqtSignal
 from PyQt5.QtGui import QImage
 
+from .camera_frame import CameraFrame
+from .camera_properties import PropertyCache
+from .preview_converter import PreviewConverter
+
 log = logging.getLogger(__name__)
 
 
 class SDKCameraThread(QThread):
     """
     Opens the camera (using the DeviceInfo + resolution passed in via set_* methods),
-    then starts a QueueSink-based stream. Each new frame is emitted as a QImage via
-    frame_ready(QImage, buffer). When stop() is called, stops streaming and closes the device.
+    then starts a QueueSink-based stream. Each new frame is emitted via
+    frame_ready(QImage, CameraFrame): the QImage is for display only, the
+    CameraFrame carries the native pixels plus metadata and keeps the IC4 buffer
+    alive until every consumer has released it. When stop() is called, stops
+    streaming and closes the device.
+
+    The sink owns a ring of ``buffer_count`` pre-allocated output buffers. The IC4
+    callback (:meth:`frames_queued`) only pops a buffer and hands it to an internal
+    queue; conversion and signal emission happen on this thread's own loop in
+    :meth:`run`, so a slow consumer no longer blocks the driver callback.
+
+    An optional capture ROI (:meth:`set_capture_roi`) sets sensor binning and
+    a hardware Width/Height/OffsetX/OffsetY window before streaming, then
+    raises AcquisitionFrameRate to the maximum the camera reports for it.
+    The geometry actually applied is in :attr:`capture_geometry` once
+    ``grabber_ready`` has been emitted.
+
+    A camera profile (:meth:`set_profile`, ``{property: value}``) is written
+    in one batch through :attr:`property_cache` after the defaults and before
+    ``stream_setup``, so every start leaves the camera in the same state.
+
+    With trigger mode on (:meth:`set_trigger_mode`, CAMERA_TRIGGER_MODE) the
+    camera exposes one frame per CamTrig pulse on CAMERA_TRIGGER_SOURCE
+    instead of free-running at AcquisitionFrameRate.
+
+    ``camera_id`` tags every CameraFrame (and the stats dict) so several
+    threads, one per camera, can feed the same RecordingManager.
     """
 
     # Emitted once the grabber is open (but before streaming starts).
     grabber_ready = pyqtSignal()
 
-    # Emitted for each new frame: (QImage, raw_buffer_object)
+    # Emitted for each new frame: (preview QImage, CameraFrame).
+    # Every connected slot must call CameraFrame.release() once it is done.
     frame_ready = pyqtSignal(QImage, object)
 
     # Emitted on error: (message, code_as_string)
     error = pyqtSignal(str, str)
 
-    def __init__(self, parent=None):
+    # Emitted every CAMERA_STATS_INTERVAL_MS with a dict of pipeline counters
+    # (see :meth:`get_stats`).
+    stats_updated = pyqtSignal(dict)
+
+    def __init__(self, camera_id=0, parent=None):
         super().__init__(parent)
+        self.camera_id = int(camera_id)
         self.grabber = None
         self._stop_requested = False
 
         # Will be set by MainWindow before start():
         self._device_info = None  # an ic4.DeviceInfo instance
         self._resolution = None  # tuple (width, height, pixel_format_name)
+        self._frame_rate = float(DEFAULT_FPS)
+        # {"x", "y", "width", "height", "binning", "max_frame_rate"} in sensor
+        # pixels (width/height None = full sensor); None keeps _resolution
+        self._capture_roi = None
+        self.capture_geometry = None
+        self._profile = None
+        self._trigger_mode = bool(CAMERA_TRIGGER_MODE)
+        self.property_cache = None  # PropertyCache, valid while the device is open
+        # Headless runs skip the 8-bit preview and emit a null QImage
+        self._preview_enabled = True
 
         # Keep a reference to the sink so we can stop it later
         self._sink = None
 
+        # Buffer ring + hand-off queue between the IC4 callback and run()
+        self._buffer_count = CAMERA_BUFFER_COUNT
+        self._frame_queue = queue.Queue(maxsize=self._buffer_count)
+
+        # Pipeline counters (touched from the IC4 callback thread and run())
+        self._stats_lock = threading.Lock()
+        self._frames_queued = 0
+        self._frames_processed = 0
+        self._frames_dropped = 0
+
+        # >8-bit → 8-bit preview stage; the ring is resized in set_buffer_count()
+        self._preview = PreviewConverter(self._buffer_count + 2)
+
     def set_device_info(self, dev_info):
         self._device_info = dev_info
 
+    def set_frame_rate(self, fps):
+        """AcquisitionFrameRate applied when the device opens (call before start())."""
+        self._frame_rate = float(fps)
+
+    def set_trigger_mode(self, enabled):
+        """
+        Hardware trigger on or off.  Before start() it is applied when the
+        device opens; while streaming it is written at once.  Returns False
+        if the camera rejected it.
+        """
+        self._trigger_mode = bool(enabled)
+        if self.grabber is None or self.property_cache is None:
+            return True
+        return self._apply_trigger_mode(self.grabber.device_property_map)
+
+    @property
+    def trigger_mode(self):
+        return self._trigger_mode
+
+    def set_capture_roi(self, roi):
+        """Hardware ROI/binning applied when the device opens (call before start())."""
+        self._capture_roi = dict(roi) if roi else None
+
+    def set_profile(self, properties):
+        """Camera profile applied before streaming starts (call before start())."""
+        self._profile = dict(properties) if properties else None
+
+    def set_preview_enabled(self, enabled):
+        """Without a preview, frame_ready carries a null QImage and no conversion runs."""
+        self._preview_enabled = bool(enabled)
+
+    def set_buffer_count(self, count):
+        """Set the size of the QueueSink buffer ring (must be called before start())."""
+        self._buffer_count = max(2, int(count))
+        self._frame_queue = queue.Queue(maxsize=self._buffer_count)
+        self._preview = PreviewConverter(
+            self._buffer_count + 2, **self._preview_init_args()
+        )
+
+    def _preview_init_args(self):
+        settings = self._preview.settings()
+        return {"bit_depth": settings["bit_depth"], "mode": settings["mode"]}
+
+    def set_preview_settings(self, settings):
+        """
+        Change the preview conversion (``mode``, ``bit_depth``, ``window``,
+        ``percentiles``; see PreviewConverter).  Safe to call while streaming.
+        """
+        self._preview.configure(**settings)
+
+    def preview_settings(self):
+        return self._preview.settings()
+
+    @staticmethod
+    def _significant_bits(pf_name):
+        """Bit depth implied by a PixelFormat name, e.g. Mono12p → 12."""
+        m = re.search(r"(\d+)", pf_name or "")
+        return int(m.group(1)) if m else 8
+
+    def _sink_pixel_formats(self):
+        """
+        Output formats to request from the QueueSink: the native depth for
+        mono sensors so the recorder gets the data untouched (Mono10/12/14/16
+        → Mono16).  Everything else (Bayer, RGB, YUV) is converted to Mono8 by
+        IC4, as the preview and recording pipelines are single-channel.
+        """
+        native_pf = self._resolution[2] if self._resolution else None
+        if native_pf and native_pf.startswith("Mono"):
+            if self._significant_bits(native_pf) > 8:
+                return [ic4.PixelFormat.Mono16]
+        return [ic4.PixelFormat.Mono8]
+
+    def get_stats(self):
+        """
+        Return a snapshot of the frame pipeline counters:
+
+        - ``queued``: buffers handed over by the IC4 callback
+        - ``processed``: frames converted and emitted via frame_ready
+        - ``dropped``: frames lost either in our hand-off queue or inside IC4
+          (device/transform/sink underruns reported by ``stream_statistics``)
+        - ``queue_depth`` / ``buffer_count``: current fill level of the ring
+        """
+        with self._stats_lock:
+            stats = {
+                "camera_id": self.camera_id,
+                "queued": self._frames_queued,
+                "processed": self._frames_processed,
+                "dropped": self._frames_dropped,
+                "queue_depth": self._frame_queue.qsize(),
+                "buffer_count": self._buffer_count,
+            }
+
+        if self.grabber is not None:
+            try:
+                ss = self.grabber.stream_statistics
+                stats["dropped"] += (
+                    ss.device_underrun + ss.transform_underrun + ss.sink_underrun
+                )
+                stats["device_delivered"] = ss.device_delivered
+                stats["transmission_errors"] = ss.device_transmission_error
+            except Exception:
+                # Stream statistics are only available while streaming
+                pass
+
+        return stats
+
     def set_resolution(self, resolution_tuple):
         # resolution_tuple is (w, h, pf_name), e.g. (2448, 2048, "Mono8")
         self._resolution = resolution_tuple
+        # Default preview shift follows the sensor's significant bits; non-mono
+        # formats arrive as Mono8 (see _sink_pixel_formats)
+        pf_name = resolution_tuple[2] or ""
+        native_bits = self._significant_bits(pf_name) if pf_name.startswith("Mono") else 8
+        bits = PREVIEW_BIT_DEPTH or native_bits
+        self._preview.configure(bit_depth=bits)
 
     def run(self):
         try:
@@ -75,14 +258,15 @@ class SDKCameraThread(QThread):
 
             # ─── Apply PixelFormat & resolution ────────────────────────────────
 
-            # ─── DEBUG: Log all available float properties ────────────────────
-            log.debug("Available float properties:")
-            for p in self.grabber.device_property_map:
-                try:
-                    val = p.get_value()
-                    log.debug(f"{p.identifier} = {val}")
-                except Exception:
-                    pass
+            # ─── DEBUG: Log all device properties (CAMERA_DUMP_PROPERTIES) ────
+            if CAMERA_DUMP_PROPERTIES and log.isEnabledFor(logging.DEBUG):
+                log.debug("Available device properties:")
+                for p in self.grabber.device_property_map:
+                    try:
+                        val = p.get_value()
+                        log.debug(f"{p.identifier} = {val}")
+                    except Exception:
+                        pass
 
             # ─── Set Default Camera Properties BEFORE Streaming ───────────────
             props = self.grabber.device_property_map
@@ -98,18 +282,6 @@ class SDKCameraThread(QThread):
                 log.info("Set Gain to 5.0")
             except Exception as e:
                 log.warning(f"Could not set Gain: {e}")
-            try:
-                fr_node = props.find_float("AcquisitionFrameRate")
-                if fr_node:
-                    fr_node.value = float(DEFAULT_FPS)
-                    log.info(
-                        f"SDKCameraThread: Set AcquisitionFrameRate = {DEFAULT_FPS}"
-                    )
-            except Exception as e:
-                log.warning(
-                    f"SDKCameraThread: Could not set AcquisitionFrameRate: {e}"
-                )
-
             if self._resolution is not None:
                 w, h, pf_name = self._resolution
                 try:
@@ -132,6 +304,14 @@ class SDKCameraThread(QThread):
                 except Exception as e:
                     log.warning(f"SDKCameraThread: Could not set resolution/PF: {e}")
 
+            # ─── Capture ROI / binning, then the frame rate it allows ─────────
+            # The maximum AcquisitionFrameRate depends on the geometry, so it
+            # is set last.
+            if self._capture_roi is not None:
+                self._apply_capture_roi(props)
+            self._apply_frame_rate(props)
+            self.capture_geometry = self._read_geometry(props)
+
             # ─── Disable Auto features to keep manual settings stable ─────────
 
             try:
@@ -168,40 +348,49 @@ class SDKCameraThread(QThread):
             except Exception as e:
                 log.warning(f"SDKCameraThread: Could not set AcquisitionMode: {e}")
 
-            # ─── Disable trigger so camera will free‐run ─────────────────────────
-            try:
-                trig_node = self.grabber.device_property_map.find_enumeration(
-                    "TriggerMode"
+            # ─── Hardware trigger (CamTrig) or free-run ─────────────────────────
+            self._apply_trigger_mode(props)
+
+            # ─── Camera profile, in one batch through the cached nodes ─────────
+            self.property_cache = PropertyCache(props)
+            if self._profile:
+                profile = dict(self._profile)
+                if self._capture_roi and self._capture_roi.get("max_frame_rate"):
+                    # The ROI asked for its maximum rate; keep it
+                    profile.pop("AcquisitionFrameRate", None)
+                t0 = time.perf_counter()
+                failed = self.property_cache.apply_batch(profile)
+                log.info(
+                    f"SDKCameraThread: Applied camera profile ({len(profile) - len(failed)}"
+                    f"/{len(profile)} properties) in "
+                    f"{(time.perf_counter() - t0) * 1000:.1f} ms"
                 )
-                if trig_node:
-                    trig_node.value = "Off"
-                    log.info("SDKCameraThread: Set TriggerMode = Off")
-                else:
-                    log.warning(
-                        "SDKCameraThread: TriggerMode node not found; assuming free‐run."
-                    )
-            except Exception as e:
-                log.warning(f"SDKCameraThread: Could not disable TriggerMode: {e}")
+                self.capture_geometry = self._read_geometry(props)
 
             # ─── Signal “grabber_ready” so UI can enable controls ────────────────
             self.grabber_ready.emit()
 
-            # ─── Build QueueSink requesting Mono8 (fallback to native PF if needed)─
+            # ─── Build QueueSink at native bit depth (fallback to Mono8) ─────────
+            # The actual buffer ring is allocated in sink_connected().
             try:
                 self._sink = ic4.QueueSink(
-                    self, [ic4.PixelFormat.Mono8], max_output_buffers=1
+                    self,
+                    self._sink_pixel_formats(),
+                    max_output_buffers=self._buffer_count,
+                )
+            except Exception as e:
+                log.warning(
+                    f"SDKCameraThread: QueueSink for native PF failed ({e}); using Mono8."
                 )
-            except:
-                native_pf = self._resolution[2] if self._resolution else None
-                if native_pf and hasattr(ic4.PixelFormat, native_pf):
+                try:
                     self._sink = ic4.QueueSink(
                         self,
-                        [getattr(ic4.PixelFormat, native_pf)],
-                        max_output_buffers=1,
+                        [ic4.PixelFormat.Mono8],
+                        max_output_buffers=self._buffer_count,
                     )
-                else:
+                except Exception:
                     raise RuntimeError(
-                        "SDKCameraThread: Unable to create QueueSink for Mono8 or native PF."
+                        "SDKCameraThread: Unable to create QueueSink for native PF or Mono8."
                     )
 
             # ─── Start streaming immediately ───────────────────────────────────────
@@ -215,11 +404,29 @@ class SDKCameraThread(QThread):
                 "SDKCameraThread: stream_setup(ACQUISITION_START) succeeded. Entering frame loop…"
             )
 
-            # ─── Frame loop: IC4 calls frames_queued() whenever a new buffer is ready ─
+            # ─── Frame loop: IC4 calls frames_queued() whenever a new buffer is ready,
+            #     this loop converts and emits whatever the callback queued ─────────
+            last_stats = time.monotonic()
+            stats_interval = CAMERA_STATS_INTERVAL_MS / 1000.0
             while not self._stop_requested:
-                self.msleep(10)
+                try:
+                    buf, t_queued = self._frame_queue.get(timeout=0.05)
+                except queue.Empty:
+                    buf = None
+
+                if buf is not None:
+                    telemetry.record(
+                        "camera.handoff", time.perf_counter() - t_queued
+                    )
+                    self._process_buffer(buf)
+
+                now = time.monotonic()
+                if now - last_stats >= stats_interval:
+                    last_stats = now
+                    self.stats_updated.emit(self.get_stats())
 
             # ─── Stop streaming & close device ───────────────────────────────────
+            self._drain_frame_queue()
             self.grabber.stream_stop()
             self.grabber.device_close()
             log.info("SDKCameraThread: Streaming stopped, device closed.")
@@ -235,41 +442,272 @@ class SDKCameraThread(QThread):
             # All cleanup is handled by MainWindow once threads have stopped.
             pass
 
+    # ─── Capture geometry ──────────────────────────────────────────────
+    @staticmethod
+    def _set_integer(props, name, value):
+        """
+        Set integer property ``name`` to ``value`` snapped to its increment
+        and range; returns the value applied, or None if it is unavailable.
+        """
+        try:
+            node = props.find_integer(name)
+            if not node:
+                return None
+            lo, hi = node.minimum, node.maximum
+            try:
+                inc = max(1, node.increment)
+            except Exception:
+                inc = 1
+            value = lo + ((int(value) - lo) // inc) * inc
+            node.value = min(max(value, lo), hi)
+            return node.value
+        except Exception as e:
+            log.debug(f"SDKCameraThread: Could not set {name}: {e}")
+            return None
+
+    @staticmethod
+    def _get_integer(props, name, attr="value", default=None):
+        try:
+            node = props.find_integer(name)
+            return getattr(node, attr) if node else default
+        except Exception:
+            return default
+
+    def _apply_capture_roi(self, props):
+        """Binning first (it changes WidthMax/HeightMax), then size, then offsets."""
+        roi = self._capture_roi
+        binning = max(1, int(roi.get("binning") or 1))
+        applied = 1
+        for h_name, v_name in (
+            ("BinningHorizontal", "BinningVertical"),
+            ("DecimationHorizontal", "DecimationVertical"),
+        ):
+            bh = self._set_integer(props, h_name, binning)
+            if bh is None:
+                continue
+            self._set_integer(props, v_name, binning)
+            applied = bh
+            break
+        if applied != binning:
+            log.warning(
+                f"SDKCameraThread: Binning {binning}× not available; using {applied}×."
+            )
+
+        # Offsets to 0 so Width/Height can take any value up to the maximum
+        self._set_integer(props, "OffsetX", 0)
+        self._set_integer(props, "OffsetY", 0)
+        for size_name, key, offset_name, offset_key in (
+            ("Width", "width", "OffsetX", "x"),
+            ("Height", "height", "OffsetY", "y"),
+        ):
+            full = self._get_integer(props, size_name, "maximum")
+            if full is None:
+                continue
+            want = roi.get(key)
+            size = full if not want else min(full, int(want) // applied)
+            size = self._set_integer(props, size_name, size) or full
+            offset = int(roi.get(offset_key) or 0) // applied
+            self._set_integer(props, offset_name, min(offset, full - size))
+
+        g = self._read_geometry(props)
+        log.info(
+            f"SDKCameraThread: Capture ROI {g['width']}×{g['height']} at "
+            f"({g['x']}, {g['y']}) sensor px, binning {g['binning']}×"
+        )
+
+    def _apply_frame_rate(self, props):
+        """Requested rate, or the geometry's maximum with ``max_frame_rate``."""
+        try:
+            fr_node = props.find_float("AcquisitionFrameRate")
+            if not fr_node:
+                return
+            fr_max = fr_node.maximum
+            target = self._frame_rate
+            if self._capture_roi and self._capture_roi.get("max_frame_rate"):
+                target = fr_max
+            fr_node.value = min(max(target, fr_node.minimum), fr_max)
+            log.info(
+                f"SDKCameraThread: Set AcquisitionFrameRate = {fr_node.value:.2f} "
+                f"(max {fr_max:.2f})"
+            )
+        except Exception as e:
+            log.warning(f"SDKCameraThread: Could not set AcquisitionFrameRate: {e}")
+
+    def _apply_trigger_mode(self, props):
+        """TriggerMode On (FrameStart on CAMERA_TRIGGER_SOURCE) or Off."""
+        try:
+            trig_node = props.find_enumeration("TriggerMode")
+            if not trig_node:
+                log.warning(
+                    "SDKCameraThread: TriggerMode node not found; assuming free‐run."
+                )
+                return not self._trigger_mode
+            if self._trigger_mode:
+                for name, value in (
+                    ("TriggerSelector", "FrameStart"),
+                    ("TriggerSource", CAMERA_TRIGGER_SOURCE),
+                    ("TriggerActivation", CAMERA_TRIGGER_ACTIVATION),
+                ):
+                    try:
+                        node = props.find_enumeration(name)
+                        if node:
+                            node.value = value
+                    except Exception as e:
+                        log.debug(f"SDKCameraThread: Could not set {name}: {e}")
+            trig_node.value = "On" if self._trigger_mode else "Off"
+            log.info(f"SDKCameraThread: Set TriggerMode = {trig_node.value}")
+            return True
+        except Exception as e:
+            log.warning(f"SDKCameraThread: Could not set TriggerMode: {e}")
+            return False
+
+    def _read_geometry(self, props):
+        """Applied geometry in sensor pixels plus the frame rate and its maximum."""
+        binning = 1
+        for name in ("BinningHorizontal", "DecimationHorizontal"):
+            value = self._get_integer(props, name)
+            if value:
+                binning = int(value)
+                break
+        width = self._get_integer(props, "Width", default=0)
+        height = self._get_integer(props, "Height", default=0)
+        geometry = {
+            "x": self._get_integer(props, "OffsetX", default=0) * binning,
+            "y": self._get_integer(props, "OffsetY", default=0) * binning,
+            "width": width * binning,
+            "height": height * binning,
+            "binning": binning,
+            "sensor_width": self._get_integer(props, "SensorWidth", default=None),
+            "sensor_height": self._get_integer(props, "SensorHeight", default=None),
+            "frame_rate": None,
+            "max_frame_rate": None,
+        }
+        try:
+            fr_node = props.find_float("AcquisitionFrameRate")
+            geometry["frame_rate"] = fr_node.value
+            geometry["max_frame_rate"] = fr_node.maximum
+        except Exception:
+            pass
+        return geometry
+
     def frames_queued(self, sink):
         """
         This callback is invoked by IC4 each time a new buffer is available.
-        Pop the buffer, convert to QImage, emit it, and allow IC4 to recycle it.
+        It only pops the buffer and hands it to run(); no conversion happens here.
+        If the hand-off queue is full the oldest pending buffer is dropped so the
+        preview stays current.
         """
+        t0 = time.perf_counter()
         try:
             buf = sink.pop_output_buffer()
-            arr = buf.numpy_wrap()  # arr: shape=(H, W) dtype=uint8 or uint16
+        except Exception as e:
+            log.error(f"SDKCameraThread.frames_queued: Error popping buffer: {e}")
+            return
 
-            # Downconvert 16‐bit to 8‐bit if necessary
-            if arr.dtype == np.uint8:
-                gray8 = arr
-            else:
-                max_val = float(arr.max()) if arr.max() > 0 else 1.0
-                scale = 255.0 / max_val
-                gray8 = (arr.astype(np.float32) * scale).astype(np.uint8)
+        # Queued together with the hand-off time (camera.handoff latency)
+        item = (buf, time.perf_counter())
+        try:
+            self._frame_queue.put_nowait(item)
+        except queue.Full:
+            try:
+                stale, _ = self._frame_queue.get_nowait()
+                self._release_buffer(stale)
+            except queue.Empty:
+                pass
+            with self._stats_lock:
+                self._frames_dropped += 1
+            telemetry.count("camera.dropped")
+            try:
+                self._frame_queue.put_nowait(item)
+            except queue.Full:
+                self._release_buffer(buf)
+                return
+
+        with self._stats_lock:
+            self._frames_queued += 1
+        telemetry.record("camera.callback", time.perf_counter() - t0)
+
+    def _process_buffer(self, buf):
+        """Wrap one popped buffer in a CameraFrame and emit it (runs on this thread)."""
+        try:
+            frame = CameraFrame.from_ic4_buffer(buf, camera_id=self.camera_id)
+        except Exception as e:
+            log.error(f"SDKCameraThread._process_buffer: Error wrapping buffer: {e}")
+            self._release_buffer(buf)
+            return
+
+        try:
+            if not self._preview_enabled:
+                frame.retain(self.receivers(self.frame_ready))
+                self.frame_ready.emit(QImage(), frame)
+                with self._stats_lock:
+                    self._frames_processed += 1
+                return
+
+            arr = frame.array  # arr: shape=(H, W) dtype=uint8 or uint16
+
+            # Downconvert >8‐bit to 8‐bit for the preview only (one LUT pass
+            # into a reused buffer); the native array stays untouched for the
+            # recorder.
+            t0 = time.perf_counter()
+            gray8 = self._preview.convert(arr)
+            telemetry.record("camera.convert", time.perf_counter() - t0)
+            if gray8 is not arr:
+                frame.preview = gray8
 
             h, w = gray8.shape[:2]
 
-            # Build a QImage from single‐channel grayscale
+            # Build a QImage from single‐channel grayscale.  It aliases memory
+            # owned by ``frame``, which stays valid until the frame is released.
             qimg = QImage(gray8.data, w, h, gray8.strides[0], QImage.Format_Grayscale8)
 
-            # Emit to the UI
-            self.frame_ready.emit(qimg, buf)
+            # One reference per connected consumer, then emit to the UI/recorder
+            frame.retain(self.receivers(self.frame_ready))
+            t0 = time.perf_counter()
+            self.frame_ready.emit(qimg, frame)
+            telemetry.record("camera.emit", time.perf_counter() - t0)
+
+            with self._stats_lock:
+                self._frames_processed += 1
 
         except Exception as e:
             log.error(
-                f"SDKCameraThread.frames_queued: Error popping/converting buffer: {e}"
+                f"SDKCameraThread._process_buffer: Error converting buffer: {e}"
             )
             code_enum = getattr(e, "code", None)
             code_str = str(code_enum) if code_enum else ""
             self.error.emit(str(e), code_str)
 
+        finally:
+            # Drop the producer's own reference
+            frame.release()
+
+    def _drain_frame_queue(self):
+        """Release every buffer still waiting in the hand-off queue."""
+        while True:
+            try:
+                buf, _ = self._frame_queue.get_nowait()
+            except queue.Empty:
+                break
+            self._release_buffer(buf)
+
+    @staticmethod
+    def _release_buffer(buf):
+        """Give a buffer back to the sink's free queue."""
+        try:
+            buf.release()
+        except Exception:
+            pass
+
     # ─── Required listener methods for QueueSink ─────────────────────────────
     def sink_connected(self, sink, pixel_format, min_buffers_required) -> bool:
+        # Pre-allocate the whole ring up front so no allocation happens mid-stream
+        count = max(self._buffer_count, min_buffers_required)
+        try:
+            sink.alloc_and_queue_buffers(count)
+            log.info(f"SDKCameraThread: Allocated {count} sink buffers.")
+        except Exception as e:
+            log.warning(f"SDKCameraThread: Could not pre-allocate sink buffers: {e}")
         # Return True so the sink actually attaches
         return True
 
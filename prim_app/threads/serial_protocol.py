@@ -0,0 +1,166 @@
+# prim_app/threads/serial_protocol.py
+"""
+Stream parsers for the PRIM device's serial output.
+
+Both parsers accept arbitrary chunks of bytes (whatever one bulk read
+returned) via :meth:`feed` and return every complete sample as a list of
+``(frameIdx, deviceTime_s, pressure)`` tuples.  Incomplete trailing data is
+kept for the next call.
+
+ASCII (default firmware)::
+
+    <frameIdx>,<deviceTime_s>,<pressure>\\r\\n
+
+Binary (compact firmware option), one PACKET_SIZE-byte packet per sample::
+
+    0xAA 0x55 | uint32 frameIdx | uint32 deviceTime_ms | float32 pressure | uint8 checksum
+
+All fields little-endian; the checksum is the sum of the 12 payload bytes
+modulo 256.
+
+Commands to the device are ASCII lines: ``G`` start, ``S`` stop, ``Z`` zero,
+and ``<SERIAL_RATE_COMMAND_PREFIX><interval_ms>`` for the sample/CamTrig
+interval (:func:`rate_command`).
+"""
+
+import logging
+import struct
+
+from utils.config import SERIAL_RATE_COMMAND_PREFIX
+
+log = logging.getLogger(__name__)
+
+SYNC = b"\xaa\x55"
+PAYLOAD = struct.Struct("<IIf")
+PACKET_SIZE = len(SYNC) + PAYLOAD.size + 1
+DEVICE_TIME_SCALE = 1e-3  # deviceTime_ms → seconds
+
+# Cap on buffered bytes without a line terminator / sync word (garbage guard)
+MAX_PENDING_BYTES = 64 * 1024
+
+
+class AsciiLineParser:
+    """Splits newline-terminated CSV lines; bad lines are counted and skipped."""
+
+    def __init__(self):
+        self._pending = bytearray()
+        self.malformed = 0
+
+    def reset(self):
+        self._pending.clear()
+
+    def feed(self, data):
+        self._pending += data
+        end = self._pending.rfind(b"\n")
+        if end < 0:
+            if len(self._pending) > MAX_PENDING_BYTES:
+                self.malformed += 1
+                self._pending.clear()
+            return []
+
+        lines = bytes(self._pending[:end]).split(b"\n")
+        del self._pending[: end + 1]
+
+        samples = []
+        for line in lines:
+            parts = line.split(b",")
+            if len(parts) < 3:
+                if line.strip():
+                    self._bad_line(line, "expected 3 fields")
+                continue
+            try:
+                # int()/float() accept bytes with surrounding whitespace
+                samples.append((int(parts[0]), float(parts[1]), float(parts[2])))
+            except ValueError as ve:
+                self._bad_line(line, ve)
+        return samples
+
+    def _bad_line(self, line, reason):
+        self.malformed += 1
+        # Only the first few, so a garbled stream cannot flood the log
+        if self.malformed <= 10 or self.malformed % 1000 == 0:
+            log.warning(
+                f"Malformed data line #{self.malformed} ({reason}): "
+                f"{line.decode('utf-8', errors='replace').strip()}"
+            )
+
+
+class BinaryPacketParser:
+    """Resynchronises on SYNC and drops packets whose checksum does not match."""
+
+    def __init__(self):
+        self._pending = bytearray()
+        self.malformed = 0  # checksum failures
+        self.skipped_bytes = 0  # bytes discarded while hunting for SYNC
+
+    def reset(self):
+        self._pending.clear()
+
+    def feed(self, data):
+        self._pending += data
+        buf = self._pending
+        samples = []
+        pos = 0
+        n = len(buf)
+        while True:
+            start = buf.find(SYNC, pos)
+            if start < 0:
+                # Keep a possible partial sync byte at the very end
+                keep = 1 if n and buf[-1] == SYNC[0] else 0
+                self.skipped_bytes += n - pos - keep
+                pos = n - keep
+                break
+            self.skipped_bytes += start - pos
+            if start + PACKET_SIZE > n:
+                pos = start
+                break
+
+            body = start + len(SYNC)
+            payload = buf[body : body + PAYLOAD.size]
+            checksum = buf[body + PAYLOAD.size]
+            if sum(payload) & 0xFF != checksum:
+                # Could be a false sync inside another packet: slide by one
+                self.malformed += 1
+                pos = start + 1
+                continue
+
+            idx, t_ms, p = PAYLOAD.unpack_from(buf, body)
+            samples.append((idx, t_ms * DEVICE_TIME_SCALE, p))
+            pos = start + PACKET_SIZE
+
+        del buf[:pos]
+        if len(buf) > MAX_PENDING_BYTES:
+            self.skipped_bytes += len(buf)
+            buf.clear()
+        return samples
+
+
+PROTOCOL_PARSERS = {
+    "ascii": AsciiLineParser,
+    "binary": BinaryPacketParser,
+}
+
+
+def create_parser(protocol):
+    cls = PROTOCOL_PARSERS.get(protocol)
+    if cls is None:
+        log.warning(f"Unknown serial protocol {protocol!r}; using 'ascii'.")
+        cls = AsciiLineParser
+    return cls()
+
+
+def rate_command(rate_hz):
+    """
+    ``(command, actual_hz)`` setting the device's sample interval to the
+    whole millisecond nearest to ``rate_hz``.
+    """
+    interval_ms = max(1, int(round(1000.0 / max(float(rate_hz), 1e-3))))
+    return f"{SERIAL_RATE_COMMAND_PREFIX}{interval_ms}", 1000.0 / interval_ms
+
+
+def parse_rate_command(command):
+    """The interval in seconds of a :func:`rate_command` string, else None."""
+    prefix = SERIAL_RATE_COMMAND_PREFIX
+    if command.startswith(prefix) and command[len(prefix) :].isdigit():
+        return max(1, int(command[len(prefix) :])) / 1000.0
+    return None
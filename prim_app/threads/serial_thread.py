@@ -9,6 +9,21 @@ import logging
 from PyQt5.QtCore import QThread, pyqtSignal, QMutex, QWaitCondition
 import queue
 
+import numpy as np
+
+from utils.config import (
+    DSP_ENABLED,
+    SERIAL_PROTOCOL,
+    SERIAL_READ_TIMEOUT_S,
+    SERIAL_READ_CHUNK,
+    SERIAL_BLOCK_INTERVAL_MS,
+    SERIAL_BLOCK_MAX_SAMPLES,
+)
+from utils.telemetry import telemetry
+from writers.columnar_log import PRESSURE_RECORD_DTYPE
+from .pressure_dsp import PressureDSP
+from .serial_protocol import create_parser, rate_command
+
 log = logging.getLogger(__name__)
 
 # How many seconds of silence on the serial port we interpret
@@ -18,15 +33,41 @@ IDLE_TIMEOUT_S = 2.0
 
 class SerialThread(QThread):
     data_ready = pyqtSignal(int, float, float)  # (frameIndex, timestamp_s, pressure)
+    # Block of samples as a PRESSURE_RECORD_DTYPE structured array (frameIdx,
+    # deviceTime, pressure, hostTime), emitted every SERIAL_BLOCK_INTERVAL_MS
+    # or SERIAL_BLOCK_MAX_SAMPLES samples.  Preferred over data_ready, which is
+    # kept for backward compatibility and only emitted while connected.
+    # The block is shared by all receivers and must be treated as read-only.
+    samples_ready = pyqtSignal(object)
+    # With DSP_ENABLED, the same samples after PressureDSP (DSP_RECORD_DTYPE),
+    # emitted right after each samples_ready block; read-only as well.
+    processed_ready = pyqtSignal(object)
+    # (deviceTime, +1 / -1) of every pressure step PressureDSP detects
+    step_detected = pyqtSignal(float, int)
     error_occurred = pyqtSignal(str)  # For reporting errors back to the GUI
     status_changed = pyqtSignal(str)  # For general status updates
 
-    def __init__(self, port=None, baud=115200, test_csv=None, parent=None):
+    def __init__(
+        self, port=None, baud=115200, test_csv=None, protocol=SERIAL_PROTOCOL, parent=None
+    ):
         super().__init__(parent)
         self.port = port
         self.baud = baud
         self.ser = None
 
+        # Bulk reads land in one reusable buffer and are framed by the parser
+        self.protocol = protocol
+        self._parser = create_parser(protocol)
+        self._read_buf = bytearray(SERIAL_READ_CHUNK)
+        self._read_view = memoryview(self._read_buf)
+
+        # Samples waiting for the next samples_ready block
+        self._block = []
+        self._block_started = None
+
+        # Filters / derived channels, run on this thread for every block
+        self.dsp = PressureDSP() if DSP_ENABLED else None
+
         # Control flags
         self.running = False
         self._got_first_packet = False  # Have we seen at least one valid line?
@@ -43,7 +84,9 @@ class SerialThread(QThread):
         """Main loop for reading from the PRIM device.
 
         If a serial ``port`` is provided, the thread opens it and emits
-        ``data_ready`` for each valid packet. Lack of new data for
+        ``data_ready`` for each valid packet.  Reads block in the driver for
+        at most SERIAL_READ_TIMEOUT_S and take everything that has arrived,
+        so one wakeup frames many packets. Lack of new data for
         ``IDLE_TIMEOUT_S`` seconds after the first packet triggers
         shutdown.  When no ``port`` is given the thread immediately
         reports an error and exits.
@@ -59,7 +102,7 @@ class SerialThread(QThread):
 
         # 1) Attempt to open the real serial port
         try:
-            self.ser = serial.Serial(self.port, self.baud, timeout=1)
+            self.ser = self._open_port()
             log.info(f"Opened serial port {self.port} @ {self.baud} baud")
             self.status_changed.emit(f"Connected to {self.port}")
         except Exception as e:
@@ -86,7 +129,7 @@ class SerialThread(QThread):
                 # 2b-i) If `ser` is None, attempt to reopen once per loop iteration
                 if self.ser is None:
                     try:
-                        self.ser = serial.Serial(self.port, self.baud, timeout=1)
+                        self.ser = self._open_port()
                         log.info(f"[SerialThread] Reconnected to {self.port}")
                         self.status_changed.emit(f"Reconnected to {self.port}")
                     except Exception as e_op:
@@ -97,41 +140,22 @@ class SerialThread(QThread):
                         self.msleep(100)
                     continue
 
-                # 2b-ii) Now `self.ser` is not None → attempt to read lines
+                # 2b-ii) Now `self.ser` is not None → bulk read + frame packets
                 try:
-                    if self.ser.in_waiting > 0:
-                        raw = self.ser.readline()
-                        if raw:
-                            line = raw.decode("utf-8", errors="replace").strip()
-                            log.debug(f"Raw serial data: {line}")
-
-                            parts = [fld.strip() for fld in line.split(",")]
-                            if len(parts) < 3:
-                                log.warning(
-                                    f"Malformed data line (expected 3 fields): {line}"
-                                )
-                            else:
-                                try:
-                                    frame_idx_device = int(parts[0])
-                                    t_device = float(parts[1])
-                                    p = float(parts[2])
-                                except ValueError as ve:
-                                    log.error(f"Parse error for line '{line}': {ve}")
-                                else:
-                                    # Valid packet → emit signal
-                                    self.data_ready.emit(frame_idx_device, t_device, p)
-
-                                    # Mark that we've seen at least one packet
-                                    if not self._got_first_packet:
-                                        self._got_first_packet = True
-                                    # Update last-data timestamp
-                                    self._last_data_time = time.time()
-                        else:
-                            # readline timed out without data; will check idle below
-                            pass
-                    else:
-                        # No bytes waiting; sleep briefly
-                        self.msleep(10)
+                    # Ask for everything already buffered (at least one byte, so
+                    # the driver blocks until data arrives or the timeout hits)
+                    want = min(max(self.ser.in_waiting, 1), len(self._read_buf))
+                    n = self.ser.readinto(self._read_view[:want])
+                    if n:
+                        samples = self._parser.feed(self._read_view[:n])
+                        if samples:
+                            host_ts = time.time()
+                            self._queue_samples(samples, host_ts)
+                            # Mark that we've seen at least one packet
+                            self._got_first_packet = True
+                            # Update last-data timestamp
+                            self._last_data_time = host_ts
+                    self._flush_block()
 
                 except serial.SerialException as se:
                     # Port dropped unexpectedly → attempt to reconnect
@@ -144,6 +168,8 @@ class SerialThread(QThread):
                     except Exception:
                         pass
                     self.ser = None
+                    # A partial packet from before the drop is meaningless now
+                    self._parser.reset()
                     # Wait a short moment before retrying
                     t0 = time.time()
                     while (
@@ -161,6 +187,7 @@ class SerialThread(QThread):
 
 
         # 3) Clean up on exit
+        self._flush_block(force=True)
         if self.ser:
             try:
                 self.ser.close()
@@ -172,6 +199,51 @@ class SerialThread(QThread):
         self.running = False
         log.info("SerialThread finished.")
 
+    def _queue_samples(self, samples, host_ts):
+        # Legacy per-sample signal, only if anyone still listens to it
+        if self.receivers(self.data_ready) > 0:
+            for frame_idx_device, t_device, p in samples:
+                self.data_ready.emit(frame_idx_device, t_device, p)
+
+        if not self._block:
+            self._block_started = time.monotonic()
+        self._block.extend((idx, t, p, host_ts) for idx, t, p in samples)
+
+    def _flush_block(self, force=False):
+        """Emit the pending samples as one block once the cadence is reached."""
+        if not self._block:
+            return
+        age_ms = (time.monotonic() - self._block_started) * 1000.0
+        if (
+            force
+            or age_ms >= SERIAL_BLOCK_INTERVAL_MS
+            or len(self._block) >= SERIAL_BLOCK_MAX_SAMPLES
+        ):
+            block = np.array(self._block, dtype=PRESSURE_RECORD_DTYPE)
+            self._block = []
+            self.samples_ready.emit(block)
+            self._process_block(block)
+
+    def _process_block(self, block):
+        """Run PressureDSP over the block and emit processed_ready / step_detected."""
+        if self.dsp is None:
+            return
+        try:
+            t0 = time.perf_counter()
+            processed = self.dsp.process(block)
+            telemetry.record("serial.dsp", time.perf_counter() - t0)
+        except Exception as e:
+            log.exception(f"[SerialThread] Pressure DSP failed: {e}")
+            return
+        self.processed_ready.emit(processed)
+        for row in processed[processed["step"] != 0]:
+            self.step_detected.emit(float(row["deviceTime"]), int(row["step"]))
+
+    def _open_port(self):
+        ser = serial.Serial(self.port, self.baud, timeout=SERIAL_READ_TIMEOUT_S)
+        self._parser.reset()
+        return ser
+
     def send_command(self, command_str):
         """
         Queue a command (ASCII + newline) for the Arduino. GUI can call this safely.
@@ -184,6 +256,15 @@ class SerialThread(QThread):
             log.warning("Serial thread not running → cannot send command.")
             self.error_occurred.emit("Cannot send: Serial disconnected.")
 
+    def set_sample_rate(self, rate_hz):
+        """
+        Ask the firmware to sample (and pulse CamTrig) at ``rate_hz``; returns
+        the rate it will actually run at (whole-millisecond interval).
+        """
+        command, actual_hz = rate_command(rate_hz)
+        self.send_command(command)
+        return actual_hz
+
     def stop(self):
         """
         Ask the thread to exit cleanly. If it doesn't within 2 seconds, force‐terminate.
@@ -0,0 +1,447 @@
+# prim_app/threads/simulated_sources.py
+
+import logging
+import math
+import queue
+import threading
+import time
+
+import numpy as np
+from PyQt5.QtCore import QThread, pyqtSignal
+from PyQt5.QtGui import QImage
+
+from utils.config import (
+    CAMERA_BUFFER_COUNT,
+    CAMERA_STATS_INTERVAL_MS,
+    DSP_ENABLED,
+    SERIAL_BLOCK_INTERVAL_MS,
+    SERIAL_BLOCK_MAX_SAMPLES,
+    SIM_CAMERA_RESOLUTION,
+    SIM_CAMERA_BIT_DEPTH,
+    SIM_CAMERA_PATTERN_FRAMES,
+    SIM_SAMPLE_RATE_HZ,
+)
+from utils.telemetry import telemetry
+from writers.columnar_log import PRESSURE_RECORD_DTYPE
+
+from .camera_frame import CameraFrame
+from .preview_converter import PreviewConverter
+from .pressure_dsp import PressureDSP
+from .serial_protocol import parse_rate_command, rate_command
+
+log = logging.getLogger(__name__)
+
+
+def render_vessel_frames(width, height, bit_depth, count, seed=0):
+    """
+    ``count`` frames of a dark vertical vessel on a bright background whose
+    diameter swings through one period over the sequence, plus sensor noise.
+    Returned arrays are read-only; uint8 for 8 bits, uint16 otherwise.
+    """
+    rng = np.random.default_rng(seed)
+    full = (1 << bit_depth) - 1
+    dtype = np.uint8 if bit_depth <= 8 else np.uint16
+    x = np.arange(width, dtype=np.float32) - width / 2.0
+    frames = []
+    for k in range(count):
+        half = width * (0.15 + 0.05 * math.sin(2.0 * math.pi * k / max(count, 1)))
+        # Soft edges (a few px wide) so sub-pixel edge finding has work to do
+        wall = 1.0 / (1.0 + np.exp((np.abs(x) - half) / 2.0))
+        row = full * (0.75 - 0.45 * wall)
+        img = np.broadcast_to(row, (height, width)).astype(np.float32)
+        img += rng.normal(0.0, full * 0.02, size=(height, width)).astype(np.float32)
+        frame = np.clip(img, 0, full).astype(dtype)
+        frame.setflags(write=False)
+        frames.append(frame)
+    return frames
+
+
+class _BufferSlots:
+    """Counts the simulated sink buffers that are still held downstream."""
+
+    def __init__(self, count):
+        self.count = count
+        self.in_use = 0
+        self._lock = threading.Lock()
+
+    def acquire(self):
+        with self._lock:
+            if self.in_use >= self.count:
+                return False
+            self.in_use += 1
+            return True
+
+    def release(self):
+        with self._lock:
+            self.in_use = max(0, self.in_use - 1)
+
+
+class _SimulatedBuffer:
+    """Stand-in for an ``ic4.ImageBuffer``: release() frees its ring slot."""
+
+    __slots__ = ("_slots",)
+
+    def __init__(self, slots):
+        self._slots = slots
+
+    def release(self):
+        slots, self._slots = self._slots, None
+        if slots is not None:
+            slots.release()
+
+
+class SimulatedCameraThread(QThread):
+    """
+    Drop-in replacement for :class:`SDKCameraThread` that needs no IC4
+    device.  Frames come from a small set of pre-rendered images
+    (:func:`render_vessel_frames`) so the generator itself costs next to
+    nothing, and go out through the same preview conversion and
+    ``frame_ready(QImage, CameraFrame)`` contract as the real camera.
+
+    Like a QueueSink, only ``buffer_count`` frames can be in flight; a frame
+    that finds no free slot (consumers still holding every buffer) is
+    counted as dropped.  Frames are produced free-running at the set frame
+    rate, or once per :meth:`trigger` call in ``triggered`` mode (the
+    simulated PRIM device calls it for each sample, like CamTrig).
+    """
+
+    grabber_ready = pyqtSignal()
+    frame_ready = pyqtSignal(QImage, object)
+    error = pyqtSignal(str, str)
+    stats_updated = pyqtSignal(dict)
+
+    def __init__(
+        self,
+        resolution=SIM_CAMERA_RESOLUTION,
+        bit_depth=SIM_CAMERA_BIT_DEPTH,
+        fps=SIM_SAMPLE_RATE_HZ,
+        triggered=False,
+        camera_id=0,
+        parent=None,
+    ):
+        super().__init__(parent)
+        self.grabber = None  # No IC4 grabber; property panels stay disabled
+        self._stop_requested = False
+        self._width, self._height = (int(v) for v in resolution)
+        self._bit_depth = int(bit_depth)
+        self._frame_rate = float(fps)
+        self._triggered = bool(triggered)
+        self.camera_id = int(camera_id)
+        self._capture_roi = None
+        self.capture_geometry = None
+        self._preview_enabled = True
+
+        self._triggers = queue.Queue()
+        self._buffer_count = CAMERA_BUFFER_COUNT
+        self._slots = _BufferSlots(self._buffer_count)
+        self._stats_lock = threading.Lock()
+        self._frames_queued = 0
+        self._frames_processed = 0
+        self._frames_dropped = 0
+        self._preview = PreviewConverter(self._buffer_count + 2, bit_depth=self._bit_depth)
+
+    # ─── SDKCameraThread-compatible setup (call before start()) ────────
+    def set_device_info(self, dev_info):
+        pass
+
+    def set_resolution(self, resolution_tuple):
+        w, h, pf_name = resolution_tuple
+        self._width, self._height = int(w), int(h)
+        digits = "".join(c for c in pf_name or "" if c.isdigit())
+        if digits:
+            self._bit_depth = int(digits)
+        self._preview.configure(bit_depth=self._bit_depth)
+
+    def set_frame_rate(self, fps):
+        self._frame_rate = float(fps)
+
+    def set_trigger_mode(self, enabled):
+        """Switch between firing on :meth:`trigger` and free-running (also live)."""
+        self._triggered = bool(enabled)
+        return True
+
+    @property
+    def trigger_mode(self):
+        return self._triggered
+
+    def set_capture_roi(self, roi):
+        self._capture_roi = dict(roi) if roi else None
+
+    def set_preview_enabled(self, enabled):
+        self._preview_enabled = bool(enabled)
+
+    def set_buffer_count(self, count):
+        self._buffer_count = max(2, int(count))
+        self._slots = _BufferSlots(self._buffer_count)
+        settings = self._preview.settings()
+        self._preview = PreviewConverter(
+            self._buffer_count + 2,
+            bit_depth=settings["bit_depth"],
+            mode=settings["mode"],
+        )
+
+    def set_preview_settings(self, settings):
+        self._preview.configure(**settings)
+
+    def preview_settings(self):
+        return self._preview.settings()
+
+    def trigger(self, host_ts=None):
+        """One CamTrig pulse (thread-safe); only used in ``triggered`` mode."""
+        self._triggers.put(host_ts)
+
+    def get_stats(self):
+        with self._stats_lock:
+            return {
+                "camera_id": self.camera_id,
+                "queued": self._frames_queued,
+                "processed": self._frames_processed,
+                "dropped": self._frames_dropped,
+                "queue_depth": self._slots.in_use,
+                "buffer_count": self._buffer_count,
+            }
+
+    # ─── Frame generation ──────────────────────────────────────────────
+    def _geometry(self):
+        """Apply the capture ROI the way the camera would (binning, then crop)."""
+        width, height = self._width, self._height
+        roi = self._capture_roi or {}
+        binning = max(1, int(roi.get("binning") or 1))
+        x = int(roi.get("x") or 0) // binning
+        y = int(roi.get("y") or 0) // binning
+        out_w = width // binning
+        out_h = height // binning
+        if roi.get("width"):
+            out_w = min(out_w, int(roi["width"]) // binning)
+        if roi.get("height"):
+            out_h = min(out_h, int(roi["height"]) // binning)
+        x = min(x, width // binning - out_w)
+        y = min(y, height // binning - out_h)
+        return {
+            "x": x * binning,
+            "y": y * binning,
+            "width": out_w * binning,
+            "height": out_h * binning,
+            "binning": binning,
+            "sensor_width": width,
+            "sensor_height": height,
+            "frame_rate": self._frame_rate,
+            "max_frame_rate": self._frame_rate,
+        }
+
+    def run(self):
+        try:
+            self.capture_geometry = self._geometry()
+            g = self.capture_geometry
+            b = g["binning"]
+            frames = render_vessel_frames(
+                g["width"] // b, g["height"] // b, self._bit_depth, SIM_CAMERA_PATTERN_FRAMES
+            )
+            pixel_format = "Mono8" if self._bit_depth <= 8 else "Mono16"
+            log.info(
+                f"SimulatedCameraThread: {g['width'] // b}×{g['height'] // b} "
+                f"{pixel_format} ({self._bit_depth} bit), "
+                + ("triggered" if self._triggered else f"{self._frame_rate:.1f} fps")
+            )
+            self.grabber_ready.emit()
+
+            period = 1.0 / max(self._frame_rate, 1e-3)
+            next_due = time.perf_counter()
+            last_stats = time.monotonic()
+            stats_interval = CAMERA_STATS_INTERVAL_MS / 1000.0
+            frame_number = 0
+            while not self._stop_requested:
+                if self._triggered:
+                    try:
+                        self._triggers.get(timeout=0.05)
+                        fire = True
+                    except queue.Empty:
+                        fire = False
+                else:
+                    wait = next_due - time.perf_counter()
+                    if wait > 0:
+                        time.sleep(min(wait, 0.05))
+                    fire = time.perf_counter() >= next_due
+                    if fire:
+                        next_due += period
+
+                if fire:
+                    self._produce(frames[frame_number % len(frames)], frame_number, pixel_format)
+                    frame_number += 1
+
+                now = time.monotonic()
+                if now - last_stats >= stats_interval:
+                    last_stats = now
+                    self.stats_updated.emit(self.get_stats())
+
+            log.info("SimulatedCameraThread: stopped.")
+        except Exception as e:
+            log.exception("SimulatedCameraThread: encountered an error.")
+            self.error.emit(str(e), "")
+
+    def _produce(self, array, frame_number, pixel_format):
+        with self._stats_lock:
+            self._frames_queued += 1
+        if not self._slots.acquire():
+            # Every buffer is still held downstream: a sink underrun
+            with self._stats_lock:
+                self._frames_dropped += 1
+            telemetry.count("camera.dropped")
+            return
+
+        frame = CameraFrame(
+            array,
+            buffer=_SimulatedBuffer(self._slots),
+            frame_number=frame_number,
+            device_timestamp_ns=time.perf_counter_ns(),
+            pixel_format=pixel_format,
+            camera_id=self.camera_id,
+        )
+        try:
+            qimg = QImage()
+            if self._preview_enabled:
+                t0 = time.perf_counter()
+                gray8 = self._preview.convert(array)
+                telemetry.record("camera.convert", time.perf_counter() - t0)
+                if gray8 is not array:
+                    frame.preview = gray8
+                h, w = gray8.shape[:2]
+                qimg = QImage(gray8.data, w, h, gray8.strides[0], QImage.Format_Grayscale8)
+
+            frame.retain(self.receivers(self.frame_ready))
+            t0 = time.perf_counter()
+            self.frame_ready.emit(qimg, frame)
+            telemetry.record("camera.emit", time.perf_counter() - t0)
+            with self._stats_lock:
+                self._frames_processed += 1
+        finally:
+            frame.release()
+
+    def stop(self):
+        self._stop_requested = True
+
+
+class SimulatedSerialThread(QThread):
+    """
+    Drop-in replacement for :class:`SerialThread` that plays the PRIM
+    firmware: samples ``(frameIdx, deviceTime, pressure)`` at ``rate_hz``
+    with a slow pressure wave plus noise, emitted as PRESSURE_RECORD_DTYPE
+    blocks on the same cadence as the real thread.  ``G`` restarts the
+    frame index and device clock, ``S`` pauses streaming and the rate
+    command (``T<interval_ms>``) changes the sample rate.  With a
+    ``camera`` in triggered mode each sample also fires one frame, so
+    frameIdx and camera frame numbers stay locked like on the rig.
+    ``camera`` may be a list: every camera on the CamTrig line is fired.
+    """
+
+    data_ready = pyqtSignal(int, float, float)
+    samples_ready = pyqtSignal(object)
+    processed_ready = pyqtSignal(object)
+    step_detected = pyqtSignal(float, int)
+    error_occurred = pyqtSignal(str)
+    status_changed = pyqtSignal(str)
+
+    def __init__(self, rate_hz=SIM_SAMPLE_RATE_HZ, camera=None, seed=0, parent=None):
+        super().__init__(parent)
+        self.port = "SIM"
+        self.rate_hz = float(rate_hz)
+        if camera is None:
+            self.cameras = []
+        elif isinstance(camera, (list, tuple)):
+            self.cameras = list(camera)
+        else:
+            self.cameras = [camera]
+        self.running = False
+        self._stop_requested = False
+        self._commands = queue.Queue()
+        self._rng = np.random.default_rng(seed)
+        self._block = []
+        self._block_started = None
+        self.dsp = PressureDSP() if DSP_ENABLED else None
+
+    def run(self):
+        self.running = True
+        self.status_changed.emit("Connected to simulated PRIM device")
+        period = 1.0 / max(self.rate_hz, 1e-3)
+        streaming = True
+        frame_idx = 0
+        t_start = time.perf_counter()
+        next_due = t_start
+
+        while self.running and not self._stop_requested:
+            try:
+                cmd = self._commands.get_nowait()
+            except queue.Empty:
+                cmd = None
+            if cmd == "G":
+                streaming, frame_idx = True, 0
+                t_start = next_due = time.perf_counter()
+            elif cmd == "S":
+                streaming = False
+            elif cmd and parse_rate_command(cmd) is not None:
+                period = parse_rate_command(cmd)
+                self.rate_hz = 1.0 / period
+                next_due = time.perf_counter()
+            elif cmd:
+                log.debug(f"SimulatedSerialThread: ignoring command {cmd!r}")
+
+            now = time.perf_counter()
+            while streaming and next_due <= now:
+                t_dev = next_due - t_start
+                pressure = 15.0 + 5.0 * math.sin(2.0 * math.pi * 0.1 * t_dev)
+                pressure += float(self._rng.normal(0.0, 0.05))
+                for camera in self.cameras:
+                    camera.trigger()
+                if self.receivers(self.data_ready) > 0:
+                    self.data_ready.emit(frame_idx, t_dev, pressure)
+                if not self._block:
+                    self._block_started = time.monotonic()
+                self._block.append((frame_idx, t_dev, pressure, time.time()))
+                frame_idx += 1
+                next_due += period
+            self._flush_block()
+
+            wait = next_due - time.perf_counter() if streaming else 0.01
+            time.sleep(min(max(wait, 0.0), SERIAL_BLOCK_INTERVAL_MS / 1000.0))
+
+        self._flush_block(force=True)
+        self.status_changed.emit("Disconnected")
+        self.running = False
+        log.info("SimulatedSerialThread finished.")
+
+    def _flush_block(self, force=False):
+        if not self._block:
+            return
+        age_ms = (time.monotonic() - self._block_started) * 1000.0
+        if (
+            force
+            or age_ms >= SERIAL_BLOCK_INTERVAL_MS
+            or len(self._block) >= SERIAL_BLOCK_MAX_SAMPLES
+        ):
+            block = np.array(self._block, dtype=PRESSURE_RECORD_DTYPE)
+            self._block = []
+            self.samples_ready.emit(block)
+            if self.dsp is not None:
+                processed = self.dsp.process(block)
+                self.processed_ready.emit(processed)
+                for row in processed[processed["step"] != 0]:
+                    self.step_detected.emit(float(row["deviceTime"]), int(row["step"]))
+
+    def set_sample_rate(self, rate_hz):
+        command, actual_hz = rate_command(rate_hz)
+        self.send_command(command)
+        return actual_hz
+
+    def send_command(self, command_str):
+        if self.running:
+            self._commands.put(command_str.strip())
+            log.info(f"Queued command: {command_str}")
+        else:
+            log.warning("Serial thread not running → cannot send command.")
+            self.error_occurred.emit("Cannot send: Serial disconnected.")
+
+    def stop(self):
+        log.info("Stopping SimulatedSerialThread…")
+        self._stop_requested = True
+        self.running = False
+        self.wait(2000)
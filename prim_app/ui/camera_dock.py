@@ -0,0 +1,159 @@
+# prim_app/ui/camera_dock.py
+
+import logging
+import time
+
+from PyQt5.QtCore import Qt, pyqtSignal, pyqtSlot
+from PyQt5.QtWidgets import QDockWidget, QLabel, QVBoxLayout, QWidget
+
+from ui.canvas.qtcamera_widget import QtCameraWidget
+from ui.refresh_scheduler import UiRefreshScheduler
+
+log = logging.getLogger(__name__)
+
+
+class CameraDock(QDockWidget):
+    """
+    Live view of an additional camera (``camera_id`` >= 1), recorded next to
+    the main one from the same CamTrig line.  Owns the camera's
+    SDKCameraThread and a UiRefreshScheduler of its own; MainWindow connects
+    :attr:`camera_thread` to the recorder while recording.
+
+    The stats line under the view shows where this camera loses frames: the
+    camera side (fps and drops in the buffer ring / link) always, and while
+    recording the writer side (queue, MB/s, drops) and sync of its stream.
+    """
+
+    # camera_id, after the dock was closed and the camera stopped
+    closed = pyqtSignal(int)
+
+    def __init__(self, camera_id, dev_info, resolution, profile=None, parent=None):
+        super().__init__(f"Camera {camera_id}: {dev_info.model_name}", parent)
+        self.setObjectName(f"CameraDock{camera_id}")
+        self.setAttribute(Qt.WA_DeleteOnClose)
+        self.camera_id = camera_id
+        self.dev_info = dev_info
+        self._resolution = resolution
+        self._profile = profile
+        self.camera_thread = None
+
+        self._camera_text = "Connecting…"
+        self._writer_text = ""
+        self._sync_text = ""
+        self._last_processed = None  # (processed, monotonic time)
+
+        body = QWidget()
+        lay = QVBoxLayout(body)
+        lay.setContentsMargins(2, 2, 2, 2)
+        lay.setSpacing(2)
+        self.camera_widget = QtCameraWidget(body)
+        lay.addWidget(self.camera_widget, stretch=1)
+        self.stats_label = QLabel(self._camera_text)
+        self.stats_label.setToolTip(
+            "Camera: fps, frames dropped / queued in the buffer ring | "
+            "Writer: queued frames, write bandwidth, dropped | Sync: paired frames"
+        )
+        self.stats_label.setWordWrap(True)
+        lay.addWidget(self.stats_label)
+        self.setWidget(body)
+
+        self.ui_refresh = UiRefreshScheduler(parent=self)
+        self.ui_refresh.frame_ready.connect(self.camera_widget._on_frame_ready)
+
+    @property
+    def capture_geometry(self):
+        return self.camera_thread.capture_geometry if self.camera_thread else None
+
+    def is_running(self):
+        return self.camera_thread is not None and self.camera_thread.isRunning()
+
+    def start(self):
+        from threads.sdk_camera_thread import SDKCameraThread
+
+        self.camera_thread = SDKCameraThread(camera_id=self.camera_id, parent=self)
+        self.camera_thread.set_device_info(self.dev_info)
+        self.camera_thread.set_resolution(self._resolution)
+        if self._profile:
+            self.camera_thread.set_profile(self._profile)
+        self.camera_thread.grabber_ready.connect(self._on_grabber_ready)
+        self.camera_thread.frame_ready.connect(self.ui_refresh.push_frame)
+        self.camera_thread.error.connect(self._on_camera_error)
+        self.camera_thread.stats_updated.connect(self._on_camera_stats)
+        self.ui_refresh.start()
+        self.camera_thread.start()
+
+    def stop(self, wait_ms=1500):
+        thread, self.camera_thread = self.camera_thread, None
+        if thread is not None and thread.isRunning():
+            thread.stop()
+            if not thread.wait(wait_ms):
+                log.warning(f"Camera {self.camera_id} did not stop gracefully.")
+        self.ui_refresh.stop()
+        self.camera_widget.clear_image()
+
+    # ─── Stats ──────────────────────────────────────────────────────────
+    @pyqtSlot()
+    def _on_grabber_ready(self):
+        geom = self.capture_geometry
+        if geom:
+            b = max(1, geom.get("binning", 1))
+            self.setWindowTitle(
+                f"Camera {self.camera_id}: {self.dev_info.model_name} "
+                f"({geom['width'] // b}×{geom['height'] // b})"
+            )
+        self._camera_text = "Connected"
+        self._refresh_label()
+
+    @pyqtSlot(dict)
+    def _on_camera_stats(self, stats):
+        now = time.monotonic()
+        processed = stats.get("processed", 0)
+        fps = 0.0
+        if self._last_processed is not None:
+            count, t = self._last_processed
+            fps = (processed - count) / max(now - t, 1e-6)
+        self._last_processed = (processed, now)
+        self._camera_text = (
+            f"Camera: {fps:.1f} fps, {stats.get('dropped', 0)} dropped / "
+            f"{stats.get('queue_depth', 0)} of {stats.get('buffer_count', 0)}"
+        )
+        self._refresh_label()
+
+    def set_writer_stats(self, stats):
+        text = (
+            f"Writer: {stats.get('queue_depth', 0)}/{stats.get('queue_size', 0)} queued, "
+            f"{stats.get('mb_per_s', 0.0):.1f} MB/s"
+        )
+        if stats.get("dropped"):
+            text += f", {stats['dropped']} dropped"
+        self._writer_text = text
+        self._refresh_label()
+
+    def set_sync_stats(self, stats):
+        if stats.get("offset") is None:
+            self._sync_text = "Sync: waiting for lock"
+        else:
+            self._sync_text = f"Sync: {stats.get('matched', 0)} paired"
+            if stats.get("unmatched_frames"):
+                self._sync_text += f", {stats['unmatched_frames']} unmatched"
+        self._refresh_label()
+
+    def clear_recording_stats(self):
+        self._writer_text = self._sync_text = ""
+        self._refresh_label()
+
+    def _refresh_label(self):
+        parts = [self._camera_text, self._writer_text, self._sync_text]
+        self.stats_label.setText(" | ".join(p for p in parts if p))
+
+    @pyqtSlot(str, str)
+    def _on_camera_error(self, msg, code):
+        log.error(f"Camera {self.camera_id} error ({code}): {msg}")
+        self.stop(wait_ms=0)
+        self._camera_text = f"Error: {msg}"
+        self._refresh_label()
+
+    def closeEvent(self, event):
+        self.stop()
+        self.closed.emit(self.camera_id)
+        super().closeEvent(event)
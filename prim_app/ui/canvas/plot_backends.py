@@ -0,0 +1,31 @@
+# prim_app/ui/canvas/plot_backends.py
+
+import logging
+
+from utils.config import PLOT_BACKEND, PLOT_BACKENDS
+
+log = logging.getLogger(__name__)
+
+
+def create_pressure_plot_widget(backend=PLOT_BACKEND, parent=None):
+    """
+    Build the live pressure plot for ``backend`` (one of PLOT_BACKENDS).
+    Backend modules are imported lazily; if pyqtgraph cannot be imported (or
+    fails to set up its OpenGL viewport) the matplotlib widget is used.
+    Returns ``(widget, backend_actually_used)``.
+    """
+    if backend not in PLOT_BACKENDS:
+        log.warning(f"Unknown plot backend {backend!r}; using matplotlib.")
+        backend = "matplotlib"
+
+    if backend == "pyqtgraph":
+        try:
+            from .pressure_plot_gl_widget import PyqtgraphPressurePlotWidget
+
+            return PyqtgraphPressurePlotWidget(parent), "pyqtgraph"
+        except Exception as e:
+            log.warning(f"pyqtgraph plot backend unavailable ({e}); using matplotlib.")
+
+    from .pressure_plot_widget import PressurePlotWidget
+
+    return PressurePlotWidget(parent), "matplotlib"
@@ -0,0 +1,268 @@
+# prim_app/ui/canvas/plot_data_buffer.py
+
+import math
+
+import numpy as np
+
+from utils.config import PLOT_RING_CAPACITY
+
+# Samples per bucket at the finest pyramid level, and how many buckets of one
+# level make a bucket of the next.  10 levels cover buckets of up to
+# 16 * 4**9 ≈ 4 M samples, i.e. more than 10 h at 100 Hz in a few hundred points.
+_BASE_BLOCK = 16
+_LEVEL_FACTOR = 4
+_NUM_LEVELS = 10
+
+
+class _MinMaxLevel:
+    """
+    One level of the decimation pyramid: complete buckets ``(t0, min, max)``
+    in growable arrays plus up to ``factor - 1`` pending inputs that do not
+    yet make a full bucket.
+    """
+
+    def __init__(self, factor):
+        self.factor = factor
+        self.n = 0
+        self.t = np.empty(256)
+        self.mn = np.empty(256)
+        self.mx = np.empty(256)
+        self.pend_t = np.empty(0)
+        self.pend_mn = np.empty(0)
+        self.pend_mx = np.empty(0)
+
+    def extend(self, t, mn, mx):
+        """Add inputs; return the newly completed ``(t, mn, mx)`` buckets."""
+        if len(self.pend_t):
+            t = np.concatenate((self.pend_t, t))
+            mn = np.concatenate((self.pend_mn, mn))
+            mx = np.concatenate((self.pend_mx, mx))
+
+        full = (len(t) // self.factor) * self.factor
+        self.pend_t, self.pend_mn, self.pend_mx = t[full:], mn[full:], mx[full:]
+        if full == 0:
+            return None
+
+        bt = t[:full:self.factor]
+        bmn = mn[:full].reshape(-1, self.factor).min(axis=1)
+        bmx = mx[:full].reshape(-1, self.factor).max(axis=1)
+        self._store(bt, bmn, bmx)
+        return bt, bmn, bmx
+
+    def _store(self, bt, bmn, bmx):
+        need = self.n + len(bt)
+        if need > len(self.t):
+            cap = max(need, 2 * len(self.t))
+            for name in ("t", "mn", "mx"):
+                grown = np.empty(cap)
+                grown[: self.n] = getattr(self, name)[: self.n]
+                setattr(self, name, grown)
+        self.t[self.n : need] = bt
+        self.mn[self.n : need] = bmn
+        self.mx[self.n : need] = bmx
+        self.n = need
+
+
+class PlotDataBuffer:
+    """
+    Data model behind the live pressure plot.
+
+    * The most recent ``capacity`` samples are kept at full resolution in a
+      fixed-size numpy ring buffer.
+    * All samples also feed a min/max decimation pyramid, so any time range of
+      the whole session can be drawn with a bounded number of points.
+
+    :meth:`view` returns the raw samples when they fit in ``max_points`` and the
+    finest pyramid level that does otherwise.  Times must be non-decreasing.
+    """
+
+    def __init__(self, capacity=PLOT_RING_CAPACITY):
+        self.capacity = int(capacity)
+        self._t = np.empty(self.capacity)
+        self._p = np.empty(self.capacity)
+        self.clear()
+
+    def clear(self):
+        self._head = 0  # next write position in the ring
+        self._count = 0  # samples appended since the last clear
+        self._first_t = None
+        self._pmin = math.inf
+        self._pmax = -math.inf
+        self._levels = [_MinMaxLevel(_BASE_BLOCK)] + [
+            _MinMaxLevel(_LEVEL_FACTOR) for _ in range(_NUM_LEVELS - 1)
+        ]
+
+    def __len__(self):
+        return self._count
+
+    @property
+    def evicted(self):
+        """Samples that fell out of the ring (left only in the pyramid)."""
+        return max(0, self._count - self.capacity)
+
+    @property
+    def first_time(self):
+        return self._first_t
+
+    @property
+    def last_time(self):
+        if not self._count:
+            return None
+        return self._t[(self._head - 1) % self.capacity]
+
+    @property
+    def last_value(self):
+        if not self._count:
+            return None
+        return self._p[(self._head - 1) % self.capacity]
+
+    def y_range(self):
+        """Min/max of every value appended since the last clear."""
+        if not self._count:
+            return None
+        return self._pmin, self._pmax
+
+    # ─── Appending ───────────────────────────────────────────────────────
+    def append(self, t, p):
+        self.extend(np.array((t,), dtype=float), np.array((p,), dtype=float))
+
+    def extend(self, ts, ps):
+        ts = np.asarray(ts, dtype=float)
+        ps = np.asarray(ps, dtype=float)
+        n = len(ts)
+        if n == 0:
+            return
+        if self._first_t is None:
+            self._first_t = float(ts[0])
+
+        # Ring buffer (only the last ``capacity`` values can survive)
+        rt, rp = ts[-self.capacity :], ps[-self.capacity :]
+        m = len(rt)
+        first = min(m, self.capacity - self._head)
+        self._t[self._head : self._head + first] = rt[:first]
+        self._p[self._head : self._head + first] = rp[:first]
+        if m > first:
+            self._t[: m - first] = rt[first:]
+            self._p[: m - first] = rp[first:]
+        self._head = (self._head + m) % self.capacity
+        self._count += n
+
+        self._pmin = min(self._pmin, float(ps.min()))
+        self._pmax = max(self._pmax, float(ps.max()))
+
+        # Pyramid: each level only does work when the one below completes buckets
+        buckets = (ts, ps, ps)
+        for level in self._levels:
+            buckets = level.extend(*buckets)
+            if buckets is None:
+                break
+
+    # ─── Reading ─────────────────────────────────────────────────────────
+    def _ring_segments(self):
+        """Ring contents as (up to two) time-ordered ``(t, p)`` views."""
+        if self._count < self.capacity:
+            return [(self._t[: self._head], self._p[: self._head])]
+        return [
+            (self._t[self._head :], self._p[self._head :]),
+            (self._t[: self._head], self._p[: self._head]),
+        ]
+
+    def ring_data(self):
+        """Copy of the full-resolution ring contents, oldest first."""
+        segs = self._ring_segments()
+        return (
+            np.concatenate([t for t, _ in segs]),
+            np.concatenate([p for _, p in segs]),
+        )
+
+    def _ring_range(self, xmin, xmax):
+        xs, ys = [], []
+        for t, p in self._ring_segments():
+            i0 = max(np.searchsorted(t, xmin, "left") - 1, 0)
+            i1 = np.searchsorted(t, xmax, "right") + 1
+            xs.append(t[i0:i1])
+            ys.append(p[i0:i1])
+        return np.concatenate(xs), np.concatenate(ys)
+
+    def _level_parts(self, k):
+        """
+        Level ``k`` as two time-ordered ``(t, min, max)`` parts: its completed
+        buckets (views, no copy) and the short tail of pending inputs of
+        levels ``k`` … 0 that are not folded into it yet.
+        """
+        lvl = self._levels[k]
+        pending = self._levels[k::-1]
+        tail = tuple(
+            np.concatenate([getattr(level, name) for level in pending])
+            for name in ("pend_t", "pend_mn", "pend_mx")
+        )
+        return (lvl.t[: lvl.n], lvl.mn[: lvl.n], lvl.mx[: lvl.n]), tail
+
+    @staticmethod
+    def _search(parts, x, side):
+        """``searchsorted`` of ``x`` in the times of ``parts`` as if joined."""
+        (t0, *_), (t1, *_) = parts
+        i = int(np.searchsorted(t0, x, side))
+        if i == len(t0):
+            i += int(np.searchsorted(t1, x, side))
+        return i
+
+    @staticmethod
+    def _slice(parts, i0, i1):
+        """Rows ``i0:i1`` of ``parts`` as if joined; copies only the window."""
+        head, tail = parts
+        n0 = len(head[0])
+        return tuple(
+            np.concatenate((a[i0:i1], b[max(i0 - n0, 0) : max(i1 - n0, 0)]))
+            for a, b in zip(head, tail)
+        )
+
+    def view(self, xmin, xmax, max_points):
+        """
+        Points ``(x, y)`` to draw for the time range ``[xmin, xmax]`` using at
+        most about ``max_points`` points (one neighbour beyond each edge is
+        included so the line runs to the axes border).  The cost depends on
+        the window, not on the session length: levels are sized by binary
+        search and only the chosen one is sliced.
+        """
+        if not self._count:
+            return np.empty(0), np.empty(0)
+        max_points = max(4, int(max_points))
+
+        ring_holds_all = self._count <= self.capacity
+        oldest = self._ring_segments()[0][0]
+        if ring_holds_all or (len(oldest) and oldest[0] <= xmin):
+            x, y = self._ring_range(xmin, xmax)
+            if len(x) <= max_points:
+                return x, y
+
+        # Two output points (min and max) per bucket
+        max_buckets = max_points // 2
+        for k in range(len(self._levels)):
+            parts = self._level_parts(k)
+            i0 = max(self._search(parts, xmin, "left") - 1, 0)
+            i1 = self._search(parts, xmax, "right") + 1
+            if i1 - i0 <= max_buckets or k == len(self._levels) - 1:
+                t, mn, mx = self._slice(parts, i0, i1)
+                return np.repeat(t, 2), np.column_stack((mn, mx)).ravel()
+
+    def nearest(self, x):
+        """Sample (or finest bucket) closest in time to ``x``: ``(t, p)`` or None."""
+        if not self._count:
+            return None
+
+        segs = self._ring_segments()
+        oldest = segs[0][0]
+        if self._count <= self.capacity or (len(oldest) and x >= oldest[0]):
+            segs = segs + [(np.empty(0), np.empty(0))] * (2 - len(segs))
+            parts = tuple((t, p, p) for t, p in segs)
+        else:
+            parts = self._level_parts(0)
+
+        # x lies between rows idx-1 and idx (only one of them at either end);
+        # pick the closer neighbour
+        idx = self._search(parts, x, "left")
+        n = len(parts[0][0]) + len(parts[1][0])
+        t, mn, mx = self._slice(parts, max(idx - 1, 0), min(idx + 1, n))
+        best = 0 if len(t) == 1 or abs(x - t[0]) <= abs(x - t[1]) else 1
+        return float(t[best]), float((mn[best] + mx[best]) / 2.0)
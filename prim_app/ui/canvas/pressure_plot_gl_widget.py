@@ -0,0 +1,423 @@
+# prim_app/ui/canvas/pressure_plot_gl_widget.py
+
+import os
+import time
+import logging
+import math
+
+import numpy as np
+from PyQt5.QtWidgets import (
+    QWidget,
+    QSizePolicy,
+    QVBoxLayout,
+    QMessageBox,
+    QFileDialog,
+    QScrollBar,
+    QLabel,
+)
+from PyQt5.QtCore import Qt, QTimer, pyqtSlot
+import pyqtgraph as pg
+
+from utils.config import (
+    PLOT_DEFAULT_Y_MIN,
+    PLOT_DEFAULT_Y_MAX,
+    PLOT_MAX_POINTS,
+    PLOT_REFRESH_HZ,
+)
+from utils.telemetry import telemetry
+from .plot_data_buffer import PlotDataBuffer
+
+log = logging.getLogger(__name__)
+
+# Time represented by one scrollbar step (same as PressurePlotWidget; not
+# imported from there so this backend does not pull in matplotlib)
+SCROLL_RESOLUTION_S = 0.1
+
+
+class PyqtgraphPressurePlotWidget(QWidget):
+    """
+    Drop-in alternative to :class:`PressurePlotWidget` that renders with
+    pyqtgraph (OpenGL viewport when available) instead of matplotlib/Agg.
+
+    Same public API (``update_plot``, ``set_manual_x_limits``,
+    ``set_manual_y_limits``, ``reset_zoom``, ``clear_plot``,
+    ``update_diameter_block``, ``update_filtered_block``, ``export_as_image``,
+    ``get_plot_data``).  New samples only go into the
+    :class:`PlotDataBuffer`; the curve is re-uploaded at most PLOT_REFRESH_HZ
+    times per second, with the decimated view for the visible range.
+    """
+
+    def __init__(self, parent=None):
+        super().__init__(parent)
+        self.setSizePolicy(QSizePolicy.Expanding, QSizePolicy.Expanding)
+        layout = QVBoxLayout(self)
+        layout.setContentsMargins(0, 0, 0, 0)
+
+        pg.setConfigOptions(
+            useOpenGL=True, antialias=False, background="w", foreground="k"
+        )
+        self.plot = pg.PlotWidget()
+        self.plot.setLabel("bottom", "<b>Time (s)</b>")
+        self.plot.setLabel("left", "<b>Pressure (mmHg)</b>")
+        self.plot.showGrid(x=True, y=True, alpha=0.3)
+        self.plot.setMouseEnabled(x=False, y=False)
+        self.plot.hideButtons()
+        self.plot.getPlotItem().setMenuEnabled(False)
+        self.view_box = self.plot.getViewBox()
+        self.view_box.disableAutoRange()
+
+        self.curve = self.plot.plot([], [], pen=pg.mkPen("k", width=2))
+        layout.addWidget(self.plot)
+
+        # Scrollbar for manual X panning
+        self.scrollbar = QScrollBar(Qt.Horizontal, self)
+        self.scrollbar.hide()
+        layout.addWidget(self.scrollbar)
+        self.scrollbar.valueChanged.connect(self._on_scroll)
+
+        # Data storage: full-resolution ring + min/max pyramid for the history
+        self.data = PlotDataBuffer()
+        # Live diameter trace in a second ViewBox (right axis), created with
+        # its first data
+        self.diameter_data = PlotDataBuffer()
+        self.diameter_view = None
+        self.diameter_curve = None
+        # Filtered pressure (PressureDSP channel), created with its first data
+        self.filtered_data = PlotDataBuffer()
+        self.filtered_curve = None
+        self.manual_xlim = None
+        self.manual_ylim = (PLOT_DEFAULT_Y_MIN, PLOT_DEFAULT_Y_MAX)
+        self.plot.setYRange(*self.manual_ylim, padding=0)
+        self.plot.setXRange(0, 100, padding=0)
+        self.window_duration = 100  # Duration of the visible window in seconds
+
+        # Placeholder text (overlay label, centred over the plot)
+        self.placeholder = QLabel("Waiting for PRIM device data...", self.plot)
+        self.placeholder.setAlignment(Qt.AlignCenter)
+        self.placeholder.setStyleSheet(
+            "color:gray;font-size:12pt;background:#ECEFF4;"
+            "border-radius:6px;padding:6px;"
+        )
+
+        # Hover label + marker
+        self.hover_text = pg.TextItem(
+            "", color="k", anchor=(0, 1), fill=pg.mkBrush(245, 222, 179, 220)
+        )
+        self.hover_marker = pg.ScatterPlotItem(size=8, brush=pg.mkBrush("k"))
+        self.plot.addItem(self.hover_text, ignoreBounds=True)
+        self.plot.addItem(self.hover_marker, ignoreBounds=True)
+        self.hover_text.hide()
+        self.hover_marker.hide()
+        self.plot.scene().sigMouseMoved.connect(self._on_hover)
+
+        # Rendering is decoupled from data arrival
+        self._dirty = False
+        self._auto_x = True
+        self._auto_y = False
+        self._render_timer = QTimer(self)
+        self._render_timer.setInterval(max(1, int(1000 / PLOT_REFRESH_HZ)))
+        self._render_timer.timeout.connect(self._render)
+        self._render_timer.start()
+
+    # ─── Placeholder / hover ────────────────────────────────────────────
+    def resizeEvent(self, event):
+        super().resizeEvent(event)
+        self._position_placeholder()
+
+    def _position_placeholder(self):
+        self.placeholder.adjustSize()
+        r = self.plot.rect()
+        self.placeholder.move(
+            (r.width() - self.placeholder.width()) // 2,
+            (r.height() - self.placeholder.height()) // 2,
+        )
+
+    def _update_placeholder(self, text=None):
+        if text:
+            self.curve.setData([], [])
+            self._hide_hover()
+            self.placeholder.setText(text)
+            self.placeholder.show()
+            self._position_placeholder()
+        else:
+            self.placeholder.hide()
+
+    def _hide_hover(self):
+        self.hover_text.hide()
+        self.hover_marker.hide()
+
+    def _on_hover(self, scene_pos):
+        if not len(self.data) or self.placeholder.isVisible():
+            self._hide_hover()
+            return
+        if not self.view_box.sceneBoundingRect().contains(scene_pos):
+            self._hide_hover()
+            return
+
+        pt = self.view_box.mapSceneToView(scene_pos)
+        found = self.data.nearest(pt.x())
+        if found is None:
+            self._hide_hover()
+            return
+        t, p = found
+        self.hover_text.setText(f"Time: {t:.2f} s\nPressure: {p:.2f} mmHg")
+        self.hover_text.setPos(t, p)
+        self.hover_marker.setData([t], [p])
+        self.hover_text.show()
+        self.hover_marker.show()
+
+    # ─── Data / rendering ───────────────────────────────────────────────
+    @pyqtSlot(float, float, bool, bool)
+    def update_plot(self, t, p, auto_x, auto_y):
+        if not len(self.data) and self.placeholder.isVisible():
+            self._update_placeholder(None)
+        self.data.append(t, p)
+        self._auto_x, self._auto_y = auto_x, auto_y
+        self._dirty = True
+
+    def update_plot_block(self, ts, ps, auto_x, auto_y):
+        """Append a batch of samples; drawn on the next render tick."""
+        if not len(ts):
+            return
+        if not len(self.data) and self.placeholder.isVisible():
+            self._update_placeholder(None)
+        self.data.extend(ts, ps)
+        self._auto_x, self._auto_y = auto_x, auto_y
+        self._dirty = True
+
+    def _render(self):
+        if not self._dirty:
+            return
+        self._dirty = False
+        t0 = time.perf_counter()
+        self._apply_limits(self._auto_x, self._auto_y)
+        self._refresh_curve()
+        telemetry.record("ui.plot_redraw", time.perf_counter() - t0)
+
+    def _current_xlim(self):
+        (xmin, xmax), _ = self.view_box.viewRange()
+        return xmin, xmax
+
+    def _refresh_curve(self):
+        xmin, xmax = self._current_xlim()
+        width_px = max(int(self.view_box.width()), 1)
+        x, y = self.data.view(xmin, xmax, min(PLOT_MAX_POINTS, 2 * width_px))
+        self.curve.setData(x, y, skipFiniteCheck=True)
+        if self.filtered_curve is not None:
+            x, y = self.filtered_data.view(xmin, xmax, min(PLOT_MAX_POINTS, 2 * width_px))
+            self.filtered_curve.setData(x, y, skipFiniteCheck=True)
+        if self.diameter_curve is not None:
+            x, y = self.diameter_data.view(xmin, xmax, min(PLOT_MAX_POINTS, 2 * width_px))
+            self.diameter_curve.setData(x, y, skipFiniteCheck=True)
+
+    def _create_diameter_view(self, units):
+        item = self.plot.getPlotItem()
+        self.diameter_view = pg.ViewBox(enableMouse=False)
+        self.diameter_view.disableAutoRange()
+        item.showAxis("right")
+        item.scene().addItem(self.diameter_view)
+        axis = item.getAxis("right")
+        axis.linkToView(self.diameter_view)
+        axis.setLabel(f"Diameter ({units})", color="#d62728")
+        self.diameter_view.setXLink(item)
+        self.diameter_curve = pg.PlotCurveItem(pen=pg.mkPen("#d62728", width=1.5))
+        self.diameter_view.addItem(self.diameter_curve)
+
+        def sync_geometry():
+            self.diameter_view.setGeometry(self.view_box.sceneBoundingRect())
+
+        self.view_box.sigResized.connect(sync_geometry)
+        sync_geometry()
+
+    def update_diameter_block(self, ts, ds, units="px"):
+        """Append live diameters (device time, value); drawn on the next render tick."""
+        finite = np.isfinite(ts) & np.isfinite(ds)
+        if not finite.any():
+            return
+        if self.diameter_view is None:
+            self._create_diameter_view(units)
+        self.diameter_data.extend(ts[finite], ds[finite])
+        lo, hi = self.diameter_data.y_range()
+        pad = max((hi - lo) * 0.1, 1.0)
+        self.diameter_view.setYRange(lo - pad, hi + pad, padding=0)
+        self._dirty = True
+
+    def update_filtered_block(self, ts, ys):
+        """Append filtered pressure (drawn over the raw trace on the next tick)."""
+        if not len(ts):
+            return
+        if self.filtered_curve is None:
+            pen = pg.mkPen("#1f77b4", width=1.5)
+            self.filtered_curve = self.plot.plot([], [], pen=pen)
+        self.filtered_data.extend(ts, ys)
+        self._dirty = True
+
+    def clear_diameter(self):
+        self.diameter_data.clear()
+        if self.diameter_curve is not None:
+            self.diameter_curve.setData([], [])
+
+    def _apply_limits(self, auto_x, auto_y):
+        first, last = self.data.first_time, self.data.last_time
+
+        if auto_x:
+            self.manual_xlim = None
+            self.scrollbar.hide()
+            if len(self.data) > 1 and last > first:
+                pad = max(1, (last - first) * 0.05)
+                self.plot.setXRange(first - pad * 0.1, last + pad * 0.9, padding=0)
+            elif len(self.data):
+                self.plot.setXRange(last - 0.5, last + 0.5, padding=0)
+        elif len(self.data):
+            xmin = max(0.0, last - self.window_duration)
+            xmax = last if last > xmin else xmin + 1.0
+            self.manual_xlim = (xmin, xmax)
+            self.plot.setXRange(xmin, xmax, padding=0)
+            self.scrollbar.hide()
+
+        if auto_y:
+            self.manual_ylim = None
+            y_range = self.data.y_range()
+            if y_range:
+                mn, mx = y_range
+                pad = max(abs(mx - mn) * 0.1, 2.0)
+                self.plot.setYRange(mn - pad, mx + pad, padding=0)
+        elif self.manual_ylim:
+            self.plot.setYRange(*self.manual_ylim, padding=0)
+        elif not len(self.data):
+            self.plot.setYRange(PLOT_DEFAULT_Y_MIN, PLOT_DEFAULT_Y_MAX, padding=0)
+
+    def _update_scrollbar(self):
+        if not len(self.data) or not self.manual_xlim:
+            self.scrollbar.hide()
+            return
+
+        xmin, xmax = self.manual_xlim
+        first, last = self.data.first_time, self.data.last_time
+        window_steps = max(int((xmax - xmin) / SCROLL_RESOLUTION_S), 1)
+        full_steps = int((last - first) / SCROLL_RESOLUTION_S)
+        if full_steps <= window_steps:
+            self.scrollbar.hide()
+            return
+
+        self.scrollbar.blockSignals(True)
+        self.scrollbar.setMinimum(0)
+        self.scrollbar.setMaximum(full_steps - window_steps)
+        self.scrollbar.setPageStep(window_steps)
+        self.scrollbar.setSingleStep(max(window_steps // 10, 1))
+        pos = int((xmin - first) / SCROLL_RESOLUTION_S)
+        self.scrollbar.setValue(min(max(pos, 0), full_steps - window_steps))
+        self.scrollbar.blockSignals(False)
+        self.scrollbar.show()
+
+    @pyqtSlot(int)
+    def _on_scroll(self, pos):
+        if not self.manual_xlim or len(self.data) <= 1:
+            return
+        width = self.manual_xlim[1] - self.manual_xlim[0]
+        xmin_new = self.data.first_time + pos * SCROLL_RESOLUTION_S
+        self.manual_xlim = (xmin_new, xmin_new + width)
+        self.plot.setXRange(*self.manual_xlim, padding=0)
+        self._refresh_curve()
+
+    # ─── Public API shared with PressurePlotWidget ──────────────────────
+    def set_manual_x_limits(self, xmin, xmax):
+        if xmin < xmax:
+            self.manual_xlim = (xmin, xmax)
+            self.plot.setXRange(xmin, xmax, padding=0)
+            self._update_scrollbar()
+            self._refresh_curve()
+        else:
+            log.warning("X min must be less than X max")
+
+    def set_manual_y_limits(self, ymin, ymax):
+        if ymin < ymax and math.isfinite(ymin) and math.isfinite(ymax):
+            self.manual_ylim = (ymin, ymax)
+            self.plot.setYRange(ymin, ymax, padding=0)
+        else:
+            log.warning(
+                f"Y limits must be finite and min < max. Received: {ymin}, {ymax}"
+            )
+
+    def reset_zoom(self, auto_x, auto_y):
+        self.manual_xlim = None
+        if auto_x:
+            self.scrollbar.hide()
+
+        if not auto_y:
+            self.manual_ylim = (PLOT_DEFAULT_Y_MIN, PLOT_DEFAULT_Y_MAX)
+            self.plot.setYRange(*self.manual_ylim, padding=0)
+        else:
+            self.manual_ylim = None
+
+        if len(self.data):
+            self._auto_x, self._auto_y = auto_x, auto_y
+            self._apply_limits(auto_x, auto_y)
+            self._refresh_curve()
+        else:
+            self.plot.setXRange(0, 10, padding=0)
+            self._update_placeholder("Plot cleared or waiting for data.")
+
+    def clear_plot(self):
+        self.data.clear()
+        self.curve.setData([], [])
+        self.clear_diameter()
+        self.filtered_data.clear()
+        if self.filtered_curve is not None:
+            self.filtered_curve.setData([], [])
+        self.plot.setXRange(0, 100, padding=0)
+        if self.manual_ylim is None:
+            self.plot.setYRange(PLOT_DEFAULT_Y_MIN, PLOT_DEFAULT_Y_MAX, padding=0)
+        else:
+            self.plot.setYRange(*self.manual_ylim, padding=0)
+        self._update_placeholder("Plot data cleared.")
+
+    def get_plot_data(self):
+        """
+        Full-resolution samples currently held for the live view, oldest
+        first.  ``truncated`` counts the earlier samples of the session that
+        are no longer held at full resolution (not included).
+        """
+        t, p = self.data.ring_data()
+        return {
+            "time": t.tolist(),
+            "pressure": p.tolist(),
+            "truncated": self.data.evicted,
+        }
+
+    def export_as_image(self):
+        if not len(self.data):
+            QMessageBox.warning(self, "Empty Plot", "Plot has no data to export.")
+            return
+        default_name = f"plot_export_{time.strftime('%Y%m%d-%H%M%S')}.png"
+        path, _ = QFileDialog.getSaveFileName(
+            self,
+            "Save Plot Image",
+            default_name,
+            "PNG (*.png);;JPEG (*.jpg);;SVG (*.svg)",
+        )
+        if not path:
+            return
+        try:
+            import pyqtgraph.exporters as exporters
+
+            hover_visible = self.hover_text.isVisible()
+            self._hide_hover()
+            if path.lower().endswith(".svg"):
+                exporter = exporters.SVGExporter(self.plot.getPlotItem())
+            else:
+                exporter = exporters.ImageExporter(self.plot.getPlotItem())
+                exporter.parameters()["width"] = max(1600, self.plot.width() * 3)
+            exporter.export(path)
+            if hover_visible:
+                self.hover_text.show()
+                self.hover_marker.show()
+
+            sb = self.window().statusBar() if self.window() else None
+            if sb:
+                sb.showMessage(f"Plot exported to {os.path.basename(path)}", 3000)
+        except Exception as e:
+            log.exception(f"Error exporting plot image: {e}")
+            QMessageBox.critical(
+                self, "Export Error", f"Could not save plot image: {e}"
+            )
@@ -1,10 +1,10 @@
 # pressure_plot_widget.py
 import os
 import time
-import bisect
 import logging
 import math
 
+import numpy as np
 from PyQt5.QtWidgets import (
     QWidget,
     QSizePolicy,
@@ -13,16 +13,38 @@ from PyQt5.QtWidgets import (
     QFileDialog,
     QScrollBar,
 )
-from PyQt5.QtCore import Qt, pyqtSlot
+from PyQt5.QtCore import Qt, pyqtSignal, pyqtSlot
 from matplotlib.figure import Figure
 from matplotlib.backends.backend_qtagg import FigureCanvasQTAgg as FigureCanvas
 
-from utils.config import PLOT_DEFAULT_Y_MIN, PLOT_DEFAULT_Y_MAX
+from utils.config import (
+    PLOT_DEFAULT_Y_MIN,
+    PLOT_DEFAULT_Y_MAX,
+    PLOT_MAX_POINTS,
+    PLOT_RING_CAPACITY,
+)
+from utils.telemetry import telemetry
+from .plot_data_buffer import PlotDataBuffer
 
 log = logging.getLogger(__name__)
 
+# Resolution of the horizontal scrollbar, in seconds per step
+SCROLL_RESOLUTION_S = 0.1
+
+
+class _TimedCanvas(FigureCanvas):
+    """FigureCanvas that reports every full redraw as ui.plot_redraw."""
+
+    def draw(self):
+        t0 = time.perf_counter()
+        super().draw()
+        telemetry.record("ui.plot_redraw", time.perf_counter() - t0)
+
 
 class PressurePlotWidget(QWidget):
+    # Time (s) picked with the mouse while the time cursor is enabled
+    time_cursor_moved = pyqtSignal(float)
+
     def __init__(self, parent=None):
         super().__init__(parent)
         self.setSizePolicy(QSizePolicy.Expanding, QSizePolicy.Expanding)
@@ -43,7 +65,7 @@ class PressurePlotWidget(QWidget):
 
         (self.line,) = self.ax.plot([], [], "-", lw=2, color="black")
 
-        self.canvas = FigureCanvas(self.fig)
+        self.canvas = _TimedCanvas(self.fig)
         layout.addWidget(self.canvas)
 
         # Scrollbar for manual X panning
@@ -81,9 +103,15 @@ class PressurePlotWidget(QWidget):
         """
         )
 
-        # Data storage
-        self.times = []
-        self.pressures = []
+        # Data storage: full-resolution ring + min/max pyramid for the history
+        self.data = PlotDataBuffer()
+        # Live diameter trace on a second Y axis, created with its first data
+        self.diameter_data = PlotDataBuffer()
+        self.ax_diameter = None
+        self.diameter_line = None
+        # Filtered pressure (PressureDSP channel) over the raw trace
+        self.filtered_data = PlotDataBuffer()
+        self.filtered_line = None
         self.manual_xlim = None
         self.manual_ylim = (PLOT_DEFAULT_Y_MIN, PLOT_DEFAULT_Y_MAX)
         self.ax.set_ylim(self.manual_ylim)
@@ -118,6 +146,11 @@ class PressurePlotWidget(QWidget):
         # Connect hover event
         self.canvas.mpl_connect("motion_notify_event", self._on_hover)
 
+        # Time cursor (review mode), created by enable_time_cursor()
+        self.cursor_line = None
+        self.cursor_annotation = None
+        self._cursor_dragging = False
+
     def _update_placeholder(self, text=None):
         if text:
             self.line.set_data([], [])  #
@@ -148,39 +181,34 @@ class PressurePlotWidget(QWidget):
         self.canvas.draw_idle()
 
     def _find_nearest_datapoint(self, x_coord):
-        """Finds the nearest data point (time, pressure, index) to the given x_coord."""
-        if not self.times:
-            return None, None, -1
-
-        # bisect_left finds the insertion point for x_coord to maintain sorted order
-        idx = bisect.bisect_left(self.times, x_coord)
-
-        if idx == 0:  # x_coord is at or before the first element
-            best_idx = 0
-        elif idx == len(self.times):  # x_coord is after the last element
-            best_idx = len(self.times) - 1
-        else:  # x_coord is between self.times[idx-1] and self.times[idx]
-            # Determine which of the two neighbours is closer
-            dist1 = abs(x_coord - self.times[idx - 1])
-            dist2 = abs(x_coord - self.times[idx])
-            if dist1 <= dist2:
-                best_idx = idx - 1
-            else:
-                best_idx = idx
-
-        # Optional: Add a threshold if you only want to show hover for very close points
-        # For example, if the closest point's x value is too far from mouse x_coord:
-        # x_axis_range = self.ax.get_xlim()[1] - self.ax.get_xlim()[0]
-        # if x_axis_range > 0 and abs(self.times[best_idx] - x_coord) > x_axis_range * 0.05: # 5% of current x-axis view
-        #     return None, None, -1
-
-        return self.times[best_idx], self.pressures[best_idx], best_idx
+        """Finds the nearest data point (time, pressure) to the given x_coord."""
+        found = self.data.nearest(x_coord)
+        if found is None:
+            return None, None
+        return found
+
+    def _max_render_points(self):
+        """About two points (min/max) per horizontal pixel of the axes."""
+        width_px = max(int(self.ax.bbox.width), 1)
+        return min(PLOT_MAX_POINTS, 2 * width_px)
+
+    def _refresh_line(self):
+        """Replace the line data with the decimated view of the current X range."""
+        xmin, xmax = self.ax.get_xlim()
+        x, y = self.data.view(xmin, xmax, self._max_render_points())
+        self.line.set_data(x, y)
+        if self.filtered_line is not None:
+            x, y = self.filtered_data.view(xmin, xmax, self._max_render_points())
+            self.filtered_line.set_data(x, y)
+        if self.diameter_line is not None:
+            x, y = self.diameter_data.view(xmin, xmax, self._max_render_points())
+            self.diameter_line.set_data(x, y)
 
     def _on_hover(self, event):
         """Handles mouse motion event to show data point information."""
         # If no data, or placeholder is visible, or line is not visible, do nothing with hover
         if (
-            not self.times
+            not len(self.data)
             or (self.placeholder and self.placeholder.get_visible())
             or not self.line.get_visible()
         ):
@@ -192,14 +220,15 @@ class PressurePlotWidget(QWidget):
         annotation_visible = self.hover_annotation.get_visible()
         needs_redraw = False
 
-        if event.inaxes == self.ax:  # Check if mouse is over the plot axes
+        # The diameter axis (twinx) sits on top and shares the X coordinates
+        if event.inaxes is not None and event.inaxes in (self.ax, self.ax_diameter):
             x_mouse, y_mouse = (
                 event.xdata,
                 event.ydata,
             )  # Mouse coordinates in data space
 
             # Find the data point on the line closest to the mouse's x-coordinate
-            target_x, target_y, _ = self._find_nearest_datapoint(x_mouse)
+            target_x, target_y = self._find_nearest_datapoint(x_mouse)
 
             if target_x is not None:
                 self.hover_annotation.xy = (target_x, target_y)
@@ -227,35 +256,88 @@ class PressurePlotWidget(QWidget):
     @pyqtSlot(float, float, bool, bool)
     def update_plot(self, t, p, auto_x, auto_y):
         # Remove placeholder on first data
-        if not self.times and self.placeholder and self.placeholder.get_visible():
+        if not len(self.data) and self.placeholder and self.placeholder.get_visible():
             self._update_placeholder(None)
 
         # Append new data
-        self.times.append(t)
-        self.pressures.append(p)
-        self.line.set_data(self.times, self.pressures)
+        self.data.append(t, p)
+        self._apply_limits(auto_x, auto_y)
+
+        # The line always changes, so a redraw is always due
+        self._refresh_line()
+        self.canvas.draw_idle()
+
+    def update_plot_block(self, ts, ps, auto_x, auto_y):
+        """Append a batch of samples and redraw once (see UiRefreshScheduler)."""
+        if not len(ts):
+            return
+        if not len(self.data) and self.placeholder and self.placeholder.get_visible():
+            self._update_placeholder(None)
+
+        self.data.extend(ts, ps)
+        self._apply_limits(auto_x, auto_y)
+        self._refresh_line()
+        self.canvas.draw_idle()
+
+    def update_diameter_block(self, ts, ds, units="px"):
+        """
+        Append live diameters (device time, value) to the second trace.
+        Drawn with the next pressure redraw, which owns the shared X axis.
+        """
+        finite = np.isfinite(ts) & np.isfinite(ds)
+        if not finite.any():
+            return
+        if self.ax_diameter is None:
+            self.ax_diameter = self.ax.twinx()
+            self.ax_diameter.set_ylabel(
+                f"Diameter ({units})", fontsize=16, fontweight="bold", color="tab:red"
+            )
+            self.ax_diameter.tick_params(labelsize=10, colors="tab:red")
+            (self.diameter_line,) = self.ax_diameter.plot(
+                [], [], "-", lw=1.5, color="tab:red"
+            )
+        self.diameter_data.extend(ts[finite], ds[finite])
+        lo, hi = self.diameter_data.y_range()
+        pad = max((hi - lo) * 0.1, 1.0)
+        self.ax_diameter.set_ylim(lo - pad, hi + pad)
+
+    def update_filtered_block(self, ts, ys):
+        """
+        Append filtered pressure (device time, value) to the trace drawn over
+        the raw one.  Drawn with the next pressure redraw.
+        """
+        if not len(ts):
+            return
+        if self.filtered_line is None:
+            (self.filtered_line,) = self.ax.plot(
+                [], [], "-", lw=1.5, color="tab:blue", alpha=0.9
+            )
+        self.filtered_data.extend(ts, ys)
+
+    def clear_diameter(self):
+        self.diameter_data.clear()
+        if self.diameter_line is not None:
+            self.diameter_line.set_data([], [])
+            self.canvas.draw_idle()
 
-        # Remember the current axis limits so we only redraw if something changes:
-        current_xlim = self.ax.get_xlim()
-        current_ylim = self.ax.get_ylim()
+    def _apply_limits(self, auto_x, auto_y):
+        """Recompute axis limits from the data and the auto-scale flags."""
+        first, last = self.data.first_time, self.data.last_time
 
         # ─── X-axis handling ───────────────────────────────
         if auto_x:
-            # Clear any manual X-limits and let matplotlib autoscale
+            # Clear any manual X-limits and fit the whole session
             self.manual_xlim = None
             self.scrollbar.hide()
-            if len(self.times) > 1:
-                start, end = self.times[0], self.times[-1]
-                pad = max(1, (end - start) * 0.05)
-                self.ax.set_xlim(start - pad * 0.1, end + pad * 0.9)
-            elif self.times:  # single data point
-                t0 = self.times[-1]
-                self.ax.set_xlim(t0 - 0.5, t0 + 0.5)
-        else:
+            if len(self.data) > 1 and last > first:
+                pad = max(1, (last - first) * 0.05)
+                self.ax.set_xlim(first - pad * 0.1, last + pad * 0.9)
+            elif len(self.data):  # single data point
+                self.ax.set_xlim(last - 0.5, last + 0.5)
+        elif len(self.data):
             # SLIDING WINDOW: always show [t_latest - window_duration, t_latest]
-            t_latest = self.times[-1]
-            xmin = max(0.0, t_latest - self.window_duration)
-            xmax = t_latest
+            xmin = max(0.0, last - self.window_duration)
+            xmax = last if last > xmin else xmin + 1.0
             self.manual_xlim = (xmin, xmax)
             self.ax.set_xlim(self.manual_xlim)
 
@@ -265,100 +347,60 @@ class PressurePlotWidget(QWidget):
         # ─── Y-axis handling ───────────────────────────────
         if auto_y:
             self.manual_ylim = None  # clear any manual Y-limits
-            if self.pressures:
-                mn, mx = min(self.pressures), max(self.pressures)
+            y_range = self.data.y_range()
+            if y_range:
+                mn, mx = y_range
                 pad = max(abs(mx - mn) * 0.1, 2.0)
                 self.ax.set_ylim(mn - pad, mx + pad)
         else:
             if self.manual_ylim:
                 # Use whatever manual Y-limits have been set previously
                 self.ax.set_ylim(self.manual_ylim)
-            elif not self.pressures:
+            elif not len(self.data):
                 # No data yet → fallback to default
                 self.ax.set_ylim(PLOT_DEFAULT_Y_MIN, PLOT_DEFAULT_Y_MAX)
 
-        # ─── Only redraw if limits or data changed ───────
-        new_xlim = self.ax.get_xlim()
-        new_ylim = self.ax.get_ylim()
-
-        if current_xlim != new_xlim or current_ylim != new_ylim or self.line.stale:
-            self.canvas.draw_idle()
-
     def _update_scrollbar(self):
-        if not self.times or not self.manual_xlim:  # Ensure data and manual_xlim exist
+        if not len(self.data) or not self.manual_xlim:  # Ensure data and manual_xlim exist
             self.scrollbar.hide()
             return
 
-        # Determine index-based window for manual_xlim
+        # The scrollbar works in time steps of SCROLL_RESOLUTION_S over the
+        # whole session, so it stays valid however much history there is.
         xmin, xmax = self.manual_xlim
-        idx0 = bisect.bisect_left(self.times, xmin)
-        idx1 = bisect.bisect_right(self.times, xmax)
-        window_size = max(idx1 - idx0, 1)  # Ensure window_size is at least 1
-        full_len = len(self.times)
+        first, last = self.data.first_time, self.data.last_time
+        window_steps = max(int((xmax - xmin) / SCROLL_RESOLUTION_S), 1)
+        full_steps = int((last - first) / SCROLL_RESOLUTION_S)
 
-        if full_len <= window_size:  # If the window covers all data
+        if full_steps <= window_steps:  # If the window covers all data
             self.scrollbar.hide()
             return
 
         # Configure scrollbar
+        self.scrollbar.blockSignals(True)
         self.scrollbar.setMinimum(0)
-        self.scrollbar.setMaximum(
-            max(full_len - window_size, 0)
-        )  # Ensure maximum is not negative
-        self.scrollbar.setPageStep(window_size)
-        self.scrollbar.setSingleStep(
-            max(window_size // 10, 1)
-        )  # Ensure singleStep is at least 1
+        self.scrollbar.setMaximum(full_steps - window_steps)
+        self.scrollbar.setPageStep(window_steps)
+        self.scrollbar.setSingleStep(max(window_steps // 10, 1))
 
         # Position scrollbar thumb
-        self.scrollbar.setValue(idx0)  # Set value after setting min/max/pageStep
+        pos = int((xmin - first) / SCROLL_RESOLUTION_S)
+        self.scrollbar.setValue(min(max(pos, 0), full_steps - window_steps))
+        self.scrollbar.blockSignals(False)
         self.scrollbar.show()
 
     @pyqtSlot(int)
     def _on_scroll(self, pos):
-        # Pan X-axis window based on scroll position
-        if not self.manual_xlim or not self.times or len(self.times) <= 1:
+        # Pan X-axis window based on scroll position, keeping the zoom level
+        if not self.manual_xlim or len(self.data) <= 1:
             return
 
-        # Determine window size from current manual_xlim to maintain zoom level
         current_xmin, current_xmax = self.manual_xlim
-        # Find indices for the current xlim to estimate window width in data units
-        current_idx_min = bisect.bisect_left(self.times, current_xmin)
-        current_idx_max = bisect.bisect_right(self.times, current_xmax)
-
-        # Calculate window width in terms of number of data points
-        # This uses pageStep as an approximation of window size in indices
-        window_indices = self.scrollbar.pageStep()
-
-        # New start index from scrollbar position
-        start_idx = pos
-        end_idx = min(
-            start_idx + window_indices - 1, len(self.times) - 1
-        )  # Ensure end_idx is valid
-
-        if start_idx >= end_idx and len(self.times) > 1:  # Ensure valid range
-            # This can happen if window_indices is too small or pos is at the very end.
-            # Default to a small window at the end.
-            start_idx = max(0, len(self.times) - 2)
-            end_idx = len(self.times) - 1
-
-        if start_idx < 0:
-            start_idx = 0  # Should not happen with QScrollBar limits
-
-        xmin_new = self.times[start_idx]
-        xmax_new = self.times[end_idx]
-
-        # Ensure xmax_new is greater than xmin_new, especially for small datasets
-        if xmin_new == xmax_new and len(self.times) > 1:
-            if end_idx + 1 < len(self.times):
-                xmax_new = self.times[end_idx + 1]
-            elif start_idx - 1 >= 0:
-                xmin_new = self.times[start_idx - 1]
-            else:  # Single point, or all points identical; give a small default range
-                xmax_new = xmin_new + 1.0
-
-        self.manual_xlim = (xmin_new, xmax_new)
+        width = current_xmax - current_xmin
+        xmin_new = self.data.first_time + pos * SCROLL_RESOLUTION_S
+        self.manual_xlim = (xmin_new, xmin_new + width)
         self.ax.set_xlim(self.manual_xlim)
+        self._refresh_line()
         self.canvas.draw_idle()
 
     def set_manual_x_limits(self, xmin, xmax):
@@ -366,6 +408,7 @@ class PressurePlotWidget(QWidget):
             self.manual_xlim = (xmin, xmax)
             self.ax.set_xlim(self.manual_xlim)
             self._update_scrollbar()  # Update scrollbar based on new manual limits
+            self._refresh_line()  # Re-decimate for the new range
             self.canvas.draw_idle()  # Redraw
         else:
             log.warning("X min must be less than X max")
@@ -394,10 +437,11 @@ class PressurePlotWidget(QWidget):
             self.manual_ylim = None
 
         # Re-evaluate plot based on current data and new auto settings
-        if self.times:
-            # Call update_plot with the last data point to trigger re-scaling
-            # The auto_x and auto_y flags will ensure correct scaling behavior
-            self.update_plot(self.times[-1], self.pressures[-1], auto_x, auto_y)
+        if len(self.data):
+            # Rescale with the auto_x and auto_y flags and redraw
+            self._apply_limits(auto_x, auto_y)
+            self._refresh_line()
+            self.canvas.draw_idle()
         else:  # No data, set to default view
             self.ax.set_xlim(0, 10)  # Default X if no data
             if self.manual_ylim and not auto_y:  # Apply manual Y if set and not auto_y
@@ -410,8 +454,13 @@ class PressurePlotWidget(QWidget):
             self.canvas.draw_idle()
 
     def clear_plot(self):
-        self.times.clear()
-        self.pressures.clear()
+        self.data.clear()
+        self.diameter_data.clear()
+        if self.diameter_line is not None:
+            self.diameter_line.set_data([], [])
+        self.filtered_data.clear()
+        if self.filtered_line is not None:
+            self.filtered_line.set_data([], [])
 
         self.line.set_data([], [])
         self.ax.set_xlim(0, 100)  # Reset to a default X view
@@ -436,8 +485,99 @@ class PressurePlotWidget(QWidget):
         self._update_placeholder("Plot data cleared.")  # This will also call draw_idle
         # self.canvas.draw_idle() # Called by _update_placeholder
 
+    # ─── Time cursor (review mode) ───────────────────────────────────────
+    def load_series(self, ts, ps, diameter=None, units="px"):
+        """
+        Show a whole recorded series at once (replaces the live data), plus
+        an optional ``(ts, ds)`` diameter trace.  The pressure is kept at full
+        resolution however long it is, so the hover label and the time
+        cursor snap to real samples.
+        """
+        self.data = PlotDataBuffer(capacity=max(len(ts), PLOT_RING_CAPACITY))
+        self.clear_diameter()
+        if diameter is not None and len(diameter[0]):
+            self.update_diameter_block(*diameter, units=units)
+        if not len(ts):
+            self._update_placeholder("No pressure data in this recording.")
+            return
+        self._update_placeholder(None)
+        self.data.extend(ts, ps)
+        self._apply_limits(True, True)
+        self._refresh_line()
+        self.canvas.draw_idle()
+
+    def enable_time_cursor(self):
+        """
+        Draw a vertical time cursor; clicking or dragging in the plot moves
+        it and emits ``time_cursor_moved``.
+        """
+        if self.cursor_line is not None:
+            return
+        self.cursor_line = self.ax.axvline(
+            0.0, color="tab:blue", lw=1.5, alpha=0.8, visible=False
+        )
+        self.cursor_annotation = self.ax.annotate(
+            "",
+            xy=(0, 0),
+            xytext=(10, -30),
+            textcoords="offset points",
+            bbox=dict(boxstyle="round,pad=0.3", fc="#DCE9F5", alpha=0.9),
+        )
+        self.cursor_annotation.set_visible(False)
+        self.canvas.mpl_connect("button_press_event", self._on_cursor_press)
+        self.canvas.mpl_connect("motion_notify_event", self._on_cursor_drag)
+        self.canvas.mpl_connect("button_release_event", self._on_cursor_release)
+
+    def set_time_cursor(self, t):
+        """Move the cursor to time ``t``, labelled with the nearest sample."""
+        if self.cursor_line is None:
+            return
+        self.cursor_line.set_xdata([t, t])
+        self.cursor_line.set_visible(True)
+        target_x, target_y = self._find_nearest_datapoint(t)
+        if target_x is not None:
+            self.cursor_annotation.xy = (target_x, target_y)
+            self.cursor_annotation.set_text(
+                f"Time: {target_x:.3f} s\nPressure: {target_y:.2f} mmHg"
+            )
+            self.cursor_annotation.set_visible(True)
+        self.canvas.draw_idle()
+
+    def _cursor_event_time(self, event):
+        if event.button != 1 or event.xdata is None:
+            return None
+        if event.inaxes not in (self.ax, self.ax_diameter):
+            return None
+        return float(event.xdata)
+
+    def _on_cursor_press(self, event):
+        t = self._cursor_event_time(event)
+        if t is not None:
+            self._cursor_dragging = True
+            self.time_cursor_moved.emit(t)
+
+    def _on_cursor_drag(self, event):
+        if self._cursor_dragging and event.xdata is not None:
+            self.time_cursor_moved.emit(float(event.xdata))
+
+    def _on_cursor_release(self, event):
+        self._cursor_dragging = False
+
+    def get_plot_data(self):
+        """
+        Full-resolution samples currently held for the live view, oldest
+        first.  ``truncated`` counts the earlier samples of the session that
+        are no longer held at full resolution (not included).
+        """
+        t, p = self.data.ring_data()
+        return {
+            "time": t.tolist(),
+            "pressure": p.tolist(),
+            "truncated": self.data.evicted,
+        }
+
     def export_as_image(self):
-        if not self.times and not (
+        if not len(self.data) and not (
             self.placeholder and self.placeholder.get_visible()
         ):  #
             QMessageBox.warning(self, "Empty Plot", "Plot has no data to export.")
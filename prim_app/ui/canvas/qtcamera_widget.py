@@ -1,33 +1,206 @@
 # File: prim_app/ui/canvas/qtcamera_widget.py
 
+import ctypes
+import logging
+import time
+
+import numpy as np
 from PyQt5.QtWidgets import QOpenGLWidget
-from PyQt5.QtGui import QPainter, QImage
-from PyQt5.QtCore import Qt, pyqtSlot
-from OpenGL.GL import glClearColor
+from PyQt5.QtGui import QPainter, QImage, QPen, QColor
+from PyQt5.QtCore import Qt, QPointF, QRectF, pyqtSignal, pyqtSlot
+from OpenGL import GL as gl
+from OpenGL.GL import shaders
+
+from utils.telemetry import telemetry
+
+log = logging.getLogger(__name__)
+
+# GL texture formats per (dtype, channels): internal format, pixel format, type
+_NP_GL_FORMATS = {
+    (np.dtype(np.uint8), 1): (gl.GL_R8, gl.GL_RED, gl.GL_UNSIGNED_BYTE),
+    (np.dtype(np.uint16), 1): (gl.GL_R16, gl.GL_RED, gl.GL_UNSIGNED_SHORT),
+    (np.dtype(np.uint8), 3): (gl.GL_RGB8, gl.GL_RGB, gl.GL_UNSIGNED_BYTE),
+    (np.dtype(np.uint8), 4): (gl.GL_RGBA8, gl.GL_RGBA, gl.GL_UNSIGNED_BYTE),
+}
+
+_VERTEX_SHADER = """
+#version 330 core
+layout(location = 0) in vec2 a_pos;
+layout(location = 1) in vec2 a_uv;
+uniform vec2 u_scale;
+uniform vec2 u_offset;
+out vec2 v_uv;
+void main() {
+    v_uv = a_uv;
+    gl_Position = vec4(a_pos * u_scale + u_offset, 0.0, 1.0);
+}
+"""
+
+# Window/level: texture values in [u_low, u_high] are stretched to [0, 1]
+_FRAGMENT_SHADER = """
+#version 330 core
+in vec2 v_uv;
+uniform sampler2D u_tex;
+uniform float u_low;
+uniform float u_high;
+uniform bool u_mono;
+out vec4 frag_color;
+void main() {
+    vec4 c = texture(u_tex, v_uv);
+    vec3 rgb = u_mono ? vec3(c.r) : c.rgb;
+    rgb = clamp((rgb - u_low) / max(u_high - u_low, 1e-6), 0.0, 1.0);
+    frag_color = vec4(rgb, 1.0);
+}
+"""
+
+# Full-screen quad (triangle strip): x, y, u, v.  v is flipped so image row 0
+# (uploaded first) is at the top.
+_QUAD = np.array(
+    [
+        -1.0, -1.0, 0.0, 1.0,
+        1.0, -1.0, 1.0, 1.0,
+        -1.0, 1.0, 0.0, 0.0,
+        1.0, 1.0, 1.0, 0.0,
+    ],
+    dtype=np.float32,
+)
+
+MIN_ZOOM = 1.0
+MAX_ZOOM = 32.0
+
+# Line ROIs shorter than this (image pixels) are ignored when drawn
+MIN_LINE_LENGTH = 4.0
+_LINE_COLORS = [QColor(255, 200, 0), QColor(0, 220, 255), QColor(255, 90, 200)]
 
 
 class QtCameraWidget(QOpenGLWidget):
     """
-    A simple widget that displays incoming QImage frames from the camera thread.
+    Displays incoming camera frames as an OpenGL texture.
+
+    Frames are streamed into the texture through two pixel-unpack buffers
+    (PBOs) used alternately, and the GPU does the scaling, so the GUI thread
+    never resamples the image.  Mouse wheel zooms around the cursor, dragging
+    pans and a double-click resets the view.  :meth:`set_display_range`
+    applies a window/level contrast stretch in the fragment shader.
+
+    In line-drawing mode (:meth:`set_draw_mode`) dragging draws line ROIs
+    across a vessel instead of panning, and a right-click removes the last
+    one; :attr:`lines_changed` carries the lines in image pixel coordinates.
+    In rectangle mode one drag draws a capture region, reported by
+    :attr:`rect_drawn` as (x, y, w, h) image pixels, and drawing stops.
+
+    If the GL 3.3 pipeline cannot be set up, the widget falls back to
+    painting the QImage with QPainter.
     """
 
+    # [((x0, y0), (x1, y1)), …] in image pixels, after every edit
+    lines_changed = pyqtSignal(list)
+    # (x, y, width, height) in image pixels, once per rectangle drawn
+    rect_drawn = pyqtSignal(tuple)
+
     def __init__(self, parent=None):
         super().__init__(parent)
         self._current_qimage = None
+        self._current_frame = None  # CameraFrame not yet uploaded
+        self._pending_upload = False
+
+        # GL objects
+        self._gl_ok = False
+        self._program = None
+        self._vao = None
+        self._vbo = None
+        self._texture = None
+        self._pbos = []
+        self._pbo_index = 0
+        self._tex_key = None  # (w, h, internal_format) of the allocated texture
+        self._tex_size = None  # (w, h) of the image in the texture
+        self._mono = True
+        self._uniforms = {}
+
+        # View state: zoom factor, pan offset in normalized device coords
+        self._zoom = 1.0
+        self._pan = [0.0, 0.0]
+        self._drag_pos = None
 
+        # Display range (fraction of the texture's full scale)
+        self._low = 0.0
+        self._high = 1.0
+
+        # Line ROIs / capture rectangle (image pixels) and the one being drawn
+        self._draw_mode = None
+        self._lines = []
+        self._rect = None
+        self._line_start = None
+        self._line_end = None
+
+    # ─── GL setup ───────────────────────────────────────────────────────
     def initializeGL(self):
-        """Initialize OpenGL state."""
-        glClearColor(0.0, 0.0, 0.0, 1.0)
+        """Compile the shaders and create the quad, texture and PBOs."""
+        gl.glClearColor(0.0, 0.0, 0.0, 1.0)
+        try:
+            self._vao = gl.glGenVertexArrays(1)
+            gl.glBindVertexArray(self._vao)
 
+            self._program = shaders.compileProgram(
+                shaders.compileShader(_VERTEX_SHADER, gl.GL_VERTEX_SHADER),
+                shaders.compileShader(_FRAGMENT_SHADER, gl.GL_FRAGMENT_SHADER),
+            )
+            for name in ("u_scale", "u_offset", "u_tex", "u_low", "u_high", "u_mono"):
+                self._uniforms[name] = gl.glGetUniformLocation(self._program, name)
+
+            self._vbo = gl.glGenBuffers(1)
+            gl.glBindBuffer(gl.GL_ARRAY_BUFFER, self._vbo)
+            gl.glBufferData(gl.GL_ARRAY_BUFFER, _QUAD.nbytes, _QUAD, gl.GL_STATIC_DRAW)
+            stride = 4 * _QUAD.itemsize
+            gl.glEnableVertexAttribArray(0)
+            gl.glVertexAttribPointer(
+                0, 2, gl.GL_FLOAT, gl.GL_FALSE, stride, ctypes.c_void_p(0)
+            )
+            gl.glEnableVertexAttribArray(1)
+            gl.glVertexAttribPointer(
+                1, 2, gl.GL_FLOAT, gl.GL_FALSE, stride, ctypes.c_void_p(8)
+            )
+            gl.glBindVertexArray(0)
+
+            self._texture = gl.glGenTextures(1)
+            gl.glBindTexture(gl.GL_TEXTURE_2D, self._texture)
+            gl.glTexParameteri(gl.GL_TEXTURE_2D, gl.GL_TEXTURE_MIN_FILTER, gl.GL_LINEAR)
+            gl.glTexParameteri(gl.GL_TEXTURE_2D, gl.GL_TEXTURE_MAG_FILTER, gl.GL_LINEAR)
+            gl.glTexParameteri(
+                gl.GL_TEXTURE_2D, gl.GL_TEXTURE_WRAP_S, gl.GL_CLAMP_TO_EDGE
+            )
+            gl.glTexParameteri(
+                gl.GL_TEXTURE_2D, gl.GL_TEXTURE_WRAP_T, gl.GL_CLAMP_TO_EDGE
+            )
+            gl.glBindTexture(gl.GL_TEXTURE_2D, 0)
+
+            self._pbos = list(gl.glGenBuffers(2))
+            self._tex_key = None
+            self._gl_ok = True
+        except Exception as e:
+            log.error(f"QtCameraWidget: GL pipeline unavailable ({e}); using QPainter.")
+            self._gl_ok = False
+
+        # A frame may have arrived before the context existed
+        self._pending_upload = self._current_frame is not None or (
+            self._current_qimage is not None
+        )
+
+    # ─── Frame input ────────────────────────────────────────────────────
     @pyqtSlot(QImage, object)
-    def _on_frame_ready(self, qimg: QImage, raw_buffer):
+    def _on_frame_ready(self, qimg: QImage, frame):
         """
-        Slot to receive each new frame from SDKCameraThread.frame_ready.
-        Simply store the QImage and trigger a repaint.
+        Slot to receive each new frame (via UiRefreshScheduler).
+        The frame is kept until its pixels have been uploaded to the texture in
+        the next paintGL(), then released; a newer frame arriving first simply
+        replaces (and releases) it.
         """
-        # Make a deep copy to ensure the data stays valid even if the thread recycles buffers
-        self._current_qimage = qimg.copy()
-        # Ask Qt to repaint this widget
+        previous = self._current_frame
+        self._current_frame = frame
+        self._current_qimage = qimg
+        self._pending_upload = True
+        if previous is not None:
+            previous.release()
         self.update()
 
     def clear_image(self):
@@ -35,26 +208,355 @@ class QtCameraWidget(QOpenGLWidget):
         Clear the displayed image (e.g. when stopping the camera).
         """
         self._current_qimage = None
+        self._release_current_frame()
+        self._pending_upload = False
+        self._tex_size = None
         self.update()
 
+    def _release_current_frame(self):
+        if self._current_frame is not None:
+            self._current_frame.release()
+            self._current_frame = None
+
+    def _frame_pixels(self):
+        """Return ``(array, is_bgr)`` for the pending frame, or ``(None, False)``."""
+        frame = self._current_frame
+        if frame is not None and not frame.released:
+            arr = frame.preview if frame.preview is not None else frame.array
+            if arr is not None:
+                if arr.ndim == 3 and arr.shape[2] == 1:
+                    arr = arr[:, :, 0]
+                return arr, frame.pixel_format.upper().startswith("BGR")
+
+        qimg = self._current_qimage
+        if qimg is None or qimg.isNull():
+            return None, False
+        if qimg.format() == QImage.Format_Grayscale8:
+            channels, dtype, is_bgr = 1, np.uint8, False
+        elif qimg.format() == QImage.Format_Grayscale16:
+            channels, dtype, is_bgr = 1, np.uint16, False
+        elif qimg.format() == QImage.Format_RGB888:
+            channels, dtype, is_bgr = 3, np.uint8, False
+        else:
+            qimg = qimg.convertToFormat(QImage.Format_ARGB32)
+            channels, dtype, is_bgr = 4, np.uint8, True  # BGRA in memory
+        ptr = qimg.constBits()
+        ptr.setsize(qimg.byteCount())
+        itemsize = np.dtype(dtype).itemsize
+        rows = np.frombuffer(ptr, dtype=dtype).reshape(
+            qimg.height(), qimg.bytesPerLine() // itemsize
+        )
+        arr = rows[:, : qimg.width() * channels]
+        if channels > 1:
+            arr = arr.reshape(qimg.height(), qimg.width(), channels)
+        return arr, is_bgr
+
+    # ─── Texture streaming ──────────────────────────────────────────────
+    def _upload_pending(self):
+        arr, is_bgr = self._frame_pixels()
+        if arr is None:
+            self._pending_upload = False
+            return
+
+        channels = 1 if arr.ndim == 2 else arr.shape[2]
+        fmt = _NP_GL_FORMATS.get((arr.dtype, channels))
+        if fmt is None:
+            log.warning(
+                f"QtCameraWidget: unsupported frame layout {arr.dtype}×{channels}."
+            )
+            self._pending_upload = False
+            self._release_current_frame()
+            return
+        internal, pix_format, pix_type = fmt
+        if is_bgr and channels == 3:
+            pix_format = gl.GL_BGR
+        elif is_bgr and channels == 4:
+            pix_format = gl.GL_BGRA
+
+        arr = np.ascontiguousarray(arr)
+        h, w = arr.shape[:2]
+        nbytes = arr.nbytes
+
+        gl.glBindTexture(gl.GL_TEXTURE_2D, self._texture)
+        gl.glPixelStorei(gl.GL_UNPACK_ALIGNMENT, 1)
+        if self._tex_key != (w, h, internal):
+            gl.glTexImage2D(
+                gl.GL_TEXTURE_2D, 0, internal, w, h, 0, pix_format, pix_type, None
+            )
+            self._tex_key = (w, h, internal)
+
+        # Stream through the next PBO: orphan its storage, copy the pixels in
+        # and let the driver DMA them into the texture asynchronously.
+        pbo = self._pbos[self._pbo_index]
+        self._pbo_index = (self._pbo_index + 1) % len(self._pbos)
+        gl.glBindBuffer(gl.GL_PIXEL_UNPACK_BUFFER, pbo)
+        gl.glBufferData(gl.GL_PIXEL_UNPACK_BUFFER, nbytes, None, gl.GL_STREAM_DRAW)
+        ptr = gl.glMapBufferRange(
+            gl.GL_PIXEL_UNPACK_BUFFER,
+            0,
+            nbytes,
+            gl.GL_MAP_WRITE_BIT | gl.GL_MAP_INVALIDATE_BUFFER_BIT,
+        )
+        if ptr:
+            ctypes.memmove(ptr, arr.ctypes.data, nbytes)
+            gl.glUnmapBuffer(gl.GL_PIXEL_UNPACK_BUFFER)
+            gl.glTexSubImage2D(
+                gl.GL_TEXTURE_2D, 0, 0, 0, w, h, pix_format, pix_type,
+                ctypes.c_void_p(0),
+            )
+            gl.glBindBuffer(gl.GL_PIXEL_UNPACK_BUFFER, 0)
+        else:
+            gl.glBindBuffer(gl.GL_PIXEL_UNPACK_BUFFER, 0)
+            gl.glTexSubImage2D(
+                gl.GL_TEXTURE_2D, 0, 0, 0, w, h, pix_format, pix_type, arr
+            )
+        gl.glBindTexture(gl.GL_TEXTURE_2D, 0)
+
+        self._tex_size = (w, h)
+        self._mono = channels == 1
+        self._pending_upload = False
+
+        # The texture now owns a copy of the pixels; hand the buffer back
+        self._current_qimage = None
+        self._release_current_frame()
+
+    # ─── Painting ───────────────────────────────────────────────────────
     def paintGL(self):
         """
-        Called whenever the widget needs to be repainted. If we have a QImage,
-        draw it scaled to fit while preserving aspect ratio. Otherwise, fill
-        background with black. Using QOpenGLWidget means drawing is hardware
-        accelerated via OpenGL.
+        Upload the newest frame (if any) and draw the textured quad scaled to
+        fit while preserving aspect ratio, with the current zoom/pan applied.
         """
+        t0 = time.perf_counter()
+        try:
+            if self._gl_ok:
+                self._paint_gl()
+            else:
+                self._paint_fallback()
+        finally:
+            telemetry.record("ui.paint", time.perf_counter() - t0)
+
+    def _paint_gl(self):
+        dpr = self.devicePixelRatioF()
+        gl.glViewport(0, 0, int(self.width() * dpr), int(self.height() * dpr))
+        gl.glClear(gl.GL_COLOR_BUFFER_BIT)
+
+        if self._pending_upload:
+            self._upload_pending()
+        if self._tex_size is None:
+            return
+
+        sx, sy = self._fit_scale()
+        gl.glUseProgram(self._program)
+        gl.glUniform2f(self._uniforms["u_scale"], sx * self._zoom, sy * self._zoom)
+        gl.glUniform2f(self._uniforms["u_offset"], self._pan[0], self._pan[1])
+        gl.glUniform1i(self._uniforms["u_tex"], 0)
+        gl.glUniform1f(self._uniforms["u_low"], self._low)
+        gl.glUniform1f(self._uniforms["u_high"], self._high)
+        gl.glUniform1i(self._uniforms["u_mono"], int(self._mono))
+
+        gl.glActiveTexture(gl.GL_TEXTURE0)
+        gl.glBindTexture(gl.GL_TEXTURE_2D, self._texture)
+        gl.glBindVertexArray(self._vao)
+        gl.glDrawArrays(gl.GL_TRIANGLE_STRIP, 0, 4)
+        gl.glBindVertexArray(0)
+        gl.glBindTexture(gl.GL_TEXTURE_2D, 0)
+        gl.glUseProgram(0)
+
+        if self._lines or self._rect or self._line_start is not None:
+            self._paint_overlay()
+
+    def _paint_fallback(self):
         painter = QPainter(self)
         painter.fillRect(self.rect(), Qt.black)
-
         if self._current_qimage:
-            # Scale the image to fit this widget, preserving aspect ratio
             scaled = self._current_qimage.scaled(
-                self.size(), Qt.KeepAspectRatio, Qt.SmoothTransformation
+                self.size(), Qt.KeepAspectRatio, Qt.FastTransformation
             )
-            # Center the image
             x = (self.width() - scaled.width()) // 2
             y = (self.height() - scaled.height()) // 2
             painter.drawImage(x, y, scaled)
+        painter.end()
+
+    def _fit_scale(self):
+        """Quad scale (NDC) that letterboxes the image into the widget."""
+        w, h = self._tex_size
+        ww, wh = max(self.width(), 1), max(self.height(), 1)
+        img_aspect = w / h
+        widget_aspect = ww / wh
+        if img_aspect > widget_aspect:
+            return 1.0, widget_aspect / img_aspect
+        return img_aspect / widget_aspect, 1.0
+
+    # ─── Line ROIs / capture rectangle ──────────────────────────────────
+    def set_draw_mode(self, mode):
+        """Mouse drawing: ``"line"`` ROIs, a ``"rect"`` capture region or ``None`` (pan)."""
+        self._draw_mode = mode if mode in ("line", "rect") else None
+        self._line_start = self._line_end = None
+        self.setCursor(Qt.CrossCursor if self._draw_mode else Qt.ArrowCursor)
+        self.update()
+
+    def line_rois(self):
+        return list(self._lines)
+
+    def set_line_rois(self, lines):
+        self._lines = [tuple(map(tuple, line)) for line in lines]
+        self.update()
+        self.lines_changed.emit(self.line_rois())
+
+    def clear_line_rois(self):
+        self.set_line_rois([])
+
+    def set_capture_rect(self, rect):
+        """Outline ``(x, y, w, h)`` (image pixels) on the view; None hides it."""
+        self._rect = tuple(rect) if rect else None
+        self.update()
+
+    def _image_to_widget(self, u, v):
+        """Image pixel (u, v) → widget coordinates, with the current zoom/pan."""
+        w, h = self._tex_size
+        sx, sy = self._fit_scale()
+        x_ndc = (2.0 * u / w - 1.0) * sx * self._zoom + self._pan[0]
+        y_ndc = (1.0 - 2.0 * v / h) * sy * self._zoom + self._pan[1]
+        return QPointF(
+            (x_ndc + 1.0) * 0.5 * self.width(), (1.0 - y_ndc) * 0.5 * self.height()
+        )
+
+    def _widget_to_image(self, pos):
+        """Widget position → image pixel (u, v), clamped to the image."""
+        w, h = self._tex_size
+        sx, sy = self._fit_scale()
+        x_ndc, y_ndc = self._to_ndc(pos)
+        u = ((x_ndc - self._pan[0]) / (sx * self._zoom) + 1.0) * 0.5 * w
+        v = (1.0 - (y_ndc - self._pan[1]) / (sy * self._zoom)) * 0.5 * h
+        return (min(max(u, 0.0), w - 1.0), min(max(v, 0.0), h - 1.0))
+
+    def _paint_overlay(self):
+        painter = QPainter(self)
+        painter.setRenderHint(QPainter.Antialiasing)
+        drawing_rect = self._draw_mode == "rect" and self._line_start is not None
+        if self._rect is not None or drawing_rect:
+            if drawing_rect:
+                (x0, y0), (x1, y1) = self._line_start, self._line_end
+            else:
+                x, y, w, h = self._rect
+                x0, y0, x1, y1 = x, y, x + w, y + h
+            painter.setPen(QPen(QColor(80, 255, 80), 2, Qt.DashLine))
+            painter.setBrush(Qt.NoBrush)
+            corners = self._image_to_widget(x0, y0), self._image_to_widget(x1, y1)
+            painter.drawRect(QRectF(*corners).normalized())
 
+        lines = list(self._lines)
+        if self._draw_mode == "line" and self._line_start is not None:
+            lines.append((self._line_start, self._line_end))
+        for n, (p0, p1) in enumerate(lines):
+            pen = QPen(_LINE_COLORS[n % len(_LINE_COLORS)], 2)
+            if n >= len(self._lines):
+                pen.setStyle(Qt.DashLine)
+            painter.setPen(pen)
+            a, b = self._image_to_widget(*p0), self._image_to_widget(*p1)
+            painter.drawLine(a, b)
+            painter.drawText(b + QPointF(4, -4), str(n + 1))
         painter.end()
+
+    # ─── Display range / view ───────────────────────────────────────────
+    def set_display_range(self, low, high):
+        """
+        Contrast-stretch texture values in ``[low, high]`` (fractions of the
+        full scale, e.g. 0–4095/65535 for 12-bit data in a 16-bit frame).
+        """
+        if high <= low:
+            log.warning(f"Display range must have low < high. Received: {low}, {high}")
+            return
+        self._low = float(low)
+        self._high = float(high)
+        self.update()
+
+    def reset_view(self):
+        self._zoom = 1.0
+        self._pan = [0.0, 0.0]
+        self.update()
+
+    def _clamp_pan(self):
+        # Do not let the image leave the widget entirely
+        limit = max(self._zoom - 1.0, 0.0) + 1.0
+        self._pan[0] = min(max(self._pan[0], -limit), limit)
+        self._pan[1] = min(max(self._pan[1], -limit), limit)
+
+    def _to_ndc(self, pos):
+        return (
+            2.0 * pos.x() / max(self.width(), 1) - 1.0,
+            1.0 - 2.0 * pos.y() / max(self.height(), 1),
+        )
+
+    def wheelEvent(self, event):
+        if self._tex_size is None:
+            return
+        steps = event.angleDelta().y() / 120.0
+        new_zoom = min(max(self._zoom * (1.25 ** steps), MIN_ZOOM), MAX_ZOOM)
+        if new_zoom == self._zoom:
+            return
+        # Keep the point under the cursor fixed
+        cx, cy = self._to_ndc(event.pos())
+        ratio = new_zoom / self._zoom
+        self._pan[0] = cx - (cx - self._pan[0]) * ratio
+        self._pan[1] = cy - (cy - self._pan[1]) * ratio
+        self._zoom = new_zoom
+        if self._zoom == MIN_ZOOM:
+            self._pan = [0.0, 0.0]
+        self._clamp_pan()
+        self.update()
+
+    def mousePressEvent(self, event):
+        if self._draw_mode and self._tex_size is not None:
+            if event.button() == Qt.LeftButton:
+                self._line_start = self._line_end = self._widget_to_image(event.pos())
+            elif self._draw_mode == "line" and event.button() == Qt.RightButton and self._lines:
+                self.set_line_rois(self._lines[:-1])
+            return
+        if event.button() == Qt.LeftButton:
+            self._drag_pos = event.pos()
+        super().mousePressEvent(event)
+
+    def mouseMoveEvent(self, event):
+        if self._line_start is not None:
+            self._line_end = self._widget_to_image(event.pos())
+            self.update()
+            return
+        if self._drag_pos is not None and self._zoom > MIN_ZOOM:
+            dx = 2.0 * (event.pos().x() - self._drag_pos.x()) / max(self.width(), 1)
+            dy = -2.0 * (event.pos().y() - self._drag_pos.y()) / max(self.height(), 1)
+            self._pan[0] += dx
+            self._pan[1] += dy
+            self._drag_pos = event.pos()
+            self._clamp_pan()
+            self.update()
+        super().mouseMoveEvent(event)
+
+    def mouseReleaseEvent(self, event):
+        if self._line_start is not None and event.button() == Qt.LeftButton:
+            p0, p1 = self._line_start, self._widget_to_image(event.pos())
+            self._line_start = self._line_end = None
+            if self._draw_mode == "rect":
+                x, y = min(p0[0], p1[0]), min(p0[1], p1[1])
+                w, h = abs(p1[0] - p0[0]), abs(p1[1] - p0[1])
+                if w >= MIN_LINE_LENGTH and h >= MIN_LINE_LENGTH:
+                    self.set_draw_mode(None)
+                    self.set_capture_rect((x, y, w, h))
+                    self.rect_drawn.emit((int(x), int(y), int(round(w)), int(round(h))))
+                else:
+                    self.update()
+                return
+            if np.hypot(p1[0] - p0[0], p1[1] - p0[1]) >= MIN_LINE_LENGTH:
+                self.set_line_rois(self._lines + [(p0, p1)])
+            else:
+                self.update()
+            return
+        if event.button() == Qt.LeftButton:
+            self._drag_pos = None
+        super().mouseReleaseEvent(event)
+
+    def mouseDoubleClickEvent(self, event):
+        if self._draw_mode:
+            return
+        self.reset_view()
+        super().mouseDoubleClickEvent(event)
@@ -0,0 +1,267 @@
+# prim_app/ui/console_log.py
+
+import collections
+import logging
+
+from PyQt5.QtWidgets import (
+    QWidget,
+    QVBoxLayout,
+    QHBoxLayout,
+    QListView,
+    QCheckBox,
+    QPushButton,
+    QLabel,
+    QAbstractItemView,
+    QApplication,
+)
+from PyQt5.QtCore import Qt, QTimer, QAbstractListModel, QModelIndex
+from PyQt5.QtGui import QFontDatabase, QColor, QKeySequence
+
+from utils.config import (
+    CONSOLE_MAX_LINES,
+    CONSOLE_MAX_LINES_PER_TICK,
+    CONSOLE_SOURCES,
+    CONSOLE_LOG_LEVEL,
+    UI_REFRESH_HZ,
+)
+
+log = logging.getLogger(__name__)
+
+# Logger name prefix → console source (anything else is "app")
+_SOURCE_PREFIXES = (
+    ("threads.serial", "serial"),
+    ("threads.sdk_camera", "camera"),
+    ("threads.camera", "camera"),
+    ("threads.preview", "camera"),
+    ("threads.diameter", "camera"),
+    ("ui.canvas.qtcamera", "camera"),
+    ("threads.frame_writer", "recorder"),
+    ("recording_manager", "recorder"),
+    ("frame_sync", "recorder"),
+    ("pretrigger", "recorder"),
+    ("writers", "recorder"),
+)
+
+# Entry kinds; the payload is only turned into text when a row is painted
+_SAMPLE, _RECORD, _TEXT = range(3)
+
+_LEVEL_COLORS = {
+    logging.WARNING: QColor(230, 160, 40),
+    logging.ERROR: QColor(230, 70, 70),
+    logging.CRITICAL: QColor(230, 70, 70),
+}
+
+
+def source_for_logger(name):
+    for prefix, source in _SOURCE_PREFIXES:
+        if name.startswith(prefix):
+            return source
+    return "app"
+
+
+class ConsoleLogModel(QAbstractListModel):
+    """
+    Ring of at most ``max_lines`` console entries.
+
+    Producers (any thread) :meth:`post` raw entries into a bounded pending
+    queue; :meth:`flush` moves them into the model in one insert per UI tick.
+    Entries of disabled sources are dropped in :meth:`post`, and text is only
+    formatted in :meth:`data` for the rows a view actually paints.
+    """
+
+    def __init__(self, max_lines=CONSOLE_MAX_LINES, parent=None):
+        super().__init__(parent)
+        self.max_lines = max(1, int(max_lines))
+        self._rows = []  # (source, kind, payload)
+        self._pending = collections.deque(maxlen=self.max_lines)
+        self._enabled = set(CONSOLE_SOURCES)
+        self._formatter = logging.Formatter(
+            "%(asctime)s %(levelname)s [%(name)s] %(message)s", "%H:%M:%S"
+        )
+
+    # ─── Producers ──────────────────────────────────────────────────────
+    def source_enabled(self, source):
+        return source in self._enabled
+
+    def post(self, source, kind, payload):
+        if source in self._enabled:
+            self._pending.append((source, kind, payload))
+
+    def post_text(self, source, text):
+        self.post(source, _TEXT, text)
+
+    def post_samples(self, idx, t, p):
+        """Queue one UI tick of serial samples (numpy arrays), newest last."""
+        if "serial" not in self._enabled or not len(t):
+            return
+        start = max(0, len(t) - CONSOLE_MAX_LINES_PER_TICK)
+        if start:
+            self._pending.append(("serial", _TEXT, f"... {start} earlier samples not shown"))
+        for i in range(start, len(t)):
+            self._pending.append(("serial", _SAMPLE, (int(idx[i]), float(t[i]), float(p[i]))))
+
+    # ─── Filters ────────────────────────────────────────────────────────
+    def set_source_enabled(self, source, enabled):
+        """Enable/disable a source; disabling also removes its existing lines."""
+        if enabled:
+            self._enabled.add(source)
+            return
+        self._enabled.discard(source)
+        self.beginResetModel()
+        self._rows = [row for row in self._rows if row[0] != source]
+        self._pending = collections.deque(
+            (row for row in self._pending if row[0] != source), maxlen=self.max_lines
+        )
+        self.endResetModel()
+
+    # ─── Consumer (GUI thread) ──────────────────────────────────────────
+    def flush(self):
+        """Move pending entries into the model; returns the number added."""
+        batch = []
+        try:
+            while True:
+                batch.append(self._pending.popleft())
+        except IndexError:
+            pass
+        if not batch:
+            return 0
+        batch = batch[-self.max_lines :]
+
+        excess = len(self._rows) + len(batch) - self.max_lines
+        if excess > 0:
+            self.beginRemoveRows(QModelIndex(), 0, excess - 1)
+            del self._rows[:excess]
+            self.endRemoveRows()
+
+        first = len(self._rows)
+        self.beginInsertRows(QModelIndex(), first, first + len(batch) - 1)
+        self._rows.extend(batch)
+        self.endInsertRows()
+        return len(batch)
+
+    def clear(self):
+        self.beginResetModel()
+        self._rows = []
+        self._pending.clear()
+        self.endResetModel()
+
+    # ─── QAbstractListModel ─────────────────────────────────────────────
+    def rowCount(self, parent=QModelIndex()):
+        return 0 if parent.isValid() else len(self._rows)
+
+    def data(self, index, role=Qt.DisplayRole):
+        if not index.isValid() or index.row() >= len(self._rows):
+            return None
+        source, kind, payload = self._rows[index.row()]
+        if role == Qt.DisplayRole:
+            if kind == _SAMPLE:
+                idx, t, p = payload
+                return f"PRIM Data: Idx={idx}, Time={t:.3f}s, P={p:.2f}"
+            if kind == _RECORD:
+                return self._formatter.format(payload)
+            return payload
+        if role == Qt.ForegroundRole and kind == _RECORD:
+            return _LEVEL_COLORS.get(payload.levelno)
+        return None
+
+    def text_of_rows(self, rows):
+        return "\n".join(
+            self.data(self.index(r), Qt.DisplayRole) or "" for r in sorted(rows)
+        )
+
+
+class ConsoleLogHandler(logging.Handler):
+    """Routes log records into a ConsoleLogModel (safe from any thread)."""
+
+    def __init__(self, model, level=CONSOLE_LOG_LEVEL):
+        super().__init__(level)
+        self.model = model
+
+    def emit(self, record):
+        source = source_for_logger(record.name)
+        # Checked before the record is kept, so filtered lines cost nothing
+        if self.model.source_enabled(source):
+            self.model.post(source, _RECORD, record)
+
+
+class ConsoleLogWidget(QWidget):
+    """
+    Console dock contents: per-source filter checkboxes, a uniform-row list
+    view over :class:`ConsoleLogModel` and follow/clear controls.  Pending
+    lines are flushed once per UI tick while the widget is visible.
+    """
+
+    def __init__(self, max_lines=CONSOLE_MAX_LINES, parent=None):
+        super().__init__(parent)
+        self.model = ConsoleLogModel(max_lines, self)
+
+        layout = QVBoxLayout(self)
+        layout.setContentsMargins(3, 3, 3, 3)
+        layout.setSpacing(4)
+
+        bar = QHBoxLayout()
+        bar.addWidget(QLabel("Show:"))
+        self.source_checks = {}
+        for source in CONSOLE_SOURCES:
+            cb = QCheckBox(source.capitalize())
+            cb.setChecked(True)
+            cb.toggled.connect(
+                lambda checked, s=source: self.model.set_source_enabled(s, checked)
+            )
+            bar.addWidget(cb)
+            self.source_checks[source] = cb
+        bar.addStretch()
+        self.follow_cb = QCheckBox("Follow")
+        self.follow_cb.setChecked(True)
+        bar.addWidget(self.follow_cb)
+        clear_btn = QPushButton("Clear")
+        clear_btn.clicked.connect(self.model.clear)
+        bar.addWidget(clear_btn)
+        layout.addLayout(bar)
+
+        self.view = QListView()
+        self.view.setModel(self.model)
+        self.view.setUniformItemSizes(True)
+        self.view.setSelectionMode(QAbstractItemView.ExtendedSelection)
+        self.view.setFont(QFontDatabase.systemFont(QFontDatabase.FixedFont))
+        layout.addWidget(self.view)
+
+        self.handler = ConsoleLogHandler(self.model)
+
+        self._timer = QTimer(self)
+        self._timer.setInterval(max(1, int(1000 / max(1, UI_REFRESH_HZ))))
+        self._timer.timeout.connect(self._on_tick)
+
+    def install(self, logger=None):
+        """Attach the console's logging handler (to the root logger by default)."""
+        (logger or logging.getLogger()).addHandler(self.handler)
+
+    def uninstall(self, logger=None):
+        (logger or logging.getLogger()).removeHandler(self.handler)
+
+    def append_samples(self, idx, t, p):
+        self.model.post_samples(idx, t, p)
+
+    def append_text(self, text, source="app"):
+        self.model.post_text(source, text)
+
+    def showEvent(self, event):
+        super().showEvent(event)
+        self._on_tick()
+        self._timer.start()
+
+    def hideEvent(self, event):
+        self._timer.stop()
+        super().hideEvent(event)
+
+    def _on_tick(self):
+        if self.model.flush() and self.follow_cb.isChecked():
+            self.view.scrollToBottom()
+
+    def keyPressEvent(self, event):
+        if event.matches(QKeySequence.Copy):
+            rows = [i.row() for i in self.view.selectionModel().selectedIndexes()]
+            if rows:
+                QApplication.clipboard().setText(self.model.text_of_rows(rows))
+            return
+        super().keyPressEvent(event)
@@ -1,7 +1,7 @@
 import logging
 import math
 
-from PyQt5.QtCore import Qt
+from PyQt5.QtCore import Qt, pyqtSignal
 from PyQt5.QtWidgets import (
     QWidget,
     QFormLayout,
@@ -11,18 +11,39 @@ from PyQt5.QtWidgets import (
     QComboBox,
     QSlider,
     QHBoxLayout,
+    QSpinBox,
+    QPushButton,
+    QInputDialog,
 )
 
-from imagingcontrol4 import IC4Exception
+from threads.camera_properties import PropertyCache, PropertyWriter, save_profile
+from utils.config import PREVIEW_MODES, CAMERA_BINNING_CHOICES, CAMERA_ROI_MAX_FPS
 
 log = logging.getLogger(__name__)
 
 
 class CameraControlPanel(QWidget):
+    # Preview conversion settings for SDKCameraThread.set_preview_settings():
+    # {"mode", "bit_depth", "window"}.  Display only; allowed while recording.
+    preview_settings_changed = pyqtSignal(dict)
+    # Capture ROI for SDKCameraThread.set_capture_roi(): {"x", "y", "width",
+    # "height", "binning", "max_frame_rate"} in sensor pixels.  Applying it
+    # restarts the camera, so it is blocked while recording.
+    capture_roi_requested = pyqtSignal(dict)
+    # True: the next drag on the camera view draws the capture ROI
+    roi_draw_requested = pyqtSignal(bool)
+    # Name of a camera profile just written to CAMERA_PROFILES_DIR
+    profile_saved = pyqtSignal(str)
+
     def __init__(self, parent=None):
         super().__init__(parent)
         self.grabber = None
+        # Cached property nodes (SDKCameraThread.property_cache if set before
+        # _on_grabber_ready) and the worker that applies changes off this thread
+        self.property_cache = None
+        self._writer = None
         self.is_recording = False
+        self._pending_roi = None  # (x, y, w, h) sensor px; None = full sensor
         self._exp_scale = 1
         self._gain_scale = 1
 
@@ -92,31 +113,204 @@ class CameraControlPanel(QWidget):
         self.pf_combo.currentIndexChanged.connect(self._on_pf_changed)
         self.layout.addRow(self.pf_label, self.pf_combo)
 
+        # ─── Preview display range (>8-bit formats) ─────────────────────
+        self.preview_mode_combo = QComboBox()
+        mode_labels = {
+            "bitdepth": "Fixed bit depth",
+            "percentile": "Auto (percentile)",
+            "manual": "Manual window",
+        }
+        for mode in PREVIEW_MODES:
+            self.preview_mode_combo.addItem(mode_labels.get(mode, mode), mode)
+        self.preview_mode_combo.setEnabled(False)
+        self.preview_mode_combo.currentIndexChanged.connect(
+            self._on_preview_settings_changed
+        )
+        self.layout.addRow(QLabel("Preview Range:"), self.preview_mode_combo)
+
+        self.preview_bits_spin = QSpinBox()
+        self.preview_bits_spin.setRange(8, 16)
+        self.preview_bits_spin.setSuffix(" bit")
+        self.preview_bits_spin.setEnabled(False)
+        self.preview_bits_spin.valueChanged.connect(self._on_preview_settings_changed)
+        self.layout.addRow(QLabel("Preview Bit Depth:"), self.preview_bits_spin)
+
+        self.preview_low_spin = QSpinBox()
+        self.preview_high_spin = QSpinBox()
+        for spin in (self.preview_low_spin, self.preview_high_spin):
+            spin.setRange(0, 65535)
+            spin.setEnabled(False)
+            spin.valueChanged.connect(self._on_preview_settings_changed)
+        self.preview_high_spin.setValue(65535)
+        win_row = QWidget()
+        win_layout = QHBoxLayout(win_row)
+        win_layout.setContentsMargins(0, 0, 0, 0)
+        win_layout.addWidget(self.preview_low_spin)
+        win_layout.addWidget(QLabel("–"))
+        win_layout.addWidget(self.preview_high_spin)
+        self.layout.addRow(QLabel("Preview Window:"), win_row)
+
+        # ─── Capture ROI / binning (applied by restarting the camera) ───
+        self.binning_combo = QComboBox()
+        for b in CAMERA_BINNING_CHOICES:
+            self.binning_combo.addItem(f"{b}×{b}", b)
+        self.binning_combo.setEnabled(False)
+        self.layout.addRow(QLabel("Binning:"), self.binning_combo)
+
+        self.roi_label = QLabel("Full sensor")
+        self.layout.addRow(QLabel("Capture ROI:"), self.roi_label)
+
+        self.draw_roi_btn = QPushButton("Draw ROI")
+        self.draw_roi_btn.setCheckable(True)
+        self.draw_roi_btn.setToolTip("Drag a rectangle on the camera view")
+        self.draw_roi_btn.toggled.connect(self.roi_draw_requested)
+        self.full_sensor_btn = QPushButton("Full Sensor")
+        self.full_sensor_btn.clicked.connect(lambda: self.set_pending_roi(None))
+        self.apply_roi_btn = QPushButton("Apply")
+        self.apply_roi_btn.setToolTip("Restart the camera with this ROI and binning")
+        self.apply_roi_btn.clicked.connect(self._on_apply_roi)
+        roi_row = QWidget()
+        roi_layout = QHBoxLayout(roi_row)
+        roi_layout.setContentsMargins(0, 0, 0, 0)
+        for btn in (self.draw_roi_btn, self.full_sensor_btn, self.apply_roi_btn):
+            btn.setEnabled(False)
+            roi_layout.addWidget(btn)
+        self.layout.addRow(roi_row)
+
+        self.max_fps_cb = QCheckBox("Maximum frame rate for the ROI")
+        self.max_fps_cb.setChecked(CAMERA_ROI_MAX_FPS)
+        self.max_fps_cb.setEnabled(False)
+        self.layout.addRow(self.max_fps_cb)
+
+        self.geometry_label = QLabel("")
+        self.layout.addRow(self.geometry_label)
+
+        self.save_profile_btn = QPushButton("Save Profile…")
+        self.save_profile_btn.setToolTip(
+            "Save exposure, gain and frame rate as a camera profile"
+        )
+        self.save_profile_btn.setEnabled(False)
+        self.save_profile_btn.clicked.connect(self._on_save_profile)
+        self.layout.addRow(self.save_profile_btn)
+
     def set_recording_state(self, recording):
         self.is_recording = recording
         log.debug(f"CameraControlPanel: is_recording set to {self.is_recording}")
+        for w in (
+            self.binning_combo,
+            self.draw_roi_btn,
+            self.full_sensor_btn,
+            self.apply_roi_btn,
+            self.max_fps_cb,
+        ):
+            w.setEnabled(not recording and self.grabber is not None)
+
+    # ─── Capture ROI ────────────────────────────────────────────────────
+    def set_pending_roi(self, roi):
+        """ROI (x, y, w, h) in sensor pixels to apply next; None = full sensor."""
+        self._pending_roi = tuple(int(v) for v in roi) if roi else None
+        self.draw_roi_btn.setChecked(False)
+        if self._pending_roi:
+            x, y, w, h = self._pending_roi
+            self.roi_label.setText(f"{w}×{h} at ({x}, {y}) — not applied")
+        else:
+            self.roi_label.setText("Full sensor — not applied")
+
+    def set_capture_geometry(self, geometry):
+        """Show the geometry SDKCameraThread applied (see its capture_geometry)."""
+        if not geometry:
+            self.geometry_label.setText("")
+            return
+        b = geometry.get("binning", 1)
+        x, y = geometry.get("x", 0), geometry.get("y", 0)
+        w, h = geometry.get("width", 0), geometry.get("height", 0)
+        sensor = (geometry.get("sensor_width"), geometry.get("sensor_height"))
+        full = sensor[0] is not None and (x, y, w, h) == (0, 0) + sensor
+        self._pending_roi = None if full else (x, y, w, h)
+        self.roi_label.setText("Full sensor" if full else f"{w}×{h} at ({x}, {y})")
+        idx = self.binning_combo.findData(b)
+        if idx >= 0:
+            self.binning_combo.setCurrentIndex(idx)
+        text = f"Output {w // max(b, 1)}×{h // max(b, 1)} px"
+        if geometry.get("frame_rate") is not None:
+            text += (
+                f", {geometry['frame_rate']:.1f} fps "
+                f"(max {geometry.get('max_frame_rate') or 0:.1f})"
+            )
+        self.geometry_label.setText(text)
+
+    def _on_apply_roi(self):
+        if self.is_recording:
+            log.warning("Blocked capture ROI change during recording")
+            return
+        roi = {
+            "binning": self.binning_combo.currentData() or 1,
+            "max_frame_rate": self.max_fps_cb.isChecked(),
+            "x": 0,
+            "y": 0,
+            "width": None,
+            "height": None,
+        }
+        if self._pending_roi:
+            roi["x"], roi["y"], roi["width"], roi["height"] = self._pending_roi
+        self.capture_roi_requested.emit(roi)
+
+    def set_preview_settings(self, settings):
+        """Show the converter's current settings without re-emitting them."""
+        widgets = (
+            self.preview_mode_combo,
+            self.preview_bits_spin,
+            self.preview_low_spin,
+            self.preview_high_spin,
+        )
+        for w in widgets:
+            w.blockSignals(True)
+        idx = self.preview_mode_combo.findData(settings.get("mode"))
+        if idx >= 0:
+            self.preview_mode_combo.setCurrentIndex(idx)
+        self.preview_bits_spin.setValue(int(settings.get("bit_depth", 8)))
+        low, high = settings.get("window", (0, 65535))
+        self.preview_low_spin.setValue(int(low))
+        self.preview_high_spin.setValue(int(high))
+        for w in widgets:
+            w.blockSignals(False)
+        self._update_preview_controls()
+
+    def _update_preview_controls(self):
+        mode = self.preview_mode_combo.currentData()
+        self.preview_mode_combo.setEnabled(True)
+        self.preview_bits_spin.setEnabled(mode == "bitdepth")
+        self.preview_low_spin.setEnabled(mode == "manual")
+        self.preview_high_spin.setEnabled(mode == "manual")
+
+    def _on_preview_settings_changed(self, *_):
+        self._update_preview_controls()
+        low = self.preview_low_spin.value()
+        high = self.preview_high_spin.value()
+        settings = {
+            "mode": self.preview_mode_combo.currentData(),
+            "bit_depth": self.preview_bits_spin.value(),
+        }
+        if high > low:
+            settings["window"] = (low, high)
+        self.preview_settings_changed.emit(settings)
 
     def _setup_float_control(self, prop_id, spinbox, decimals=2, slider=None):
         log.info(f"CameraControlPanel: Looking for property {prop_id}")
 
         try:
-            prop = self.grabber.device_property_map.find_float(prop_id)
-            if not prop:
+            prop = self.property_cache.node(prop_id)
+            rng = self.property_cache.range(prop_id)
+            if not prop or rng is None:
                 log.warning(f"CameraControlPanel: Property {prop_id} not found.")
                 return 1
 
-            min_val = prop.minimum
-            max_val = prop.maximum
+            min_val, max_val, step = rng
             cur_val = prop.value
-            step = 0.1  # Default fallback
-
-            try:
-                step = prop.increment
-                if step <= 0:
-                    raise ValueError()
-            except Exception:
+            if not step or step <= 0:
                 step = (max_val - min_val) / 100.0
 
+            spinbox.blockSignals(True)
             spinbox.setRange(min_val, max_val)
             spinbox.setSingleStep(step)
 
@@ -125,20 +319,21 @@ class CameraControlPanel(QWidget):
             spinbox.setDecimals(min(decimals, 6))
 
             spinbox.setValue(cur_val)
+            spinbox.blockSignals(False)
             spinbox.setEnabled(True)
 
             scale = 1
             if slider is not None:
                 digits = spinbox.decimals()
                 scale = 10**digits
+                slider.blockSignals(True)
                 slider.setRange(int(min_val * scale), int(max_val * scale))
                 slider.setSingleStep(max(1, int(step * scale)))
                 slider.setValue(int(cur_val * scale))
+                slider.blockSignals(False)
                 slider.setEnabled(True)
 
-            log.debug(
-                f"{prop_id}: min={min_val}, max={max_val}, step={step}, value={cur_val}, unit={prop.unit}"
-            )
+            log.debug(f"{prop_id}: min={min_val}, max={max_val}, step={step}, value={cur_val}")
 
             return scale
 
@@ -156,6 +351,10 @@ class CameraControlPanel(QWidget):
             )
             return
 
+        if self.property_cache is None:
+            self.property_cache = PropertyCache(self.grabber.device_property_map)
+        self._start_writer()
+
         self._exp_scale = self._setup_float_control(
             "ExposureTime", self.exposure_spin, decimals=1, slider=self.exposure_slider
         )
@@ -163,19 +362,18 @@ class CameraControlPanel(QWidget):
             "Gain", self.gain_spin, decimals=2, slider=self.gain_slider
         )
 
-        try:
-            ae_node = self.grabber.device_property_map.find_enumeration("ExposureAuto")
-            self.ae_checkbox.setChecked(ae_node.value == "Continuous")
-            self.ae_checkbox.setEnabled(True)
-        except Exception as e:
-            log.warning(f"CameraControlPanel: Failed to init ExposureAuto: {e}")
-
-        try:
-            ag_node = self.grabber.device_property_map.find_enumeration("GainAuto")
-            self.ag_checkbox.setChecked(ag_node.value == "Continuous")
-            self.ag_checkbox.setEnabled(True)
-        except Exception as e:
-            log.warning(f"CameraControlPanel: Failed to init GainAuto: {e}")
+        for name, checkbox in (
+            ("ExposureAuto", self.ae_checkbox),
+            ("GainAuto", self.ag_checkbox),
+        ):
+            value = self.property_cache.get(name)
+            if value is None:
+                log.warning(f"CameraControlPanel: Failed to init {name}")
+                continue
+            checkbox.blockSignals(True)
+            checkbox.setChecked(value == "Continuous")
+            checkbox.blockSignals(False)
+            checkbox.setEnabled(True)
 
         try:
             # Use the generic helper so missing 'increment' does not disable the control
@@ -186,7 +384,8 @@ class CameraControlPanel(QWidget):
             log.warning(f"CameraControlPanel: Failed to init AcquisitionFrameRate: {e}")
 
         try:
-            pf_node = self.grabber.device_property_map.find_enumeration("PixelFormat")
+            pf_node = self.property_cache.node("PixelFormat")
+            self.pf_combo.blockSignals(True)
             self.pf_combo.clear()
             for entry in pf_node.entries:
                 self.pf_combo.addItem(entry.name)
@@ -195,82 +394,147 @@ class CameraControlPanel(QWidget):
                 idx = self.pf_combo.findText(current)
                 if idx >= 0:
                     self.pf_combo.setCurrentIndex(idx)
+            self.pf_combo.blockSignals(False)
             self.pf_combo.setEnabled(True)
         except Exception as e:
             log.warning(f"CameraControlPanel: Failed to init PixelFormat: {e}")
 
+        # Only offer binning factors the camera accepts
+        rng = self.property_cache.range("BinningHorizontal")
+        top = rng[1] if rng else 1
+        current = self.binning_combo.currentData()
+        self.binning_combo.clear()
+        for b in CAMERA_BINNING_CHOICES:
+            if b <= top:
+                self.binning_combo.addItem(f"{b}×{b}", b)
+        idx = self.binning_combo.findData(current)
+        self.binning_combo.setCurrentIndex(max(idx, 0))
+        self.save_profile_btn.setEnabled(True)
+        self.set_recording_state(self.is_recording)
+
+    # ─── Property writes (coalesced on the PropertyWriter thread) ───────
+    def _start_writer(self):
+        if self._writer is not None:
+            self._writer.stop()
+        self._writer = PropertyWriter(self.property_cache)
+        self._writer.property_applied.connect(self._on_property_applied)
+        self._writer.start()
+
+    def release_grabber(self):
+        """Camera stopped: drop the grabber, its cached nodes and the writer."""
+        if self._writer is not None:
+            self._writer.stop()
+            self._writer = None
+        self.grabber = None
+        self.property_cache = None
+        self.save_profile_btn.setEnabled(False)
+
+    def _submit(self, name, value):
+        if self._writer is None:
+            log.warning(f"CameraControlPanel: no camera; {name} not set")
+            return
+        self._writer.submit(name, value)
+
+    def apply_profile(self, properties):
+        """Apply a saved profile to the running camera (one coalesced batch)."""
+        if self.is_recording:
+            log.warning("Blocked camera profile change during recording")
+            return
+        if self._writer is not None and properties:
+            self._writer.submit_batch(properties)
+
+    def _on_property_applied(self, name, value):
+        """Show the value the camera accepted (it may have been clamped)."""
+        controls = {
+            "ExposureTime": (self.exposure_spin, self.exposure_slider, self._exp_scale),
+            "Gain": (self.gain_spin, self.gain_slider, self._gain_scale),
+            "AcquisitionFrameRate": (self.framerate_spin, None, 1),
+        }
+        if name in controls:
+            spin, slider, scale = controls[name]
+            for w in (spin, slider):
+                if w is not None:
+                    w.blockSignals(True)
+            spin.setValue(float(value))
+            if slider is not None:
+                slider.setValue(int(float(value) * scale))
+            for w in (spin, slider):
+                if w is not None:
+                    w.blockSignals(False)
+        elif name in ("ExposureAuto", "GainAuto"):
+            cb = self.ae_checkbox if name == "ExposureAuto" else self.ag_checkbox
+            cb.blockSignals(True)
+            cb.setChecked(value == "Continuous")
+            cb.blockSignals(False)
+
+        if name == "ExposureTime" and self.property_cache is not None:
+            # The frame rate limit follows the exposure time
+            rng = self.property_cache.range("AcquisitionFrameRate")
+            if rng is not None:
+                self.framerate_spin.blockSignals(True)
+                self.framerate_spin.setRange(rng[0], rng[1])
+                self.framerate_spin.blockSignals(False)
+
+    def _on_save_profile(self):
+        if self.property_cache is None:
+            return
+        name, ok = QInputDialog.getText(self, "Save Camera Profile", "Profile name:")
+        name = name.strip()
+        if not ok or not name:
+            return
+        device = None
+        try:
+            device = self.grabber.device_info.model_name
+        except Exception:
+            pass
+        try:
+            save_profile(name, self.property_cache.snapshot(), device=device)
+        except OSError as e:
+            log.error(f"CameraControlPanel: failed to save profile {name!r}: {e}")
+            return
+        self.profile_saved.emit(name)
+
     def _on_exposure_changed(self, new_val):
         if self.is_recording:
             log.warning("Blocked Exposure change during recording")
             return
-        try:
-            node = self.grabber.device_property_map.find_float("ExposureTime")
-            node.value = float(new_val)  # ✅ CORRECT WAY TO SET
-            log.debug(f"ExposureTime set to {node.value} µs")
-            self.exposure_slider.blockSignals(True)
-            self.exposure_slider.setValue(int(float(new_val) * self._exp_scale))
-            self.exposure_slider.blockSignals(False)
-        except Exception as e:
-            log.error(
-                f"CameraControlPanel: failed to set ExposureTime = {new_val}: {e}"
-            )
+        self._submit("ExposureTime", float(new_val))
+        self.exposure_slider.blockSignals(True)
+        self.exposure_slider.setValue(int(float(new_val) * self._exp_scale))
+        self.exposure_slider.blockSignals(False)
 
     def _on_gain_changed(self, new_val):
         if self.is_recording:
             log.warning("Blocked Gain change during recording")
             return
-        try:
-            node = self.grabber.device_property_map.find_float("Gain")
-            node.value = float(new_val)  # ✅ CORRECT
-            self.gain_slider.blockSignals(True)
-            self.gain_slider.setValue(int(float(new_val) * self._gain_scale))
-            self.gain_slider.blockSignals(False)
-        except Exception as e:
-            log.error(f"CameraControlPanel: failed to set Gain = {new_val}: {e}")
+        self._submit("Gain", float(new_val))
+        self.gain_slider.blockSignals(True)
+        self.gain_slider.setValue(int(float(new_val) * self._gain_scale))
+        self.gain_slider.blockSignals(False)
 
     def _on_auto_exposure_toggled(self, state):
         if self.is_recording:
             log.warning("Blocked Auto Exposure toggle during recording")
             return
-        try:
-            node = self.grabber.device_property_map.find_enumeration("ExposureAuto")
-            node.value = "Continuous" if state == Qt.Checked else "Off"
-        except Exception as e:
-            log.error(f"CameraControlPanel: failed to set ExposureAuto: {e}")
+        self._submit("ExposureAuto", "Continuous" if state == Qt.Checked else "Off")
 
     def _on_auto_gain_toggled(self, state):
         if self.is_recording:
             log.warning("Blocked Auto Gain toggle during recording")
             return
-        try:
-            node = self.grabber.device_property_map.find_enumeration("GainAuto")
-            node.value = "Continuous" if state == Qt.Checked else "Off"
-        except Exception as e:
-            log.error(f"CameraControlPanel: failed to set GainAuto: {e}")
+        self._submit("GainAuto", "Continuous" if state == Qt.Checked else "Off")
 
     def _on_framerate_changed(self, new_val):
         if self.is_recording:
             log.warning("Blocked Frame Rate change during recording")
             return
-        try:
-            node = self.grabber.device_property_map.find_float("AcquisitionFrameRate")
-            node.value = float(new_val)  # ✅ FIXED
-        except Exception as e:
-            log.error(
-                f"CameraControlPanel: failed to set AcquisitionFrameRate = {new_val}: {e}"
-            )
+        self._submit("AcquisitionFrameRate", float(new_val))
 
     def _on_pf_changed(self, index):
         if self.is_recording:
             log.warning("Blocked Pixel Format change during recording")
             return
-        try:
-            node = self.grabber.device_property_map.find_enumeration("PixelFormat")
-            new_pf = self.pf_combo.currentText()
-            if new_pf:
-                node.value = new_pf
-        except Exception as e:
-            log.error(
-                f"CameraControlPanel: failed to set PixelFormat = {self.pf_combo.currentText()}: {e}"
-            )
+        new_pf = self.pf_combo.currentText()
+        if new_pf:
+            self._submit("PixelFormat", new_pf)
 
@@ -0,0 +1,121 @@
+# prim_app/ui/control_panels/telemetry_panel.py
+
+import logging
+from PyQt5.QtWidgets import (
+    QWidget,
+    QVBoxLayout,
+    QHBoxLayout,
+    QTableWidget,
+    QTableWidgetItem,
+    QHeaderView,
+    QPushButton,
+    QCheckBox,
+)
+from PyQt5.QtCore import Qt, QTimer
+
+from utils.config import TELEMETRY_PANEL_REFRESH_MS
+from utils.telemetry import telemetry
+
+log = logging.getLogger(__name__)
+
+COLUMNS = ["Metric", "Count", "Rate/s", "Mean (ms)", "p50 (ms)", "p99 (ms)", "Max (ms)"]
+
+
+class TelemetryPanel(QWidget):
+    """
+    Table of the pipeline histograms, counters and gauges from
+    :data:`utils.telemetry.telemetry`.  Refreshes every
+    TELEMETRY_PANEL_REFRESH_MS while visible; hidden it costs nothing.
+    """
+
+    def __init__(self, parent=None):
+        super().__init__(parent)
+        self._last_counts = {}
+        self._last_time = None
+
+        layout = QVBoxLayout(self)
+        layout.setContentsMargins(3, 3, 3, 3)
+        layout.setSpacing(4)
+
+        buttons = QHBoxLayout()
+        self.enabled_cb = QCheckBox("Collect")
+        self.enabled_cb.setToolTip("Record hot-path timings (tiny per-frame cost)")
+        self.enabled_cb.setChecked(telemetry.enabled)
+        self.enabled_cb.toggled.connect(self._on_enabled_toggled)
+        buttons.addWidget(self.enabled_cb)
+        buttons.addStretch()
+        self.reset_btn = QPushButton("Reset")
+        self.reset_btn.clicked.connect(self._on_reset)
+        buttons.addWidget(self.reset_btn)
+        layout.addLayout(buttons)
+
+        self.table = QTableWidget(0, len(COLUMNS))
+        self.table.setHorizontalHeaderLabels(COLUMNS)
+        self.table.verticalHeader().setVisible(False)
+        self.table.setEditTriggers(QTableWidget.NoEditTriggers)
+        self.table.horizontalHeader().setSectionResizeMode(0, QHeaderView.Stretch)
+        layout.addWidget(self.table)
+
+        self._timer = QTimer(self)
+        self._timer.setInterval(TELEMETRY_PANEL_REFRESH_MS)
+        self._timer.timeout.connect(self.refresh)
+
+    def showEvent(self, event):
+        super().showEvent(event)
+        self.refresh()
+        self._timer.start()
+
+    def hideEvent(self, event):
+        self._timer.stop()
+        super().hideEvent(event)
+
+    def _on_enabled_toggled(self, checked):
+        telemetry.enabled = checked
+
+    def _on_reset(self):
+        telemetry.reset()
+        self._last_counts = {}
+        self._last_time = None
+        self.refresh()
+
+    def refresh(self):
+        snap = telemetry.snapshot()
+        now = snap["time"]
+        dt = (now - self._last_time) if self._last_time else None
+        self._last_time = now
+
+        rows = []
+        for name, h in snap["histograms"].items():
+            rows.append(
+                (
+                    name,
+                    h["count"],
+                    self._rate(name, h["count"], dt),
+                    f"{h['mean'] * 1e3:.3f}",
+                    f"{h['p50'] * 1e3:.3f}",
+                    f"{h['p99'] * 1e3:.3f}",
+                    f"{h['max'] * 1e3:.3f}",
+                )
+            )
+        for name, value in snap["counters"].items():
+            rows.append((name, value, self._rate(name, value, dt), "", "", "", ""))
+        for name, value in snap["gauges"].items():
+            rows.append((name, value, "", "", "", "", ""))
+
+        self.table.setRowCount(len(rows))
+        for r, row in enumerate(rows):
+            for c, value in enumerate(row):
+                item = self.table.item(r, c)
+                if item is None:
+                    item = QTableWidgetItem()
+                    if c:
+                        item.setTextAlignment(Qt.AlignRight | Qt.AlignVCenter)
+                    self.table.setItem(r, c, item)
+                item.setText(str(value))
+
+    def _rate(self, name, count, dt):
+        previous = self._last_counts.get(name)
+        self._last_counts[name] = count
+        if previous is None or not dt:
+            return ""
+        return f"{(count - previous) / dt:.1f}"
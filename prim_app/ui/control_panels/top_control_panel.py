@@ -46,12 +46,30 @@ class TopControlPanel(QWidget):
         self.pres_lbl.setStyleSheet("font-size:12pt;font-weight:bold;")
         status_layout.addRow("Current Pressure:", self.pres_lbl)
 
+        # PressureDSP channels (hidden until the first processed block)
+        dsp_box = QGroupBox("Pressure Analysis")
+        dsp_layout = QFormLayout(dsp_box)
+        self.filtered_lbl = QLabel("N/A")
+        self.filtered_lbl.setToolTip("Low-pass filtered pressure")
+        dsp_layout.addRow("Filtered:", self.filtered_lbl)
+        self.mean_lbl = QLabel("N/A")
+        self.mean_lbl.setToolTip("Mean ± SD since connecting or zeroing")
+        dsp_layout.addRow("Mean ± SD:", self.mean_lbl)
+        self.slope_lbl = QLabel("N/A")
+        self.slope_lbl.setToolTip("Rate of change of the filtered pressure")
+        dsp_layout.addRow("Rate:", self.slope_lbl)
+        self.step_lbl = QLabel("None")
+        dsp_layout.addRow("Last Step:", self.step_lbl)
+        self.dsp_box = dsp_box
+        self.dsp_box.setVisible(False)
+
         self.zero_btn = QPushButton("Zero PRIM?")
         self.zero_btn.setEnabled(False)
         self.zero_btn.clicked.connect(self.zero_requested.emit)
         status_layout.addRow(self.zero_btn)
 
         layout.addWidget(status_box, 1)
+        layout.addWidget(dsp_box, 1)
 
     def update_connection_status(self, text: str, connected: bool):
         """
@@ -74,3 +92,15 @@ class TopControlPanel(QWidget):
         self.idx_lbl.setText(str(idx))
         self.time_lbl.setText(f"{t_dev:.2f}")
         self.pres_lbl.setText(f"{p_dev:.2f} mmHg")
+
+    def update_dsp_data(self, row):
+        """Show the newest PressureDSP row (DSP_RECORD_DTYPE)."""
+        self.dsp_box.setVisible(True)
+        self.filtered_lbl.setText(f"{row['lowpass']:.2f} mmHg")
+        self.mean_lbl.setText(f"{row['mean']:.2f} ± {row['std']:.2f} mmHg")
+        self.slope_lbl.setText(f"{row['slope']:+.2f} mmHg/s")
+
+    def show_step(self, t_dev: float, direction: int):
+        """Report a pressure step detected at device time ``t_dev``."""
+        arrow = "↑" if direction > 0 else "↓"
+        self.step_lbl.setText(f"{arrow} at {t_dev:.1f} s")
@@ -0,0 +1,120 @@
+# prim_app/ui/export_dialog.py
+
+import os
+
+from PyQt5.QtWidgets import (
+    QCheckBox,
+    QComboBox,
+    QDialog,
+    QDialogButtonBox,
+    QFileDialog,
+    QFormLayout,
+    QHBoxLayout,
+    QLineEdit,
+    QPushButton,
+    QSpinBox,
+)
+
+from utils.config import (
+    EXPORT_BINNING,
+    EXPORT_DEFAULT_FORMAT,
+    EXPORT_OVERLAY,
+    EXPORT_STEP,
+)
+from writers.stack_export import EXPORT_FORMATS, default_output_path
+
+
+class ExportDialog(QDialog):
+    """
+    Options for exporting one recorded stack: format, time-lapse step,
+    spatial binning, burned-in overlay and the output file.  :meth:`options`
+    returns them as keyword arguments of ``export_stack``.
+    """
+
+    def __init__(self, video_path, parent=None):
+        super().__init__(parent)
+        self.setWindowTitle(f"Export {os.path.basename(video_path)}")
+        self.video_path = video_path
+        self._path_edited = False
+
+        form = QFormLayout(self)
+        self.format_combo = QComboBox()
+        for key, (label, _, _) in EXPORT_FORMATS.items():
+            self.format_combo.addItem(label, key)
+        self.format_combo.setCurrentIndex(
+            max(0, self.format_combo.findData(EXPORT_DEFAULT_FORMAT))
+        )
+        form.addRow("Format:", self.format_combo)
+
+        self.step_spin = QSpinBox()
+        self.step_spin.setRange(1, 10000)
+        self.step_spin.setValue(EXPORT_STEP)
+        self.step_spin.setToolTip("Keep every N-th page (time-lapse); 1 keeps all.")
+        form.addRow("Every N-th page:", self.step_spin)
+
+        self.bin_spin = QSpinBox()
+        self.bin_spin.setRange(1, 16)
+        self.bin_spin.setValue(EXPORT_BINNING)
+        self.bin_spin.setToolTip("Average N×N pixel blocks; 1 keeps full resolution.")
+        form.addRow("Binning:", self.bin_spin)
+
+        self.overlay_check = QCheckBox("Burn in time and pressure")
+        self.overlay_check.setChecked(EXPORT_OVERLAY)
+        form.addRow("", self.overlay_check)
+
+        self.path_edit = QLineEdit()
+        self.path_edit.textEdited.connect(self._on_path_edited)
+        browse = QPushButton("…")
+        browse.setFixedWidth(30)
+        browse.clicked.connect(self._browse)
+        row = QHBoxLayout()
+        row.addWidget(self.path_edit, stretch=1)
+        row.addWidget(browse)
+        form.addRow("Output:", row)
+
+        buttons = QDialogButtonBox(QDialogButtonBox.Ok | QDialogButtonBox.Cancel)
+        buttons.button(QDialogButtonBox.Ok).setText("Export")
+        buttons.accepted.connect(self.accept)
+        buttons.rejected.connect(self.reject)
+        form.addRow(buttons)
+
+        self.format_combo.currentIndexChanged.connect(self._update_default_path)
+        self.step_spin.valueChanged.connect(self._update_default_path)
+        self.bin_spin.valueChanged.connect(self._update_default_path)
+        self._update_default_path()
+        self.resize(520, self.sizeHint().height())
+
+    def _fmt(self):
+        return self.format_combo.currentData()
+
+    def _on_path_edited(self, _text):
+        self._path_edited = True
+
+    def _update_default_path(self, *_):
+        if self._path_edited:
+            # Keep the user's file, but follow the format's extension
+            stem = os.path.splitext(self.path_edit.text())[0]
+            self.path_edit.setText(f"{stem}.{EXPORT_FORMATS[self._fmt()][1]}")
+            return
+        path = default_output_path(
+            self.video_path, self._fmt(), self.step_spin.value(), self.bin_spin.value()
+        )
+        self.path_edit.setText(path)
+
+    def _browse(self):
+        ext = EXPORT_FORMATS[self._fmt()][1]
+        path, _ = QFileDialog.getSaveFileName(
+            self, "Export To", self.path_edit.text(), f"*.{ext}"
+        )
+        if path:
+            self.path_edit.setText(path)
+            self._path_edited = True
+
+    def options(self):
+        return {
+            "out_path": self.path_edit.text().strip() or None,
+            "fmt": self._fmt(),
+            "step": self.step_spin.value(),
+            "binning": self.bin_spin.value(),
+            "overlay": self.overlay_check.isChecked(),
+        }
@@ -0,0 +1,134 @@
+# prim_app/ui/refresh_scheduler.py
+
+import logging
+import time
+
+import numpy as np
+from PyQt5.QtCore import QObject, QTimer, pyqtSignal, pyqtSlot
+from PyQt5.QtGui import QImage
+
+from utils.config import UI_REFRESH_HZ
+from utils.telemetry import telemetry
+from writers.columnar_log import PRESSURE_RECORD_DTYPE
+
+log = logging.getLogger(__name__)
+
+
+class UiRefreshScheduler(QObject):
+    """
+    Rate limiter between the acquisition threads and the live view.
+
+    ``push_block`` (or the per-sample ``push_sample``) and ``push_frame`` are
+    connected to SerialThread.samples_ready and SDKCameraThread.frame_ready.
+    Samples are collected and frames are coalesced (only the newest frame is
+    kept; the one it replaces is released straight away).  Every
+    1 / ``refresh_hz`` s the pending batch goes out on ``samples_ready`` and
+    the latest frame on ``frame_ready``, so the GUI does per-tick rather than
+    per-item work.  The recorder stays connected to the
+    acquisition threads directly and is not affected by this throttling.
+    PressureDSP output (``push_processed``) is batched the same way and goes
+    out on ``processed_ready``.
+
+    ``frame_ready`` follows the CameraFrame convention: every connected slot
+    receives one reference and must release it.
+    """
+
+    # (frameIdx, deviceTime, pressure) numpy arrays of the samples since the
+    # previous tick, oldest first
+    samples_ready = pyqtSignal(object, object, object)
+    # PressureDSP blocks (DSP_RECORD_DTYPE) since the previous tick, as one array
+    processed_ready = pyqtSignal(object)
+    frame_ready = pyqtSignal(QImage, object)
+
+    def __init__(self, refresh_hz=UI_REFRESH_HZ, parent=None):
+        super().__init__(parent)
+        self._blocks = []  # PRESSURE_RECORD_DTYPE blocks since the last tick
+        self._processed = []
+        self._pending_qimage = None
+        self._pending_frame = None
+        self.frames_coalesced = 0
+
+        self._timer = QTimer(self)
+        self._timer.setInterval(max(1, int(1000 / max(1, refresh_hz))))
+        self._timer.timeout.connect(self._on_tick)
+
+    def start(self):
+        self._timer.start()
+
+    def stop(self):
+        self._timer.stop()
+        self._blocks = []
+        self._processed = []
+        self.discard_frame()
+
+    def set_refresh_rate(self, hz):
+        self._timer.setInterval(max(1, int(1000 / max(1, hz))))
+
+    # ─── Producers ──────────────────────────────────────────────────────
+    @pyqtSlot(int, float, float)
+    def push_sample(self, idx, t, p):
+        self._blocks.append(
+            np.array([(idx, t, p, time.time())], dtype=PRESSURE_RECORD_DTYPE)
+        )
+
+    @pyqtSlot(object)
+    def push_block(self, block):
+        """Queue a SerialThread.samples_ready block (structured array)."""
+        if len(block):
+            telemetry.record("queue.samples_to_ui", time.time() - block["hostTime"][-1])
+            self._blocks.append(block)
+
+    @pyqtSlot(object)
+    def push_processed(self, block):
+        """Queue a SerialThread.processed_ready block."""
+        if len(block):
+            self._processed.append(block)
+
+    @pyqtSlot(QImage, object)
+    def push_frame(self, qimg, frame):
+        if frame is not None:
+            telemetry.record("queue.frame_to_ui", time.time() - frame.host_timestamp)
+        previous = self._pending_frame
+        self._pending_qimage = qimg
+        self._pending_frame = frame
+        if previous is not None:
+            self.frames_coalesced += 1
+            previous.release()
+            telemetry.count("ui.frames_coalesced")
+
+    def discard_frame(self):
+        """Drop the frame waiting for the next tick (e.g. when the camera stops)."""
+        frame = self._pending_frame
+        self._pending_qimage = None
+        self._pending_frame = None
+        if frame is not None:
+            frame.release()
+
+    # ─── Tick ───────────────────────────────────────────────────────────
+    def _on_tick(self):
+        if self._blocks:
+            # One concatenation per tick instead of per-sample Python lists
+            blocks, self._blocks = self._blocks, []
+            arr = blocks[0] if len(blocks) == 1 else np.concatenate(blocks)
+            self.samples_ready.emit(
+                arr["frameIdx"].astype(np.int64),
+                arr["deviceTime"].astype(float),
+                arr["pressure"].astype(float),
+            )
+        if self._processed:
+            blocks, self._processed = self._processed, []
+            self.processed_ready.emit(
+                blocks[0] if len(blocks) == 1 else np.concatenate(blocks)
+            )
+
+        if self._pending_qimage is not None:
+            qimg, frame = self._pending_qimage, self._pending_frame
+            self._pending_qimage = None
+            self._pending_frame = None
+            if frame is not None:
+                frame.retain(self.receivers(self.frame_ready))
+            try:
+                self.frame_ready.emit(qimg, frame)
+            finally:
+                if frame is not None:
+                    frame.release()
@@ -0,0 +1,286 @@
+# prim_app/ui/review_dock.py
+
+import logging
+import os
+import time
+
+import numpy as np
+from PyQt5.QtCore import Qt, QTimer, pyqtSignal, pyqtSlot
+from PyQt5.QtGui import QImage, QKeySequence
+from PyQt5.QtWidgets import (
+    QComboBox,
+    QDockWidget,
+    QHBoxLayout,
+    QLabel,
+    QPushButton,
+    QShortcut,
+    QSlider,
+    QSplitter,
+    QVBoxLayout,
+    QWidget,
+)
+
+from threads.camera_frame import CameraFrame
+from threads.frame_prefetcher import FramePrefetcher
+from ui.canvas.pressure_plot_widget import PressurePlotWidget
+from ui.canvas.qtcamera_widget import QtCameraWidget
+from utils.config import REVIEW_PLAYBACK_SPEEDS, UI_REFRESH_HZ
+from writers.recording_index import load_pressure, page_times, recording_base
+
+log = logging.getLogger(__name__)
+
+
+class ReviewDock(QDockWidget):
+    """
+    Frame-accurate review of a finished recording: the stack in a
+    QtCameraWidget next to the recording's pressure (and diameter) trace in a
+    PressurePlotWidget, with one time cursor shared by both.
+
+    Pages come from a :class:`FramePrefetcher` (background reads into an LRU
+    cache).  The slider, the arrow keys (one page) and clicking or dragging
+    in the plot move the cursor; Space plays back at the recorded frame rate
+    times the selected speed, skipping pages the display cannot keep up with.
+    Page times are the paired ``deviceTime`` of the index, interpolated over
+    unmatched pages.
+    """
+
+    closed = pyqtSignal()
+
+    def __init__(self, video_path, parent=None):
+        super().__init__(f"Review: {os.path.basename(video_path)}", parent)
+        self.setObjectName("ReviewDock")
+        self.setAttribute(Qt.WA_DeleteOnClose)
+        self.video_path = video_path
+        self.base = recording_base(video_path)
+
+        self._index = None
+        self._page_times = np.zeros(0)
+        self._fps = 30.0
+        self._page = -1
+        self._display_range_set = False
+        self._play_anchor = None  # (monotonic time, page) while playing
+
+        body = QWidget()
+        lay = QVBoxLayout(body)
+        lay.setContentsMargins(2, 2, 2, 2)
+        lay.setSpacing(4)
+
+        splitter = QSplitter(Qt.Horizontal)
+        self.camera_widget = QtCameraWidget(splitter)
+        self.plot_widget = PressurePlotWidget(splitter)
+        self.plot_widget.enable_time_cursor()
+        self.plot_widget.time_cursor_moved.connect(self.show_time)
+        splitter.addWidget(self.camera_widget)
+        splitter.addWidget(self.plot_widget)
+        lay.addWidget(splitter, stretch=1)
+
+        controls = QHBoxLayout()
+        self.btn_prev = QPushButton("◀")
+        self.btn_prev.setToolTip("Previous page (Left)")
+        self.btn_prev.clicked.connect(lambda: self.step(-1))
+        self.btn_play = QPushButton("Play")
+        self.btn_play.setCheckable(True)
+        self.btn_play.setToolTip("Play / pause (Space)")
+        self.btn_play.toggled.connect(self._on_play_toggled)
+        self.btn_next = QPushButton("▶")
+        self.btn_next.setToolTip("Next page (Right)")
+        self.btn_next.clicked.connect(lambda: self.step(1))
+        self.speed_combo = QComboBox()
+        for speed in REVIEW_PLAYBACK_SPEEDS:
+            self.speed_combo.addItem(f"{speed:g}×", speed)
+        self.speed_combo.setCurrentIndex(
+            self.speed_combo.findData(1.0) if 1.0 in REVIEW_PLAYBACK_SPEEDS else 0
+        )
+        self.speed_combo.currentIndexChanged.connect(self._restart_play_anchor)
+        self.slider = QSlider(Qt.Horizontal)
+        self.slider.setEnabled(False)
+        self.slider.valueChanged.connect(self.show_page)
+        self.info_label = QLabel("Opening…")
+        self.info_label.setMinimumWidth(320)
+        for w in (self.btn_prev, self.btn_play, self.btn_next, self.speed_combo):
+            controls.addWidget(w)
+        controls.addWidget(self.slider, stretch=1)
+        controls.addWidget(self.info_label)
+        lay.addLayout(controls)
+        self.setWidget(body)
+
+        for key, slot in (
+            (Qt.Key_Left, lambda: self.step(-1)),
+            (Qt.Key_Right, lambda: self.step(1)),
+            (Qt.Key_Space, self.btn_play.toggle),
+        ):
+            shortcut = QShortcut(QKeySequence(key), body)
+            shortcut.setContext(Qt.WidgetWithChildrenShortcut)
+            shortcut.activated.connect(slot)
+
+        self._play_timer = QTimer(self)
+        self._play_timer.setInterval(max(1, int(1000 / max(1, UI_REFRESH_HZ))))
+        self._play_timer.timeout.connect(self._on_play_tick)
+
+        self.prefetcher = FramePrefetcher(video_path, parent=self)
+        self.prefetcher.opened.connect(self._on_opened)
+        self.prefetcher.frame_loaded.connect(self._on_frame_loaded)
+        self.prefetcher.error_occurred.connect(self._on_error)
+
+    def start(self):
+        self._load_traces()
+        self.prefetcher.start()
+
+    def stop(self):
+        self._play_timer.stop()
+        if self.prefetcher.isRunning():
+            self.prefetcher.stop()
+            if not self.prefetcher.wait(2000):
+                log.warning("FramePrefetcher did not stop gracefully.")
+        self.camera_widget.clear_image()
+
+    # ─── Loading ────────────────────────────────────────────────────────
+    def _load_traces(self):
+        try:
+            ts, ps = load_pressure(self.base)
+        except Exception as e:
+            log.error(f"Review: cannot read the pressure of {self.base}: {e}")
+            ts, ps = np.zeros(0), np.zeros(0)
+
+        diameter = None
+        diameter_path = self.base + "_diameter.bin"
+        if os.path.exists(diameter_path):
+            from threads.diameter_tracker import mean_per_frame
+            from writers.columnar_log import open_log
+
+            try:
+                diameter = mean_per_frame(np.array(open_log(diameter_path)))
+            except Exception as e:
+                log.warning(f"Review: diameter trace of {self.base} skipped: {e}")
+        self.plot_widget.load_series(ts, ps, diameter)
+
+    @pyqtSlot(object)
+    def _on_opened(self, index):
+        self._index = index
+        n = len(index)
+        if not n:
+            self.info_label.setText("The recording has no pages.")
+            return
+
+        self._page_times, self._fps = page_times(index, self._fps)
+
+        self.slider.blockSignals(True)
+        self.slider.setRange(0, n - 1)
+        self.slider.setPageStep(max(1, int(self._fps)))
+        self.slider.blockSignals(False)
+        self.slider.setEnabled(True)
+        self.show_page(0)
+
+    # ─── Cursor ─────────────────────────────────────────────────────────
+    @pyqtSlot(int)
+    def show_page(self, page):
+        if self._index is None or not len(self._index):
+            return
+        page = min(max(int(page), 0), len(self._index) - 1)
+        if page == self._page:
+            return
+        self._page = page
+        if self.slider.value() != page:
+            self.slider.blockSignals(True)
+            self.slider.setValue(page)
+            self.slider.blockSignals(False)
+
+        arr = self.prefetcher.request(page)
+        if arr is not None:
+            self._display(page, arr)
+        self.plot_widget.set_time_cursor(float(self._page_times[page]))
+        self._update_info()
+
+    @pyqtSlot(float)
+    def show_time(self, t):
+        """Move to the page recorded closest to time ``t``."""
+        if not len(self._page_times):
+            return
+        i = int(np.searchsorted(self._page_times, t))
+        if i == len(self._page_times) or (
+            i > 0 and t - self._page_times[i - 1] <= self._page_times[i] - t
+        ):
+            i -= 1
+        self._stop_playback()
+        self.show_page(i)
+
+    def step(self, n):
+        self._stop_playback()
+        self.show_page(self._page + n)
+
+    @pyqtSlot(int, object)
+    def _on_frame_loaded(self, page, arr):
+        if page == self._page:
+            self._display(page, arr)
+
+    def _display(self, page, arr):
+        if not self._display_range_set:
+            # Stretch the sensor's significant bits (e.g. 12 of 16)
+            self._display_range_set = True
+            if arr.dtype == np.uint16:
+                bits = max(8, int(arr.max()).bit_length())
+                self.camera_widget.set_display_range(0.0, ((1 << bits) - 1) / 65535.0)
+        frame = CameraFrame(arr, frame_number=int(self._index["cameraFrame"][page]))
+        self.camera_widget._on_frame_ready(QImage(), frame)
+
+    def _update_info(self):
+        row = self._index[self._page]
+        pressure = float(row["pressure"])
+        text = (
+            f"Page {self._page + 1}/{len(self._index)} · "
+            f"t = {self._page_times[self._page]:.3f} s · "
+        )
+        text += f"{pressure:.2f} mmHg" if np.isfinite(pressure) else "unmatched"
+        if row["preTrigger"]:
+            text += " · pre-trigger"
+        self.info_label.setText(text)
+        stats = self.prefetcher.stats()
+        self.info_label.setToolTip(
+            f"Frame cache: {stats['cached_pages']} pages, {stats['cache_mb']:.0f} MB, "
+            f"{stats['hit_rate']:.0%} hits"
+        )
+
+    # ─── Playback ───────────────────────────────────────────────────────
+    @pyqtSlot(bool)
+    def _on_play_toggled(self, playing):
+        if playing and self._index is not None and len(self._index):
+            if self._page >= len(self._index) - 1:
+                self.show_page(0)
+            self.btn_play.setText("Pause")
+            self._restart_play_anchor()
+            self._play_timer.start()
+        else:
+            self._play_timer.stop()
+            self._play_anchor = None
+            self.btn_play.setText("Play")
+            if playing:
+                self.btn_play.setChecked(False)
+
+    def _restart_play_anchor(self, *_):
+        if self._play_timer.isActive() or self.btn_play.isChecked():
+            self._play_anchor = (time.monotonic(), max(self._page, 0))
+
+    def _stop_playback(self):
+        if self.btn_play.isChecked():
+            self.btn_play.setChecked(False)
+
+    def _on_play_tick(self):
+        if self._play_anchor is None:
+            return
+        t0, page0 = self._play_anchor
+        speed = self.speed_combo.currentData() or 1.0
+        page = page0 + int((time.monotonic() - t0) * self._fps * speed)
+        if page >= len(self._index) - 1:
+            self.show_page(len(self._index) - 1)
+            self._stop_playback()
+            return
+        self.show_page(page)
+
+    @pyqtSlot(str)
+    def _on_error(self, msg):
+        self.info_label.setText(msg)
+
+    def closeEvent(self, event):
+        self.stop()
+        self.closed.emit()
+        super().closeEvent(event)
@@ -54,3 +54,7 @@ def load_app_settings():
 # --- Constants for setting keys ---
 SETTING_LAST_CAMERA_INDEX = "last_camera_index"
 SETTING_LAST_PROFILE_NAME = "last_profile_name"
+SETTING_RECORDING_FORMAT = "recording_format"
+SETTING_PLOT_BACKEND = "plot_backend"
+SETTING_TRIGGER_MODE = "trigger_mode"
+SETTING_TRIGGER_RATE_HZ = "trigger_rate_hz"
@@ -19,16 +19,185 @@ Path(PRIM_RESULTS_DIR).mkdir(parents=True, exist_ok=True)
 # ─── Recording settings ─────────────────────────────────────────────────────────
 DEFAULT_VIDEO_EXTENSION = "tif"
 DEFAULT_VIDEO_CODEC = None  # Not used when recording to TIFF
-SUPPORTED_FORMATS = ["tif"]
+# Frame writer backends (see writers/frame_writers.py):
+#   "tif"      – uncompressed BigTIFF, one page per frame
+#   "tif-zstd" – BigTIFF with zstd-compressed tiles (lossless)
+#   "h5"       – chunked HDF5 stack with per-frame metadata columns
+SUPPORTED_FORMATS = ["tif", "tif-zstd", "h5"]
+DEFAULT_RECORDING_FORMAT = "tif"
+WRITER_COMPRESSION_LEVEL = 3  # zstd / deflate level for compressed backends
+WRITER_COMPRESSION_WORKERS = max(1, min(8, (os.cpu_count() or 2) - 1))
+WRITER_TILE_SIZE = 256  # Tile edge (px) for compressed TIFF
+
+# Pressure samples are logged to a binary columnar file (writers/columnar_log.py);
+# on stop it is also exported to the legacy CSV layout if this is True.
+PRESSURE_LOG_EXPORT_CSV = True
+
+# Frame/sample synchronization (frame_sync.py).  In hardware-trigger mode
+# camera frame numbers are paired with the Arduino CamTrig frameIdx through an
+# offset locked on the first frame whose host arrival is within
+# SYNC_LOCK_TOLERANCE_S of the first sample; a free-running camera gets the
+# sample nearest in host time (within the same tolerance) instead.
+# Frames/samples still unpaired after SYNC_MATCH_TIMEOUT_S are counted as
+# unmatched; unmatched frames are still written (frameIdx -1).  Only
+# SYNC_ZERO_COPY_FRAMES waiting frames keep their IC4 buffer; older ones are
+# copied.
+SYNC_LOCK_TOLERANCE_S = 0.1
+SYNC_MATCH_TIMEOUT_S = 0.5
+SYNC_ZERO_COPY_FRAMES = 4
+# Max disagreement between camera and Arduino frame intervals before a
+# pairing is counted as a skew violation
+SYNC_MAX_SKEW_S = 0.005
+# Armed recordings (RecordingManager.start_recording with wait_for_trigger):
+# output files are opened up front and the last PRETRIGGER_SECONDS of frames
+# and samples are kept in RAM (at most PRETRIGGER_MAX_MB of pixels), then
+# written at the start of the recording.  0 disables the pre-trigger ring.
+PRETRIGGER_SECONDS = 5.0
+PRETRIGGER_MAX_MB = 1024
 DEFAULT_FPS = 10
+
+# Write-behind queue between RecordingManager and the disk writer thread.
+# WRITER_BACKPRESSURE_POLICY decides what happens when the queue is full:
+#   "block" – the recorder waits for the disk (lossless, stalls the recorder)
+#   "drop"  – the frame is left out of the recording (live preview unaffected)
+#   "spill" – the frame is copied to RAM beyond the bound and written later;
+#             the whole queue is capped at MEMORY_BUDGET_MB of pixels, past
+#             which frames are dropped
+WRITER_QUEUE_SIZE = 64
+WRITER_BATCH_SIZE = 16  # Max frames written per wake-up of the writer thread
+WRITER_BACKPRESSURE_POLICY = "spill"
+WRITER_STATS_INTERVAL_MS = 1000
+# Closing the window while recording waits for the writers to drain: at least
+# RECORDER_STOP_TIMEOUT_S plus RECORDER_STOP_S_PER_FRAME per queued frame,
+# then asks whether to keep waiting.  The recorder is never terminated.
+RECORDER_STOP_TIMEOUT_S = 10.0
+RECORDER_STOP_S_PER_FRAME = 0.05
+# Crash safety: every RECORDING_CHECKPOINT_S the frame writer fsyncs the stack
+# and records how far it is durable in <video>_journal.bin (which also has one
+# row per page), and the recorder fsyncs the pressure/sync/diameter logs.
+# After a crash ``python -m writers.recovery <folder>`` rebuilds the stack,
+# index and CSVs from the journals.  0 disables checkpoints.
+RECORDING_CHECKPOINT_S = 10.0
+# Frame buffer pool (threads/frame_pool.py): pixels kept outside the camera's
+# buffer ring (pre-trigger ring, frames waiting for sync, writer spill, preview
+# rings) are borrowed from one pool of at most MEMORY_BUDGET_MB.  When it is
+# exhausted MEMORY_OVERFLOW_POLICY decides:
+#   "block"    – wait up to MEMORY_BLOCK_TIMEOUT_S for a buffer, then drop
+#   "drop"     – the frame is left out (counted in the status-bar gauge)
+#   "allocate" – opt-in: allocate beyond the budget and count it as an
+#                overflow; the budget is then no longer a hard limit
+# Keep the budget above PRETRIGGER_MAX_MB plus the writer's expected spill.
+MEMORY_BUDGET_MB = 2048
+MEMORY_OVERFLOW_POLICY = "block"
+MEMORY_BLOCK_TIMEOUT_S = 0.05
+MEMORY_GAUGE_WARN_FRACTION = 0.9  # Gauge turns red above this share of the budget
 DEFAULT_CAMERA_INDEX = 0  # Default device index
 
+# ─── Camera streaming ────────────────────────────────────────────────────────────
+# Number of IC4 output buffers pre-allocated for the QueueSink ring. Raise this
+# for high frame rates so short GUI/disk stalls do not starve the sink.
+CAMERA_BUFFER_COUNT = 8
+CAMERA_STATS_INTERVAL_MS = 1000  # How often SDKCameraThread emits stats_updated
+# Log every device property at DEBUG when the camera opens.  Walking the whole
+# property map is slow, so it is off unless needed for troubleshooting.
+CAMERA_DUMP_PROPERTIES = False
+# Property changes from the Controls tab are written by a worker thread; writes
+# arriving within this many ms collapse into the newest value per property.
+# Saved camera profiles (CAMERA_PROFILES_DIR) are applied in one batch before
+# streaming starts.
+CAMERA_PROPERTY_COALESCE_MS = 30
+# Capture ROI (hardware OffsetX/OffsetY/Width/Height) and sensor binning, set
+# from the Controls tab; the camera restarts to apply them.  With
+# CAMERA_ROI_MAX_FPS the frame rate is raised to the maximum the camera
+# reports for the new geometry.
+CAMERA_BINNING_CHOICES = [1, 2, 4]
+CAMERA_ROI_MAX_FPS = True
+# Cameras recorded together (Acquisition ▸ Add Camera…, headless --camera A,B):
+# all are triggered from the same CamTrig line and each gets its own buffer
+# ring, writer thread and <base>_cam<N>_video / _sync.bin next to camera 0's.
+MAX_CAMERAS = 4
+# Hardware triggering from the Arduino's CamTrig pin.  Off keeps the camera
+# free-running at its AcquisitionFrameRate; Acquisition ▸ Calibrate Trigger
+# Rate… turns it on and the choice is remembered in the app settings.
+CAMERA_TRIGGER_MODE = False
+CAMERA_TRIGGER_SOURCE = "Line1"
+CAMERA_TRIGGER_ACTIVATION = "RisingEdge"
+
+# Preview conversion of >8-bit frames (recordings always keep native depth).
+#   "bitdepth"   fixed shift; PREVIEW_BIT_DEPTH=None derives it from PixelFormat
+#   "percentile" contrast stretch between PREVIEW_PERCENTILES, smoothed
+#   "manual"     user window (low, high) in 16-bit counts
+PREVIEW_MODES = ["bitdepth", "percentile", "manual"]
+PREVIEW_DEFAULT_MODE = "bitdepth"
+PREVIEW_BIT_DEPTH = None
+PREVIEW_PERCENTILES = (0.5, 99.5)
+PREVIEW_PERCENTILE_INTERVAL = 10  # Frames between percentile updates
+PREVIEW_PERCENTILE_SMOOTHING = 0.2  # EMA weight of each new window
+PREVIEW_PERCENTILE_STRIDE = 8  # Sub-sampling step for the percentile estimate
+
 # Frame size fallback (actual size will be queried from camera at runtime)
 DEFAULT_FRAME_SIZE = (640, 480)  # (width, height)
 
 # ─── Serial communication ────────────────────────────────────────────────────────
 DEFAULT_SERIAL_BAUD_RATE = 115200
 SERIAL_COMMAND_TERMINATOR = b"\n"  # Arduino uses Serial.println()
+# Sample framing sent by the firmware: "ascii" (CSV lines) or "binary"
+# (sync word + packed struct + checksum; see threads/serial_protocol.py)
+SERIAL_PROTOCOLS = ["ascii", "binary"]
+SERIAL_PROTOCOL = "ascii"
+SERIAL_READ_TIMEOUT_S = 0.02  # Max wait for the first byte of a bulk read
+SERIAL_READ_CHUNK = 4096  # Size of the reusable read buffer
+# samples_ready cadence: a block goes out after this long or this many samples
+SERIAL_BLOCK_INTERVAL_MS = 20
+SERIAL_BLOCK_MAX_SAMPLES = 256
+# Sets the firmware's sample (and CamTrig) interval, startup.timeDelay, in ms:
+# "<prefix><interval_ms>".  Must match the command the PRIM firmware parses.
+SERIAL_RATE_COMMAND_PREFIX = "T"
+
+# ─── Trigger-rate calibration (threads/rate_calibrator.py) ───────────────────────
+# The PRIM device is stepped from CALIBRATION_START_HZ up by
+# CALIBRATION_RATE_FACTOR per step (to the camera's maximum or
+# CALIBRATION_MAX_HZ) while every frame goes through a real writer of the
+# current format into a scratch folder.  A step passes if over
+# CALIBRATION_STEP_S (after CALIBRATION_SETTLE_S) no frame was dropped or
+# missed and the writer kept up; it fails early once written frames fall below
+# CALIBRATION_MIN_THROUGHPUT of the trigger rate.  The highest passing rate
+# times CALIBRATION_HEADROOM is configured on the device.
+CALIBRATION_START_HZ = DEFAULT_FPS
+CALIBRATION_RATE_FACTOR = 1.25
+CALIBRATION_MAX_HZ = 200.0
+CALIBRATION_STEP_S = 5.0
+CALIBRATION_SETTLE_S = 1.0
+CALIBRATION_MIN_THROUGHPUT = 0.98
+CALIBRATION_HEADROOM = 0.9
+CALIBRATION_TICK_MS = 250
+
+# ─── Pressure signal processing (threads/pressure_dsp.py) ────────────────────────
+# Streaming filters run on the serial worker for every sample; the results go
+# out as processed_ready blocks (DSP_RECORD_DTYPE) to the plot, readouts and
+# recorder.  Windows are in samples.  Steps are found by a two-sided CUSUM on
+# the low-passed signal: DSP_STEP_DRIFT_MMHG of slack per sample, a step once
+# the sum passes DSP_STEP_THRESHOLD_MMHG.  DSP_PLOT_CHANNEL is drawn over the
+# raw trace (None: not drawn).  With DSP_SOFTWARE_ZERO the Zero button tares
+# the signal here instead of sending "Z" to the device.
+DSP_ENABLED = True
+DSP_MOVING_WINDOW = 25
+DSP_LOWPASS_HZ = 2.0
+DSP_SLOPE_WINDOW = 50
+DSP_STEP_THRESHOLD_MMHG = 3.0
+DSP_STEP_DRIFT_MMHG = 0.25
+DSP_CHANNELS = ["lowpass", "movingAverage", "movingMedian"]
+DSP_PLOT_CHANNEL = "lowpass"
+DSP_SOFTWARE_ZERO = False
+
+# ─── Simulated sources (threads/simulated_sources.py) ────────────────────────────
+# Stand-ins for the camera and PRIM device used by --simulate and the
+# benchmarks.  The simulated Arduino "pulses CamTrig" once per sample, so
+# frames and samples pair up exactly like on the rig.
+SIM_CAMERA_RESOLUTION = (2448, 2048)  # (width, height)
+SIM_CAMERA_BIT_DEPTH = 12  # 8 → Mono8, otherwise Mono16 holding this many bits
+SIM_CAMERA_PATTERN_FRAMES = 32  # Distinct pre-rendered frames, cycled
+SIM_SAMPLE_RATE_HZ = DEFAULT_FPS  # Pressure samples (and triggers) per second
 
 # ─── Application info ───────────────────────────────────────────────────────────
 APP_NAME = "PRIMAcquisition"
@@ -42,13 +211,83 @@ and a synchronized CSV log.</p>
 <p>Experiment control (start/stop) can be triggered directly from this application.</p>
 """
 
+# ─── Startup ────────────────────────────────────────────────────────────────────
+# Imported on a background thread once the main window is shown, so the first
+# recording does not wait for them.
+STARTUP_PRELOAD_MODULES = ["tifffile", "h5py"]
+
 # ─── Logging ────────────────────────────────────────────────────────────────────
-LOG_LEVEL = "DEBUG"  # DEBUG, INFO, WARNING, ERROR
+# DEBUG, INFO, WARNING, ERROR.  DEBUG logs from the acquisition hot paths and
+# is itself a measurable cost; use the Pipeline Stats dock for timings instead.
+LOG_LEVEL = "INFO"
+
+# ─── Headless mode (prim_app.py --headless, see headless.py) ────────────────────
+HEADLESS_STATUS_INTERVAL_S = 5.0  # Seconds between one-line status reports
+
+# ─── Telemetry ──────────────────────────────────────────────────────────────────
+# Hot-path timings and counters (utils/telemetry.py), shown in the Pipeline
+# Stats dock.  Histograms keep the last TELEMETRY_WINDOW values for their
+# percentiles.  With TELEMETRY_EXPORT each recording also gets a
+# <base>_telemetry.jsonl file with one snapshot per second.
+TELEMETRY_ENABLED = True
+TELEMETRY_WINDOW = 1024
+TELEMETRY_EXPORT = True
+TELEMETRY_PANEL_REFRESH_MS = 500
+
+# ─── Live diameter tracking (threads/diameter_tracker.py) ───────────────────────
+# Profiles along the line ROIs drawn on the camera view are averaged over
+# DIAMETER_LINE_WIDTH parallel lines, box-smoothed over DIAMETER_SMOOTH_PX
+# samples and searched for the strongest edge in each half.  At most
+# DIAMETER_MAX_PENDING frames wait for a worker; the oldest are dropped
+# beyond that (recording is unaffected).  DIAMETER_UM_PER_PX converts the
+# result to µm; None keeps pixels.
+DIAMETER_LINE_WIDTH = 5
+DIAMETER_SMOOTH_PX = 3
+DIAMETER_WORKERS = max(1, min(4, (os.cpu_count() or 2) // 2))
+DIAMETER_MAX_PENDING = 64
+DIAMETER_UM_PER_PX = None
 
 # ─── Plotting ──────────────────────────────────────────────────────────────────
-PLOT_MAX_POINTS = 1000  # Max points to keep in live plot
+PLOT_MAX_POINTS = 4000  # Upper bound on points drawn per redraw (≈2 per pixel)
+PLOT_RING_CAPACITY = 65536  # Full-resolution samples kept for the live view
 PLOT_DEFAULT_Y_MIN = -5
 PLOT_DEFAULT_Y_MAX = 30  # Typical pressure range in mmHg
+# Live plot renderer: "matplotlib" (Agg, always available) or "pyqtgraph"
+# (OpenGL-accelerated; falls back to matplotlib if pyqtgraph is missing).
+# Overridden by the saved app setting and the --plot-backend command line flag.
+PLOT_BACKENDS = ["matplotlib", "pyqtgraph"]
+PLOT_BACKEND = "matplotlib"
+PLOT_REFRESH_HZ = 60  # Max redraw rate of the pyqtgraph backend
+# Live view (plot, camera preview, status labels) refresh rate.  Samples and
+# frames are coalesced between ticks; recording always gets every item.
+UI_REFRESH_HZ = 30
+CONSOLE_MAX_LINES_PER_TICK = 20  # Data lines echoed to the console per tick
+CONSOLE_MAX_LINES = 5000  # Ring size of the console dock (oldest lines drop)
+# Console sources (ui/console_log.py); disabled ones are dropped before formatting
+CONSOLE_SOURCES = ["serial", "camera", "recorder", "app"]
+CONSOLE_LOG_LEVEL = "INFO"  # Minimum level of log records shown in the console
+
+# ─── Review mode (ui/review_dock.py) ────────────────────────────────────────────
+# Recorded frames are read on a background thread (threads/frame_prefetcher.py)
+# into an LRU cache of REVIEW_CACHE_MB; REVIEW_PREFETCH_AHEAD pages are read
+# ahead of the cursor in the direction of travel and REVIEW_PREFETCH_BEHIND
+# behind it, so scrubbing and playback mostly hit the cache.
+REVIEW_CACHE_MB = 1024
+REVIEW_PREFETCH_AHEAD = 64
+REVIEW_PREFETCH_BEHIND = 8
+REVIEW_PLAYBACK_SPEEDS = [0.25, 0.5, 1.0, 2.0, 4.0]
+
+# ─── Recording export (writers/stack_export.py) ─────────────────────────────────
+# Stacks are streamed page by page: rendered (binning, 8-bit window, burned-in
+# time/pressure) on EXPORT_WORKERS threads with at most EXPORT_IN_FLIGHT pages
+# in memory.  EXPORT_STEP keeps every N-th page (time-lapse), EXPORT_BINNING
+# averages N×N pixel blocks.  Formats: "h264", "h265", "mjpeg", "tiff".
+EXPORT_DEFAULT_FORMAT = "h264"
+EXPORT_STEP = 1
+EXPORT_BINNING = 1
+EXPORT_OVERLAY = True
+EXPORT_WORKERS = max(1, min(8, (os.cpu_count() or 2) - 1))
+EXPORT_IN_FLIGHT = 32
 
 # ─── Camera profiles / Application config directory ─────────────────────────────
 # User‐writable directory for storing camera profiles
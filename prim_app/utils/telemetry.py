@@ -0,0 +1,140 @@
+# prim_app/utils/telemetry.py
+
+import collections
+import json
+import logging
+import os
+import threading
+import time
+
+from utils.config import TELEMETRY_ENABLED, TELEMETRY_WINDOW
+
+log = logging.getLogger(__name__)
+
+
+class Histogram:
+    """
+    Durations (seconds) or other values of one pipeline stage.  Keeps
+    lifetime count/sum/max plus the last ``window`` values for percentiles.
+    """
+
+    __slots__ = ("count", "total", "max", "_recent", "_lock")
+
+    def __init__(self, window=TELEMETRY_WINDOW):
+        self.count = 0
+        self.total = 0.0
+        self.max = 0.0
+        self._recent = collections.deque(maxlen=window)
+        self._lock = threading.Lock()
+
+    def record(self, value):
+        with self._lock:
+            self.count += 1
+            self.total += value
+            if value > self.max:
+                self.max = value
+            self._recent.append(value)
+
+    def snapshot(self):
+        with self._lock:
+            recent = sorted(self._recent)
+            count, total, peak = self.count, self.total, self.max
+        if not recent:
+            return {"count": count, "mean": 0.0, "p50": 0.0, "p99": 0.0, "max": peak}
+
+        def pct(q):
+            return recent[min(len(recent) - 1, int(q * len(recent)))]
+
+        return {
+            "count": count,
+            "mean": total / count,
+            "p50": pct(0.50),
+            "p99": pct(0.99),
+            "max": peak,
+        }
+
+
+class Telemetry:
+    """
+    Process-wide registry of histograms, counters and gauges, safe to use
+    from any thread.  Every call is a no-op while ``enabled`` is False, so
+    instrumentation can stay in the hot paths.
+
+    Typical use::
+
+        t0 = time.perf_counter()
+        ...
+        telemetry.record("camera.convert", time.perf_counter() - t0)
+    """
+
+    def __init__(self, enabled=TELEMETRY_ENABLED):
+        self.enabled = enabled
+        self._histograms = {}
+        self._counters = collections.Counter()
+        self._gauges = {}
+        self._lock = threading.Lock()
+
+    def _histogram(self, name):
+        hist = self._histograms.get(name)
+        if hist is None:
+            with self._lock:
+                hist = self._histograms.setdefault(name, Histogram())
+        return hist
+
+    def record(self, name, value):
+        """Add one value (normally a duration in seconds) to histogram ``name``."""
+        if self.enabled:
+            self._histogram(name).record(value)
+
+    def count(self, name, n=1):
+        if self.enabled:
+            with self._lock:
+                self._counters[name] += n
+
+    def set_gauge(self, name, value):
+        if self.enabled:
+            self._gauges[name] = value
+
+    def snapshot(self):
+        """Plain-dict view of every metric (JSON serialisable)."""
+        with self._lock:
+            histograms = dict(self._histograms)
+            counters = dict(self._counters)
+        return {
+            "time": time.time(),
+            "histograms": {k: h.snapshot() for k, h in sorted(histograms.items())},
+            "counters": dict(sorted(counters.items())),
+            "gauges": dict(sorted(self._gauges.items())),
+        }
+
+    def reset(self):
+        with self._lock:
+            self._histograms = {}
+            self._counters = collections.Counter()
+            self._gauges = {}
+
+
+# Shared instance used by all threads
+telemetry = Telemetry()
+
+
+class TelemetryLog:
+    """Appends one JSON snapshot per line (``<base>_telemetry.jsonl``)."""
+
+    def __init__(self, path):
+        self.path = path
+        self._file = open(path, "w", encoding="utf-8")
+
+    def write(self, snapshot):
+        self._file.write(json.dumps(snapshot) + "\n")
+        self._file.flush()
+
+    def sync(self):
+        if self._file is not None:
+            self._file.flush()
+            os.fsync(self._file.fileno())
+
+    def close(self):
+        if self._file is not None:
+            self._file.close()
+            self._file = None
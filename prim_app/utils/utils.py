@@ -1,6 +1,5 @@
 # PRIM-QTAPP/prim_app/utils/utils.py
 import time
-import cv2
 import serial.tools.list_ports
 import re
 
@@ -18,6 +17,8 @@ def timestamped_filename(prefix, ext):
 
 def list_cameras(max_idx=5):  # OpenCV camera listing
     """Lists available OpenCV/DirectShow cameras."""
+    import cv2  # Only needed here; slow to import
+
     cams = []
     for i in range(max_idx):
         cap = cv2.VideoCapture(i, cv2.CAP_DSHOW)
@@ -0,0 +1,264 @@
+# prim_app/writers/columnar_log.py
+"""
+Append-only binary log of fixed-width records.
+
+Layout::
+
+    [ header: HEADER_SIZE bytes ][ record 0 ][ record 1 ] …
+
+The header starts with ``MAGIC``, then the record size as little-endian
+uint32, then a NUL-padded JSON blob with the numpy dtype description and any
+extra attributes.  Records are raw ``numpy`` structured rows, so a log can be
+memory-mapped directly for analysis (:func:`open_log`).  Rows are buffered and
+written in blocks; after a crash everything up to the last complete record is
+still readable, and :func:`recover_log` trims a torn tail.
+
+Run as a script to convert a log to CSV::
+
+    python -m writers.columnar_log recording_..._pressure.bin [out.csv]
+"""
+
+import csv
+import json
+import os
+import struct
+import sys
+import time
+
+import numpy as np
+
+MAGIC = b"PRIMLOG1"
+HEADER_SIZE = 512
+
+# One Arduino sample: CamTrig frame index, device time (s), pressure (mmHg)
+# and host receive time (time.time()).
+PRESSURE_RECORD_DTYPE = np.dtype(
+    [
+        ("frameIdx", "<i8"),
+        ("deviceTime", "<f8"),
+        ("pressure", "<f8"),
+        ("hostTime", "<f8"),
+    ]
+)
+
+# Columns (and their order) of the legacy experiment CSV
+PRESSURE_CSV_COLUMNS = ("frameIdx", "deviceTime", "pressure")
+
+# One frame/sample pairing from FrameSyncEngine: TIFF page index (-1 if the
+# page was dropped), camera frame number and device timestamp, the matched
+# Arduino sample (frameIdx -1 / NaN fields when unmatched) and host arrival
+# time of the frame.
+SYNC_RECORD_DTYPE = np.dtype(
+    [
+        ("pageIdx", "<i8"),
+        ("cameraFrame", "<i8"),
+        ("cameraTimestampNs", "<i8"),
+        ("frameIdx", "<i8"),
+        ("deviceTime", "<f8"),
+        ("pressure", "<f8"),
+        ("hostTime", "<f8"),
+    ]
+)
+
+# One live diameter measurement (threads/diameter_tracker.py): camera frame
+# number, host arrival time, device time estimated from the latest sample,
+# line ROI index, diameter (px or µm, NaN if no edges) and edge strength
+# (0–1, relative to the profile's range).  One row per ROI per frame.
+DIAMETER_RECORD_DTYPE = np.dtype(
+    [
+        ("cameraFrame", "<i8"),
+        ("hostTime", "<f8"),
+        ("deviceTime", "<f8"),
+        ("roi", "<i4"),
+        ("diameter", "<f8"),
+        ("strength", "<f4"),
+    ]
+)
+
+DIAMETER_CSV_COLUMNS = ("cameraFrame", "deviceTime", "roi", "diameter", "strength")
+
+# One processed sample from threads/pressure_dsp.py: the raw sample's frame
+# index and device time, the pressure minus the software zero ``offset``, the
+# low-pass / moving average / moving median channels, mean and SD since the
+# last reset, rate of change (mmHg/s, sliding least squares) and ``step``
+# (+1 / -1 on the sample a pressure step was detected, else 0).
+DSP_RECORD_DTYPE = np.dtype(
+    [
+        ("frameIdx", "<i8"),
+        ("deviceTime", "<f8"),
+        ("pressure", "<f8"),
+        ("lowpass", "<f8"),
+        ("movingAverage", "<f8"),
+        ("movingMedian", "<f8"),
+        ("mean", "<f8"),
+        ("std", "<f8"),
+        ("slope", "<f8"),
+        ("step", "i1"),
+        ("offset", "<f8"),
+    ]
+)
+
+DSP_CSV_COLUMNS = (
+    "frameIdx",
+    "deviceTime",
+    "pressure",
+    "lowpass",
+    "movingAverage",
+    "movingMedian",
+    "slope",
+    "step",
+)
+
+DEFAULT_BLOCK_RECORDS = 256
+DEFAULT_FLUSH_INTERVAL_S = 1.0
+
+
+def _encode_header(dtype, attrs):
+    meta = json.dumps({"dtype": dtype.descr, "attrs": attrs or {}}).encode("utf-8")
+    fixed = MAGIC + struct.pack("<I", dtype.itemsize)
+    if len(fixed) + len(meta) > HEADER_SIZE:
+        raise ValueError("Columnar log header too large.")
+    return fixed + meta + b"\0" * (HEADER_SIZE - len(fixed) - len(meta))
+
+
+def read_header(path):
+    """Return ``(dtype, attrs)`` stored in the header of the log at ``path``."""
+    with open(path, "rb") as f:
+        raw = f.read(HEADER_SIZE)
+    if len(raw) < HEADER_SIZE or not raw.startswith(MAGIC):
+        raise ValueError(f"{path} is not a PRIM columnar log.")
+    (record_size,) = struct.unpack_from("<I", raw, len(MAGIC))
+    meta = json.loads(raw[len(MAGIC) + 4 :].rstrip(b"\0").decode("utf-8"))
+    dtype = np.dtype([tuple(field) for field in meta["dtype"]])
+    if dtype.itemsize != record_size:
+        raise ValueError(f"{path}: header record size does not match dtype.")
+    return dtype, meta.get("attrs", {})
+
+
+class ColumnarLogWriter:
+    """
+    Buffered writer for a columnar log.  Rows are collected in a pre-allocated
+    block of ``block_records`` rows and written (and flushed) whenever the block
+    fills up or ``flush_interval_s`` has passed since the last flush.
+    """
+
+    def __init__(
+        self,
+        path,
+        dtype=PRESSURE_RECORD_DTYPE,
+        attrs=None,
+        block_records=DEFAULT_BLOCK_RECORDS,
+        flush_interval_s=DEFAULT_FLUSH_INTERVAL_S,
+    ):
+        self.path = path
+        self.dtype = np.dtype(dtype)
+        self.flush_interval_s = flush_interval_s
+        self.records_written = 0
+
+        self._block = np.zeros(max(1, int(block_records)), dtype=self.dtype)
+        self._fill = 0
+        self._last_flush = time.monotonic()
+
+        self._file = open(path, "wb")
+        self._file.write(_encode_header(self.dtype, attrs))
+        self._file.flush()
+
+    def append(self, *values):
+        """Append one row given as positional field values."""
+        self._block[self._fill] = values
+        self._fill += 1
+        if self._fill == len(self._block) or (
+            time.monotonic() - self._last_flush >= self.flush_interval_s
+        ):
+            self.flush()
+
+    def append_block(self, rows):
+        """Append a structured array (or anything convertible to ``dtype``)."""
+        rows = np.asarray(rows, dtype=self.dtype)
+        if len(rows) == 0:
+            return
+        self.flush()
+        self._file.write(rows.tobytes())
+        self.records_written += len(rows)
+        if time.monotonic() - self._last_flush >= self.flush_interval_s:
+            self.flush()
+
+    def flush(self):
+        if self._file is None:
+            return
+        if self._fill:
+            self._file.write(self._block[: self._fill].tobytes())
+            self.records_written += self._fill
+            self._fill = 0
+        self._file.flush()
+        self._last_flush = time.monotonic()
+
+    def sync(self):
+        """Flush and fsync: every row appended so far survives a crash or power loss."""
+        if self._file is None:
+            return
+        self.flush()
+        os.fsync(self._file.fileno())
+
+    def close(self):
+        if self._file is None:
+            return
+        self.flush()
+        self._file.close()
+        self._file = None
+
+
+def open_log(path, mode="r"):
+    """
+    Memory-map the complete records of the log at ``path`` as a structured
+    ``numpy`` array (a torn last record is ignored).
+    """
+    dtype, _ = read_header(path)
+    n = (os.path.getsize(path) - HEADER_SIZE) // dtype.itemsize
+    if n <= 0:
+        return np.zeros(0, dtype=dtype)
+    return np.memmap(path, dtype=dtype, mode=mode, offset=HEADER_SIZE, shape=(n,))
+
+
+def recover_log(path):
+    """
+    Truncate a log left behind by a crash to its last complete record.
+    Returns the number of records kept.
+    """
+    dtype, _ = read_header(path)
+    size = os.path.getsize(path)
+    n = max(0, (size - HEADER_SIZE) // dtype.itemsize)
+    good = HEADER_SIZE + n * dtype.itemsize
+    if good < size:
+        with open(path, "r+b") as f:
+            f.truncate(good)
+    return n
+
+
+def export_csv(log_path, csv_path=None, columns=PRESSURE_CSV_COLUMNS, chunk=65536):
+    """
+    Write ``columns`` of the log to a CSV file (default: same name, ``.csv``).
+    Streams in chunks so multi-hour logs never have to fit in memory.
+    Returns the CSV path.
+    """
+    if csv_path is None:
+        csv_path = os.path.splitext(log_path)[0] + ".csv"
+    data = open_log(log_path)
+    # Logs without any of the requested columns are exported whole
+    columns = [c for c in columns if c in data.dtype.names] or list(data.dtype.names)
+    with open(csv_path, "w", newline="") as f:
+        writer = csv.writer(f)
+        writer.writerow(columns)
+        for start in range(0, len(data), chunk):
+            block = data[start : start + chunk]
+            writer.writerows(zip(*(block[c].tolist() for c in columns)))
+    return csv_path
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print("Usage: python -m writers.columnar_log <log.bin> [out.csv]")
+        sys.exit(1)
+    recover_log(sys.argv[1])
+    out = export_csv(sys.argv[1], sys.argv[2] if len(sys.argv) > 2 else None)
+    print(f"Wrote {out}")
@@ -0,0 +1,413 @@
+# prim_app/writers/frame_writers.py
+
+import json
+import logging
+import os
+import zlib
+from concurrent.futures import ThreadPoolExecutor
+
+import numpy as np
+
+from writers.columnar_log import ColumnarLogWriter
+from writers.recording_index import (
+    JOURNAL_CHECKPOINT,
+    JOURNAL_PAGE,
+    JOURNAL_RECORD_DTYPE,
+    index_path_for,
+    index_row,
+    journal_path_for,
+    write_index,
+)
+from utils.config import (
+    DEFAULT_RECORDING_FORMAT,
+    WRITER_COMPRESSION_LEVEL,
+    WRITER_COMPRESSION_WORKERS,
+    WRITER_TILE_SIZE,
+)
+
+log = logging.getLogger(__name__)
+
+# The per-page metadata columns of an HDF5 recording (``/metadata/<key>``),
+# fixed up front like the columnar logs' dtypes: everything RecordingManager
+# and the rate calibrator put on a page.  Missing values are stored as -1
+# (preTrigger 0) or NaN; keys outside the schema are not stored.
+HDF5_METADATA_DTYPE = np.dtype(
+    [
+        ("pageIdx", "<i8"),
+        ("frameIdx", "<i8"),
+        ("deviceTime", "<f8"),
+        ("pressure", "<f8"),
+        ("cameraFrame", "<i8"),
+        ("cameraTimestampNs", "<i8"),
+        ("preTrigger", "u1"),
+        ("cameraId", "<i8"),
+        ("roiX", "<i8"),
+        ("roiY", "<i8"),
+        ("roiWidth", "<i8"),
+        ("roiHeight", "<i8"),
+        ("binning", "<i8"),
+    ]
+)
+
+
+def _fsync_path(path):
+    """fsync ``path`` through a descriptor of our own (the library owns its handle)."""
+    fd = os.open(path, os.O_RDWR | getattr(os, "O_BINARY", 0))
+    try:
+        os.fsync(fd)
+    finally:
+        os.close(fd)
+
+
+class FrameWriterBackend:
+    """
+    Interface for the on-disk format behind FrameWriterThread.
+
+    A backend is created on the recorder thread but ``open``, ``write_batch``,
+    ``close`` and ``write_index`` are only ever called from the writer
+    thread, in that order.  ``write_batch`` receives a list of
+    ``(array, metadata_dict)`` tuples in acquisition order and records each
+    page with :meth:`_index_page` for the sidecar index.
+
+    While the stack is open every page also goes into a crash journal
+    (:meth:`open_journal`), and :meth:`checkpoint` fsyncs the stack and
+    records how many pages are durable, so writers/recovery.py can repair a
+    stack that was never closed.
+    """
+
+    # File extension (without dot) appended to the recording's base name
+    extension = "tif"
+
+    def __init__(self, path):
+        self.path = path
+        self._index = []  # writers.recording_index.index_row tuples
+        self._journal = None  # ColumnarLogWriter (JOURNAL_RECORD_DTYPE) while open
+        self.durable_pages = 0
+
+    @property
+    def index_path(self):
+        return index_path_for(self.path)
+
+    @property
+    def journal_path(self):
+        return journal_path_for(self.path)
+
+    def _index_page(
+        self, metadata, offset=-1, nbytes=0, file_end=-1, ifd_next=-1, ifd_offset=-1
+    ):
+        row = index_row(metadata, offset, nbytes, ifd_offset)
+        self._index.append(row)
+        if self._journal is not None:
+            self._journal.append(*row, file_end, ifd_next, JOURNAL_PAGE)
+
+    def open_journal(self):
+        """Start the crash journal (after :meth:`open`)."""
+        self._journal = ColumnarLogWriter(
+            self.journal_path,
+            JOURNAL_RECORD_DTYPE,
+            attrs={"video": os.path.basename(self.path), "backend": type(self).__name__},
+        )
+
+    def close_journal(self, remove=False):
+        """Close the journal; ``remove`` once the index has been saved."""
+        if self._journal is None:
+            return
+        self._journal.close()
+        self._journal = None
+        if remove:
+            try:
+                os.remove(self.journal_path)
+            except OSError as e:
+                log.warning(f"Could not remove journal {self.journal_path}: {e}")
+
+    def checkpoint(self):
+        """
+        Make every page written so far durable and record that in the
+        journal (its page rows first, then the checkpoint row, each fsync'ed).
+        Returns the number of durable pages.
+        """
+        file_end, ifd_next = self._sync()
+        pages = len(self._index)
+        if self._journal is not None:
+            self._journal.sync()
+            self._journal.append(
+                *index_row({"pageIdx": pages}), file_end, ifd_next, JOURNAL_CHECKPOINT
+            )
+            self._journal.sync()
+        self.durable_pages = pages
+        return pages
+
+    def _sync(self):
+        """Flush and fsync the stack; returns ``(file_end, ifd_next)`` for the journal."""
+        _fsync_path(self.path)
+        return self.file_size(), -1
+
+    def write_index(self):
+        """Save the sidecar index of every page written (see RecordingReader)."""
+        write_index(self.index_path, self._index)
+
+    def open(self):
+        raise NotImplementedError
+
+    def write_batch(self, items):
+        raise NotImplementedError
+
+    def close(self):
+        raise NotImplementedError
+
+    def file_size(self):
+        """Bytes currently on disk (used for compression/bandwidth stats)."""
+        try:
+            return os.path.getsize(self.path)
+        except OSError:
+            return 0
+
+
+class BigTiffWriter(FrameWriterBackend):
+    """Uncompressed BigTIFF, one page per frame with a JSON ImageDescription."""
+
+    extension = "tif"
+    # Pixels are stored contiguously, so their file offsets go into the index
+    contiguous = True
+
+    def __init__(self, path):
+        super().__init__(path)
+        self._tif = None
+
+    def open(self):
+        import tifffile
+
+        self._tif = tifffile.TiffWriter(self.path, bigtiff=True)
+
+    def _write_kwargs(self, arr):
+        return {}
+
+    # tifffile keeps its file handle and the position of the last IFD's
+    # next-IFD pointer private; recovery copes without either (-1)
+    def _file_end(self):
+        try:
+            return int(self._tif._fh.tell())
+        except Exception:
+            return -1
+
+    def _ifd_next(self):
+        pos = getattr(self._tif, "_ifdoffset", None)
+        return int(pos) if isinstance(pos, int) and pos > 0 else -1
+
+    def write_batch(self, items):
+        for arr, metadata in items:
+            # tifffile writes each page's IFD at the current end of the file,
+            # padded to a word boundary, ahead of its pixel data
+            ifd_offset = self._file_end()
+            if ifd_offset >= 0:
+                ifd_offset += ifd_offset % 2
+            located = self._tif.write(
+                arr,
+                description=json.dumps(metadata),
+                returnoffset=self.contiguous,
+                **self._write_kwargs(arr),
+            )
+            offset, nbytes = located if located else (-1, 0)
+            self._index_page(
+                metadata,
+                offset,
+                nbytes,
+                self._file_end(),
+                self._ifd_next(),
+                ifd_offset,
+            )
+
+    def _sync(self):
+        try:
+            self._tif._fh.flush()
+        except Exception:
+            pass
+        _fsync_path(self.path)
+        return self._file_end(), self._ifd_next()
+
+    def close(self):
+        if self._tif is not None:
+            self._tif.close()
+            self._tif = None
+
+
+class CompressedTiffWriter(BigTiffWriter):
+    """
+    BigTIFF with losslessly compressed tiles.  tifffile compresses the tiles of
+    each page on a pool of WRITER_COMPRESSION_WORKERS threads.  zstd needs the
+    ``imagecodecs`` package; without it we fall back to built-in deflate.
+    """
+
+    extension = "tif"
+    contiguous = False
+
+    def __init__(self, path, level=WRITER_COMPRESSION_LEVEL):
+        super().__init__(path)
+        self.level = level
+        self._compression = "zstd"
+
+    def open(self):
+        try:
+            import imagecodecs  # noqa: F401
+        except ImportError:
+            log.warning(
+                "imagecodecs not installed; compressed TIFF falls back to deflate."
+            )
+            self._compression = "zlib"
+        super().open()
+
+    def _write_kwargs(self, arr):
+        tile = WRITER_TILE_SIZE
+        kwargs = {
+            "compression": (self._compression, self.level),
+            "maxworkers": WRITER_COMPRESSION_WORKERS,
+        }
+        # Tiles must be multiples of 16 and no larger than the frame
+        if arr.shape[0] >= tile and arr.shape[1] >= tile:
+            kwargs["tile"] = (tile, tile)
+        return kwargs
+
+
+class Hdf5FrameWriter(FrameWriterBackend):
+    """
+    Chunked HDF5 stack: ``/frames`` is an (N, H, W) dataset with one chunk per
+    frame and the standard deflate filter, so any HDF5 reader can open it.
+    Chunks are compressed on a thread pool (zlib releases the GIL) and then
+    stored with ``write_direct_chunk``.  Per-frame metadata goes into
+    ``/metadata/<key>`` 1-D columns instead of per-page JSON.  The file is
+    written in SWMR mode, so after a crash it opens as of the last
+    :meth:`checkpoint` (``flush``).
+    """
+
+    extension = "h5"
+
+    def __init__(self, path, level=WRITER_COMPRESSION_LEVEL):
+        super().__init__(path)
+        self.level = level
+        self._file = None
+        self._frames = None
+        self._columns = {}
+        self._count = 0
+        self._pool = None
+        self._skipped_keys = set()  # unknown or malformed keys already logged
+
+    def open(self):
+        try:
+            import h5py
+        except ImportError as e:
+            raise RuntimeError("HDF5 recording requires the h5py package.") from e
+
+        # libver "latest" is required for SWMR
+        self._file = h5py.File(self.path, "w", libver="latest")
+        self._pool = ThreadPoolExecutor(
+            max_workers=WRITER_COMPRESSION_WORKERS, thread_name_prefix="h5-compress"
+        )
+
+    def _create_datasets(self, arr):
+        h, w = arr.shape[:2]
+        self._frames = self._file.create_dataset(
+            "frames",
+            shape=(0, h, w),
+            maxshape=(None, h, w),
+            dtype=arr.dtype,
+            chunks=(1, h, w),
+            compression="gzip",
+            compression_opts=self.level,
+        )
+        group = self._file.create_group("metadata")
+        for key in HDF5_METADATA_DTYPE.names:
+            self._columns[key] = group.create_dataset(
+                key,
+                shape=(0,),
+                maxshape=(None,),
+                dtype=HDF5_METADATA_DTYPE[key],
+                chunks=(4096,),
+            )
+
+    def _skip_once(self, key, reason):
+        if key not in self._skipped_keys:
+            self._skipped_keys.add(key)
+            log.warning(
+                f"HDF5 metadata key {key!r} not stored in {self.path}: {reason}"
+            )
+
+    def _column_value(self, md, key, fill):
+        value = md.get(key)
+        if value is None:
+            return fill
+        if isinstance(value, (bool, int, float, np.integer, np.floating)):
+            return value
+        self._skip_once(key, f"non-numeric value {value!r}")
+        return fill
+
+    def _compress(self, arr):
+        return zlib.compress(np.ascontiguousarray(arr).tobytes(), self.level)
+
+    def write_batch(self, items):
+        if not items:
+            return
+        if self._frames is None:
+            self._create_datasets(items[0][0])
+            try:
+                # Every dataset exists now; from here on the file stays readable
+                self._file.swmr_mode = True
+            except Exception as e:
+                log.warning(
+                    f"HDF5 SWMR mode unavailable ({e}); a crash may corrupt {self.path}."
+                )
+
+        chunks = list(self._pool.map(self._compress, [arr for arr, _ in items]))
+
+        start = self._count
+        end = start + len(items)
+        self._frames.resize(end, axis=0)
+        for i, chunk in enumerate(chunks):
+            self._frames.id.write_direct_chunk((start + i, 0, 0), chunk)
+
+        for _, md in items:
+            for key in md.keys() - self._columns.keys():
+                self._skip_once(key, "not in HDF5_METADATA_DTYPE")
+        for key, column in self._columns.items():
+            kind = column.dtype.kind
+            fill = np.nan if kind == "f" else (-1 if kind == "i" else 0)
+            values = [self._column_value(md, key, fill) for _, md in items]
+            column.resize(end, axis=0)
+            column[start:end] = values
+
+        for _, md in items:
+            self._index_page(md)
+        self._count = end
+
+    def _sync(self):
+        if self._file is not None:
+            self._file.flush()
+        return super()._sync()
+
+    def close(self):
+        if self._pool is not None:
+            self._pool.shutdown(wait=True)
+            self._pool = None
+        if self._file is not None:
+            self._file.close()
+            self._file = None
+
+
+WRITER_BACKENDS = {
+    "tif": BigTiffWriter,
+    "tif-zstd": CompressedTiffWriter,
+    "h5": Hdf5FrameWriter,
+}
+
+
+def create_frame_writer(fmt, base_path):
+    """
+    Instantiate the backend registered for ``fmt`` (see SUPPORTED_FORMATS)
+    writing to ``base_path`` + the backend's extension.
+    """
+    cls = WRITER_BACKENDS.get(fmt)
+    if cls is None:
+        log.warning(
+            f"Unknown recording format {fmt!r}; using {DEFAULT_RECORDING_FORMAT!r}."
+        )
+        cls = WRITER_BACKENDS[DEFAULT_RECORDING_FORMAT]
+    return cls(f"{base_path}.{cls.extension}")
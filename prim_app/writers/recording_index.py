@@ -0,0 +1,341 @@
+# prim_app/writers/recording_index.py
+
+import glob
+import json
+import logging
+import os
+import re
+
+import numpy as np
+
+log = logging.getLogger(__name__)
+
+_VIDEO_RE = re.compile(r"(_cam\d+)?_video\.(tif|h5)$")
+
+# One row per page of a recording, in page order.  ``offset``/``nbytes``
+# locate the raw pixels of uncompressed pages in the file (-1 when the page is
+# compressed or the stack is HDF5); ``ifdOffset`` is the page's TIFF IFD, so
+# compressed pages are found without walking the IFD chain (-1 for HDF5).
+# Unmatched pages have frameIdx -1 and NaN deviceTime/pressure, as in the
+# per-page metadata.
+INDEX_RECORD_DTYPE = np.dtype(
+    [
+        ("pageIdx", "<i8"),
+        ("offset", "<i8"),
+        ("nbytes", "<i8"),
+        ("frameIdx", "<i8"),
+        ("deviceTime", "<f8"),
+        ("pressure", "<f8"),
+        ("cameraFrame", "<i8"),
+        ("cameraTimestampNs", "<i8"),
+        ("preTrigger", "u1"),
+        ("ifdOffset", "<i8"),
+    ]
+)
+
+
+# Crash journal written next to the stack while it is open (and removed once
+# the index is saved): one "page" row per page with its index columns, the
+# file size after the page and, for TIFF, where its next-IFD pointer sits;
+# and one "checkpoint" row each time the stack was fsync'ed, with pageIdx =
+# the number of pages durable and fileEnd = the durable size.  See
+# writers/recovery.py.
+JOURNAL_PAGE = 0
+JOURNAL_CHECKPOINT = 1
+JOURNAL_RECORD_DTYPE = np.dtype(
+    INDEX_RECORD_DTYPE.descr
+    + [("fileEnd", "<i8"), ("ifdNext", "<i8"), ("kind", "u1")]
+)
+
+
+def index_path_for(video_path):
+    """``…_video.tif`` → ``…_video_index.npy``."""
+    return os.path.splitext(video_path)[0] + "_index.npy"
+
+
+def journal_path_for(video_path):
+    """``…_video.tif`` → ``…_video_journal.bin``."""
+    return os.path.splitext(video_path)[0] + "_journal.bin"
+
+
+def index_row(metadata, offset=-1, nbytes=0, ifd_offset=-1):
+    """Turn one page's metadata dict into an INDEX_RECORD_DTYPE tuple."""
+
+    def num(key, fill):
+        value = metadata.get(key)
+        return fill if value is None else value
+
+    return (
+        num("pageIdx", -1),
+        offset,
+        nbytes,
+        num("frameIdx", -1),
+        num("deviceTime", np.nan),
+        num("pressure", np.nan),
+        num("cameraFrame", -1),
+        num("cameraTimestampNs", 0),
+        1 if metadata.get("preTrigger") else 0,
+        ifd_offset,
+    )
+
+
+def write_index(path, rows):
+    """Write ``rows`` (index_row tuples) atomically as a .npy file."""
+    arr = np.array(rows, dtype=INDEX_RECORD_DTYPE)
+    tmp = path + ".tmp"
+    with open(tmp, "wb") as f:
+        np.save(f, arr)
+    os.replace(tmp, path)
+    return arr
+
+
+def build_index(video_path):
+    """
+    Recreate the index of a recording without a sidecar (older recordings or
+    a crash before stop) by walking every page once.  Slow; the result is
+    saved next to the recording so it only happens once.
+    """
+    rows = []
+    if video_path.endswith(".h5"):
+        import h5py
+
+        with h5py.File(video_path, "r") as f:
+            group = f.get("metadata")
+            n = f["frames"].shape[0]
+            columns = {k: group[k][:] for k in group} if group is not None else {}
+        for i in range(n):
+            md = {k: v[i].item() for k, v in columns.items()}
+            md.setdefault("pageIdx", i)
+            for key in ("deviceTime", "pressure"):
+                if key in md and np.isnan(md[key]):
+                    md[key] = None
+            rows.append(index_row(md))
+    else:
+        import tifffile
+
+        with tifffile.TiffFile(video_path) as tif:
+            for i, page in enumerate(tif.pages):
+                try:
+                    md = json.loads(page.description)
+                except (ValueError, TypeError):
+                    md = {}
+                md.setdefault("pageIdx", i)
+                contiguous = page.is_contiguous if page.compression == 1 else None
+                offset, nbytes = contiguous if contiguous else (-1, 0)
+                rows.append(index_row(md, offset, nbytes, page.offset))
+
+    path = index_path_for(video_path)
+    try:
+        return write_index(path, rows)
+    except OSError as e:
+        log.warning(f"Could not save rebuilt index {path}: {e}")
+        return np.array(rows, dtype=INDEX_RECORD_DTYPE)
+
+
+def open_index(video_path, rebuild=True):
+    """Memory-map the sidecar index of ``video_path`` (rebuilding it if missing)."""
+    path = index_path_for(video_path)
+    if os.path.exists(path):
+        return np.load(path, mmap_mode="r")
+    if not rebuild:
+        raise FileNotFoundError(path)
+    log.info(f"No index for {video_path}; rebuilding from the page metadata…")
+    return build_index(video_path)
+
+
+def find_recordings(folder):
+    """Every recorded stack (``recording_*_video.tif/.h5``) in a Fill folder."""
+    paths = glob.glob(os.path.join(folder, "recording_*_video.*"))
+    return sorted(p for p in paths if _VIDEO_RE.search(p))
+
+
+def recording_base(video_path):
+    """``…/recording_<ts>_cam1_video.tif`` → ``…/recording_<ts>``."""
+    return _VIDEO_RE.sub("", video_path)
+
+
+def load_pressure(base):
+    """``(deviceTime, pressure)`` of a recording, from its log or legacy CSV."""
+    from writers.columnar_log import open_log
+
+    log_path = base + "_pressure.bin"
+    if os.path.exists(log_path):
+        rows = open_log(log_path)
+        return np.array(rows["deviceTime"]), np.array(rows["pressure"])
+    csv_path = base + "_pressure.csv"
+    if os.path.exists(csv_path):
+        data = np.loadtxt(csv_path, delimiter=",", skiprows=1, usecols=(1, 2), ndmin=2)
+        return data[:, 0], data[:, 1]
+    return np.zeros(0), np.zeros(0)
+
+
+def page_times(index, default_fps=30.0):
+    """
+    ``(times, fps)`` of a recording's pages: the paired ``deviceTime``,
+    interpolated over unmatched pages, and the frame rate from the camera
+    timestamps (or the device times when the camera gave none).
+    """
+    n = len(index)
+    pages = np.arange(n)
+    device_time = np.asarray(index["deviceTime"], dtype=np.float64)
+    finite = np.isfinite(device_time)
+
+    fps = float(default_fps)
+    camera_ns = np.asarray(index["cameraTimestampNs"], dtype=np.float64)
+    steps = np.diff(camera_ns[camera_ns > 0])
+    steps = steps[steps > 0]
+    if len(steps):
+        fps = 1e9 / float(np.median(steps))
+    elif finite.sum() > 1:
+        fps = 1.0 / max(float(np.median(np.diff(device_time[finite]))), 1e-6)
+
+    if finite.sum() > 1:
+        times = np.interp(pages, pages[finite], device_time[finite])
+    elif finite.any():
+        t0 = device_time[finite][0] - pages[finite][0] / fps
+        times = t0 + pages / fps
+    else:
+        times = pages / fps
+    return times, fps
+
+
+class RecordingReader:
+    """
+    Random access to a recorded stack through its sidecar index.
+
+    Uncompressed BigTIFF pages are read straight from a memory map of the
+    file (no IFD parsing); compressed TIFF pages are parsed from the IFD
+    offset in the index and decoded through tifffile, so a seek costs the
+    same for any page (indexes from before ``ifdOffset`` fall back to
+    tifffile's page list); HDF5 frames are read through h5py by page number.
+    Metadata queries (``index``, :meth:`pages_between`) never touch the
+    stack.
+
+        with RecordingReader(path) as rec:
+            frame = rec[1234]
+            idx = rec.pages_between(10.0, 20.0)
+            stack = rec.frames(idx[::5])
+    """
+
+    def __init__(self, video_path, rebuild_index=True):
+        self.path = video_path
+        self.index = open_index(video_path, rebuild_index)
+        self._tif = None
+        self._h5 = None
+        self._frames_ds = None
+        self._raw = None
+        self._stack = None
+        self._ifd_offsets = None
+
+        if video_path.endswith(".h5"):
+            import h5py
+
+            self._h5 = h5py.File(video_path, "r")
+            self._frames_ds = self._h5["frames"]
+            self.shape = self._frames_ds.shape[1:]
+            self.dtype = self._frames_ds.dtype
+            return
+
+        import tifffile
+
+        self._tif = tifffile.TiffFile(video_path)
+        page0 = self._tif.pages[0]
+        self.shape = page0.shape
+        self.dtype = np.dtype(page0.dtype).newbyteorder(self._tif.byteorder)
+
+        if "ifdOffset" in (self.index.dtype.names or ()):
+            self._ifd_offsets = np.asarray(self.index["ifdOffset"])
+        frame_bytes = int(np.prod(self.shape)) * self.dtype.itemsize
+        offsets = np.asarray(self.index["offset"])
+        if len(offsets) and (offsets >= 0).all() and (
+            np.asarray(self.index["nbytes"]) == frame_bytes
+        ).all():
+            self._raw = np.memmap(video_path, dtype=np.uint8, mode="r")
+            steps = np.diff(offsets)
+            if len(offsets) == 1 or ((steps == steps[0]).all() and steps[0] >= frame_bytes):
+                # Evenly spaced pages: one strided (N, H, W) view of the file
+                step = int(steps[0]) if len(steps) else frame_bytes
+                self._stack = np.ndarray(
+                    (len(offsets),) + tuple(self.shape),
+                    dtype=self.dtype,
+                    buffer=self._raw,
+                    offset=int(offsets[0]),
+                    strides=(step,) + np.empty(self.shape, self.dtype).strides,
+                )
+
+    def __len__(self):
+        return len(self.index)
+
+    def __getitem__(self, key):
+        if isinstance(key, slice):
+            return self.frames(range(len(self))[key])
+        return self.frame(key)
+
+    def frame(self, i):
+        """Page ``i`` as an (H, W) array (a read-only view for memory-mapped stacks)."""
+        i = int(i)
+        if i < 0:
+            i += len(self)
+        if self._stack is not None:
+            return self._stack[i]
+        if self._raw is not None:
+            offset = int(self.index["offset"][i])
+            nbytes = int(self.index["nbytes"][i])
+            return self._raw[offset : offset + nbytes].view(self.dtype).reshape(self.shape)
+        if self._frames_ds is not None:
+            return self._frames_ds[i]
+        if self._ifd_offsets is not None and self._ifd_offsets[i] > 0:
+            return self._page_at(i).asarray()
+        return self._tif.pages[i].asarray()
+
+    def _page_at(self, i):
+        """Parse page ``i`` from its IFD offset, without walking the chain."""
+        import tifffile
+
+        fh = self._tif.filehandle
+        with fh.lock:
+            fh.seek(int(self._ifd_offsets[i]))
+            return tifffile.TiffPage(self._tif, index=i)
+
+    def frames(self, indices):
+        """Stack of the given pages, shape (len(indices), H, W)."""
+        indices = np.asarray(list(indices), dtype=np.int64)
+        if self._stack is not None:
+            return self._stack[indices]
+        if self._frames_ds is not None and len(indices) and (np.diff(indices) > 0).all():
+            return self._frames_ds[indices]
+        out = np.empty((len(indices),) + tuple(self.shape), dtype=self.dtype)
+        for n, i in enumerate(indices):
+            out[n] = self.frame(i)
+        return out
+
+    def strided(self, step, start=0, stop=None):
+        """Every ``step``-th page from ``start`` to ``stop``."""
+        return self.frames(range(len(self))[start:stop:step])
+
+    def pages_between(self, t0, t1, clock="deviceTime"):
+        """Page numbers whose ``clock`` column lies in [t0, t1)."""
+        values = np.asarray(self.index[clock])
+        return np.flatnonzero((values >= t0) & (values < t1))
+
+    def time_range(self, t0, t1, clock="deviceTime"):
+        """``(pages, stack)`` of every page recorded between t0 and t1."""
+        pages = self.pages_between(t0, t1, clock)
+        return pages, self.frames(pages)
+
+    def close(self):
+        self._stack = None
+        self._raw = None
+        if self._tif is not None:
+            self._tif.close()
+            self._tif = None
+        if self._h5 is not None:
+            self._h5.close()
+            self._h5 = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+        return False
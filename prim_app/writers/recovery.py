@@ -0,0 +1,266 @@
+# prim_app/writers/recovery.py
+"""
+Repair a recording that was never closed (crash, power loss, PC sleep).
+
+For every ``<video>_journal.bin`` left next to a stack (a clean stop removes
+it) the stack is cut back to the last state the journal vouches for and its
+sidecar index is written from the journal rows, so the work is proportional
+to the number of pages, not the size of the stack:
+
+* BigTIFF: the file is truncated after the last complete page and that
+  page's next-IFD pointer is zeroed.  Pages after the last checkpoint are
+  kept too if their IFD chain and data are on disk (true after an
+  application crash); ``--durable-only`` keeps checkpointed pages only,
+  which is the safe choice after a power loss.
+* HDF5 (written in SWMR mode): the file opens as of its last flush; the
+  index is cut to the frames it holds.
+
+The recording's columnar logs (pressure, sync, diameter, DSP) are trimmed to
+their last complete record and the pressure/diameter/DSP CSVs are exported::
+
+    python -m writers.recovery <Fill folder or …_video_journal.bin> [--durable-only]
+"""
+
+import argparse
+import glob
+import os
+import re
+import struct
+import sys
+
+import numpy as np
+
+from writers.columnar_log import (
+    DIAMETER_CSV_COLUMNS,
+    DSP_CSV_COLUMNS,
+    PRESSURE_CSV_COLUMNS,
+    export_csv,
+    open_log,
+    read_header,
+    recover_log,
+)
+from writers.recording_index import (
+    INDEX_RECORD_DTYPE,
+    JOURNAL_CHECKPOINT,
+    JOURNAL_PAGE,
+    index_path_for,
+    write_index,
+)
+
+JOURNAL_SUFFIX = "_video_journal.bin"
+BIGTIFF_HEADER_SIZE = 16
+BIGTIFF_TAG_SIZE = 20
+MAX_IFD_TAGS = 4096  # anything larger is not an IFD tifffile wrote
+
+
+def read_journal(journal_path):
+    """
+    ``(video_path, pages, checkpoint)``: the complete page rows and the last
+    checkpoint row (None if the recording never reached one).
+    """
+    _, attrs = read_header(journal_path)
+    video_path = os.path.join(os.path.dirname(journal_path), attrs["video"])
+    rows = np.array(open_log(journal_path))
+    pages = rows[rows["kind"] == JOURNAL_PAGE]
+    checkpoints = rows[rows["kind"] == JOURNAL_CHECKPOINT]
+    return video_path, pages, checkpoints[-1] if len(checkpoints) else None
+
+
+def _index_rows(pages):
+    out = np.zeros(len(pages), dtype=INDEX_RECORD_DTYPE)
+    out["ifdOffset"] = -1  # journals from before the column
+    for name in INDEX_RECORD_DTYPE.names:
+        if name in pages.dtype.names:
+            out[name] = pages[name]
+    return out
+
+
+# ─── BigTIFF ─────────────────────────────────────────────────────────────
+def _follow_ifds(f, fmt, size, pointer, limit):
+    """
+    Follow the IFD chain from the next-IFD pointer at ``pointer`` for up to
+    ``limit`` IFDs; returns the pointer positions of the complete ones.
+    Only the 8-byte links and tag counts are read.
+    """
+    positions = []
+    while len(positions) < limit:
+        f.seek(pointer)
+        raw = f.read(8)
+        if len(raw) < 8:
+            break
+        (ifd,) = struct.unpack(fmt, raw)
+        if ifd == 0 or ifd + 8 > size:
+            break
+        f.seek(ifd)
+        (count,) = struct.unpack(fmt, f.read(8))
+        nxt = ifd + 8 + BIGTIFF_TAG_SIZE * count
+        if not 0 < count <= MAX_IFD_TAGS or nxt + 8 > size:
+            break
+        positions.append(nxt)
+        pointer = nxt
+    return positions
+
+
+def _recover_tiff(video_path, pages, checkpoint, durable_only):
+    size = os.path.getsize(video_path)
+    with open(video_path, "r+b") as f:
+        header = f.read(BIGTIFF_HEADER_SIZE)
+        if len(header) < BIGTIFF_HEADER_SIZE or header[:2] not in (b"II", b"MM"):
+            raise ValueError(f"{video_path} has no BigTIFF header.")
+        fmt = "<Q" if header[:2] == b"II" else ">Q"
+
+        durable = int(checkpoint["pageIdx"]) if checkpoint is not None else 0
+        durable = min(durable, len(pages))
+        pointer = int(checkpoint["ifdNext"]) if checkpoint is not None else -1
+        if durable and pointer < 0:
+            # No pointer in the journal: walk the links from the header once
+            chain = _follow_ifds(f, fmt, size, 8, durable)
+            durable = len(chain)
+            pointer = chain[-1] if chain else -1
+        keep = durable
+
+        if not durable_only:
+            start = pointer if durable else 8
+            for position in _follow_ifds(f, fmt, size, start, len(pages) - durable):
+                end = int(pages[keep]["fileEnd"])
+                # The page's pixels must be on disk as well as its IFD
+                if end < 0 or end > size:
+                    break
+                keep += 1
+                pointer = position
+
+        if keep == 0:
+            raise ValueError(f"{video_path} has no complete page.")
+
+        # Terminate the chain after the last kept page and drop the rest
+        f.seek(pointer)
+        f.write(struct.pack(fmt, 0))
+        end = int(pages[keep - 1]["fileEnd"])
+        if pointer + 8 <= end < size:
+            f.truncate(end)
+        f.flush()
+        os.fsync(f.fileno())
+    return keep, durable
+
+
+# ─── HDF5 ────────────────────────────────────────────────────────────────
+def _recover_h5(video_path, pages, checkpoint, durable_only):
+    import h5py
+
+    with h5py.File(video_path, "r", libver="latest", swmr=True) as f:
+        frames = f["frames"].shape[0] if "frames" in f else 0
+    durable = int(checkpoint["pageIdx"]) if checkpoint is not None else 0
+    keep = min(frames, len(pages))
+    if durable_only:
+        keep = min(keep, durable)
+    return keep, min(durable, keep)
+
+
+def recover_stack(journal_path, durable_only=False):
+    """
+    Repair the stack of ``journal_path`` and write its index; the journal is
+    removed afterwards.  Returns a summary dict.
+    """
+    video_path, pages, checkpoint = read_journal(journal_path)
+    if video_path.endswith(".h5"):
+        keep, durable = _recover_h5(video_path, pages, checkpoint, durable_only)
+    else:
+        keep, durable = _recover_tiff(video_path, pages, checkpoint, durable_only)
+    write_index(index_path_for(video_path), _index_rows(pages[:keep]))
+    os.remove(journal_path)
+    return {
+        "video": video_path,
+        "pages": keep,
+        "journaled": len(pages),
+        "durable": durable,
+    }
+
+
+# ─── Whole recordings ────────────────────────────────────────────────────
+def recording_base(journal_path):
+    """``…/recording_<ts>_cam1_video_journal.bin`` → ``…/recording_<ts>``."""
+    base = journal_path[: -len(JOURNAL_SUFFIX)]
+    return re.sub(r"_cam\d+$", "", base)
+
+
+def find_unfinished(folder):
+    """Recording base paths in ``folder`` with a journal or a log but no CSV."""
+    journals = glob.glob(os.path.join(folder, "*" + JOURNAL_SUFFIX))
+    bases = {recording_base(p) for p in journals}
+    for log_path in glob.glob(os.path.join(folder, "recording_*_pressure.bin")):
+        if not os.path.exists(os.path.splitext(log_path)[0] + ".csv"):
+            bases.add(log_path[: -len("_pressure.bin")])
+    return sorted(bases)
+
+
+def recover_recording(base, durable_only=False):
+    """
+    Repair every stack and log of the recording ``base`` (``…/recording_<ts>``).
+    Returns a list of ``(path, message)`` lines; failures are reported, not raised.
+    """
+    report = []
+    for journal in sorted(glob.glob(glob.escape(base) + "*" + JOURNAL_SUFFIX)):
+        try:
+            r = recover_stack(journal, durable_only)
+            report.append(
+                (
+                    r["video"],
+                    f"{r['pages']} pages kept ({r['durable']} checkpointed, "
+                    f"{r['journaled']} journaled)",
+                )
+            )
+        except Exception as e:
+            report.append((journal, f"not recovered: {e}"))
+
+    for log_path in sorted(glob.glob(glob.escape(base) + "*.bin")):
+        if log_path.endswith(JOURNAL_SUFFIX):
+            continue
+        try:
+            n = recover_log(log_path)
+        except Exception as e:
+            report.append((log_path, f"not recovered: {e}"))
+            continue
+        message = f"{n} records"
+        columns = None
+        if log_path.endswith("_pressure.bin"):
+            columns = PRESSURE_CSV_COLUMNS
+        elif log_path.endswith("_diameter.bin"):
+            columns = DIAMETER_CSV_COLUMNS
+        elif log_path.endswith("_dsp.bin"):
+            columns = DSP_CSV_COLUMNS
+        if columns is not None:
+            try:
+                csv_path = export_csv(log_path, columns=columns)
+                message += f", exported {os.path.basename(csv_path)}"
+            except Exception as e:
+                message += f", CSV export failed: {e}"
+        report.append((log_path, message))
+    return report
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("path", help="Fill folder or a recording's journal file.")
+    parser.add_argument(
+        "--durable-only",
+        action="store_true",
+        help="Keep only checkpointed pages (use after a power loss).",
+    )
+    args = parser.parse_args(argv)
+
+    if os.path.isdir(args.path):
+        bases = find_unfinished(args.path)
+    else:
+        bases = [recording_base(args.path)]
+    if not bases:
+        print(f"No unfinished recordings in {args.path}")
+        return 0
+    for base in bases:
+        print(os.path.basename(base))
+        for path, message in recover_recording(base, args.durable_only):
+            print(f"  {os.path.basename(path)}: {message}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
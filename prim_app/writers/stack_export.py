@@ -0,0 +1,342 @@
+# prim_app/writers/stack_export.py
+"""
+Stream a recorded stack into a file that is easy to share: an H.264/H.265
+or MJPEG preview video, or a spatially binned BigTIFF, optionally decimated
+in time (every ``step``-th page) and with the time and pressure of each page
+burned in.
+
+Pages are read one at a time on the calling thread through the recording's
+index and rendered (binning, 8-bit window, overlay) on a pool of
+EXPORT_WORKERS threads, with at most EXPORT_IN_FLIGHT pages in memory, so
+the stack is never loaded as a whole::
+
+    python -m writers.stack_export <…_video.tif> [--format h264] [--step 10] [--bin 2]
+"""
+
+import argparse
+import collections
+import json
+import logging
+import os
+import sys
+import time
+from concurrent.futures import ThreadPoolExecutor
+
+import numpy as np
+
+from utils.config import (
+    EXPORT_BINNING,
+    EXPORT_DEFAULT_FORMAT,
+    EXPORT_IN_FLIGHT,
+    EXPORT_OVERLAY,
+    EXPORT_STEP,
+    EXPORT_WORKERS,
+    PREVIEW_PERCENTILES,
+    PREVIEW_PERCENTILE_STRIDE,
+)
+from writers.recording_index import (
+    RecordingReader,
+    load_pressure,
+    page_times,
+    recording_base,
+)
+
+log = logging.getLogger(__name__)
+
+# format -> (label, extension, FourCC codes to try; None for TIFF)
+EXPORT_FORMATS = {
+    "h264": ("H.264 video (.mp4)", "mp4", ("avc1", "H264", "mp4v")),
+    "h265": ("H.265 video (.mp4)", "mp4", ("hvc1", "HEVC", "mp4v")),
+    "mjpeg": ("MJPEG video (.avi)", "avi", ("MJPG",)),
+    "tiff": ("Binned BigTIFF (.tif)", "tif", None),
+}
+
+WINDOW_SAMPLE_PAGES = 16  # pages sampled for the shared 8-bit display window
+
+
+class ExportCancelled(Exception):
+    """Raised inside :func:`export_stack` when ``cancelled()`` turns true."""
+
+
+def default_output_path(video_path, fmt, step=1, binning=1):
+    """``…_video.tif`` → ``…_video_preview[_x10][_bin2].mp4`` (same folder)."""
+    stem = os.path.splitext(video_path)[0] + "_preview"
+    if step > 1:
+        stem += f"_x{step}"
+    if binning > 1:
+        stem += f"_bin{binning}"
+    return f"{stem}.{EXPORT_FORMATS[fmt][1]}"
+
+
+def bin_frame(arr, factor):
+    """Mean of ``factor`` × ``factor`` blocks; a partial block at the edge is cut."""
+    if factor <= 1:
+        return arr
+    h, w = arr.shape[0] // factor, arr.shape[1] // factor
+    blocks = arr[: h * factor, : w * factor].reshape(h, factor, w, factor)
+    return blocks.mean(axis=(1, 3), dtype=np.float32).astype(arr.dtype)
+
+
+def display_window(reader, pages):
+    """One (low, high) window for the whole export, from a sample of ``pages``."""
+    picks = np.unique(np.linspace(0, len(pages) - 1, WINDOW_SAMPLE_PAGES).astype(int))
+    stride = PREVIEW_PERCENTILE_STRIDE
+    sample = np.concatenate(
+        [np.asarray(reader.frame(pages[i]))[::stride, ::stride].ravel() for i in picks]
+    )
+    low, high = np.percentile(sample, PREVIEW_PERCENTILES)
+    return float(low), float(max(high, low + 1))
+
+
+def _lut(dtype, window):
+    """uint8 lookup table mapping ``window`` of an integer ``dtype`` to 0–255."""
+    low, high = window
+    values = np.arange(1 << (8 * np.dtype(dtype).itemsize), dtype=np.float32)
+    return np.clip((values - low) * (255.0 / (high - low)), 0, 255).astype(np.uint8)
+
+
+def _overlay_text(t, pressure):
+    text = f"t = {t:.2f} s"
+    if np.isfinite(pressure):
+        text += f"   P = {pressure:.1f} mmHg"
+    return text
+
+
+def _draw_overlay(img, text, value):
+    import cv2
+
+    scale = max(0.4, img.shape[1] / 1200.0)
+    thickness = max(1, int(round(2 * scale)))
+    font = cv2.FONT_HERSHEY_SIMPLEX
+    (_, th), _ = cv2.getTextSize(text, font, scale, thickness)
+    org = (int(8 * scale), int(8 * scale) + th)
+    # Dark outline first so the text reads on bright and dark backgrounds
+    cv2.putText(img, text, org, font, scale, 0, thickness + 2, cv2.LINE_AA)
+    cv2.putText(img, text, org, font, scale, value, thickness, cv2.LINE_AA)
+
+
+class _VideoSink:
+    def __init__(self, path, fourccs, fps, shape):
+        import cv2
+
+        self.codec = None
+        self._writer = None
+        size = (shape[1], shape[0])
+        for code in fourccs:
+            fourcc = cv2.VideoWriter_fourcc(*code)
+            writer = cv2.VideoWriter(path, fourcc, fps, size, True)
+            if writer.isOpened():
+                self._writer, self.codec = writer, code
+                break
+            writer.release()
+        if self._writer is None:
+            raise RuntimeError(f"No video encoder for {'/'.join(fourccs)} is available.")
+        if self.codec != fourccs[0]:
+            log.warning(
+                f"stack_export: {fourccs[0]} unavailable, encoding with {self.codec}."
+            )
+
+    def write(self, img, metadata):
+        self._writer.write(img)
+
+    def close(self):
+        self._writer.release()
+
+
+class _TiffSink:
+    codec = None
+
+    def __init__(self, path):
+        import tifffile
+
+        self._tif = tifffile.TiffWriter(path, bigtiff=True)
+
+    def write(self, img, metadata):
+        self._tif.write(img, description=json.dumps(metadata))
+
+    def close(self):
+        self._tif.close()
+
+
+def export_stack(
+    video_path,
+    out_path=None,
+    fmt=EXPORT_DEFAULT_FORMAT,
+    step=EXPORT_STEP,
+    binning=EXPORT_BINNING,
+    overlay=EXPORT_OVERLAY,
+    fps=None,
+    workers=EXPORT_WORKERS,
+    progress=None,
+    cancelled=None,
+):
+    """
+    Export the stack at ``video_path`` (see the module docstring).  ``fps``
+    defaults to the recorded frame rate, so a ``step`` of 10 plays back ten
+    times faster.  ``progress(done, total)`` is called after every page and
+    ``cancelled()`` polled before each one; a cancelled export removes its
+    partial output and raises :class:`ExportCancelled`.  Returns a summary
+    dict.
+    """
+    if fmt not in EXPORT_FORMATS:
+        raise ValueError(f"Unknown export format {fmt!r}.")
+    step = max(1, int(step))
+    binning = max(1, int(binning))
+    out_path = out_path or default_output_path(video_path, fmt, step, binning)
+    video = EXPORT_FORMATS[fmt][2] is not None
+
+    reader = RecordingReader(video_path)
+    sink = None
+    pool = None
+    t_start = time.perf_counter()
+    try:
+        pages = np.arange(0, len(reader), step)
+        if not len(pages):
+            raise ValueError(f"{video_path} has no pages.")
+        times, recorded_fps = page_times(reader.index)
+        pressure = np.array(reader.index["pressure"], dtype=np.float64)
+        missing = ~np.isfinite(pressure)
+        if overlay and missing.any():
+            # Unmatched pages: interpolate the pressure log at their time
+            ts, ps = load_pressure(recording_base(video_path))
+            if len(ts):
+                pressure[missing] = np.interp(times[missing], ts, ps)
+
+        lut = None
+        if video:
+            if reader.dtype.kind == "u" and reader.dtype.itemsize <= 2:
+                lut = _lut(reader.dtype, display_window(reader, pages))
+            overlay_value = (255, 255, 255)
+        elif reader.dtype.kind in "ui":
+            overlay_value = int(np.iinfo(reader.dtype).max)
+        else:
+            overlay_value = 1.0
+
+        def render(page, arr):
+            img = bin_frame(np.asarray(arr), binning)
+            if video:
+                import cv2
+
+                if lut is not None:
+                    img = lut[img]
+                else:
+                    img = cv2.normalize(img, None, 0, 255, cv2.NORM_MINMAX, cv2.CV_8U)
+                img = cv2.cvtColor(img, cv2.COLOR_GRAY2BGR)
+            elif overlay:
+                img = np.array(img, copy=True)  # never draw into the source
+            if overlay:
+                text = _overlay_text(times[page], pressure[page])
+                _draw_overlay(img, text, overlay_value)
+            return img
+
+        first = render(pages[0], reader.frame(pages[0]))
+        fps = float(fps or recorded_fps)
+        if video:
+            sink = _VideoSink(out_path, EXPORT_FORMATS[fmt][2], fps, first.shape)
+        else:
+            sink = _TiffSink(out_path)
+
+        def metadata(page):
+            row = reader.index[page]
+            p = float(pressure[page])
+            return {
+                "sourcePage": int(page),
+                "frameIdx": int(row["frameIdx"]),
+                "deviceTime": float(times[page]),
+                "pressure": p if np.isfinite(p) else None,
+                "binning": binning,
+            }
+
+        total = len(pages)
+        sink.write(first, metadata(pages[0]))
+        if progress:
+            progress(1, total)
+
+        pool = ThreadPoolExecutor(
+            max_workers=max(1, int(workers)), thread_name_prefix="export"
+        )
+        inflight = collections.deque()
+        done = 1
+        for page in pages[1:]:
+            if cancelled and cancelled():
+                raise ExportCancelled()
+            inflight.append((page, pool.submit(render, page, reader.frame(page))))
+            if len(inflight) >= EXPORT_IN_FLIGHT:
+                p, future = inflight.popleft()
+                sink.write(future.result(), metadata(p))
+                done += 1
+                if progress:
+                    progress(done, total)
+        while inflight:
+            if cancelled and cancelled():
+                raise ExportCancelled()
+            p, future = inflight.popleft()
+            sink.write(future.result(), metadata(p))
+            done += 1
+            if progress:
+                progress(done, total)
+
+        codec = sink.codec
+        sink.close()
+        sink = None
+        return {
+            "path": out_path,
+            "pages": total,
+            "format": fmt,
+            "codec": codec,
+            "fps": fps,
+            "seconds": time.perf_counter() - t_start,
+        }
+    except BaseException:
+        if sink is not None:
+            try:
+                sink.close()
+            except Exception:
+                pass
+            sink = None
+            try:
+                os.remove(out_path)
+            except OSError:
+                pass
+        raise
+    finally:
+        if pool is not None:
+            pool.shutdown(wait=True, cancel_futures=True)
+        reader.close()
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("video", help="Recorded stack (…_video.tif or …_video.h5).")
+    parser.add_argument("-o", "--output", help="Output file (default: next to it).")
+    parser.add_argument(
+        "--format", choices=sorted(EXPORT_FORMATS), default=EXPORT_DEFAULT_FORMAT
+    )
+    parser.add_argument("--step", type=int, default=EXPORT_STEP, help="Keep every N-th.")
+    parser.add_argument("--bin", type=int, default=EXPORT_BINNING, help="Binning factor.")
+    parser.add_argument("--fps", type=float, help="Frame rate (default: as recorded).")
+    parser.add_argument(
+        "--no-overlay", action="store_true", help="Do not burn in time and pressure."
+    )
+    args = parser.parse_args(argv)
+
+    def progress(done, total):
+        if done == total or done % 100 == 0:
+            print(f"\r  {done}/{total} pages", end="", flush=True)
+
+    result = export_stack(
+        args.video,
+        args.output,
+        fmt=args.format,
+        step=args.step,
+        binning=args.bin,
+        overlay=not args.no_overlay,
+        fps=args.fps,
+        progress=progress,
+    )
+    print(f"\n{result['path']}: {result['pages']} pages in {result['seconds']:.1f} s")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())